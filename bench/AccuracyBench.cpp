@@ -0,0 +1,380 @@
+#include "Bench.h"
+#include "BatchDispatch.h"
+#include "BenchInputs.h"
+#include "InclineAngleSolver.h"
+#include "TwoBoneIKSolver.h"
+
+// Accuracy of the approximate math tiers from ApproxMath.h against the std functions and the exact solve.
+// Each function is swept over its whole domain, and the solves over random limbs plus the edge cases,
+// targets with zero components that go through makeNonZero, and the fully extended and fully folded limits.
+// Every result is one JSON line with the maximum absolute error and, for the functions, the maximum error in ULPs.
+// The process fails when a tier exceeds the error documented in ApproxMath.h.
+
+namespace
+{
+
+struct ErrorStats
+{
+  double maxAbs = 0.0;
+  double maxUlp = 0.0;
+  double worstInput = 0.0;
+
+  void add(double _input, double _value, double _reference)
+  {
+    addError(_input, std::abs(_value - _reference), _reference);
+  }
+
+  // A NaN on either side is an infinite error
+  void addError(double _input, double _error, double _reference)
+  {
+    const double abs = _error == _error ? _error : HUGE_VAL;
+    const double ulp = std::nextafter(std::abs(_reference), HUGE_VAL) - std::abs(_reference);
+    if (abs > maxAbs)
+    {
+      maxAbs = abs;
+      worstInput = _input;
+    }
+    maxUlp = std::max(maxUlp, abs / ulp);
+  }
+};
+
+// Errors relative to references at or near zero can be infinite in ULPs, which JSON has no number for
+std::string jsonNumber(double _value, const char* _format = "%.3g")
+{
+  if (!std::isfinite(_value)) return "null";
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), _format, _value);
+  return buffer;
+}
+
+bool report(const std::string& _name, const char* _precision, const ErrorStats& _stats, double _bound)
+{
+  const bool ok = _stats.maxAbs <= _bound;
+  std::printf("{\"benchmark\":%s,\"precision\":%s,\"max_abs_error\":%s,\"max_ulp\":%s,\"worst_input\":%s,\"bound\":%.3g,\"ok\":%s}\n",
+      jsonString(_name).c_str(), jsonString(_precision).c_str(), jsonNumber(_stats.maxAbs).c_str(), jsonNumber(_stats.maxUlp).c_str(),
+      jsonNumber(_stats.worstInput, "%.17g").c_str(), _bound, jsonBool(ok).c_str());
+  std::fflush(stdout);
+  if (!ok) std::fprintf(stderr, "%s %s error %.3g exceeds %.3g\n", _name.c_str(), _precision, _stats.maxAbs, _bound);
+  return ok;
+}
+
+// Wrapped difference of two angles
+double angleError(double _a, double _b)
+{
+  return std::abs(std::remainder(_a - _b, 2.0 * M_PI));
+}
+
+// Evenly spaced samples over [_lower, _upper] including both ends, followed by the given extra points
+template <typename TFunction>
+void sweep(double _lower, double _upper, std::size_t _count, std::initializer_list<double> _extra, TFunction _function)
+{
+  for (std::size_t i = 0u; i <= _count; ++i) _function(_lower + (_upper - _lower) * double(i) / double(_count));
+  for (double x : _extra) _function(x);
+}
+
+static constexpr std::size_t kSweepCount = 2000000u;
+
+// Error bounds per tier, as documented in ApproxMath.h
+struct Bounds
+{
+  double acos;
+  double atan;
+  double exp;
+  double sincos;
+  double solve;
+};
+
+template <typename TMath>
+bool functionAccuracy(const char* _precision, const Bounds& _bounds)
+{
+  const double tiny = std::numeric_limits<double>::min();
+  const double nextBelowOne = std::nextafter(1.0, 0.0);
+  bool ok = true;
+
+  ErrorStats acos;
+  sweep(-1.0, 1.0, kSweepCount, {nextBelowOne, -nextBelowOne, tiny, -tiny, 0.0}, [&](double x)
+  {
+    acos.add(x, TMath::acos(x), std::acos(x));
+  });
+  ok &= report("accuracy.acos", _precision, acos, _bounds.acos);
+
+  ErrorStats atan;
+  sweep(-64.0, 64.0, kSweepCount, {1.0, -1.0, tiny, -tiny, 1e300, -1e300, 1.0 / tiny}, [&](double x)
+  {
+    atan.add(x, TMath::atan(x), std::atan(x));
+  });
+  ok &= report("accuracy.atan", _precision, atan, _bounds.atan);
+
+  // Around the circle at a few radii, then the axes, pi and -pi are the same angle.
+  // The origin is left out, -ffast-math builds do not keep the sign of zero that atan2 depends on
+  ErrorStats atan2;
+  sweep(-M_PI, M_PI, kSweepCount, {}, [&](double a)
+  {
+    for (double radius : {1e-150, 1.0, 1e8})
+    {
+      const double y = radius * std::sin(a);
+      const double x = radius * std::cos(a);
+      const double reference = std::atan2(y, x);
+      atan2.addError(a, angleError(TMath::atan2(y, x), reference), reference);
+    }
+  });
+  for (double y : {0.0, 1.0, -1.0, tiny})
+    for (double x : {1.0, -1.0, tiny, -tiny})
+    {
+      const double reference = std::atan2(y, x);
+      atan2.addError(y, angleError(TMath::atan2(y, x), reference), reference);
+    }
+  ok &= report("accuracy.atan2", _precision, atan2, _bounds.atan);
+
+  // softenEdge only passes non positive arguments, relative error covers the tiny results
+  ErrorStats exp;
+  sweep(-745.0, 0.0, kSweepCount, {-1e-300, -708.0, -707.9}, [&](double x)
+  {
+    const double reference = std::exp(x);
+    if (reference < std::numeric_limits<double>::min()) return;
+    exp.add(x, TMath::exp(x) / reference, 1.0);
+  });
+  ok &= report("accuracy.exp.relative", _precision, exp, _bounds.exp);
+
+  ErrorStats sincos;
+  sweep(-8.0 * M_PI, 8.0 * M_PI, kSweepCount, {M_PI_4, -M_PI_4, 3.0 * M_PI_4}, [&](double x)
+  {
+    double s, c;
+    TMath::sincos(x, s, c);
+    sincos.add(x, s, std::sin(x));
+    sincos.add(x, c, std::cos(x));
+  });
+  ok &= report("accuracy.sincos", _precision, sincos, _bounds.sincos);
+  return ok;
+}
+
+template <typename TMath>
+bool solveAccuracy(const char* _precision, const Bounds& _bounds)
+{
+  struct Limb
+  {
+    Vector3<double> target;
+    Vector3<double> pole;
+    double edgeA;
+    double edgeB;
+    double twist;
+  };
+  std::vector<Limb> limbs;
+  TwoBoneIKBatchBuffers in;
+  makeLimbInputs(in, 200000u, LimbInputConfig());
+  for (std::size_t i = 0u; i < in.size(); ++i)
+  {
+    limbs.push_back({
+      Vector3<double>(in.targetX[i], in.targetY[i], in.targetZ[i]),
+      Vector3<double>(in.poleX[i], in.poleY[i], in.poleZ[i]),
+      in.edgeA[i], in.edgeB[i], in.twist[i]});
+  }
+  // Edge cases, targets and poles with zero components, including the origin.
+  // A pole on the target line leaves the twist undefined, so none of the poles line up with a target
+  const Vector3<double> pole(0.3, 1.0, -0.7);
+  for (double x : {0.0, -0.0, 1.0, -1.0})
+    for (double y : {0.0, -0.0, 0.5, -0.5})
+      for (double z : {0.0, -0.0, 1.0, -1.0})
+      {
+        limbs.push_back({Vector3<double>(x, y, z), pole, 1.0, 0.8, 0.0});
+        limbs.push_back({Vector3<double>(x, y, z), Vector3<double>(0.0, 1.0, -1.0), 1.0, 0.8, 0.2});
+      }
+  // The fully extended and fully folded limits, approached from both sides, in a few directions
+  for (const auto& direction : {Vector3<double>(1.0, 0.0, 0.0), Vector3<double>(0.6, 0.8, 0.0), Vector3<double>(-0.48, 0.6, 0.64)})
+  {
+    for (double scale : {1.0 - 1e-6, 1.0 - 1e-12, 1.0, 1.0 + 1e-12, 1.0 + 1e-6, 2.0})
+    {
+      limbs.push_back({direction * (1.8 * scale), pole, 1.0, 0.8, 0.1});
+      limbs.push_back({direction * (0.2 * scale), pole, 1.0, 0.8, 0.1});
+      limbs.push_back({direction * (0.2 * scale * scale), pole, 1.0, 0.8, -0.1});
+    }
+  }
+
+  ErrorStats bend, orientation, euler, incline, stretch;
+  for (std::size_t i = 0u; i < limbs.size(); ++i)
+  {
+    const auto& limb = limbs[i];
+    for (double dsoft : {0.0, 0.2})
+    {
+      const auto exact = solveTwoBoneIK(limb.target, limb.pole, limb.edgeA, limb.edgeB, limb.twist, dsoft, 0.5);
+      const auto approx = solveTwoBoneIK<double, TMath>(limb.target, limb.pole, limb.edgeA, limb.edgeB, limb.twist, dsoft, 0.5);
+      bend.add(double(i), approx.bendAngle, exact.bendAngle);
+      stretch.add(double(i), approx.stretchedEdgeA, exact.stretchedEdgeA);
+      // The approximate tiers are built on the root matrix, so the exact root matrix is the orientation reference,
+      // NodeBench checks it against the euler composition
+      const auto target = makeNonZero<double>(limb.target);
+      const auto edgeC = solveTwoBoneIKEdges(target, limb.edgeA, limb.edgeB, dsoft).edgeC;
+      const auto approxEdgeC = solveTwoBoneIKEdges<double, TMath>(target, limb.edgeA, limb.edgeB, dsoft).edgeC;
+      const auto exactMatrix = solveRootMatrix(target, limb.pole, limb.edgeA, limb.edgeB, edgeC, limb.twist);
+      const auto approxMatrix = solveRootMatrix<double, TMath>(target, limb.pole, limb.edgeA, limb.edgeB, approxEdgeC, limb.twist);
+      for (int r = 0; r < 3; ++r)
+        for (int c = 0; c < 3; ++c)
+          orientation.add(double(i), approxMatrix.m[r][c], exactMatrix.m[r][c]);
+      // The angles, at least 3 degrees away from the Y gimbal singularity where they are not unique,
+      // closer in the X and Z angles amplify the matrix error by 1 / cos(Y)
+      const auto exactEuler = solveRootEuler(exactMatrix);
+      if (std::abs(std::cos(exactEuler.y)) > 0.05)
+      {
+        const double error = std::max(
+            angleError(approx.orientation.x, exactEuler.x),
+            std::max(angleError(approx.orientation.y, exactEuler.y), angleError(approx.orientation.z, exactEuler.z)));
+        euler.addError(double(i), error, 0.0);
+      }
+      incline.add(double(i),
+          solveInclineAngle<double, TMath>(limb.target, limb.edgeA, limb.edgeB, dsoft),
+          solveInclineAngle(limb.target, limb.edgeA, limb.edgeB, dsoft));
+    }
+  }
+  bool ok = true;
+  ok &= report("accuracy.twoBoneIK.bendAngle", _precision, bend, _bounds.solve);
+  ok &= report("accuracy.twoBoneIK.orientationMatrix", _precision, orientation, _bounds.solve);
+  ok &= report("accuracy.twoBoneIK.orientation", _precision, euler, _bounds.solve);
+  // Stretching has no transcendentals, so every tier matches to rounding
+  ok &= report("accuracy.twoBoneIK.stretchedEdge", _precision, stretch, 1e-12);
+  ok &= report("accuracy.inclineAngle", _precision, incline, _bounds.solve);
+  return ok;
+}
+
+// The solves specialized on a feature mask against the general solve, over limbs that each leave out a different
+// set of features. They do the same math, but -ffast-math may reassociate each specialization differently,
+// so they agree to rounding in every tier and orientation method, and in where they give NaN.
+// The bend angle amplifies that rounding near full extension, where acos is steep, as for the packed solve
+template <typename TMath>
+bool featureAccuracy(const char* _precision)
+{
+  static constexpr double kBound = 1e-7;
+  TwoBoneIKBatchBuffers in;
+  makeLimbInputs(in, 20000u, LimbInputConfig());
+  std::size_t limbs = 0u, mismatches = 0u;
+  double maxError = 0.0;
+  for (std::size_t i = 0u; i < in.size(); ++i)
+  {
+    // Every mask, with the dropped features zeroed, including chains with no length
+    const unsigned mask = unsigned(i) & kAllFeatures;
+    const auto target = Vector3<double>(in.targetX[i], in.targetY[i], in.targetZ[i]);
+    const auto pole = (mask & kFeaturePole) ? Vector3<double>(in.poleX[i], in.poleY[i], in.poleZ[i]) : Vector3<double>(0.0, 0.0, 0.0);
+    const double edgeA = i % 97u ? in.edgeA[i] : 0.0;
+    const double edgeB = i % 97u ? in.edgeB[i] : 0.0;
+    const double twist = (mask & kFeatureTwist) ? in.twist[i] : 0.0;
+    const double dsoft = (mask & kFeatureSoften) ? 0.2 : 0.0;
+    const double stretchStrength = (mask & kFeatureStretch) ? 0.5 : 0.0;
+    for (auto method : {kOrientationAngles, kOrientationFrame})
+    {
+      const auto general = solveTwoBoneIK<double, TMath>(target, pole, edgeA, edgeB, twist, dsoft, stretchStrength, method);
+      const auto specialized = solveTwoBoneIKFeatures<double, TMath>(target, pole, edgeA, edgeB, twist, dsoft, stretchStrength, method);
+      bool match = true;
+      auto compare = [&](double _a, double _b)
+      {
+        if (_a != _a || _b != _b)
+        {
+          match = match && _a != _a && _b != _b;
+          return;
+        }
+        const double error = angleError(_a, _b);
+        maxError = std::max(maxError, error);
+        match = match && error <= kBound;
+      };
+      compare(general.bendAngle, specialized.bendAngle);
+      compare(general.orientation.x, specialized.orientation.x);
+      compare(general.orientation.y, specialized.orientation.y);
+      compare(general.orientation.z, specialized.orientation.z);
+      compare(general.stretchedEdgeA, specialized.stretchedEdgeA);
+      compare(general.stretchedEdgeB, specialized.stretchedEdgeB);
+      mismatches += !match;
+      ++limbs;
+    }
+  }
+  const bool ok = mismatches == 0u;
+  std::printf("{\"benchmark\":\"accuracy.twoBoneIK.features\",\"precision\":%s,\"limbs\":%zu,\"mismatches\":%zu,\"max_abs_error\":%s,"
+      "\"bound\":%.3g,\"ok\":%s}\n",
+      jsonString(_precision).c_str(), limbs, mismatches, jsonNumber(maxError).c_str(), kBound, jsonBool(ok).c_str());
+  std::fflush(stdout);
+  if (!ok) std::fprintf(stderr, "%zu feature specialized %s solves differ from the general solve\n", mismatches, _precision);
+  return ok;
+}
+
+// Every build of the batch kernels this cpu runs against the baseline build. The AVX builds contract to FMA, so they agree
+// to the tolerance of TwoBoneIKBatch.h, which is bounded by the bend angle near full extension.
+// The count leaves a tail that does not fill a pack of any width
+bool isaAccuracy()
+{
+  static constexpr double kBound = 1e-7;
+  static constexpr std::size_t kCount = 100003u;
+  LimbInputConfig config;
+  config.soften = 0.2;
+  config.stretchStrength = 0.5;
+  TwoBoneIKBatchBuffers reference;
+  makeLimbInputs(reference, kCount, config);
+  InclineAngleBatchBuffers inclineReference;
+  inclineReference.resize(kCount);
+  for (std::size_t i = 0u; i < kCount; ++i)
+  {
+    inclineReference.targetX[i] = reference.targetX[i];
+    inclineReference.targetY[i] = reference.targetY[i];
+    inclineReference.targetZ[i] = reference.targetZ[i];
+    inclineReference.edgeA[i] = reference.edgeA[i];
+    inclineReference.edgeB[i] = reference.edgeB[i];
+    inclineReference.soften[i] = reference.soften[i];
+  }
+  TwoBoneIKBatchBuffers limbs = reference;
+  InclineAngleBatchBuffers inclines = inclineReference;
+  kBatchKernelsSSE.solveTwoBoneIK(reference.view(), kCount);
+  kBatchKernelsSSE.solveInclineAngle(inclineReference.view(), kCount);
+
+  bool ok = true;
+  for (int level = kSimdSSE; level < kSimdLevelCount; ++level)
+  {
+    if (!simdLevelSupported(SimdLevel(level))) continue;
+    const BatchKernels& kernels = batchKernels(SimdLevel(level));
+    kernels.solveTwoBoneIK(limbs.view(), kCount);
+    kernels.solveInclineAngle(inclines.view(), kCount);
+    ErrorStats stats;
+    for (std::size_t i = 0u; i < kCount; ++i)
+    {
+      const double error = std::max({
+        angleError(limbs.bendAngle[i], reference.bendAngle[i]), angleError(limbs.orientationX[i], reference.orientationX[i]),
+        angleError(limbs.orientationY[i], reference.orientationY[i]), angleError(limbs.orientationZ[i], reference.orientationZ[i]),
+        std::abs(limbs.stretchedEdgeA[i] - reference.stretchedEdgeA[i]), std::abs(limbs.stretchedEdgeB[i] - reference.stretchedEdgeB[i]),
+        angleError(inclines.inclineAngle[i], inclineReference.inclineAngle[i])});
+      stats.addError(double(i), error, 0.0);
+    }
+    const bool levelOk = stats.maxAbs <= kBound;
+    std::printf("{\"benchmark\":\"accuracy.batch.isa\",\"isa\":%s,\"width\":%u,\"limbs\":%zu,\"max_abs_error\":%s,\"worst_input\":%s,"
+        "\"bound\":%.3g,\"ok\":%s}\n",
+        jsonString(kernels.name).c_str(), kernels.width, kCount, jsonNumber(stats.maxAbs).c_str(), jsonNumber(stats.worstInput, "%.17g").c_str(),
+        kBound, jsonBool(levelOk).c_str());
+    std::fflush(stdout);
+    if (!levelOk) std::fprintf(stderr, "%s batch kernels differ from the sse build by %.3g\n", kernels.name, stats.maxAbs);
+    ok &= levelOk;
+  }
+  return ok;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  const auto options = BenchOptions::parse(argc, argv);
+  const Bounds high = {4.5e-9, 1e-8, 3e-9, 2.5e-9, 1e-6};
+  const Bounds fast = {1.2e-5, 2.1e-5, 4e-6, 1.2e-6, 1e-4};
+
+  bool ok = true;
+  if (options.filter.empty() || std::string("accuracy.exact").find(options.filter) != std::string::npos)
+  {
+    ok &= featureAccuracy<ExactMath>("exact");
+    ok &= isaAccuracy();
+  }
+  if (options.filter.empty() || std::string("accuracy.high").find(options.filter) != std::string::npos)
+  {
+    ok &= functionAccuracy<HighMath>("high", high);
+    ok &= solveAccuracy<HighMath>("high", high);
+    ok &= featureAccuracy<HighMath>("high");
+  }
+  if (options.filter.empty() || std::string("accuracy.fast").find(options.filter) != std::string::npos)
+  {
+    ok &= functionAccuracy<FastMath>("fast", fast);
+    ok &= solveAccuracy<FastMath>("fast", fast);
+    ok &= featureAccuracy<FastMath>("fast");
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,126 @@
+#ifndef SIMPLEIKBENCH_INCLUDE_H
+#define SIMPLEIKBENCH_INCLUDE_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include <unistd.h>
+
+// Minimal benchmark harness, every result is printed as one JSON object per line
+
+// Keeps a value alive so the optimizer cannot drop the work that produced it
+template <typename T>
+inline void doNotOptimize(const T& value)
+{
+  __asm__ volatile("" : : "r,m"(value) : "memory");
+}
+
+struct BenchOptions
+{
+  // Only benchmarks whose name contains this are run
+  std::string filter;
+  // Number of timed samples per benchmark
+  unsigned samples = 50u;
+  // Minimum time spent in each sample, repetitions are scaled up to reach it
+  double minSampleNs = 2e5;
+
+  static BenchOptions parse(int argc, char** argv)
+  {
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+      if (!std::strcmp(argv[i], "--filter") && i + 1 < argc) options.filter = argv[++i];
+      else if (!std::strcmp(argv[i], "--samples") && i + 1 < argc) options.samples = unsigned(std::atoi(argv[++i]));
+      else if (!std::strcmp(argv[i], "--quick")) { options.samples = 10u; options.minSampleNs = 5e4; }
+      else std::fprintf(stderr, "Unknown argument %s\n", argv[i]);
+    }
+    return options;
+  }
+};
+
+// Extra key value pairs describing a benchmark configuration, values are written verbatim
+typedef std::vector<std::pair<std::string, std::string>> BenchTags;
+
+// Path for a scratch file in TMPDIR, unique to this process
+inline std::string benchTempPath(const std::string& _name)
+{
+  const char* directory = std::getenv("TMPDIR");
+  return std::string(directory && *directory ? directory : "/tmp") + "/simpleik_" + std::to_string(getpid()) + "_" + _name;
+}
+
+inline std::string jsonString(const std::string& s)
+{
+  return "\"" + s + "\"";
+}
+
+inline std::string jsonBool(bool b)
+{
+  return b ? "true" : "false";
+}
+
+// Summary of one benchmark, in nanoseconds per operation
+struct BenchResult
+{
+  double p50 = 0.0;
+  double mean = 0.0;
+};
+
+// Runs _op, which performs _opsPerCall operations, until every sample has met the minimum time.
+// Reports nanoseconds per operation percentiles over the samples, and operations per second.
+// Filtered out benchmarks are not run and return an empty result.
+inline BenchResult runBench(const BenchOptions& _options, const std::string& _name, const BenchTags& _tags, std::size_t _opsPerCall, const std::function<void()>& _op)
+{
+  if (!_options.filter.empty() && _name.find(_options.filter) == std::string::npos) return BenchResult();
+  typedef std::chrono::steady_clock Clock;
+
+  // Warm up and find how many calls fill one sample
+  _op();
+  std::size_t calls = 1u;
+  for (;;)
+  {
+    const auto start = Clock::now();
+    for (std::size_t i = 0u; i < calls; ++i) _op();
+    const double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    if (ns >= _options.minSampleNs || calls >= (std::size_t(1) << 30)) break;
+    calls *= 2u;
+  }
+
+  std::vector<double> nsPerOp(_options.samples);
+  double totalNs = 0.0;
+  for (auto& sample : nsPerOp)
+  {
+    const auto start = Clock::now();
+    for (std::size_t i = 0u; i < calls; ++i) _op();
+    const double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    totalNs += ns;
+    sample = ns / double(calls * _opsPerCall);
+  }
+  std::sort(nsPerOp.begin(), nsPerOp.end());
+  auto percentile = [&nsPerOp](double p)
+  {
+    return nsPerOp[std::min(nsPerOp.size() - 1u, std::size_t(p * double(nsPerOp.size())))];
+  };
+  const double totalOps = double(calls * _opsPerCall * nsPerOp.size());
+
+  std::printf("{\"benchmark\":%s", jsonString(_name).c_str());
+  for (const auto& tag : _tags) std::printf(",\"%s\":%s", tag.first.c_str(), tag.second.c_str());
+  std::printf(",\"samples\":%zu,\"ops_per_sample\":%zu", nsPerOp.size(), calls * _opsPerCall);
+  std::printf(",\"ns_per_op\":{\"min\":%.3f,\"p50\":%.3f,\"p90\":%.3f,\"p99\":%.3f,\"max\":%.3f,\"mean\":%.3f}",
+      nsPerOp.front(), percentile(0.5), percentile(0.9), percentile(0.99), nsPerOp.back(), totalNs / totalOps);
+  std::printf(",\"ops_per_sec\":%.1f}\n", totalOps / (totalNs * 1e-9));
+  std::fflush(stdout);
+
+  BenchResult result;
+  result.p50 = percentile(0.5);
+  result.mean = totalNs / totalOps;
+  return result;
+}
+
+#endif //SIMPLEIKBENCH_INCLUDE_H
@@ -0,0 +1,65 @@
+#ifndef SIMPLEIKBENCHINPUTS_INCLUDE_H
+#define SIMPLEIKBENCHINPUTS_INCLUDE_H
+
+#include "TwoBoneIKBatch.h"
+#include <cmath>
+#include <random>
+#include <string>
+
+// Synthetic limb inputs for the benchmarks
+struct LimbInputConfig
+{
+  // Random limbs are independent, coherent limbs vary smoothly from one to the next like a crowd
+  // playing similar animation, which is friendlier to the caches and branch predictor
+  bool coherent = false;
+  // Soften distance applied to every limb, zero disables softening
+  double soften = 0.0;
+  // Stretch strength applied to every limb, zero disables stretching
+  double stretchStrength = 0.0;
+  unsigned seed = 1u;
+
+  std::string inputsName() const { return coherent ? "coherent" : "random"; }
+};
+
+inline void makeLimbInputs(TwoBoneIKBatchBuffers& o_buffers, std::size_t _count, const LimbInputConfig& _config)
+{
+  o_buffers.resize(_count);
+  std::mt19937_64 rng(_config.seed);
+  std::uniform_real_distribution<double> position(-3.0, 3.0);
+  std::uniform_real_distribution<double> edge(0.5, 2.0);
+  std::uniform_real_distribution<double> angle(-0.5, 0.5);
+
+  for (std::size_t i = 0u; i < _count; ++i)
+  {
+    if (_config.coherent)
+    {
+      // A reaching motion sampled along the batch, every limb shares the same rig
+      const double t = double(i) * 0.01;
+      o_buffers.targetX[i] = 2.0 + 0.8 * std::cos(t);
+      o_buffers.targetY[i] = 0.5 * std::sin(t * 0.7);
+      o_buffers.targetZ[i] = 0.8 * std::sin(t);
+      o_buffers.poleX[i] = 1.5;
+      o_buffers.poleY[i] = 2.0;
+      o_buffers.poleZ[i] = -0.5;
+      o_buffers.edgeA[i] = 1.6;
+      o_buffers.edgeB[i] = 1.4;
+      o_buffers.twist[i] = 0.1;
+    }
+    else
+    {
+      o_buffers.targetX[i] = position(rng);
+      o_buffers.targetY[i] = position(rng);
+      o_buffers.targetZ[i] = position(rng);
+      o_buffers.poleX[i] = position(rng);
+      o_buffers.poleY[i] = position(rng);
+      o_buffers.poleZ[i] = position(rng);
+      o_buffers.edgeA[i] = edge(rng);
+      o_buffers.edgeB[i] = edge(rng);
+      o_buffers.twist[i] = angle(rng);
+    }
+    o_buffers.soften[i] = _config.soften;
+    o_buffers.stretchStrength[i] = _config.stretchStrength;
+  }
+}
+
+#endif //SIMPLEIKBENCHINPUTS_INCLUDE_H
@@ -0,0 +1,280 @@
+#include "Bench.h"
+#include "BenchInputs.h"
+#include "ChainIKSolver.h"
+#include "SplineIKSolver.h"
+#include "TwoBoneIKSolver.h"
+
+// Chain solves from ChainIKSolver.h, FABRIK against CCD on 4, 8 and 32 joint chains.
+// Maya's own solvers cannot run headless, so the results are held to the same standard instead:
+// a two bone chain must match the analytic two bone solve, the rotate plane solve, and every chain must keep
+// its bone lengths and reach the targets in range, as the single chain solve does.
+// Each chain length prints its mean iterations and the targets reached before the timings.
+// The spline solves from SplineIKSolver.h are checked for the arc length of every joint against a dense integration
+// of the curve, then the table build and the joint walk are timed apart, as a node only rebuilds the table when the
+// control points move. The process fails on a mismatch.
+
+namespace
+{
+
+static constexpr std::size_t kChainCount = 256u;
+static constexpr unsigned kMaxIterations = 64u;
+static constexpr double kTolerance = 1e-6;
+
+// Largest element difference of two rotations, free of the euler angle ambiguities
+double rotationError(const EulerRotation<double>& _a, const EulerRotation<double>& _b)
+{
+  const auto a = _a.asMatrix();
+  const auto b = _b.asMatrix();
+  double error = 0.0;
+  for (int r = 0; r < 3; ++r)
+    for (int c = 0; c < 3; ++c)
+      error = std::max(error, std::abs(a.m[r][c] - b.m[r][c]));
+  return error == error ? error : HUGE_VAL;
+}
+
+// A two bone chain solved to a tight tolerance against solveTwoBoneIK with the frame orientation.
+// FABRIK crawls towards a nearly straight chain, so limbs that do not converge within the budget are counted, not compared
+bool checkTwoBone(double _soften)
+{
+  LimbInputConfig config;
+  config.soften = _soften;
+  TwoBoneIKBatchBuffers in;
+  makeLimbInputs(in, 10000u, config);
+  ChainIKPose<double> pose;
+  EulerRotation<double> rotations[2];
+  double rootError = 0.0;
+  double bendError = 0.0;
+  std::size_t compared = 0u;
+  for (std::size_t i = 0u; i < in.size(); ++i)
+  {
+    const Vector3<double> target(in.targetX[i], in.targetY[i], in.targetZ[i]);
+    const Vector3<double> pole(in.poleX[i], in.poleY[i], in.poleZ[i]);
+    const double lengths[2] = {in.edgeA[i], in.edgeB[i]};
+    const auto solution = solveTwoBoneIK(target, pole, lengths[0], lengths[1], in.twist[i], in.soften[i], 0.0, kOrientationFrame);
+    const auto result = solveChainIK(target, pole, lengths, 2u, in.twist[i], in.soften[i], 1000u, 1e-12, kChainIKFABRIK, pose, rotations);
+    if (!(result.error <= 1e-12)) continue;
+    ++compared;
+    rootError = std::max(rootError, rotationError(rotations[0], solution.orientation));
+    // The elbow only bends about its local Z
+    bendError = std::max(bendError, rotationError(rotations[1], EulerRotation<double>(0.0, 0.0, solution.bendAngle)));
+  }
+  // Softening leaves many limbs nearly straight, but at least half must converge
+  const bool ok = rootError <= 1e-6 && bendError <= 1e-6 && compared * 2u >= in.size();
+  std::printf("{\"benchmark\":\"chain.twoBoneIK.match\",\"soften\":%s,\"limbs\":%zu,\"compared\":%zu,\"root_error\":%.3g,\"bend_error\":%.3g,\"bound\":1e-06,\"ok\":%s}\n",
+      jsonBool(_soften > 0.0).c_str(), in.size(), compared, rootError, bendError, jsonBool(ok).c_str());
+  std::fflush(stdout);
+  if (!ok) std::fprintf(stderr, "two bone chain differs from solveTwoBoneIK by %.3g at the root and %.3g at the elbow over %zu limbs\n",
+      rootError, bendError, compared);
+  return ok;
+}
+
+struct ChainInputs
+{
+  std::size_t bones = 0u;
+  std::vector<double> lengths;
+  std::vector<Vector3<double>> targets;
+  std::vector<Vector3<double>> poles;
+  std::vector<double> twists;
+  // Whether the target is within the reach of the chain, a chain with one long bone has a minimum reach
+  std::vector<bool> reachable;
+
+  const double* chainLengths(std::size_t _chain) const { return lengths.data() + _chain * bones; }
+};
+
+void makeChainInputs(ChainInputs& o_inputs, std::size_t _bones)
+{
+  std::mt19937_64 rng(_bones);
+  std::uniform_real_distribution<double> unit(-1.0, 1.0);
+  std::uniform_real_distribution<double> length(0.5, 2.0);
+  std::uniform_real_distribution<double> reach(0.2, 1.2);
+  o_inputs.bones = _bones;
+  o_inputs.lengths.resize(kChainCount * _bones);
+  for (auto& l : o_inputs.lengths) l = length(rng);
+  for (std::size_t i = 0u; i < kChainCount; ++i)
+  {
+    const auto* lengths = o_inputs.chainLengths(i);
+    double total = 0.0;
+    double longest = 0.0;
+    for (std::size_t b = 0u; b < _bones; ++b)
+    {
+      total += lengths[b];
+      longest = std::max(longest, lengths[b]);
+    }
+    const Vector3<double> direction = Vector3<double>(unit(rng), unit(rng), unit(rng)).normal();
+    const double distance = reach(rng) * total;
+    o_inputs.targets.push_back(direction * distance);
+    o_inputs.poles.push_back(Vector3<double>(unit(rng), unit(rng), unit(rng)) * 3.0);
+    o_inputs.twists.push_back(unit(rng) * 0.5);
+    o_inputs.reachable.push_back(distance <= total && distance >= 2.0 * longest - total);
+  }
+}
+
+struct ChainStats
+{
+  double meanIterations = 0.0;
+  std::size_t reachable = 0u;
+  // Reachable targets met within the tolerance and iteration budget
+  std::size_t reached = 0u;
+  double maxLengthError = 0.0;
+};
+
+ChainStats solveChains(const ChainInputs& _in, ChainIKMethod _method)
+{
+  ChainIKPose<double> pose;
+  std::vector<EulerRotation<double>> rotations(_in.bones);
+  ChainStats stats;
+  for (std::size_t i = 0u; i < kChainCount; ++i)
+  {
+    const auto* lengths = _in.chainLengths(i);
+    const auto result = solveChainIK(
+        _in.targets[i], _in.poles[i], lengths, _in.bones, _in.twists[i], 0.0, kMaxIterations, kTolerance, _method, pose, rotations.data());
+    stats.meanIterations += result.iterations;
+    if (_in.reachable[i])
+    {
+      ++stats.reachable;
+      stats.reached += result.error <= kTolerance;
+    }
+    for (std::size_t b = 0u; b < _in.bones; ++b)
+    {
+      const double drift = std::abs((pose.joint(b + 1u) - pose.joint(b)).length() - lengths[b]);
+      stats.maxLengthError = std::max(stats.maxLengthError, drift == drift ? drift : HUGE_VAL);
+    }
+  }
+  stats.meanIterations /= double(kChainCount);
+  return stats;
+}
+
+bool benchChain(const BenchOptions& _options, std::size_t _joints)
+{
+  ChainInputs in;
+  makeChainInputs(in, _joints - 1u);
+  bool ok = true;
+  for (auto method : {kChainIKFABRIK, kChainIKCCD})
+  {
+    const char* methodName = method == kChainIKCCD ? "ccd" : "fabrik";
+    const auto stats = solveChains(in, method);
+    // Every reachable target is met, nearly straight and folded up ones included
+    const bool methodOk = stats.maxLengthError <= 1e-9 && stats.reached == stats.reachable;
+    std::printf("{\"benchmark\":\"chain.solve.check\",\"joints\":%zu,\"method\":%s,\"max_iterations\":%u,\"mean_iterations\":%.2f,"
+        "\"reachable\":%zu,\"reached\":%zu,\"max_length_error\":%.3g,\"ok\":%s}\n",
+        _joints, jsonString(methodName).c_str(), kMaxIterations, stats.meanIterations, stats.reachable, stats.reached, stats.maxLengthError,
+        jsonBool(methodOk).c_str());
+    std::fflush(stdout);
+    if (!methodOk) std::fprintf(stderr, "%zu joint %s chain reached %zu of %zu targets and changed a bone by %.3g\n",
+        _joints, methodName, stats.reached, stats.reachable, stats.maxLengthError);
+    ok = ok && methodOk;
+
+    ChainIKPose<double> pose;
+    std::vector<EulerRotation<double>> rotations(in.bones);
+    const BenchTags tags = {{"joints", std::to_string(_joints)}, {"method", jsonString(methodName)}};
+    runBench(_options, "chain.solve", tags, kChainCount, [&]
+    {
+      for (std::size_t i = 0u; i < kChainCount; ++i)
+      {
+        doNotOptimize(solveChainIK(
+            in.targets[i], in.poles[i], in.chainLengths(i), in.bones, in.twists[i], 0.0, kMaxIterations, kTolerance, method, pose, rotations.data()));
+      }
+    });
+  }
+  return ok;
+}
+
+
+// Control points of a wavy curve about the X axis
+std::vector<Vector3<double>> splineControlPoints(std::size_t _count)
+{
+  std::vector<Vector3<double>> points(_count);
+  for (std::size_t i = 0u; i < _count; ++i) points[i] = Vector3<double>(double(i), std::sin(double(i)), 0.5 * std::cos(0.7 * double(i)));
+  return points;
+}
+
+// Arc length from the curve start to parameter _u by dense chords, far finer than the table
+double splineArcLength(const std::vector<Vector3<double>>& _points, double _u)
+{
+  static constexpr std::size_t kSteps = 200000u;
+  double length = 0.0;
+  auto previous = splineIKPoint(_points.data(), _points.size(), 0.0);
+  for (std::size_t i = 1u; i <= kSteps; ++i)
+  {
+    const auto point = splineIKPoint(_points.data(), _points.size(), _u * double(i) / double(kSteps));
+    length += (point - previous).length();
+    previous = point;
+  }
+  return length;
+}
+
+bool checkSpline()
+{
+  const auto points = splineControlPoints(8u);
+  SplineIKArcLengthTable<double> table;
+  table.build(points.data(), points.size());
+  const std::vector<double> lengths(16u, table.totalLength() / 16.0);
+  ChainIKPose<double> pose;
+  std::vector<double> stretchedLengths(lengths.size());
+  std::vector<EulerRotation<double>> rotations(lengths.size());
+  solveSplineIK(points.data(), points.size(), table, lengths.data(), lengths.size(), Vector3<double>(0.0, 1.0, 0.0), 0.0, 0.0, 1.0, 0.0,
+      pose, stretchedLengths.data(), rotations.data());
+
+  // Joints are compared by arc length, found from the parameter the table gives each one
+  double maxError = std::abs(splineArcLength(points, double(points.size() - 1u)) - table.totalLength());
+  double arcLength = 0.0;
+  std::size_t sample = 0u;
+  for (std::size_t j = 1u; j < lengths.size(); ++j)
+  {
+    arcLength += stretchedLengths[j - 1u];
+    while (table.length[sample + 1u] < arcLength) ++sample;
+    const double f = (arcLength - table.length[sample]) / (table.length[sample + 1u] - table.length[sample]);
+    const double u = table.param[sample] + f * (table.param[sample + 1u] - table.param[sample]);
+    if (!((splineIKPoint(points.data(), points.size(), u) - pose.joint(j)).length() <= 1e-12)) maxError = HUGE_VAL;
+    maxError = std::max(maxError, std::abs(splineArcLength(points, u) - arcLength));
+  }
+  const bool ok = maxError <= 1e-3 * table.totalLength() / double(points.size() - 1u);
+  std::printf("{\"benchmark\":\"spline.arcLength.check\",\"control_points\":%zu,\"samples_per_segment\":%u,\"curve_length\":%.6g,"
+      "\"max_arc_length_error\":%.3g,\"ok\":%s}\n",
+      points.size(), kSplineIKSamplesPerSegment, table.totalLength(), maxError, jsonBool(ok).c_str());
+  std::fflush(stdout);
+  if (!ok) std::fprintf(stderr, "spline joints are off their arc lengths by %.3g\n", maxError);
+  return ok;
+}
+
+void benchSpline(const BenchOptions& _options, std::size_t _joints)
+{
+  const auto points = splineControlPoints(8u);
+  SplineIKArcLengthTable<double> table;
+  table.build(points.data(), points.size());
+  // A chain a little shorter than the curve, stretched to its length
+  const std::vector<double> lengths(_joints - 1u, 0.9 * table.totalLength() / double(_joints - 1u));
+  ChainIKPose<double> pose;
+  std::vector<double> stretchedLengths(lengths.size());
+  std::vector<EulerRotation<double>> rotations(lengths.size());
+  const BenchTags tags = {{"joints", std::to_string(_joints)}, {"control_points", std::to_string(points.size())}};
+  runBench(_options, "spline.solve", tags, 1u, [&]
+  {
+    solveSplineIK(points.data(), points.size(), table, lengths.data(), lengths.size(), Vector3<double>(0.0, 1.0, 0.0), 0.0, 0.5, 1.0, 0.0,
+        pose, stretchedLengths.data(), rotations.data());
+    doNotOptimize(rotations[0]);
+  });
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  const auto options = BenchOptions::parse(argc, argv);
+  bool ok = checkTwoBone(0.0) && checkTwoBone(0.2);
+  for (std::size_t joints : {std::size_t(4), std::size_t(8), std::size_t(32)})
+  {
+    ok = benchChain(options, joints) && ok;
+  }
+
+  ok = checkSpline() && ok;
+  const auto points = splineControlPoints(8u);
+  SplineIKArcLengthTable<double> table;
+  runBench(options, "spline.table.build", {{"control_points", std::to_string(points.size())}}, 1u, [&]
+  {
+    table.build(points.data(), points.size());
+    doNotOptimize(table.length.back());
+  });
+  for (std::size_t joints : {std::size_t(4), std::size_t(8), std::size_t(32)}) benchSpline(options, joints);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,296 @@
+#include "Bench.h"
+#include "BenchInputs.h"
+#include "MockHarness.h"
+#include <fstream>
+#include <map>
+#include <memory>
+
+// A representative scene of node computes, the training workload of the profile guided build and its benchmark.
+// Unlike NodeBench this is built apart from src/Plugin.cpp, which is compiled on its own against the maya stand-in,
+// so "make pgo" can train the plugin translation unit and rebuild it with the profile and link time optimization.
+// Every frame animates the targets and pulls the outputs a rig would connect, over every precision tier,
+// orientation method and soften and stretch combination of the two bone node, plus the array, chain and spline nodes.
+// "--speedup <baseline> <optimized>" runs nothing and compares the output of two builds, which may each hold several runs,
+// the best median of each benchmark is taken so interleaved runs cancel out noise from the rest of the machine.
+
+MStatus initializePlugin(MObject _pluginObj);
+
+namespace
+{
+
+static const std::string kPrefix = NODE_NAME_PREFIX;
+static constexpr std::size_t kTwoBoneIKNodes = 192u;
+static constexpr std::size_t kInclineAngleNodes = 32u;
+static constexpr std::size_t kArrayLimbs = 256u;
+
+// A node with the attributes the frames drive and pull resolved up front, so the frames time the computes rather than
+// the harness looking attributes up by name
+struct WorkloadNode
+{
+  WorkloadNode(const std::string& _type, const std::string& _name, const char* _input, const char* _output)
+    : harness(new MockNodeHarness(kPrefix + _type, _name)), input(harness->attribute(_input)), output(harness->attribute(_output))
+  {}
+
+  template <typename TType>
+  void set(const TType& _value)
+  {
+    harness->dataBlock().inputValue(input).set(_value);
+  }
+
+  template <typename TType>
+  void setArray(const std::vector<TType>& _values)
+  {
+    setAttribute(harness->dataBlock(), input, _values);
+  }
+
+  void pull()
+  {
+    auto& node = harness->node();
+    node.compute(MPlug(node.thisMObject(), output), harness->dataBlock());
+  }
+
+  std::unique_ptr<MockNodeHarness> harness;
+  Attribute input;
+  Attribute output;
+};
+
+class ComputeWorkload
+{
+public:
+  ComputeWorkload()
+  {
+    makeLimbInputs(m_limbs, kTwoBoneIKNodes, LimbInputConfig());
+    for (std::size_t i = 0u; i < kTwoBoneIKNodes; ++i)
+    {
+      WorkloadNode workloadNode("twoBoneIK", "twoBoneIK" + std::to_string(i), "targetLocation", "bendAngle");
+      auto& node = workloadNode.harness;
+      node->set("poleVector", MVector(m_limbs.poleX[i], m_limbs.poleY[i], m_limbs.poleZ[i]));
+      node->set("staticEdgeA", m_limbs.edgeA[i]);
+      node->set("staticEdgeB", m_limbs.edgeB[i]);
+      // Every combination of the features the solve specializes on, tier and orientation method
+      node->set("twist", MAngle(i & 1u ? m_limbs.twist[i] : 0.0));
+      node->set("soften", 0.2);
+      node->set("doSoften", (i & 2u) != 0u);
+      node->set("stretchStrength", i & 4u ? 0.5 : 0.0);
+      node->set("precision", short(i / 8u % 3u));
+      node->set("orientationMethod", short(i / 24u % 2u));
+      node->set("cacheSolve", i % 48u == 47u);
+      // Most rigs drive joints from the euler output, some take the matrix or quaternion
+      node->connect("bendAngle");
+      node->connect(i % 16u == 15u ? "orientationMatrix" : i % 16u == 14u ? "orientationQuaternion" : "orientation");
+      node->connect("stretchedEdgeA");
+      node->connect("stretchedEdgeB");
+      m_twoBoneIK.push_back(std::move(workloadNode));
+    }
+    for (std::size_t i = 0u; i < kInclineAngleNodes; ++i)
+    {
+      WorkloadNode workloadNode("inclineAngle", "inclineAngle" + std::to_string(i), "targetLocation", "inclineAngle");
+      auto& node = workloadNode.harness;
+      node->set("staticEdgeA", m_limbs.edgeA[i]);
+      node->set("staticEdgeB", m_limbs.edgeB[i]);
+      node->set("soften", 0.2);
+      node->set("doSoften", (i & 1u) != 0u);
+      node->set("precision", short(i % 3u));
+      m_inclineAngle.push_back(std::move(workloadNode));
+    }
+
+    TwoBoneIKBatchBuffers arrayLimbs;
+    makeLimbInputs(arrayLimbs, kArrayLimbs, LimbInputConfig());
+    m_array.reset(new WorkloadNode("twoBoneIKArray", "twoBoneIKArray1", "targetLocation", "bendAngle"));
+    std::vector<MVector> poles;
+    std::vector<double> edgesA, edgesB, softens, stretchStrengths;
+    std::vector<MAngle> twists;
+    for (std::size_t i = 0u; i < kArrayLimbs; ++i)
+    {
+      m_arrayTargets.push_back(MVector(arrayLimbs.targetX[i], arrayLimbs.targetY[i], arrayLimbs.targetZ[i]));
+      poles.push_back(MVector(arrayLimbs.poleX[i], arrayLimbs.poleY[i], arrayLimbs.poleZ[i]));
+      edgesA.push_back(arrayLimbs.edgeA[i]);
+      edgesB.push_back(arrayLimbs.edgeB[i]);
+      twists.push_back(MAngle(arrayLimbs.twist[i]));
+      softens.push_back(0.2);
+      stretchStrengths.push_back(0.5);
+    }
+    auto& array = *m_array->harness;
+    array.setArray("targetLocation", m_arrayTargets);
+    array.setArray("poleVector", poles);
+    array.setArray("staticEdgeA", edgesA);
+    array.setArray("staticEdgeB", edgesB);
+    array.setArray("twist", twists);
+    array.setArray("soften", softens);
+    array.setArray("stretchStrength", stretchStrengths);
+
+    for (short method : {short(0), short(1)})
+    {
+      WorkloadNode workloadNode("chainIK", "chainIK" + std::to_string(method), "targetLocation", "rotations");
+      auto& node = workloadNode.harness;
+      node->set("poleVector", MVector(0.3, 1.0, -0.7));
+      node->set("soften", 0.2);
+      node->set("stretchStrength", 0.5);
+      node->set("method", method);
+      node->setArray("jointLengths", std::vector<double>{0.5, 0.6, 0.7, 0.8, 0.8, 0.7, 0.6, 0.5});
+      m_chainIK.push_back(std::move(workloadNode));
+    }
+
+    m_splineIK.reset(new WorkloadNode("splineIK", "splineIK1", "controlPoints", "rotations"));
+    m_splineIK->harness->setArray("jointLengths", std::vector<double>(8u, 0.5));
+    m_splineIK->harness->set("endTwist", MAngle(0.5));
+  }
+
+  bool isValid() const
+  {
+    bool valid = isValid(*m_array) && isValid(*m_splineIK);
+    for (const auto& node : m_twoBoneIK) valid = valid && isValid(node);
+    for (const auto& node : m_inclineAngle) valid = valid && isValid(node);
+    for (const auto& node : m_chainIK) valid = valid && isValid(node);
+    return valid;
+  }
+
+  // Each frame sweeps the targets through reach, past full extension and back, so every soften and stretch branch runs
+  void twoBoneIK()
+  {
+    const double reach = 0.6 + 0.5 * std::sin(double(m_frame) * 0.05);
+    for (std::size_t i = 0u; i < m_twoBoneIK.size(); ++i)
+    {
+      auto& node = m_twoBoneIK[i];
+      node.set(MVector(m_limbs.targetX[i], m_limbs.targetY[i], m_limbs.targetZ[i]) * reach);
+      node.pull();
+    }
+  }
+
+  void inclineAngle()
+  {
+    const double reach = 0.6 + 0.5 * std::sin(double(m_frame) * 0.05);
+    for (std::size_t i = 0u; i < m_inclineAngle.size(); ++i)
+    {
+      auto& node = m_inclineAngle[i];
+      node.set(MVector(m_limbs.targetX[i], m_limbs.targetY[i], m_limbs.targetZ[i]) * reach);
+      node.pull();
+    }
+  }
+
+  void twoBoneIKArray()
+  {
+    const MVector offset(0.1 * std::sin(double(m_frame) * 0.05), 0.0, 0.0);
+    for (auto& target : m_arrayTargets) target += offset;
+    m_array->setArray(m_arrayTargets);
+    m_array->pull();
+  }
+
+  void chainIK()
+  {
+    const double angle = double(m_frame) * 0.05;
+    for (auto& node : m_chainIK)
+    {
+      node.set(MVector(3.0 + std::sin(angle), 1.5 * std::cos(angle), 0.5));
+      node.pull();
+    }
+  }
+
+  void splineIK()
+  {
+    const double wave = 0.5 * std::sin(double(m_frame) * 0.05);
+    m_splineIK->setArray(std::vector<MVector>{
+      MVector(0.0, 0.0, 0.0), MVector(1.0, wave, 0.0), MVector(2.0, 0.0, wave), MVector(3.0, -wave, 0.0), MVector(4.0, 0.0, 0.0)});
+    m_splineIK->pull();
+  }
+
+  void frame()
+  {
+    twoBoneIK();
+    inclineAngle();
+    twoBoneIKArray();
+    chainIK();
+    splineIK();
+  }
+
+  void nextFrame() { ++m_frame; }
+
+private:
+  static bool isValid(const WorkloadNode& _node)
+  {
+    return _node.harness->isValid() && !_node.input.attr.isNull() && !_node.output.attr.isNull();
+  }
+
+  TwoBoneIKBatchBuffers m_limbs;
+  std::vector<WorkloadNode> m_twoBoneIK;
+  std::vector<WorkloadNode> m_inclineAngle;
+  std::unique_ptr<WorkloadNode> m_array;
+  std::vector<MVector> m_arrayTargets;
+  std::vector<WorkloadNode> m_chainIK;
+  std::unique_ptr<WorkloadNode> m_splineIK;
+  unsigned m_frame = 0u;
+};
+
+// The lowest median nanoseconds of each benchmark in the output of one or more runs
+std::map<std::string, double> readMedians(const std::string& _path)
+{
+  std::map<std::string, double> medians;
+  std::ifstream file(_path);
+  std::string line;
+  const std::string nameKey = "{\"benchmark\":\"", medianKey = "\"p50\":";
+  while (std::getline(file, line))
+  {
+    const auto median = line.find(medianKey);
+    if (line.compare(0u, nameKey.size(), nameKey) || median == std::string::npos) continue;
+    const auto nameEnd = line.find('"', nameKey.size());
+    const double nanoseconds = std::atof(line.c_str() + median + medianKey.size());
+    const auto inserted = medians.insert(std::make_pair(line.substr(nameKey.size(), nameEnd - nameKey.size()), nanoseconds));
+    if (!inserted.second) inserted.first->second = std::min(inserted.first->second, nanoseconds);
+  }
+  return medians;
+}
+
+int printSpeedups(const std::string& _baselinePath, const std::string& _optimizedPath)
+{
+  const auto baseline = readMedians(_baselinePath);
+  const auto optimized = readMedians(_optimizedPath);
+  if (baseline.empty() || optimized.empty())
+  {
+    std::fprintf(stderr, "no benchmarks in %s\n", (baseline.empty() ? _baselinePath : _optimizedPath).c_str());
+    return 1;
+  }
+  for (const auto& result : optimized)
+  {
+    const auto found = baseline.find(result.first);
+    if (found == baseline.end() || result.second <= 0.0) continue;
+    std::printf("{\"benchmark\":\"%s.speedup\",\"baseline_ns\":%.3f,\"ns\":%.3f,\"speedup\":%.3f}\n",
+        result.first.c_str(), found->second, result.second, found->second / result.second);
+  }
+  std::fflush(stdout);
+  return 0;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  if (argc == 4 && !std::strcmp(argv[1], "--speedup")) return printSpeedups(argv[2], argv[3]);
+  const auto options = BenchOptions::parse(argc, argv);
+  if (!initializePlugin(MObject()))
+  {
+    std::fprintf(stderr, "Plugin initialization failed\n");
+    return 1;
+  }
+  ComputeWorkload workload;
+  if (!workload.isValid())
+  {
+    std::fprintf(stderr, "a workload node type is not registered\n");
+    return 1;
+  }
+
+  auto run = [&](const char* _name, std::size_t _computes, void (ComputeWorkload::*_pass)())
+  {
+    runBench(options, _name, {{"computes", std::to_string(_computes)}}, _computes, [&]
+    {
+      (workload.*_pass)();
+      workload.nextFrame();
+    });
+  };
+  run("workload.twoBoneIK", kTwoBoneIKNodes, &ComputeWorkload::twoBoneIK);
+  run("workload.inclineAngle", kInclineAngleNodes, &ComputeWorkload::inclineAngle);
+  run("workload.twoBoneIKArray", 1u, &ComputeWorkload::twoBoneIKArray);
+  run("workload.chainIK", 2u, &ComputeWorkload::chainIK);
+  run("workload.splineIK", 1u, &ComputeWorkload::splineIK);
+  run("workload.frame", kTwoBoneIKNodes + kInclineAngleNodes + 4u, &ComputeWorkload::frame);
+  return 0;
+}
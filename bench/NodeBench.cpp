@@ -0,0 +1,1398 @@
+#include "Bench.h"
+#include "BenchInputs.h"
+#include "MockHarness.h"
+// The node headers define their type names, so they can only be included once per binary,
+// the plugin entry points are built into this translation unit to register the real nodes
+#include "../src/Plugin.cpp"
+#include "LimbStream.h"
+#include "ComputeRecorder.h"
+#include <atomic>
+#include <new>
+
+// Node compute benchmarks, these run the real node classes against the maya stand-in in mock/.
+// Each node is timed three ways, the full compute, the attribute reads and writes alone, and the solve alone,
+// so the share of a compute spent on attribute I/O can be tracked.
+// The stand-in stores attributes in plain maps, so absolute I/O costs differ from maya, the split is what matters.
+// Before timing, every node's outputs are checked against the headless core.
+
+// Every heap allocation made through operator new is counted, so the array benchmarks can report allocations per compute
+static std::atomic<unsigned long long> g_allocations{0u};
+
+// Kept out of line, gcc otherwise pairs the inlined free with the new expressions and warns of a mismatch
+__attribute__((noinline)) void* operator new(std::size_t _size)
+{
+  g_allocations.fetch_add(1u, std::memory_order_relaxed);
+  if (void* memory = std::malloc(_size ? _size : 1u)) return memory;
+  throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* _memory) noexcept { std::free(_memory); }
+__attribute__((noinline)) void operator delete(void* _memory, std::size_t) noexcept { std::free(_memory); }
+
+namespace
+{
+
+static const std::string kPrefix = NODE_NAME_PREFIX;
+static constexpr double kTolerance = 1e-9;
+// The packed solve near the fully extended and folded limits, see TwoBoneIKBatch.h
+static constexpr double kBatchTolerance = 1e-7;
+static constexpr std::size_t kArrayLimbs = 1000u;
+
+bool check(const char* _what, double _node, double _core, double _tolerance = kTolerance)
+{
+  if (std::abs(_node - _core) <= _tolerance) return true;
+  std::fprintf(stderr, "%s mismatch, node %.17g core %.17g\n", _what, _node, _core);
+  return false;
+}
+
+bool checkRotation(const char* _what, const MEulerRotation& _node, const MEulerRotation& _core, double _tolerance = kBatchTolerance)
+{
+  const auto node = _node.asMatrix();
+  const auto core = _core.asMatrix();
+  for (unsigned i = 0u; i < 3u; ++i)
+    for (unsigned j = 0u; j < 3u; ++j)
+      if (!check(_what, node[i][j], core[i][j], _tolerance)) return false;
+  return true;
+}
+
+// Turns _v about world _axis by _angle, right handed, by Rodrigues' formula rather than a rotation matrix
+MVector rotateAboutAxis(const MVector& _v, int _axis, double _angle)
+{
+  const MVector k(_axis == 0 ? 1.0 : 0.0, _axis == 1 ? 1.0 : 0.0, _axis == 2 ? 1.0 : 0.0);
+  return _v * std::cos(_angle) + (k ^ _v) * std::sin(_angle) + k * ((k * _v) * (1.0 - std::cos(_angle)));
+}
+
+// The stand-in's euler rotations against rotations applied axis by axis, in the order maya applies them, and a reorder
+// maya gives by hand, so the node checks do not rest on the stand-in sharing the core's decomposition
+bool checkMockEulerRotation()
+{
+  static const int orderAxes[6][3] = {{0, 1, 2}, {1, 2, 0}, {2, 0, 1}, {0, 2, 1}, {1, 0, 2}, {2, 1, 0}};
+  std::mt19937 random(11u);
+  std::uniform_real_distribution<double> angle(-3.1, 3.1);
+  double error = 0.0;
+  for (int order = 0; order < 6; ++order)
+  {
+    for (int i = 0; i < 50; ++i)
+    {
+      const double angles[3] = {angle(random), angle(random), angle(random)};
+      MEulerRotation rotation(angles[0], angles[1], angles[2], MEulerRotation::RotationOrder(order));
+      const auto before = rotation.asMatrix();
+      for (int to = 0; to < 6; ++to)
+      {
+        const auto reordered = rotation.reorder(MEulerRotation::RotationOrder(to)).asMatrix();
+        for (int row = 0; row < 3; ++row)
+        {
+          // Each row of the rotation matrix is where that world axis ends up
+          MVector axis(row == 0 ? 1.0 : 0.0, row == 1 ? 1.0 : 0.0, row == 2 ? 1.0 : 0.0);
+          for (int a : orderAxes[order]) axis = rotateAboutAxis(axis, a, angles[a]);
+          for (int col = 0; col < 3; ++col)
+          {
+            error = std::max({error, std::abs(before[row][col] - (&axis.x)[col]), std::abs(reordered[row][col] - (&axis.x)[col])});
+          }
+        }
+      }
+    }
+  }
+  // A quarter turn about x then z is a quarter turn about z then y in zxy order
+  const auto known = MEulerRotation(M_PI / 2.0, 0.0, M_PI / 2.0).reorder(MEulerRotation::kZXY);
+  error = std::max({error, std::abs(known.x), std::abs(known.y - M_PI / 2.0), std::abs(known.z - M_PI / 2.0)});
+  const bool ok = error <= kTolerance;
+  std::printf("{\"check\":\"mock.eulerRotation\",\"max_error\":%.3g,\"ok\":%s}\n", error, jsonBool(ok).c_str());
+  std::fflush(stdout);
+  return ok;
+}
+
+void printBreakdown(const std::string& _name, const BenchResult& _compute, const BenchResult& _io, const BenchResult& _solve)
+{
+  if (_compute.p50 <= 0.0 || _io.p50 <= 0.0 || _solve.p50 <= 0.0) return;
+  std::printf("{\"benchmark\":%s,\"compute_ns\":%.3f,\"attribute_io_ns\":%.3f,\"solve_ns\":%.3f,\"attribute_io_fraction\":%.3f}\n",
+      jsonString(_name).c_str(), _compute.p50, _io.p50, _solve.p50, _io.p50 / _compute.p50);
+  std::fflush(stdout);
+}
+
+struct LimbInput
+{
+  MVector target;
+  MVector pole;
+  double edgeA;
+  double edgeB;
+  double twist;
+};
+
+LimbInput limbInput(const TwoBoneIKBatchBuffers& _in, std::size_t _i)
+{
+  return {
+    MVector(_in.targetX[_i], _in.targetY[_i], _in.targetZ[_i]),
+    MVector(_in.poleX[_i], _in.poleY[_i], _in.poleZ[_i]),
+    _in.edgeA[_i], _in.edgeB[_i], _in.twist[_i]
+  };
+}
+
+bool benchTwoBoneIK(const BenchOptions& _options, const LimbInput& _limb)
+{
+  MockNodeHarness harness(kPrefix + "twoBoneIK", "twoBoneIK1");
+  harness.set("targetLocation", _limb.target);
+  harness.set("poleVector", _limb.pole);
+  harness.set("staticEdgeA", _limb.edgeA);
+  harness.set("staticEdgeB", _limb.edgeB);
+  harness.set("twist", MAngle(_limb.twist));
+  harness.set("soften", 0.2);
+  harness.set("stretchStrength", 0.5);
+
+  // Every output is pulled, and a plug that is not an output is rejected
+  const char* outputs[] = {"bendAngle", "orientation", "orientationQuaternion", "orientationMatrix", "stretchedEdgeA"};
+  bool computed = harness.compute("targetLocation") == MS::kUnknownParameter;
+  for (const auto output : outputs) computed = computed && harness.compute(output) == MS::kSuccess;
+  if (!computed)
+  {
+    std::fprintf(stderr, "twoBoneIK compute returned an unexpected status\n");
+    return false;
+  }
+  const auto solution = solveTwoBoneIK(toVector3(_limb.target), toVector3(_limb.pole), _limb.edgeA, _limb.edgeB, _limb.twist, 0.2, 0.5);
+  const auto orientation = harness.getEuler("orientation");
+  const bool ok =
+    check("twoBoneIK.bendAngle", harness.get<MAngle>("bendAngle").asRadians(), solution.bendAngle) &
+    check("twoBoneIK.orientationX", orientation.x, solution.orientation.x) &
+    check("twoBoneIK.orientationY", orientation.y, solution.orientation.y) &
+    check("twoBoneIK.orientationZ", orientation.z, solution.orientation.z) &
+    check("twoBoneIK.stretchedEdgeA", harness.get<double>("stretchedEdgeA"), solution.stretchedEdgeA) &
+    check("twoBoneIK.stretchedEdgeB", harness.get<double>("stretchedEdgeB"), solution.stretchedEdgeB);
+  if (!ok) return false;
+  // The quaternion and matrix outputs describe the same rotation as the euler output
+  const auto eulerMatrix = solution.orientation.asMatrix();
+  const auto matrix = harness.get<MMatrix>("orientationMatrix");
+  const auto quaternion = harness.get<MQuaternion>("orientationQuaternion");
+  const auto quaternionMatrix = Quaternion<double>(quaternion.x, quaternion.y, quaternion.z, quaternion.w).asMatrix();
+  bool rotationsOk = true;
+  for (unsigned i = 0u; i < 3u; ++i)
+    for (unsigned j = 0u; j < 3u; ++j)
+    {
+      rotationsOk = rotationsOk &&
+        check("twoBoneIK.orientationMatrix", matrix[i][j], eulerMatrix[i][j]) &&
+        check("twoBoneIK.orientationQuaternion", quaternionMatrix[i][j], eulerMatrix[i][j]);
+    }
+  if (!rotationsOk) return false;
+
+  // Each output on its own, as in a partial pull of an unconnected node
+  for (const auto output : outputs)
+  {
+    runBench(_options, std::string("node.twoBoneIK.compute.") + output, {}, 1u, [&]
+    {
+      harness.compute(output);
+    });
+  }
+  // With every output connected the first pull solves every dirty one, a change to the stretch alone leaves the
+  // orientation clean, so pulling a stretched edge then skips the euler composition
+  for (const auto output : {"bendAngle", "orientation", "stretchedEdgeA", "stretchedEdgeB"}) harness.connect(output);
+  auto& registry = MockRegistry::instance();
+  const auto pullSolvesOrientation = [&]()
+  {
+    registry.profilerEvents.clear();
+    registry.profiling = true;
+    harness.compute("stretchedEdgeA");
+    registry.profiling = false;
+    return std::any_of(registry.profilerEvents.begin(), registry.profilerEvents.end(), [](const std::pair<int, std::string>& _event)
+    {
+      return _event.second == ComputePhaseScope::name(kPhaseEulerReorder);
+    });
+  };
+  harness.set("targetLocation", _limb.target);
+  const bool afterTarget = pullSolvesOrientation();
+  harness.set("stretchStrength", 0.5);
+  const bool dirtyOnly = afterTarget && !pullSolvesOrientation();
+  std::printf("{\"check\":\"twoBoneIK.connectedDirtyOutputs\",\"ok\":%s}\n", jsonBool(dirtyOnly).c_str());
+  if (!dirtyOnly)
+  {
+    std::fprintf(stderr, "pulling a stretched edge after a stretch change solved the connected orientation again\n");
+    return false;
+  }
+  // Every output dirty at each pull, as when the target moves every frame
+  const auto compute = runBench(_options, "node.twoBoneIK.compute", {}, 1u, [&]
+  {
+    MockNodeHarness::dirtyAll();
+    harness.compute("bendAngle");
+  });
+  // Connecting the matrix in place of the euler rotation skips the euler composition
+  harness.disconnect("orientation");
+  harness.connect("orientationMatrix");
+  runBench(_options, "node.twoBoneIK.compute.matrixConnected", {}, 1u, [&]
+  {
+    MockNodeHarness::dirtyAll();
+    harness.compute("bendAngle");
+  });
+  harness.disconnect("orientationMatrix");
+  harness.connect("orientation");
+  // The same attribute traffic as the compute, without the solve
+  const auto target = harness.attribute("targetLocation");
+  const auto pole = harness.attribute("poleVector");
+  const auto edgeA = harness.attribute("staticEdgeA");
+  const auto edgeB = harness.attribute("staticEdgeB");
+  const auto twist = harness.attribute("twist");
+  const auto soften = harness.attribute("soften");
+  const auto doSoften = harness.attribute("doSoften");
+  const auto stretchStrength = harness.attribute("stretchStrength");
+  const auto bendAngle = harness.attribute("bendAngle");
+  const auto outOrientation = harness.attribute("orientation");
+  const auto stretchedEdgeA = harness.attribute("stretchedEdgeA");
+  const auto stretchedEdgeB = harness.attribute("stretchedEdgeB");
+  const auto io = runBench(_options, "node.twoBoneIK.attributeIO", {}, 1u, [&]
+  {
+    AttributeData ad(harness.dataBlock());
+    doNotOptimize(ad.get<double>(soften) * ad.get<bool>(doSoften));
+    doNotOptimize(ad.get<MVector>(target));
+    doNotOptimize(ad.get<MVector>(pole));
+    doNotOptimize(ad.get<double>(edgeA));
+    doNotOptimize(ad.get<double>(edgeB));
+    doNotOptimize(ad.get<MAngle>(twist));
+    doNotOptimize(ad.get<double>(stretchStrength));
+    ad.set(bendAngle, MAngle(solution.bendAngle));
+    ad.set(outOrientation, toMEulerRotation(solution.orientation));
+    ad.set(stretchedEdgeA, solution.stretchedEdgeA);
+    ad.set(stretchedEdgeB, solution.stretchedEdgeB);
+  });
+  const auto solve = runBench(_options, "node.twoBoneIK.solve", {}, 1u, [&]
+  {
+    doNotOptimize(solveTwoBoneIK(toVector3(_limb.target), toVector3(_limb.pole), _limb.edgeA, _limb.edgeB, _limb.twist, 0.2, 0.5));
+  });
+  printBreakdown("node.twoBoneIK.breakdown", compute, io, solve);
+
+  // With the solve cache on, unchanged inputs only cost the attribute reads and writes
+  harness.set("cacheSolve", true);
+  harness.compute("bendAngle");
+  runBench(_options, "node.twoBoneIK.compute.cached", {}, 1u, [&]
+  {
+    harness.compute("bendAngle");
+  });
+  const auto stats = static_cast<twoBoneIK&>(harness.node()).solveCacheStats();
+  if (stats.misses != 1u)
+  {
+    std::fprintf(stderr, "twoBoneIK solve cache missed %llu times for unchanged inputs\n", stats.misses);
+    return false;
+  }
+  // A changed input must miss and solve again
+  harness.set("twist", MAngle(_limb.twist + 0.5));
+  harness.compute("bendAngle");
+  const auto uncached = solveTwoBoneIK(toVector3(_limb.target), toVector3(_limb.pole), _limb.edgeA, _limb.edgeB, _limb.twist + 0.5, 0.2, 0.5);
+  if (!check("twoBoneIK.cached.orientationX", harness.getEuler("orientation").x, uncached.orientation.x)) return false;
+  harness.set("cacheSolve", false);
+
+  // The approximate tiers give the same angles as the core solved with the same math policy
+  const struct { const char* name; short precision; TwoBoneIKSolution<double> solution; } tiers[] = {
+    {"high", short(kPrecisionHigh), solveTwoBoneIK<double, HighMath>(toVector3(_limb.target), toVector3(_limb.pole), _limb.edgeA, _limb.edgeB, _limb.twist + 0.5, 0.2, 0.5)},
+    {"fast", short(kPrecisionFast), solveTwoBoneIK<double, FastMath>(toVector3(_limb.target), toVector3(_limb.pole), _limb.edgeA, _limb.edgeB, _limb.twist + 0.5, 0.2, 0.5)}
+  };
+  for (const auto& tier : tiers)
+  {
+    harness.set("precision", tier.precision);
+    harness.compute("bendAngle");
+    const auto tierOrientation = harness.getEuler("orientation");
+    const bool tierOk =
+      check("twoBoneIK.precision.bendAngle", harness.get<MAngle>("bendAngle").asRadians(), tier.solution.bendAngle) &
+      check("twoBoneIK.precision.orientationX", tierOrientation.x, tier.solution.orientation.x) &
+      check("twoBoneIK.precision.orientationY", tierOrientation.y, tier.solution.orientation.y) &
+      check("twoBoneIK.precision.orientationZ", tierOrientation.z, tier.solution.orientation.z);
+    if (!tierOk) return false;
+    runBench(_options, std::string("node.twoBoneIK.compute.precision.") + tier.name, {}, 1u, [&]
+    {
+      harness.compute("bendAngle");
+    });
+  }
+  harness.set("precision", short(kPrecisionExact));
+
+  // The frame construction matches the angle based orientation away from degenerate poles
+  harness.set("orientationMethod", short(kOrientationFrame));
+  harness.compute("bendAngle");
+  const auto frameOrientation = harness.getEuler("orientation");
+  const auto frame = solveTwoBoneIK(
+      toVector3(_limb.target), toVector3(_limb.pole), _limb.edgeA, _limb.edgeB, _limb.twist + 0.5, 0.2, 0.5, kOrientationFrame);
+  const bool frameOk =
+    check("twoBoneIK.frame.orientationX", frameOrientation.x, frame.orientation.x) &
+    check("twoBoneIK.frame.orientationY", frameOrientation.y, frame.orientation.y) &
+    check("twoBoneIK.frame.orientationZ", frameOrientation.z, frame.orientation.z) &
+    check("twoBoneIK.frame.anglesX", frame.orientation.x, uncached.orientation.x) &
+    check("twoBoneIK.frame.anglesY", frame.orientation.y, uncached.orientation.y) &
+    check("twoBoneIK.frame.anglesZ", frame.orientation.z, uncached.orientation.z);
+  if (!frameOk) return false;
+  runBench(_options, "node.twoBoneIK.compute.frame", {}, 1u, [&]
+  {
+    harness.compute("bendAngle");
+  });
+  harness.set("orientationMethod", short(kOrientationAngles));
+  return true;
+}
+
+bool benchInclineAngle(const BenchOptions& _options, const LimbInput& _limb)
+{
+  MockNodeHarness harness(kPrefix + "inclineAngle", "inclineAngle1");
+  harness.set("targetLocation", _limb.target);
+  harness.set("staticEdgeA", _limb.edgeA);
+  harness.set("staticEdgeB", _limb.edgeB);
+  harness.set("soften", 0.2);
+
+  if (harness.compute("inclineAngle") != MS::kSuccess)
+  {
+    std::fprintf(stderr, "inclineAngle compute returned an unexpected status\n");
+    return false;
+  }
+  const auto inclineAngle = solveInclineAngle(toVector3(_limb.target), _limb.edgeA, _limb.edgeB, 0.2);
+  if (!check("inclineAngle.inclineAngle", harness.get<MAngle>("inclineAngle").asRadians(), inclineAngle)) return false;
+
+  const auto compute = runBench(_options, "node.inclineAngle.compute", {}, 1u, [&]
+  {
+    harness.compute("inclineAngle");
+  });
+  const auto target = harness.attribute("targetLocation");
+  const auto edgeA = harness.attribute("staticEdgeA");
+  const auto edgeB = harness.attribute("staticEdgeB");
+  const auto soften = harness.attribute("soften");
+  const auto doSoften = harness.attribute("doSoften");
+  const auto output = harness.attribute("inclineAngle");
+  const auto io = runBench(_options, "node.inclineAngle.attributeIO", {}, 1u, [&]
+  {
+    AttributeData ad(harness.dataBlock());
+    doNotOptimize(ad.get<double>(soften) * ad.get<bool>(doSoften));
+    doNotOptimize(ad.get<MVector>(target));
+    doNotOptimize(ad.get<double>(edgeA));
+    doNotOptimize(ad.get<double>(edgeB));
+    ad.set(output, MAngle(inclineAngle));
+  });
+  const auto solve = runBench(_options, "node.inclineAngle.solve", {}, 1u, [&]
+  {
+    doNotOptimize(solveInclineAngle(toVector3(_limb.target), _limb.edgeA, _limb.edgeB, 0.2));
+  });
+  printBreakdown("node.inclineAngle.breakdown", compute, io, solve);
+  return true;
+}
+
+// Connects one array element per limb, with a single soften and stretch element driving every limb
+void setArrayInputs(MockNodeHarness& io_harness, TwoBoneIKBatchBuffers& io_limbs)
+{
+  const auto count = io_limbs.size();
+  std::vector<MVector> targets(count), poles(count);
+  std::vector<MAngle> twists(count);
+  for (std::size_t i = 0u; i < count; ++i)
+  {
+    const auto limb = limbInput(io_limbs, i);
+    targets[i] = limb.target;
+    poles[i] = limb.pole;
+    twists[i] = MAngle(limb.twist);
+    io_limbs.soften[i] = 0.2;
+    io_limbs.stretchStrength[i] = 0.5;
+  }
+  io_harness.setArray("targetLocation", targets);
+  io_harness.setArray("poleVector", poles);
+  io_harness.setArray("staticEdgeA", io_limbs.edgeA);
+  io_harness.setArray("staticEdgeB", io_limbs.edgeB);
+  io_harness.setArray("twist", twists);
+  io_harness.setArray("soften", std::vector<double>{0.2});
+  io_harness.setArray("stretchStrength", std::vector<double>{0.5});
+}
+
+bool benchTwoBoneIKArray(const BenchOptions& _options, TwoBoneIKBatchBuffers& io_limbs)
+{
+  const auto count = io_limbs.size();
+  MockNodeHarness harness(kPrefix + "twoBoneIKArray", "twoBoneIKArray1");
+  setArrayInputs(harness, io_limbs);
+
+  if (harness.compute("orientation") != MS::kSuccess)
+  {
+    std::fprintf(stderr, "twoBoneIKArray compute returned an unexpected status\n");
+    return false;
+  }
+  const auto bendAngles = harness.get<std::vector<MAngle>>("bendAngle");
+  const auto orientations = harness.getEulerArray("orientation");
+  const auto stretchedEdgesA = harness.get<std::vector<double>>("stretchedEdgeA");
+  if (bendAngles.size() != count || orientations.size() != count || stretchedEdgesA.size() != count)
+  {
+    std::fprintf(stderr, "twoBoneIKArray produced the wrong number of elements\n");
+    return false;
+  }
+  BatchDispatch::kernels().solveTwoBoneIK(io_limbs.view(), count);
+  bool ok = true;
+  for (std::size_t i = 0u; i < count && ok; ++i)
+  {
+    ok = check("twoBoneIKArray.bendAngle", bendAngles[i].asRadians(), io_limbs.bendAngle[i]) &
+      check("twoBoneIKArray.orientationX", orientations[i].x, io_limbs.orientationX[i]) &
+      check("twoBoneIKArray.stretchedEdgeA", stretchedEdgesA[i], io_limbs.stretchedEdgeA[i]);
+  }
+  if (!ok) return false;
+
+  const BenchTags tags = {{"limbs", std::to_string(count)}};
+  const auto compute = runBench(_options, "node.twoBoneIKArray.compute", tags, count, [&]
+  {
+    harness.compute("bendAngle");
+  });
+  const auto target = harness.attribute("targetLocation");
+  const auto pole = harness.attribute("poleVector");
+  const auto edgeA = harness.attribute("staticEdgeA");
+  const auto edgeB = harness.attribute("staticEdgeB");
+  const auto twist = harness.attribute("twist");
+  const auto soften = harness.attribute("soften");
+  const auto doSoften = harness.attribute("doSoften");
+  const auto stretchStrength = harness.attribute("stretchStrength");
+  const auto bendAngle = harness.attribute("bendAngle");
+  const auto orientation = harness.attribute("orientation");
+  const auto stretchedEdgeA = harness.attribute("stretchedEdgeA");
+  const auto stretchedEdgeB = harness.attribute("stretchedEdgeB");
+  const auto io = runBench(_options, "node.twoBoneIKArray.attributeIO", tags, count, [&]
+  {
+    AttributeData ad(harness.dataBlock());
+    doNotOptimize(ad.get<std::vector<MVector>>(target));
+    doNotOptimize(ad.get<std::vector<MVector>>(pole));
+    doNotOptimize(ad.get<std::vector<double>>(edgeA));
+    doNotOptimize(ad.get<std::vector<double>>(edgeB));
+    doNotOptimize(ad.get<std::vector<MAngle>>(twist));
+    doNotOptimize(ad.get<std::vector<double>>(soften));
+    doNotOptimize(ad.get<std::vector<double>>(stretchStrength));
+    doNotOptimize(ad.get<bool>(doSoften));
+    ad.set(bendAngle, bendAngles);
+    ad.set(orientation, orientations);
+    ad.set(stretchedEdgeA, io_limbs.stretchedEdgeA);
+    ad.set(stretchedEdgeB, io_limbs.stretchedEdgeB);
+  });
+  const auto batch = io_limbs.view();
+  const auto solve = runBench(_options, "node.twoBoneIKArray.solve", tags, count, [&]
+  {
+    BatchDispatch::kernels().solveTwoBoneIK(batch, count);
+    doNotOptimize(batch.bendAngle[0]);
+  });
+  printBreakdown("node.twoBoneIKArray.breakdown", compute, io, solve);
+  return true;
+}
+
+// Motion blur samples of one limb, the target moves along a short arc and the pole drifts with it
+bool benchTwoBoneIKSamples(const BenchOptions& _options, const LimbInput& _limb)
+{
+  static constexpr std::size_t kSamples = 5u;
+  std::vector<MVector> targets(kSamples), poles(kSamples);
+  for (std::size_t i = 0u; i < kSamples; ++i)
+  {
+    const double t = double(i) / double(kSamples - 1u) - 0.5;
+    targets[i] = _limb.target + MVector(0.1 * t, 0.05 * t * t, -0.08 * t);
+    poles[i] = _limb.pole + MVector(0.0, 0.2 * t, 0.0);
+  }
+
+  MockNodeHarness samples(kPrefix + "twoBoneIK", "twoBoneIKSamples1");
+  MockNodeHarness single(kPrefix + "twoBoneIK", "twoBoneIKSingle1");
+  for (auto* harness : {&samples, &single})
+  {
+    harness->set("staticEdgeA", _limb.edgeA);
+    harness->set("staticEdgeB", _limb.edgeB);
+    harness->set("twist", MAngle(_limb.twist));
+    harness->set("soften", 0.2);
+    harness->set("stretchStrength", 0.5);
+  }
+  samples.setArray("sampleTargetLocation", targets);
+  samples.setArray("samplePoleVector", poles);
+
+  // The samples match one compute per sample at every precision and with either orientation method, the exact angles
+  // samples go through the packed solve and match to its tolerance
+  for (const short precision : {short(kPrecisionExact), short(kPrecisionHigh), short(kPrecisionFast)})
+  for (const short method : {short(kOrientationAngles), short(kOrientationFrame)})
+  {
+    samples.set("precision", precision);
+    single.set("precision", precision);
+    samples.set("orientationMethod", method);
+    single.set("orientationMethod", method);
+    if (samples.compute("sampleBendAngle") != MS::kSuccess)
+    {
+      std::fprintf(stderr, "twoBoneIK sample compute returned an unexpected status\n");
+      return false;
+    }
+    const auto bendAngles = samples.get<std::vector<MAngle>>("sampleBendAngle");
+    const auto orientations = samples.getEulerArray("sampleOrientation");
+    const auto stretchedEdgesA = samples.get<std::vector<double>>("sampleStretchedEdgeA");
+    const auto stretchedEdgesB = samples.get<std::vector<double>>("sampleStretchedEdgeB");
+    if (bendAngles.size() != kSamples || orientations.size() != kSamples || stretchedEdgesA.size() != kSamples ||
+        stretchedEdgesB.size() != kSamples)
+    {
+      std::fprintf(stderr, "twoBoneIK produced the wrong number of samples\n");
+      return false;
+    }
+    for (std::size_t i = 0u; i < kSamples; ++i)
+    {
+      single.set("targetLocation", targets[i]);
+      single.set("poleVector", poles[i]);
+      single.compute("bendAngle");
+      single.compute("orientation");
+      single.compute("stretchedEdgeA");
+      const double tolerance = precision == kPrecisionExact && method == kOrientationAngles ? kBatchTolerance : kTolerance;
+      const bool ok =
+        check("twoBoneIK.samples.bendAngle", bendAngles[i].asRadians(), single.get<MAngle>("bendAngle").asRadians(), tolerance) &
+        checkRotation("twoBoneIK.samples.orientation", orientations[i], single.getEuler("orientation"), tolerance) &
+        check("twoBoneIK.samples.stretchedEdgeA", stretchedEdgesA[i], single.get<double>("stretchedEdgeA")) &
+        check("twoBoneIK.samples.stretchedEdgeB", stretchedEdgesB[i], single.get<double>("stretchedEdgeB"));
+      if (!ok) return false;
+    }
+  }
+  for (auto* harness : {&samples, &single})
+  {
+    harness->set("precision", short(kPrecisionExact));
+    harness->set("orientationMethod", short(kOrientationAngles));
+  }
+
+  // Both are timed per sample, one compute of every sample against a compute of each output at every sample time
+  const BenchTags tags = {{"subframes", std::to_string(kSamples)}};
+  const auto sampled = runBench(_options, "node.twoBoneIK.samples.compute", tags, kSamples, [&]
+  {
+    samples.compute("sampleBendAngle");
+  });
+  const auto separate = runBench(_options, "node.twoBoneIK.samples.separateComputes", tags, kSamples, [&]
+  {
+    for (std::size_t i = 0u; i < kSamples; ++i)
+    {
+      single.set("targetLocation", targets[i]);
+      single.set("poleVector", poles[i]);
+      single.compute("bendAngle");
+      single.compute("orientation");
+      single.compute("stretchedEdgeA");
+    }
+  });
+  if (sampled.p50 > 0.0 && separate.p50 > 0.0)
+  {
+    std::printf("{\"benchmark\":\"node.twoBoneIK.samples.speedup\",\"subframes\":%zu,\"speedup\":%.3f}\n", kSamples, separate.p50 / sampled.p50);
+    std::fflush(stdout);
+  }
+  return true;
+}
+
+// Mean heap allocations of one call, once a first call has grown any buffers the call keeps
+template <typename TFunction>
+double allocationsPerCall(TFunction&& _function)
+{
+  static constexpr unsigned kCalls = 16u;
+  _function();
+  const auto before = g_allocations.load(std::memory_order_relaxed);
+  for (unsigned i = 0u; i < kCalls; ++i) _function();
+  return double(g_allocations.load(std::memory_order_relaxed) - before) / kCalls;
+}
+
+// An array write through a new builder every time, as setAttribute did before arrays were updated in place
+void setArrayRebuilt(MDataBlock& io_dataBlock, const Attribute& _attribute, const std::vector<MEulerRotation>& _values)
+{
+  MArrayDataHandle handle = io_dataBlock.outputArrayValue(_attribute);
+  MArrayDataBuilder builder(_attribute, unsigned(_values.size()));
+  for (const auto& value : _values) setElement(builder.addLast(), _attribute, value);
+  handle.set(builder);
+  handle.setAllClean();
+}
+
+// Allocations and time of 10k element array reads and writes, into new vectors and through new builders against
+// reused buffers and updates in place, then the allocations of a twoBoneIKArray compute of as many limbs
+bool benchArrayAttributeIO(const BenchOptions& _options)
+{
+  static constexpr std::size_t kElements = 10000u;
+  TwoBoneIKBatchBuffers limbs;
+  makeLimbInputs(limbs, kElements, LimbInputConfig());
+  MockNodeHarness harness(kPrefix + "twoBoneIKArray", "twoBoneIKArrayIO");
+  setArrayInputs(harness, limbs);
+  if (harness.compute("orientation") != MS::kSuccess)
+  {
+    std::fprintf(stderr, "twoBoneIKArray compute returned an unexpected status\n");
+    return false;
+  }
+  AttributeData ad(harness.dataBlock());
+  const auto target = harness.attribute("targetLocation");
+  const auto orientation = harness.attribute("orientation");
+  const auto orientations = harness.getEulerArray("orientation");
+
+  // Writes of the same count update the elements, other counts rebuild the array
+  std::vector<MEulerRotation> rotated(orientations);
+  for (auto& rotation : rotated) rotation.x += 1.0;
+  ad.set(orientation, rotated);
+  bool ok = harness.getEulerArray("orientation") == rotated;
+  rotated.resize(kElements / 2u);
+  ad.set(orientation, rotated);
+  ok = ok && harness.getEulerArray("orientation") == rotated;
+  ad.set(orientation, orientations);
+  ok = ok && harness.getEulerArray("orientation") == orientations;
+  // A sparse array of the same count is rebuilt rather than written over in place, so logical index i gets value i
+  {
+    auto handle = harness.dataBlock().outputArrayValue(orientation);
+    MArrayDataBuilder builder(orientation, unsigned(kElements));
+    for (unsigned i = 0u; i < kElements; ++i) setElement(builder.addElement(2u * i), orientation, MEulerRotation());
+    handle.set(builder);
+  }
+  ad.set(orientation, orientations);
+  auto written = harness.dataBlock().outputArrayValue(orientation);
+  ok = ok && harness.getEulerArray("orientation") == orientations &&
+    written.jumpToArrayElement(unsigned(kElements - 1u)) == MS::kSuccess && written.elementIndex() == kElements - 1u;
+  if (!ok)
+  {
+    std::fprintf(stderr, "an array write did not give back the values written\n");
+    return false;
+  }
+
+  std::vector<MVector> targets;
+  const double readReturned = allocationsPerCall([&] { doNotOptimize(ad.get<std::vector<MVector>>(target)); });
+  const double readBuffer = allocationsPerCall([&] { ad.get(target, targets); });
+  const double writeRebuilt = allocationsPerCall([&] { setArrayRebuilt(harness.dataBlock(), orientation, orientations); });
+  const double writeInPlace = allocationsPerCall([&] { ad.set(orientation, orientations); });
+  const double compute = allocationsPerCall([&] { harness.compute("bendAngle"); });
+  ok = targets.size() == kElements && readBuffer == 0.0 && writeInPlace == 0.0 && compute == 0.0;
+  if (!ok) std::fprintf(stderr, "steady array reads, writes or computes allocated\n");
+  std::printf("{\"check\":\"node.arrayIO.allocations\",\"elements\":%zu,\"read_returned\":%.1f,\"read_buffer\":%.1f,"
+      "\"write_rebuilt\":%.1f,\"write_in_place\":%.1f,\"twoBoneIKArray_compute\":%.1f,\"ok\":%s}\n",
+      kElements, readReturned, readBuffer, writeRebuilt, writeInPlace, compute, jsonBool(ok).c_str());
+  std::fflush(stdout);
+
+  const BenchTags tags = {{"elements", std::to_string(kElements)}};
+  runBench(_options, "node.arrayIO.read.returned", tags, kElements, [&]
+  {
+    doNotOptimize(ad.get<std::vector<MVector>>(target));
+  });
+  runBench(_options, "node.arrayIO.read.buffer", tags, kElements, [&]
+  {
+    ad.get(target, targets);
+    doNotOptimize(targets.data());
+  });
+  runBench(_options, "node.arrayIO.write.rebuilt", tags, kElements, [&]
+  {
+    setArrayRebuilt(harness.dataBlock(), orientation, orientations);
+  });
+  runBench(_options, "node.arrayIO.write.inPlace", tags, kElements, [&]
+  {
+    ad.set(orientation, orientations);
+  });
+  return ok;
+}
+
+// An 8 bone chain, checked joint by joint against the core solve
+bool benchChainIK(const BenchOptions& _options, const LimbInput& _limb)
+{
+  static constexpr std::size_t kBones = 8u;
+  const std::vector<double> lengths = {0.5, 0.6, 0.7, 0.8, 0.8, 0.7, 0.6, 0.5};
+  MockNodeHarness harness(kPrefix + "chainIK", "chainIK1");
+  harness.set("targetLocation", _limb.target);
+  harness.set("poleVector", _limb.pole);
+  harness.set("twist", MAngle(_limb.twist));
+  harness.set("soften", 0.2);
+  harness.set("stretchStrength", 0.5);
+  harness.setArray("jointLengths", lengths);
+
+  if (harness.compute("rotations") != MS::kSuccess || harness.compute("stretchedLengths") != MS::kSuccess)
+  {
+    std::fprintf(stderr, "chainIK compute returned an unexpected status\n");
+    return false;
+  }
+  const auto rotations = harness.getEulerArray("rotations");
+  const auto stretchedLengths = harness.get<std::vector<double>>("stretchedLengths");
+  if (rotations.size() != kBones || stretchedLengths.size() != kBones)
+  {
+    std::fprintf(stderr, "chainIK produced the wrong number of elements\n");
+    return false;
+  }
+  ChainIKPose<double> pose;
+  std::vector<EulerRotation<double>> coreRotations(kBones);
+  const auto result = solveChainIK(
+      toVector3(_limb.target), toVector3(_limb.pole), lengths.data(), kBones, _limb.twist, 0.2, 16u, 1e-6, kChainIKFABRIK, pose, coreRotations.data());
+  double chainLength = 0.0;
+  for (auto length : lengths) chainLength += length;
+  bool ok = check("chainIK.iterations", harness.get<int>("iterations"), result.iterations);
+  for (std::size_t i = 0u; i < kBones && ok; ++i)
+  {
+    ok = check("chainIK.rotationX", rotations[i].x, coreRotations[i].x) &
+      check("chainIK.rotationY", rotations[i].y, coreRotations[i].y) &
+      check("chainIK.rotationZ", rotations[i].z, coreRotations[i].z) &
+      check("chainIK.stretchedLength", stretchedLengths[i], stretchEdge(lengths[i], _limb.target.length(), chainLength, 0.5));
+  }
+  if (!ok) return false;
+
+  const BenchTags tags = {{"bones", std::to_string(kBones)}};
+  const auto compute = runBench(_options, "node.chainIK.compute", tags, 1u, [&]
+  {
+    harness.compute("rotations");
+  });
+  const auto target = harness.attribute("targetLocation");
+  const auto jointLengths = harness.attribute("jointLengths");
+  const auto pole = harness.attribute("poleVector");
+  const auto twist = harness.attribute("twist");
+  const auto soften = harness.attribute("soften");
+  const auto doSoften = harness.attribute("doSoften");
+  const auto maxIterations = harness.attribute("maxIterations");
+  const auto tolerance = harness.attribute("tolerance");
+  const auto method = harness.attribute("method");
+  const auto rotationsOutput = harness.attribute("rotations");
+  const auto iterations = harness.attribute("iterations");
+  const auto io = runBench(_options, "node.chainIK.attributeIO", tags, 1u, [&]
+  {
+    AttributeData ad(harness.dataBlock());
+    doNotOptimize(ad.get<std::vector<double>>(jointLengths));
+    doNotOptimize(ad.get<double>(soften) * ad.get<bool>(doSoften));
+    doNotOptimize(ad.get<MVector>(target));
+    doNotOptimize(ad.get<MVector>(pole));
+    doNotOptimize(ad.get<MAngle>(twist));
+    doNotOptimize(ad.get<int>(maxIterations));
+    doNotOptimize(ad.get<double>(tolerance));
+    doNotOptimize(ad.get<short>(method));
+    ad.set(rotationsOutput, rotations);
+    ad.set(iterations, int(result.iterations));
+  });
+  const auto solve = runBench(_options, "node.chainIK.solve", tags, 1u, [&]
+  {
+    doNotOptimize(solveChainIK(
+        toVector3(_limb.target), toVector3(_limb.pole), lengths.data(), kBones, _limb.twist, 0.2, 16u, 1e-6, kChainIKFABRIK, pose, coreRotations.data()));
+  });
+  printBreakdown("node.chainIK.breakdown", compute, io, solve);
+  return true;
+}
+
+// Playback of an animated target, with and without starting each frame from the previous frame's pose
+bool benchChainIKWarmStart(const BenchOptions& _options)
+{
+  static constexpr int kFrames = 240;
+  const std::vector<double> lengths = {0.5, 0.6, 0.7, 0.8, 0.8, 0.7, 0.6, 0.5};
+  auto targetAt = [](double _frame)
+  {
+    return MVector(3.0 + 0.5 * std::sin(_frame / 10.0), std::cos(_frame / 7.0), 0.5 * std::sin(_frame / 13.0));
+  };
+  // The default tolerance, then a looser one a rig may opt in to, warm playback should need at most a couple of
+  // iterations a frame at either
+  for (const double tolerance : {0.0, 1e-3})
+  {
+    const std::string toleranceName = tolerance > 0.0 ? "1e-3" : "default";
+    double averageIterations[2] = {};
+    for (bool warmStart : {false, true})
+    {
+      MockNodeHarness harness(kPrefix + "chainIK", warmStart ? "chainIKWarm" : "chainIKCold");
+      auto& node = static_cast<chainIK&>(harness.node());
+      harness.set("poleVector", MVector(0.0, 3.0, 0.0));
+      harness.setArray("jointLengths", lengths);
+      harness.set("warmStart", warmStart);
+      if (tolerance > 0.0) harness.set("tolerance", tolerance);
+      for (int frame = 0; frame < kFrames; ++frame)
+      {
+        harness.dataBlock().setContext(MDGContext(MTime(double(frame))));
+        harness.set("targetLocation", targetAt(frame));
+        harness.compute("rotations");
+      }
+      const auto stats = node.warmStartStats();
+      averageIterations[warmStart] = stats.averageIterations();
+      // Every frame after the first follows on from the one before
+      if (stats.solves != kFrames || stats.warmSolves != (warmStart ? kFrames - 1u : 0u))
+      {
+        std::fprintf(stderr, "chainIK warm started %llu of %llu solves\n", stats.warmSolves, stats.solves);
+        return false;
+      }
+      // The scene sees the same counts through the stats command
+      auto& registry = MockRegistry::instance();
+      char expected[128];
+      std::snprintf(expected, sizeof(expected), "{\"node\":\"%s\",\"solves\":%llu,\"warm_solves\":%llu,\"iterations\":%llu,",
+          warmStart ? "chainIKWarm" : "chainIKCold", stats.solves, stats.warmSolves, stats.iterations);
+      if (registry.executeCommand(ComputeStatsCommand::name(), {"-chainIK"}) != MS::kSuccess ||
+          registry.commandStringResult.find(std::string(",\"chainIK\":[")) == std::string::npos ||
+          registry.commandStringResult.find(expected) == std::string::npos)
+      {
+        std::fprintf(stderr, "computeStats -chainIK reported %s\n", registry.commandStringResult.c_str());
+        return false;
+      }
+      if (warmStart)
+      {
+        // A cut and a change of bones both start cold
+        harness.dataBlock().setContext(MDGContext(MTime(double(kFrames + 100))));
+        harness.compute("rotations");
+        auto longer = lengths;
+        longer.push_back(0.4);
+        harness.setArray("jointLengths", longer);
+        harness.compute("rotations");
+        if (node.warmStartStats().warmSolves != stats.warmSolves)
+        {
+          std::fprintf(stderr, "chainIK warm started across a time jump or a change of bones\n");
+          return false;
+        }
+        harness.setArray("jointLengths", lengths);
+      }
+
+      int frame = 0;
+      node.resetWarmStartStats();
+      const BenchTags tags = {{"bones", std::to_string(lengths.size())}, {"tolerance", jsonString(toleranceName)}, {"warm_start", jsonBool(warmStart)}};
+      runBench(_options, "node.chainIK.playback", tags, 1u, [&]
+      {
+        harness.dataBlock().setContext(MDGContext(MTime(double(frame))));
+        harness.set("targetLocation", targetAt(frame));
+        harness.compute("rotations");
+        frame = (frame + 1) % kFrames;
+      });
+    }
+    const bool ok = averageIterations[1] <= averageIterations[0] && averageIterations[1] <= 2.0;
+    std::printf(
+        "{\"benchmark\":\"node.chainIK.warmStart\",\"tolerance\":%s,\"frames\":%d,\"cold_iterations\":%.2f,\"warm_iterations\":%.2f,\"ok\":%s}\n",
+        jsonString(toleranceName).c_str(), kFrames, averageIterations[0], averageIterations[1], jsonBool(ok).c_str());
+    std::fflush(stdout);
+    if (!ok)
+    {
+      std::fprintf(stderr, "chainIK warm start averaged %.2f iterations against %.2f cold at the %s tolerance\n", averageIterations[1],
+          averageIterations[0], toleranceName.c_str());
+      return false;
+    }
+  }
+  return true;
+}
+
+// A spline through a few control points, checked against the core solve, then the arc length table is checked to be
+// kept across changes of everything but the control points
+bool benchSplineIK(const BenchOptions& _options)
+{
+  const std::vector<MVector> controlPoints = {MVector(0.0, 0.0, 0.0), MVector(1.0, 0.5, 0.0), MVector(2.0, 0.0, 0.5), MVector(3.0, -0.5, 0.0), MVector(4.0, 0.0, 0.0)};
+  const std::vector<double> lengths(8u, 0.5);
+  MockNodeHarness harness(kPrefix + "splineIK", "splineIK1");
+  auto& node = static_cast<splineIK&>(harness.node());
+  harness.setArray("controlPoints", controlPoints);
+  harness.setArray("jointLengths", lengths);
+  harness.set("endTwist", MAngle(0.5));
+
+  if (harness.compute("rotations") != MS::kSuccess)
+  {
+    std::fprintf(stderr, "splineIK compute returned an unexpected status\n");
+    return false;
+  }
+  const auto positions = harness.get<std::vector<MVector>>("positions");
+  const auto rotations = harness.getEulerArray("rotations");
+  const auto stretchedLengths = harness.get<std::vector<double>>("stretchedLengths");
+  if (positions.size() != lengths.size() || rotations.size() != lengths.size() || stretchedLengths.size() != lengths.size())
+  {
+    std::fprintf(stderr, "splineIK produced the wrong number of elements\n");
+    return false;
+  }
+  std::vector<Vector3<double>> points;
+  for (const auto& point : controlPoints) points.push_back(toVector3(point));
+  SplineIKArcLengthTable<double> table;
+  table.build(points.data(), points.size());
+  ChainIKPose<double> pose;
+  std::vector<double> coreLengths(lengths.size());
+  std::vector<EulerRotation<double>> coreRotations(lengths.size());
+  solveSplineIK(points.data(), points.size(), table, lengths.data(), lengths.size(), Vector3<double>(0.0, 1.0, 0.0), 0.0, 0.5, 1.0, 0.0,
+      pose, coreLengths.data(), coreRotations.data());
+  bool ok = true;
+  for (std::size_t i = 0u; i < lengths.size() && ok; ++i)
+  {
+    ok = check("splineIK.positionX", positions[i].x, pose.x[i]) &
+      check("splineIK.positionY", positions[i].y, pose.y[i]) &
+      check("splineIK.rotationX", rotations[i].x, coreRotations[i].x) &
+      check("splineIK.rotationZ", rotations[i].z, coreRotations[i].z) &
+      check("splineIK.stretchedLength", stretchedLengths[i], coreLengths[i]);
+  }
+  if (!ok) return false;
+
+  // Twist and stretch changes reuse the table, moving a control point rebuilds it
+  harness.set("startTwist", MAngle(0.2));
+  harness.set("stretchStrength", 0.5);
+  harness.compute("rotations");
+  const auto builds = node.arcLengthTableBuilds();
+  auto moved = controlPoints;
+  moved[2].y += 0.25;
+  harness.setArray("controlPoints", moved);
+  harness.compute("rotations");
+  if (builds != 1u || node.arcLengthTableBuilds() != 2u)
+  {
+    std::fprintf(stderr, "splineIK built its arc length table %llu times\n", node.arcLengthTableBuilds());
+    return false;
+  }
+
+  const BenchTags tags = {{"bones", std::to_string(lengths.size())}, {"control_points", std::to_string(controlPoints.size())}};
+  runBench(_options, "node.splineIK.compute", tags, 1u, [&]
+  {
+    harness.compute("rotations");
+  });
+  // Moving the curve every compute pays for the table as well
+  double offset = 0.0;
+  runBench(_options, "node.splineIK.computeMovingCurve", tags, 1u, [&]
+  {
+    moved[2].y = offset;
+    offset = offset > 1.0 ? 0.0 : offset + 0.01;
+    harness.setArray("controlPoints", moved);
+    harness.compute("rotations");
+  });
+  return true;
+}
+
+// Rotation matrices of two euler rotations, which agree wherever the solves do, including across the wrap and at gimbal
+bool checkLimbStreamRoundTrip(LimbStream& _stream, const std::string& _path)
+{
+  LimbStream readBack;
+  std::string error;
+  if (!writeLimbStreamInputs(_path, _stream, error) || !readLimbStreamInputs(_path, readBack, error))
+  {
+    std::fprintf(stderr, "limb stream round trip failed, %s\n", error.c_str());
+    return false;
+  }
+  std::remove(_path.c_str());
+  bool ok = readBack.size() == _stream.size() && readBack.frame == _stream.frame && readBack.limb == _stream.limb;
+  for (std::size_t c = 0u; c < kLimbStreamInputChannels && ok; ++c) ok = *readBack.channel(c) == *_stream.channel(c);
+  if (!ok) std::fprintf(stderr, "limb stream %s did not read back bit for bit\n", _path.c_str());
+  return ok;
+}
+
+// The offline batch solve of recorded limbs against the two bone ik and incline angle nodes, in every precision
+// and orientation method, and the stream files read back bit for bit
+bool benchLimbStream(const BenchOptions& _options, const TwoBoneIKBatchBuffers& _limbs)
+{
+  static constexpr std::size_t kStreamLimbs = 8u;
+  LimbStream stream;
+  stream.resize(_limbs.size());
+  auto& limbs = stream.limbs;
+  for (std::size_t i = 0u; i < _limbs.size(); ++i)
+  {
+    stream.frame[i] = std::int64_t(i / kStreamLimbs);
+    stream.limb[i] = std::int64_t(i % kStreamLimbs);
+    limbs.targetX[i] = _limbs.targetX[i];
+    limbs.targetY[i] = _limbs.targetY[i];
+    limbs.targetZ[i] = _limbs.targetZ[i];
+    limbs.poleX[i] = _limbs.poleX[i];
+    limbs.poleY[i] = _limbs.poleY[i];
+    limbs.poleZ[i] = _limbs.poleZ[i];
+    limbs.edgeA[i] = _limbs.edgeA[i];
+    limbs.edgeB[i] = _limbs.edgeB[i];
+    limbs.twist[i] = _limbs.twist[i];
+    limbs.soften[i] = 0.2;
+    limbs.stretchStrength[i] = 0.5;
+  }
+
+  MockNodeHarness twoBoneIK(kPrefix + "twoBoneIK", "twoBoneIK1");
+  MockNodeHarness inclineAngle(kPrefix + "inclineAngle", "inclineAngle1");
+  twoBoneIK.set("soften", 0.2);
+  twoBoneIK.set("stretchStrength", 0.5);
+  inclineAngle.set("soften", 0.2);
+  static constexpr std::size_t kCheckedRows = 64u;
+  bool ok = true;
+  for (const auto precision : {kPrecisionExact, kPrecisionHigh, kPrecisionFast})
+  {
+    for (const auto method : {kOrientationAngles, kOrientationFrame})
+    {
+      solveLimbStream(stream, ThreadPool::shared(), precision, method);
+      twoBoneIK.set("precision", short(precision));
+      twoBoneIK.set("orientationMethod", short(method));
+      inclineAngle.set("precision", short(precision));
+      for (std::size_t i = 0u; i < kCheckedRows && ok; ++i)
+      {
+        const MVector target(limbs.targetX[i], limbs.targetY[i], limbs.targetZ[i]);
+        twoBoneIK.set("targetLocation", target);
+        twoBoneIK.set("poleVector", MVector(limbs.poleX[i], limbs.poleY[i], limbs.poleZ[i]));
+        twoBoneIK.set("staticEdgeA", limbs.edgeA[i]);
+        twoBoneIK.set("staticEdgeB", limbs.edgeB[i]);
+        twoBoneIK.set("twist", MAngle(limbs.twist[i]));
+        inclineAngle.set("targetLocation", target);
+        inclineAngle.set("staticEdgeA", limbs.edgeA[i]);
+        inclineAngle.set("staticEdgeB", limbs.edgeB[i]);
+        twoBoneIK.compute("bendAngle");
+        twoBoneIK.compute("orientation");
+        twoBoneIK.compute("stretchedEdgeA");
+        inclineAngle.compute("inclineAngle");
+        const auto orientation = twoBoneIK.getEuler("orientation");
+        ok =
+          check("limbStream.bendAngle", twoBoneIK.get<MAngle>("bendAngle").asRadians(), limbs.bendAngle[i]) &
+          check("limbStream.orientationX", orientation.x, limbs.orientationX[i]) &
+          check("limbStream.orientationY", orientation.y, limbs.orientationY[i]) &
+          check("limbStream.orientationZ", orientation.z, limbs.orientationZ[i]) &
+          check("limbStream.stretchedEdgeA", twoBoneIK.get<double>("stretchedEdgeA"), limbs.stretchedEdgeA[i]) &
+          check("limbStream.stretchedEdgeB", twoBoneIK.get<double>("stretchedEdgeB"), limbs.stretchedEdgeB[i]) &
+          check("limbStream.inclineAngle", inclineAngle.get<MAngle>("inclineAngle").asRadians(), stream.inclineAngle[i]);
+      }
+    }
+  }
+  ok = ok && checkLimbStreamRoundTrip(stream, benchTempPath("limbstream.csv")) && checkLimbStreamRoundTrip(stream, benchTempPath("limbstream.bin"));
+  std::printf("{\"check\":\"limbStream.nodes\",\"rows\":%zu,\"ok\":%s}\n", kCheckedRows, jsonBool(ok).c_str());
+  if (!ok) return false;
+
+  runBench(_options, "limbStream.solve", {{"threads", std::to_string(ThreadPool::shared().threadCount())}}, stream.size(), [&]
+  {
+    solveLimbStream(stream, ThreadPool::shared(), kPrecisionExact, kOrientationAngles);
+  });
+  runBench(_options, "limbStream.solve.packed", {{"threads", std::to_string(ThreadPool::shared().threadCount())}}, stream.size(), [&]
+  {
+    solveLimbStream(stream, ThreadPool::shared(), kPrecisionExact, kOrientationAngles, true);
+  });
+  return true;
+}
+
+// Computes recorded through the plugin command replay through the headless solver to the outputs the nodes gave,
+// on the solve cache path too, then the cost of a compute while recording
+bool benchComputeRecording(const BenchOptions& _options, const TwoBoneIKBatchBuffers& _limbs)
+{
+  const std::string path = benchTempPath("computes.sikr");
+  auto& registry = MockRegistry::instance();
+  MockNodeHarness twoBoneIK(kPrefix + "twoBoneIK", "twoBoneIK1");
+  MockNodeHarness cachedTwoBoneIK(kPrefix + "twoBoneIK", "twoBoneIK2");
+  MockNodeHarness inclineAngle(kPrefix + "inclineAngle", "inclineAngle1");
+  cachedTwoBoneIK.set("cacheSolve", true);
+  for (auto* node : {&twoBoneIK, &cachedTwoBoneIK, &inclineAngle}) node->set("soften", 0.2);
+
+  if (!registry.executeCommand(ComputeRecordCommand::name(), {"-start", path}) || registry.commandStringResult != path)
+  {
+    std::fprintf(stderr, "recordComputes did not start recording to %s\n", path.c_str());
+    return false;
+  }
+  static constexpr std::size_t kRecordedFrames = 16u;
+  std::size_t computes = 0u;
+  for (const auto precision : {kPrecisionExact, kPrecisionHigh, kPrecisionFast})
+  {
+    for (const auto method : {kOrientationAngles, kOrientationFrame})
+    {
+      for (std::size_t i = 0u; i < kRecordedFrames; ++i)
+      {
+        const MDGContext context((MTime(double(i))));
+        const MVector target(_limbs.targetX[i], _limbs.targetY[i], _limbs.targetZ[i]);
+        for (auto* node : {&twoBoneIK, &cachedTwoBoneIK})
+        {
+          node->dataBlock().setContext(context);
+          node->set("precision", short(precision));
+          node->set("orientationMethod", short(method));
+          node->set("targetLocation", target);
+          node->set("poleVector", MVector(_limbs.poleX[i], _limbs.poleY[i], _limbs.poleZ[i]));
+          node->set("staticEdgeA", _limbs.edgeA[i]);
+          node->set("staticEdgeB", _limbs.edgeB[i]);
+          node->set("twist", MAngle(_limbs.twist[i]));
+          node->compute("bendAngle");
+          node->compute("orientation");
+          node->compute("stretchedEdgeA");
+          computes += 3u;
+        }
+        inclineAngle.dataBlock().setContext(context);
+        inclineAngle.set("precision", short(precision));
+        inclineAngle.set("targetLocation", target);
+        inclineAngle.set("staticEdgeA", _limbs.edgeA[i]);
+        inclineAngle.set("staticEdgeB", _limbs.edgeB[i]);
+        inclineAngle.compute("inclineAngle");
+        ++computes;
+      }
+    }
+  }
+  std::vector<ComputeRecord> records;
+  std::string error;
+  bool ok = registry.executeCommand(ComputeRecordCommand::name(), {"-stop"}) && registry.commandStringResult == path &&
+    !ComputeRecorder::recording() && readComputeRecords(path, records, error);
+  if (!ok) std::fprintf(stderr, "recordComputes did not write %s %s\n", path.c_str(), error.c_str());
+  ok = ok && records.size() == computes && records.back().time == double(kRecordedFrames - 1u);
+  const auto stats = replayComputeRecords(records, ThreadPool::shared());
+  ok = ok && stats.nodes == 3u && stats.inclineAngle == computes / 7u && stats.mismatches == 0u;
+  std::printf("{\"check\":\"computeRecording.replay\",%s,\"ok\":%s}\n", stats.json().c_str(), jsonBool(ok).c_str());
+  std::remove(path.c_str());
+  if (!ok) return false;
+
+  // The same compute with recording off, where it costs one branch, and on, where the log grows by a record a compute
+  twoBoneIK.set("precision", short(kPrecisionExact));
+  twoBoneIK.set("orientationMethod", short(kOrientationAngles));
+  runBench(_options, "node.twoBoneIK.compute.recordingOff", {}, 1u, [&]
+  {
+    twoBoneIK.compute("bendAngle");
+  });
+  if (!ComputeRecorder::instance().start(path, error)) return false;
+  runBench(_options, "node.twoBoneIK.compute.recording", {}, 1u, [&]
+  {
+    twoBoneIK.compute("bendAngle");
+  });
+  ComputeRecorder::instance().stop(error);
+  std::remove(path.c_str());
+  runBench(_options, "computeRecording.replay", {{"records", std::to_string(records.size())}}, records.size(), [&]
+  {
+    replayComputeRecords(records, ThreadPool::shared());
+  });
+  return true;
+}
+
+// The compute counts reported by the stats command, and the profiler events of each compute phase
+bool benchComputeInstrumentation(const BenchOptions& _options, const LimbInput& _limb)
+{
+  auto& registry = MockRegistry::instance();
+  MockNodeHarness twoBoneIK(kPrefix + "twoBoneIK", "twoBoneIK1");
+  MockNodeHarness inclineAngle(kPrefix + "inclineAngle", "inclineAngle1");
+  for (auto* node : {&twoBoneIK, &inclineAngle})
+  {
+    node->set("targetLocation", _limb.target);
+    node->set("staticEdgeA", _limb.edgeA);
+    node->set("staticEdgeB", _limb.edgeB);
+  }
+  twoBoneIK.set("poleVector", _limb.pole);
+
+  // Counts start from the reset, the reset report still holds the earlier benchmarks
+  bool ok = registry.executeCommand(ComputeStatsCommand::name(), {"-reset"}) == MS::kSuccess;
+  static constexpr int kComputes = 10;
+  for (int i = 0; i < kComputes; ++i)
+  {
+    twoBoneIK.compute("bendAngle");
+    inclineAngle.compute("inclineAngle");
+  }
+  twoBoneIK.compute("targetLocation");
+  inclineAngle.compute("targetLocation");
+  inclineAngle.compute("targetLocation");
+  ok = ok && registry.executeCommand(ComputeStatsCommand::name(), {"-nodes", "1"}) == MS::kSuccess;
+  const std::string& json = registry.commandStringResult;
+  const auto counted = ComputeStats::instance().nodes();
+  ok = ok && counted.size() == 2u &&
+    json.find("{\"type\":\"twoBoneIK\",\"computes\":10,\"rejected\":1,") != std::string::npos &&
+    json.find("{\"type\":\"inclineAngle\",\"computes\":10,\"rejected\":2,") != std::string::npos &&
+    json.find("\"nodes\":[{\"node\":\"" + counted[0].node + "\"") != std::string::npos && json.find("},{\"node\"") == std::string::npos;
+  if (!ok) std::fprintf(stderr, "computeStats reported %s\n", json.c_str());
+
+  // Every phase of both nodes in order, the euler rotation of both orientation methods
+  registry.profiling = true;
+  registry.profilerEvents.clear();
+  twoBoneIK.compute("orientation");
+  twoBoneIK.set("orientationMethod", short(kOrientationFrame));
+  twoBoneIK.compute("orientation");
+  twoBoneIK.set("orientationMethod", short(kOrientationAngles));
+  inclineAngle.compute("inclineAngle");
+  registry.profiling = false;
+  const char* const orientationPhases[] = {"Attribute read", "Solve", "Euler reorder", "Attribute write"};
+  const char* const inclinePhases[] = {"Attribute read", "Solve", "Attribute write"};
+  std::vector<std::string> expected;
+  for (int i = 0; i < 2; ++i) expected.insert(expected.end(), std::begin(orientationPhases), std::end(orientationPhases));
+  expected.insert(expected.end(), std::begin(inclinePhases), std::end(inclinePhases));
+  bool profiled = registry.profilerEvents.size() == expected.size();
+  for (std::size_t i = 0u; i < expected.size() && profiled; ++i)
+  {
+    profiled = registry.profilerEvents[i].first == SimpleIKProfiler::category() && registry.profilerEvents[i].second == expected[i];
+  }
+  if (!profiled) std::fprintf(stderr, "the computes emitted %zu profiler events, expected %zu\n", registry.profilerEvents.size(), expected.size());
+  ok = ok && profiled;
+  std::printf("{\"check\":\"computeInstrumentation\",\"ok\":%s}\n", jsonBool(ok).c_str());
+  if (!ok) return false;
+
+  // The other benchmarks count every compute, this one takes the clock reads and counting out
+  ComputeStats::setEnabled(false);
+  runBench(_options, "node.twoBoneIK.compute.statsDisabled", {}, 1u, [&]
+  {
+    twoBoneIK.compute("bendAngle");
+  });
+  ComputeStats::setEnabled(true);
+  runBench(_options, "node.twoBoneIK.compute.statsEnabled", {}, 1u, [&]
+  {
+    twoBoneIK.compute("bendAngle");
+  });
+  return true;
+}
+
+// Nodes of one cluster feeding each other, each listed before the node upstream of it.
+// The first ik node's edges drive an incline node and a caching ik node, which the evaluator computes on its own,
+// so both only match the core when they are evaluated after the first ik node has been scattered
+bool checkEvaluatorChain(const LimbInput& _limb)
+{
+  MockNodeHarness incline(kPrefix + "inclineAngle", "chainIncline1");
+  MockNodeHarness cached(kPrefix + "twoBoneIK", "chainCached1");
+  MockNodeHarness ik(kPrefix + "twoBoneIK", "chainIK1");
+  for (auto* harness : {&incline, &cached, &ik})
+  {
+    harness->set("targetLocation", _limb.target);
+    harness->set("staticEdgeA", _limb.edgeA);
+    harness->set("staticEdgeB", _limb.edgeB);
+    harness->set("soften", 0.2);
+  }
+  for (auto* harness : {&cached, &ik})
+  {
+    harness->set("poleVector", _limb.pole);
+    harness->set("twist", MAngle(_limb.twist));
+    harness->set("stretchStrength", 1.0);
+  }
+  cached.set("cacheSolve", true);
+  ik.connect("stretchedEdgeA", incline, "staticEdgeA");
+  ik.connect("stretchedEdgeB", cached, "staticEdgeA");
+
+  SimpleIKEvaluator::resetStats();
+  MockEvaluationGraph graph({&incline.node(), &cached.node(), &ik.node()});
+  const auto target = toVector3(_limb.target);
+  const auto reach = _limb.edgeA + _limb.edgeB;
+  for (int frame = 0; frame < 3; ++frame)
+  {
+    // Out of reach by a little more every frame, so the stretched edges change
+    const auto stretched = target * ((1.1 + 0.1 * frame) * reach / std::sqrt(target * target));
+    ik.set("targetLocation", toMVector(stretched));
+    graph.evaluate();
+
+    const auto upstream = solveTwoBoneIK(stretched, toVector3(_limb.pole), _limb.edgeA, _limb.edgeB, _limb.twist, 0.2, 1.0);
+    const auto downstream = solveTwoBoneIK(target, toVector3(_limb.pole), upstream.stretchedEdgeB, _limb.edgeB, _limb.twist, 0.2, 1.0);
+    const auto inclineAngle = solveInclineAngle(target, upstream.stretchedEdgeA, _limb.edgeB, 0.2);
+    const bool ok =
+      check("evaluator.chain.stretchedEdgeA", ik.get<double>("stretchedEdgeA"), upstream.stretchedEdgeA, kBatchTolerance) &&
+      check("evaluator.chain.inclineAngle", incline.get<MAngle>("inclineAngle").asRadians(), inclineAngle, kBatchTolerance) &&
+      check("evaluator.chain.cachedBendAngle", cached.get<MAngle>("bendAngle").asRadians(), downstream.bendAngle) &&
+      check("evaluator.chain.cachedStretchedEdgeA", cached.get<double>("stretchedEdgeA"), downstream.stretchedEdgeA);
+    if (!ok) return false;
+  }
+  const auto stats = SimpleIKEvaluator::stats();
+  if (stats.batchedNodes != 2u || stats.fallbackNodes != 1u)
+  {
+    std::fprintf(stderr, "evaluator chain batched %llu and fell back on %llu nodes\n", stats.batchedNodes, stats.fallbackNodes);
+    return false;
+  }
+  // Levels this small are solved inline, so the cluster can run alongside others
+  if (graph.schedulingType(SimpleIKEvaluator::name()) != MCustomEvaluatorClusterNode::kParallel)
+  {
+    std::fprintf(stderr, "evaluator scheduled a cluster of three nodes serially\n");
+    return false;
+  }
+
+  // While recording every node computes on its own, so the nodes the evaluator batches are in the log too
+  const std::string path = benchTempPath("evaluator.sikr");
+  std::string error;
+  std::vector<ComputeRecord> records;
+  bool recorded = ComputeRecorder::instance().start(path, error);
+  graph.evaluate();
+  recorded = ComputeRecorder::instance().stop(error) && recorded && readComputeRecords(path, records, error);
+  std::remove(path.c_str());
+  for (auto* harness : {&incline, &cached, &ik})
+  {
+    const auto id = computeRecordNodeId(harness->node().name().asChar());
+    recorded = recorded && std::any_of(records.begin(), records.end(), [id](const ComputeRecord& _record) { return _record.node == id; });
+  }
+  const auto recordingStats = SimpleIKEvaluator::stats();
+  recorded = recorded && recordingStats.batchedNodes == 0u && recordingStats.fallbackNodes == 3u;
+  std::printf("{\"check\":\"evaluator.recording\",\"records\":%zu,\"ok\":%s}\n", records.size(), jsonBool(recorded).c_str());
+  if (!recorded) std::fprintf(stderr, "recording the evaluator wrote %zu records %s\n", records.size(), error.c_str());
+  if (!recorded) return false;
+  return true;
+}
+
+bool benchEvaluator(const BenchOptions& _options, const TwoBoneIKBatchBuffers& _limbs)
+{
+  // Every hundredth ik node caches its solve and every hundredth node of each type uses the fast precision,
+  // which the packed solve does not cover
+  const std::size_t count = _limbs.size();
+  const std::size_t inclineCount = count / 10u;
+  std::size_t fallbackCount = 0u;
+  std::vector<std::unique_ptr<MockNodeHarness>> harnesses;
+  std::vector<MPxNode*> nodes;
+  for (std::size_t i = 0u; i < count + inclineCount; ++i)
+  {
+    const auto limb = limbInput(_limbs, i % count);
+    const bool isIK = i < count;
+    harnesses.emplace_back(new MockNodeHarness(kPrefix + (isIK ? "twoBoneIK" : "inclineAngle"), "node" + std::to_string(i)));
+    auto& harness = *harnesses.back();
+    harness.set("targetLocation", limb.target);
+    harness.set("staticEdgeA", limb.edgeA);
+    harness.set("staticEdgeB", limb.edgeB);
+    harness.set("soften", 0.2);
+    const bool fast = i % 100u == 50u;
+    harness.set("precision", short(fast ? kPrecisionFast : kPrecisionExact));
+    fallbackCount += fast || (isIK && i % 100u == 0u);
+    if (isIK)
+    {
+      harness.set("poleVector", limb.pole);
+      harness.set("twist", MAngle(limb.twist));
+      harness.set("stretchStrength", 0.5);
+      harness.set("cacheSolve", i % 100u == 0u);
+    }
+    nodes.push_back(&harness.node());
+  }
+
+  // Reference outputs from each node's own compute, cleared before the evaluator writes them again
+  struct Outputs
+  {
+    double angle;
+    MEulerRotation orientation;
+    double stretchedEdgeA;
+  };
+  std::vector<Outputs> reference(nodes.size());
+  for (std::size_t i = 0u; i < nodes.size(); ++i)
+  {
+    auto& harness = *harnesses[i];
+    MockRegistry::instance().evaluateNode(nodes[i]);
+    if (i < count)
+    {
+      reference[i] = {harness.get<MAngle>("bendAngle").asRadians(), harness.getEuler("orientation"), harness.get<double>("stretchedEdgeA")};
+      harness.set("bendAngle", MAngle(0.0));
+      harness.set("stretchedEdgeA", 0.0);
+    }
+    else
+    {
+      reference[i] = {harness.get<MAngle>("inclineAngle").asRadians(), MEulerRotation(), 0.0};
+      harness.set("inclineAngle", MAngle(0.0));
+    }
+  }
+
+  SimpleIKEvaluator::resetStats();
+  ComputeStats::instance().reset();
+  MockEvaluationGraph graph(nodes);
+  graph.evaluate();
+  bool ok = true;
+  for (std::size_t i = 0u; i < nodes.size() && ok; ++i)
+  {
+    auto& harness = *harnesses[i];
+    if (i < count)
+    {
+      ok = check("evaluator.twoBoneIK.bendAngle", harness.get<MAngle>("bendAngle").asRadians(), reference[i].angle, kBatchTolerance) &&
+        checkRotation("evaluator.twoBoneIK.orientation", harness.getEuler("orientation"), reference[i].orientation) &&
+        check("evaluator.twoBoneIK.stretchedEdgeA", harness.get<double>("stretchedEdgeA"), reference[i].stretchedEdgeA);
+    }
+    else
+    {
+      ok = check("evaluator.inclineAngle", harness.get<MAngle>("inclineAngle").asRadians(), reference[i].angle, kBatchTolerance);
+    }
+  }
+  if (!ok) return false;
+
+  // One frame, every node in one cluster and only the caching and fast nodes computed on their own
+  const auto stats = SimpleIKEvaluator::stats();
+  if (graph.clusterSize(SimpleIKEvaluator::name()) != nodes.size() || stats.frames != 1u || stats.clusters != 1u ||
+      stats.batchedNodes != nodes.size() - fallbackCount || stats.fallbackNodes != fallbackCount)
+  {
+    std::fprintf(stderr, "evaluator counted %llu frames, %llu clusters, %llu batched and %llu fallback nodes\n",
+        stats.frames, stats.clusters, stats.batchedNodes, stats.fallbackNodes);
+    return false;
+  }
+  // A level of more than one chunk is split over the plugin pool, which serves one cluster at a time
+  const bool usesPool = std::max(count, inclineCount) > batchChunkSize(kBatchChunkSize, BatchDispatch::kernels().width);
+  if (graph.schedulingType(SimpleIKEvaluator::name()) != (usesPool ? MCustomEvaluatorClusterNode::kSerial : MCustomEvaluatorClusterNode::kParallel))
+  {
+    std::fprintf(stderr, "evaluator scheduled a cluster of %zu nodes %s\n", nodes.size(), usesPool ? "in parallel" : "serially");
+    return false;
+  }
+  const auto& result = MockRegistry::instance().commandIntResult;
+  if (!MockRegistry::instance().executeCommand(SimpleIKEvaluatorStatsCommand::name()) || result.size() != 6u ||
+      result[2] != int(stats.batchedNodes) || result[3] != int(stats.fallbackNodes))
+  {
+    std::fprintf(stderr, "evaluatorStats did not report the evaluator counters\n");
+    return false;
+  }
+  // Every node counted in sik_computeStats, the batched ones as one compute each
+  const auto counted = ComputeStats::instance().nodes();
+  std::size_t batchedComputes = 0u;
+  for (const auto& node : counted) batchedComputes += node.counters.computes == 1u && node.counters.totalNanoseconds > 0u;
+  if (counted.size() != nodes.size() || batchedComputes < nodes.size() - fallbackCount)
+  {
+    std::fprintf(stderr, "computeStats counted %zu of %zu evaluated nodes, %zu with one compute\n", counted.size(), nodes.size(), batchedComputes);
+    return false;
+  }
+
+  const BenchTags tags = {{"nodes", std::to_string(nodes.size())}};
+  runBench(_options, "node.evaluator.frame", tags, nodes.size(), [&]
+  {
+    graph.evaluate();
+  });
+  runBench(_options, "node.evaluator.perNode", tags, nodes.size(), [&]
+  {
+    for (auto node : nodes) MockRegistry::instance().evaluateNode(node);
+  });
+  return true;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  const auto options = BenchOptions::parse(argc, argv);
+  if (!initializePlugin(MObject()))
+  {
+    std::fprintf(stderr, "Plugin initialization failed\n");
+    return 1;
+  }
+
+  TwoBoneIKBatchBuffers limbs;
+  makeLimbInputs(limbs, kArrayLimbs, LimbInputConfig());
+  const auto limb = limbInput(limbs, 0u);
+  const bool ok =
+    checkMockEulerRotation() &&
+    benchTwoBoneIK(options, limb) &&
+    benchInclineAngle(options, limb) &&
+    benchTwoBoneIKArray(options, limbs) &&
+    benchTwoBoneIKSamples(options, limb) &&
+    benchArrayAttributeIO(options) &&
+    benchChainIK(options, limb) &&
+    benchChainIKWarmStart(options) &&
+    benchSplineIK(options) &&
+    benchLimbStream(options, limbs) &&
+    benchComputeRecording(options, limbs) &&
+    benchComputeInstrumentation(options, limb) &&
+    checkEvaluatorChain(limb) &&
+    benchEvaluator(options, limbs);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,81 @@
+#include "Bench.h"
+#include "BenchInputs.h"
+#include "TwoBoneIKParallel.h"
+#include <cstring>
+
+// Thread scaling of the parallel batch solves from TwoBoneIKParallel.h, from 1 to 64 threads,
+// over crowd sized batches of 50k and 500k limbs.
+// Before timing, every thread count is checked to give output bitwise identical to the single threaded solve.
+// Each thread count prints its timing, then one line with the speedup and efficiency against one thread,
+// thread counts past the hardware threads oversubscribe the cores and show the cost of doing so.
+
+namespace
+{
+
+static const unsigned kThreadCounts[] = {1u, 2u, 4u, 8u, 16u, 32u, 64u};
+
+bool sameOutputs(const TwoBoneIKBatchBuffers& _a, const TwoBoneIKBatchBuffers& _b)
+{
+  for (const auto& channel : {
+      std::make_pair(&_a.bendAngle, &_b.bendAngle), std::make_pair(&_a.orientationX, &_b.orientationX),
+      std::make_pair(&_a.orientationY, &_b.orientationY), std::make_pair(&_a.orientationZ, &_b.orientationZ),
+      std::make_pair(&_a.stretchedEdgeA, &_b.stretchedEdgeA), std::make_pair(&_a.stretchedEdgeB, &_b.stretchedEdgeB)})
+  {
+    if (std::memcmp(channel.first->data(), channel.second->data(), channel.first->size() * sizeof(double))) return false;
+  }
+  return true;
+}
+
+bool benchScaling(const BenchOptions& _options, std::size_t _count)
+{
+  LimbInputConfig config;
+  config.soften = 0.2;
+  config.stretchStrength = 0.5;
+  TwoBoneIKBatchBuffers reference;
+  makeLimbInputs(reference, _count, config);
+  TwoBoneIKBatchBuffers limbs = reference;
+  const BatchKernels& kernels = BatchDispatch::kernels();
+  kernels.solveTwoBoneIK(reference.view(), _count);
+
+  const std::string hardware = std::to_string(ThreadPool::defaultThreadCount());
+  double singleThread = 0.0;
+  for (unsigned threads : kThreadCounts)
+  {
+    ThreadPool pool(threads);
+    const auto batch = limbs.view();
+    solveTwoBoneIKBatchParallel(batch, _count, pool);
+    if (!sameOutputs(limbs, reference))
+    {
+      std::fprintf(stderr, "parallel solve on %u threads differs from the single threaded solve\n", threads);
+      return false;
+    }
+
+    const BenchTags tags = {
+      {"limbs", std::to_string(_count)}, {"threads", std::to_string(threads)}, {"hardware_threads", hardware}, {"isa", jsonString(kernels.name)}};
+    const auto result = runBench(_options, "parallel.twoBoneIK", tags, _count, [&]
+    {
+      solveTwoBoneIKBatchParallel(batch, _count, pool);
+      doNotOptimize(batch.bendAngle[0]);
+    });
+    if (threads == 1u) singleThread = result.p50;
+    if (result.p50 > 0.0 && singleThread > 0.0)
+    {
+      const double speedup = singleThread / result.p50;
+      std::printf("{\"benchmark\":\"parallel.twoBoneIK.scaling\",\"limbs\":%zu,\"threads\":%u,\"hardware_threads\":%s,\"speedup\":%.3f,\"efficiency\":%.3f}\n",
+          _count, threads, hardware.c_str(), speedup, speedup / double(threads));
+      std::fflush(stdout);
+    }
+  }
+  return true;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  const auto options = BenchOptions::parse(argc, argv);
+  const bool ok =
+    benchScaling(options, 50000u) &&
+    benchScaling(options, 500000u);
+  return ok ? 0 : 1;
+}
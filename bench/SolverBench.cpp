@@ -0,0 +1,222 @@
+#include "Bench.h"
+#include "BatchDispatch.h"
+#include "BenchInputs.h"
+#include "InclineAngleSolver.h"
+#include "TwoBoneIKBatch.h"
+#include "TwoBoneIKSolver.h"
+
+// Solver micro benchmarks, these time the headless core so flag and code changes can be compared without maya.
+// Build and run with "make bench", pass arguments through BENCH_ARGS, for example BENCH_ARGS="--filter batch --quick".
+
+namespace
+{
+
+// Inputs for the helper benchmarks, large enough to defeat value prediction and small enough to stay in cache
+static constexpr std::size_t kHelperCount = 1024u;
+
+void benchHelpers(const BenchOptions& _options)
+{
+  TwoBoneIKBatchBuffers in;
+  makeLimbInputs(in, kHelperCount, LimbInputConfig());
+  const double* a = in.edgeA.data();
+  const double* b = in.edgeB.data();
+  const double* x = in.targetX.data();
+  const double* y = in.targetY.data();
+  const double* z = in.targetZ.data();
+
+  runBench(_options, "helper.getAngle", {}, kHelperCount, [&]
+  {
+    for (std::size_t i = 0u; i < kHelperCount; ++i) doNotOptimize(getAngle(a[i], b[i], std::abs(x[i])));
+  });
+  runBench(_options, "helper.softenEdge", {}, kHelperCount, [&]
+  {
+    for (std::size_t i = 0u; i < kHelperCount; ++i) doNotOptimize(softenEdge(std::abs(x[i]), a[i] + b[i], 0.2));
+  });
+  runBench(_options, "helper.stretchEdge", {}, kHelperCount, [&]
+  {
+    for (std::size_t i = 0u; i < kHelperCount; ++i) doNotOptimize(stretchEdge(a[i], std::abs(x[i]), a[i] + b[i], 0.5));
+  });
+  runBench(_options, "helper.distPointToOLine", {}, kHelperCount, [&]
+  {
+    for (std::size_t i = 0u; i < kHelperCount; ++i)
+    {
+      doNotOptimize(distPointToOLine<double>(Vector3<double>(x[i], z[i]), Vector3<double>(y[i], a[i])));
+    }
+  });
+  runBench(_options, "helper.makeNonZero", {}, kHelperCount, [&]
+  {
+    for (std::size_t i = 0u; i < kHelperCount; ++i) doNotOptimize(makeNonZero<double>(Vector3<double>(x[i], y[i], z[i])));
+  });
+}
+
+// The orientation stages of the solve, as euler angles and as a matrix built from the rotated basis
+void benchStages(const BenchOptions& _options)
+{
+  TwoBoneIKBatchBuffers in;
+  makeLimbInputs(in, kHelperCount, LimbInputConfig());
+  std::vector<Vector3<double>> targets(kHelperCount), poles(kHelperCount);
+  std::vector<double> edgesC(kHelperCount);
+  for (std::size_t i = 0u; i < kHelperCount; ++i)
+  {
+    targets[i] = makeNonZero<double>(Vector3<double>(in.targetX[i], in.targetY[i], in.targetZ[i]));
+    poles[i] = Vector3<double>(in.poleX[i], in.poleY[i], in.poleZ[i]);
+    edgesC[i] = solveTwoBoneIKEdges(targets[i], in.edgeA[i], in.edgeB[i], 0.0).edgeC;
+  }
+
+  runBench(_options, "stage.rootOrientation", {}, kHelperCount, [&]
+  {
+    for (std::size_t i = 0u; i < kHelperCount; ++i)
+    {
+      doNotOptimize(solveRootOrientation(targets[i], poles[i], in.edgeA[i], in.edgeB[i], edgesC[i], in.twist[i]));
+    }
+  });
+  runBench(_options, "stage.rootMatrix", {}, kHelperCount, [&]
+  {
+    for (std::size_t i = 0u; i < kHelperCount; ++i)
+    {
+      doNotOptimize(solveRootMatrix(targets[i], poles[i], in.edgeA[i], in.edgeB[i], edgesC[i], in.twist[i]));
+    }
+  });
+  runBench(_options, "stage.rootFrame", {}, kHelperCount, [&]
+  {
+    for (std::size_t i = 0u; i < kHelperCount; ++i)
+    {
+      doNotOptimize(solveRootFrame(targets[i], poles[i], in.edgeA[i], in.edgeB[i], edgesC[i], in.twist[i]));
+    }
+  });
+  runBench(_options, "stage.rootQuaternion", {}, kHelperCount, [&]
+  {
+    for (std::size_t i = 0u; i < kHelperCount; ++i)
+    {
+      doNotOptimize(Quaternion<double>::fromMatrix(solveRootMatrix(targets[i], poles[i], in.edgeA[i], in.edgeB[i], edgesC[i], in.twist[i])));
+    }
+  });
+}
+
+BenchTags solveTags(const LimbInputConfig& _config, std::size_t _count)
+{
+  return {
+    {"limbs", std::to_string(_count)},
+    {"inputs", jsonString(_config.inputsName())},
+    {"soften", jsonBool(_config.soften > 0.0)},
+    {"stretch", jsonBool(_config.stretchStrength > 0.0)}
+  };
+}
+
+template <typename TMath>
+void benchScalarSolve(const BenchOptions& _options, const TwoBoneIKBatchBuffers& _in, BenchTags _tags, const char* _precision)
+{
+  _tags.emplace_back("precision", jsonString(_precision));
+  const std::size_t count = _in.size();
+  runBench(_options, "twoBoneIK.scalar", _tags, count, [&]
+  {
+    for (std::size_t i = 0u; i < count; ++i)
+    {
+      const auto solution = solveTwoBoneIK<double, TMath>(
+          Vector3<double>(_in.targetX[i], _in.targetY[i], _in.targetZ[i]),
+          Vector3<double>(_in.poleX[i], _in.poleY[i], _in.poleZ[i]),
+          _in.edgeA[i], _in.edgeB[i], _in.twist[i], _in.soften[i], _in.stretchStrength[i]);
+      doNotOptimize(solution);
+    }
+  });
+  // Specialized on the features of each limb, which only pays off for the configurations without soften or stretch
+  runBench(_options, "twoBoneIK.scalar.features", _tags, count, [&]
+  {
+    for (std::size_t i = 0u; i < count; ++i)
+    {
+      const auto solution = solveTwoBoneIKFeatures<double, TMath>(
+          Vector3<double>(_in.targetX[i], _in.targetY[i], _in.targetZ[i]),
+          Vector3<double>(_in.poleX[i], _in.poleY[i], _in.poleZ[i]),
+          _in.edgeA[i], _in.edgeB[i], _in.twist[i], _in.soften[i], _in.stretchStrength[i]);
+      doNotOptimize(solution);
+    }
+  });
+}
+
+// Scalar solves, one limb after another as the single limb nodes do, at each precision tier
+void benchScalar(const BenchOptions& _options, const LimbInputConfig& _config, std::size_t _count)
+{
+  TwoBoneIKBatchBuffers in;
+  makeLimbInputs(in, _count, _config);
+  const auto tags = solveTags(_config, _count);
+
+  benchScalarSolve<ExactMath>(_options, in, tags, "exact");
+  benchScalarSolve<HighMath>(_options, in, tags, "high");
+  benchScalarSolve<FastMath>(_options, in, tags, "fast");
+
+  // The incline angle solve has no stretch, skip the duplicate configurations
+  if (_config.stretchStrength > 0.0) return;
+  auto inclineTags = tags;
+  inclineTags.pop_back();
+  runBench(_options, "inclineAngle.scalar", inclineTags, _count, [&]
+  {
+    for (std::size_t i = 0u; i < _count; ++i)
+    {
+      doNotOptimize(solveInclineAngle(
+          Vector3<double>(in.targetX[i], in.targetY[i], in.targetZ[i]), in.edgeA[i], in.edgeB[i], in.soften[i]));
+    }
+  });
+}
+
+// Packed solves through the structure of arrays kernel
+void benchBatch(const BenchOptions& _options, const LimbInputConfig& _config, std::size_t _count)
+{
+  TwoBoneIKBatchBuffers buffers;
+  makeLimbInputs(buffers, _count, _config);
+  const auto batch = buffers.view();
+  auto tags = solveTags(_config, _count);
+  tags.emplace_back("width", std::to_string(kTwoBoneIKBatchWidth));
+
+  runBench(_options, "twoBoneIK.batch", tags, _count, [&]
+  {
+    solveTwoBoneIKBatch(batch, _count);
+    doNotOptimize(batch.bendAngle[0]);
+  });
+
+  // Each build of BatchKernels.cpp this cpu runs, the throughput the dispatch picks between
+  tags.pop_back();
+  for (int level = kSimdSSE; level < kSimdLevelCount; ++level)
+  {
+    if (!simdLevelSupported(SimdLevel(level))) continue;
+    const BatchKernels& kernels = batchKernels(SimdLevel(level));
+    auto isaTags = tags;
+    isaTags.emplace_back("isa", jsonString(kernels.name));
+    isaTags.emplace_back("width", std::to_string(kernels.width));
+    isaTags.emplace_back("selected", jsonBool(level == BatchDispatch::level()));
+    runBench(_options, "twoBoneIK.batch.isa", isaTags, _count, [&]
+    {
+      kernels.solveTwoBoneIK(batch, _count);
+      doNotOptimize(batch.bendAngle[0]);
+    });
+  }
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  const auto options = BenchOptions::parse(argc, argv);
+  benchHelpers(options);
+  benchStages(options);
+
+  // A single limb measures call latency, the larger batches measure throughput
+  for (std::size_t count : {std::size_t(1), std::size_t(1000), std::size_t(100000)})
+  {
+    for (bool coherent : {false, true})
+    {
+      for (double soften : {0.0, 0.2})
+      {
+        for (double stretchStrength : {0.0, 1.0})
+        {
+          LimbInputConfig config;
+          config.coherent = coherent;
+          config.soften = soften;
+          config.stretchStrength = stretchStrength;
+          benchScalar(options, config, count);
+          benchBatch(options, config, count);
+        }
+      }
+    }
+  }
+  return 0;
+}
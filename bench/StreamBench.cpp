@@ -0,0 +1,321 @@
+#include "Bench.h"
+#include "BenchInputs.h"
+#include "LimbColumns.h"
+#include "LimbPipeline.h"
+#include <sys/stat.h>
+#include <thread>
+
+// Recorded limb stream I/O, the CSV and binary row formats of LimbStream.h read through buffered file reads against
+// the columnar files of LimbColumns.h, read the same way and memory mapped.
+// Every format is timed reading a take, and reading and solving it, per row.
+// The files are rewritten before timing and sit in the page cache, so these are parsing and copying costs,
+// a cold read from disk adds transfer time to each format in proportion to its size.
+// The streaming pipeline of LimbPipeline.h is timed against reading, solving and writing a whole take in turn, and
+// prints how busy each stage was and how full the queues between them ran.
+// Before timing, every format is checked to give the in memory solve bit for bit, including a mapped file to file
+// solve spanning several release windows, and the pipeline is checked to write the same file as the whole take solve,
+// from files, through a ring of only two chunks, and from a named pipe. The process fails on a mismatch.
+
+namespace
+{
+
+static constexpr std::size_t kStreamRows = 1u << 16;
+static constexpr std::size_t kStreamLimbs = 64u;
+
+void makeStream(LimbStream& o_stream, std::size_t _rows)
+{
+  LimbInputConfig config;
+  config.soften = 0.2;
+  config.stretchStrength = 0.5;
+  o_stream.resize(_rows);
+  makeLimbInputs(o_stream.limbs, _rows, config);
+  for (std::size_t i = 0u; i < _rows; ++i)
+  {
+    o_stream.frame[i] = std::int64_t(i / kStreamLimbs);
+    o_stream.limb[i] = std::int64_t(i % kStreamLimbs);
+  }
+}
+
+// Reads a columnar file through buffered reads into memory, as a reader with no mapping would
+bool readColumnsBuffered(const std::string& _path, LimbStream& o_stream)
+{
+  LimbStreamIO::File in(_path, "rb");
+  LimbColumnsHeader header;
+  if (!in.file || std::fread(&header, sizeof(header), 1u, in.file) != 1u || header.columns > kLimbColumnCount) return false;
+  std::vector<LimbColumnsEntry> entries(header.columns);
+  if (std::fread(entries.data(), sizeof(LimbColumnsEntry), entries.size(), in.file) != entries.size()) return false;
+  o_stream.resize(std::size_t(header.rows));
+  for (const auto& entry : entries)
+  {
+    void* column = entry.column == kLimbColumnFrame ? static_cast<void*>(o_stream.frame.data()) :
+      entry.column == kLimbColumnLimb ? static_cast<void*>(o_stream.limb.data()) :
+      static_cast<void*>(o_stream.channel(entry.column - kLimbColumnChannels)->data());
+    if (std::fseek(in.file, long(entry.offset), SEEK_SET) != 0 || std::fread(column, sizeof(double), o_stream.size(), in.file) != o_stream.size()) return false;
+  }
+  return true;
+}
+
+// The mapped input columns with the outputs going to _outputs
+LimbStreamView mappedView(const LimbColumnsFile& _input, LimbStream& _outputs)
+{
+  auto view = _outputs.view();
+  const double** inputs[kLimbStreamInputChannels] = {
+    &view.limbs.targetX, &view.limbs.targetY, &view.limbs.targetZ, &view.limbs.poleX, &view.limbs.poleY, &view.limbs.poleZ,
+    &view.limbs.edgeA, &view.limbs.edgeB, &view.limbs.twist, &view.limbs.soften, &view.limbs.stretchStrength
+  };
+  for (std::size_t c = 0u; c < kLimbStreamInputChannels; ++c) *inputs[c] = _input.channel(c);
+  return view;
+}
+
+bool sameOutputs(const char* _what, LimbStream& _stream, LimbStream& _expected)
+{
+  bool ok = _stream.size() == _expected.size();
+  for (std::size_t c = kLimbStreamInputChannels; c < kLimbStreamInputChannels + kLimbStreamOutputChannels && ok; ++c)
+  {
+    ok = *_stream.channel(c) == *_expected.channel(c);
+  }
+  if (!ok) std::fprintf(stderr, "%s does not give the in memory solve bit for bit\n", _what);
+  return ok;
+}
+
+// A file to file mapped solve over a take that does not fill its last window
+bool checkMappedSolve(ThreadPool& io_pool)
+{
+  LimbStream stream;
+  makeStream(stream, 2u * kLimbColumnsWindowRows + 1003u);
+  const auto inputPath = benchTempPath("stream.in.sikc");
+  const auto outputPath = benchTempPath("stream.out.sikc");
+  std::string error;
+  bool ok = writeLimbColumnsInputs(inputPath, stream, error);
+  {
+    LimbColumnsFile input;
+    LimbColumnsFile output;
+    ok = ok && input.open(inputPath, error) && output.create(outputPath, input.rows(), limbColumnsOutputs(), error) &&
+      solveLimbColumns(input, output, io_pool, kPrecisionExact, kOrientationAngles, false, error);
+  }
+  LimbColumnsFile solved;
+  ok = ok && solved.open(outputPath, error);
+  if (!ok) std::fprintf(stderr, "mapped solve failed, %s\n", error.c_str());
+  solveLimbStream(stream, io_pool, kPrecisionExact, kOrientationAngles);
+  for (std::size_t c = 0u; c < kLimbStreamOutputChannels && ok; ++c)
+  {
+    const auto& expected = *stream.channel(kLimbStreamInputChannels + c);
+    ok = std::equal(expected.begin(), expected.end(), solved.channel(kLimbStreamInputChannels + c));
+  }
+  ok = ok && std::equal(stream.frame.begin(), stream.frame.end(), solved.frame()) && std::equal(stream.limb.begin(), stream.limb.end(), solved.limb());
+  if (!ok) std::fprintf(stderr, "the mapped file to file solve does not give the in memory solve bit for bit\n");
+  solved.close();
+  std::remove(inputPath.c_str());
+  std::remove(outputPath.c_str());
+  std::printf("{\"check\":\"stream.columns.mappedSolve\",\"rows\":%zu,\"windows\":%zu,\"ok\":%s}\n",
+      stream.size(), (stream.size() + kLimbColumnsWindowRows - 1u) / kLimbColumnsWindowRows, jsonBool(ok).c_str());
+  return ok;
+}
+
+bool sameFile(const std::string& _path, const std::string& _expectedPath)
+{
+  std::string contents;
+  std::string expected;
+  std::string error;
+  return LimbStreamIO::readAll(_path, contents, error) && LimbStreamIO::readAll(_expectedPath, expected, error) && contents == expected;
+}
+
+bool runPipeline(
+    const std::string& _inputPath, const std::string& _outputPath, ThreadPool& io_pool, LimbPipelineStats& o_stats, std::string& o_error,
+    std::size_t _chunkRows = kLimbPipelineChunkRows, std::size_t _chunks = kLimbPipelineChunks, TraceEventWriter* io_trace = nullptr)
+{
+  LimbStreamReader reader;
+  LimbStreamWriter writer;
+  return reader.open(_inputPath, o_error) && writer.open(_outputPath, o_error) &&
+    runLimbPipeline(reader, writer, io_pool, kPrecisionExact, kOrientationAngles, false, o_stats, o_error, _chunkRows, _chunks, io_trace) &&
+    writer.close(o_error);
+}
+
+// The pipeline writes what the whole take solve writes, for both formats, with chunks that do not divide the take and
+// too few of them for every stage to hold one, and with the input fed through a named pipe
+bool checkPipeline(LimbStream& _solved, const std::string& _csvPath, const std::string& _rowsPath, ThreadPool& io_pool)
+{
+  std::string error;
+  LimbPipelineStats stats;
+  bool ok = true;
+  for (const auto& input : {_csvPath, _rowsPath})
+  {
+    const bool csv = isLimbStreamCSV(input);
+    const auto expectedPath = benchTempPath(csv ? "stream.expected.csv" : "stream.expected.bin");
+    const auto outputPath = benchTempPath(csv ? "stream.pipeline.csv" : "stream.pipeline.bin");
+    ok = ok && writeLimbStreamOutputs(expectedPath, _solved, error) &&
+      runPipeline(input, outputPath, io_pool, stats, error) && sameFile(outputPath, expectedPath) &&
+      runPipeline(input, outputPath, io_pool, stats, error, 1000u, 2u) && sameFile(outputPath, expectedPath);
+    if (ok && !csv)
+    {
+      // A writer thread stands in for a live feed
+      const auto fifoPath = benchTempPath("stream.fifo.bin");
+      std::remove(fifoPath.c_str());
+      ok = mkfifo(fifoPath.c_str(), 0600) == 0;
+      if (ok)
+      {
+        std::string feedError;
+        bool fed = false;
+        std::thread feed([&]() { fed = writeLimbStreamInputs(fifoPath, _solved, feedError); });
+        ok = runPipeline(fifoPath, outputPath, io_pool, stats, error);
+        feed.join();
+        ok = ok && fed && sameFile(outputPath, expectedPath);
+        std::remove(fifoPath.c_str());
+      }
+    }
+    std::remove(expectedPath.c_str());
+    std::remove(outputPath.c_str());
+  }
+  if (!ok) std::fprintf(stderr, "the pipeline does not write what the whole take solve writes%s%s\n", error.empty() ? "" : ", ", error.c_str());
+  std::printf("{\"check\":\"stream.pipeline\",\"rows\":%zu,\"ok\":%s}\n", _solved.size(), jsonBool(ok).c_str());
+  return ok;
+}
+
+// A traced pipeline writes the same file, with every row traced through each stage, and the trace file is written
+bool checkTrace(LimbStream& _solved, const std::string& _rowsPath, ThreadPool& io_pool)
+{
+  std::string error;
+  LimbPipelineStats stats;
+  TraceEventWriter trace;
+  const auto expectedPath = benchTempPath("stream.expected.bin");
+  const auto outputPath = benchTempPath("stream.traced.bin");
+  const auto tracePath = benchTempPath("stream.trace.json");
+  bool ok = writeLimbStreamOutputs(expectedPath, _solved, error) &&
+    runPipeline(_rowsPath, outputPath, io_pool, stats, error, 1000u, kLimbPipelineChunks, &trace) && sameFile(outputPath, expectedPath) &&
+    trace.write(tracePath, error);
+  for (const char* stage : {"read", "solve", "write"}) ok = ok && trace.rows(stage) == _solved.size();
+  std::string contents;
+  ok = ok && LimbStreamIO::readAll(tracePath, contents, error) && contents == trace.json() &&
+    contents.find("\"args\":{\"name\":\"reader\"}") != std::string::npos;
+  if (!ok) std::fprintf(stderr, "the traced pipeline did not trace every row%s%s\n", error.empty() ? "" : ", ", error.c_str());
+  std::printf("{\"check\":\"stream.pipeline.trace\",\"events\":%zu,\"ok\":%s}\n", trace.size(), jsonBool(ok).c_str());
+  for (const auto& path : {expectedPath, outputPath, tracePath}) std::remove(path.c_str());
+  return ok;
+}
+
+long fileSize(const std::string& _path)
+{
+  LimbStreamIO::File in(_path, "rb");
+  if (!in.file) return 0;
+  std::fseek(in.file, 0, SEEK_END);
+  return std::ftell(in.file);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  const auto options = BenchOptions::parse(argc, argv);
+  auto& pool = ThreadPool::shared();
+  bool ok = checkMappedSolve(pool);
+
+  LimbStream expected;
+  makeStream(expected, kStreamRows);
+  solveLimbStream(expected, pool, kPrecisionExact, kOrientationAngles);
+  const auto csvPath = benchTempPath("stream.csv");
+  const auto rowsPath = benchTempPath("stream.bin");
+  const auto columnsPath = benchTempPath("stream.sikc");
+  std::string error;
+  if (!writeLimbStreamInputs(csvPath, expected, error) || !writeLimbStreamInputs(rowsPath, expected, error) ||
+      !writeLimbColumnsInputs(columnsPath, expected, error))
+  {
+    std::fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+
+  // Each format is read and solved once for the check, then the read is timed alone and with the solve
+  LimbStream stream;
+  LimbColumnsFile mapped;
+  auto solveStream = [&] { solveLimbStream(stream, pool, kPrecisionExact, kOrientationAngles); };
+  struct Format
+  {
+    const char* name;
+    std::string path;
+    std::function<bool()> read;
+    std::function<void()> solve;
+  };
+  const Format formats[] = {
+    {"stream.csv.buffered", csvPath, [&] { return readLimbStreamInputs(csvPath, stream, error); }, solveStream},
+    {"stream.rows.buffered", rowsPath, [&] { return readLimbStreamInputs(rowsPath, stream, error); }, solveStream},
+    {"stream.columns.buffered", columnsPath, [&] { return readColumnsBuffered(columnsPath, stream); }, solveStream},
+    {"stream.columns.mapped", columnsPath, [&]
+    {
+      // Mapping only reserves the address range, every input is touched so the read covers faulting the pages in
+      if (!mapped.open(columnsPath, error)) return false;
+      double sum = 0.0;
+      for (std::size_t c = 0u; c < kLimbStreamInputChannels; ++c)
+      {
+        const double* channel = mapped.channel(c);
+        for (std::size_t i = 0u; i < mapped.rows(); ++i) sum += channel[i];
+      }
+      doNotOptimize(sum);
+      stream.resize(std::size_t(mapped.rows()));
+      return true;
+    }, [&]
+    {
+      // Only the outputs are held in memory
+      solveLimbStream(mappedView(mapped, stream), stream.size(), pool, kPrecisionExact, kOrientationAngles);
+    }}
+  };
+  for (const auto& format : formats)
+  {
+    const bool read = format.read();
+    if (!read) std::fprintf(stderr, "%s failed to read, %s\n", format.name, error.c_str());
+    if (read) format.solve();
+    const bool same = read && sameOutputs(format.name, stream, expected);
+    ok = ok && same;
+    std::printf("{\"check\":%s,\"rows\":%zu,\"ok\":%s}\n", jsonString(format.name).c_str(), kStreamRows, jsonBool(same).c_str());
+    if (!same) continue;
+    const BenchTags tags = {
+      {"rows", std::to_string(kStreamRows)},
+      {"threads", std::to_string(pool.threadCount())},
+      {"file_bytes_per_row", std::to_string(double(fileSize(format.path)) / double(kStreamRows))}
+    };
+    runBench(options, std::string(format.name) + ".read", tags, kStreamRows, [&]
+    {
+      format.read();
+    });
+    runBench(options, std::string(format.name) + ".solve", tags, kStreamRows, [&]
+    {
+      format.read();
+      format.solve();
+    });
+  }
+  mapped.close();
+
+  // Read, solve and write in turn against the pipeline, for the binary rows where the I/O is lightest, and CSV
+  ok = checkPipeline(expected, csvPath, rowsPath, pool) && ok;
+  ok = checkTrace(expected, rowsPath, pool) && ok;
+  for (const auto& input : {rowsPath, csvPath})
+  {
+    const std::string format = isLimbStreamCSV(input) ? "csv" : "rows";
+    const auto outputPath = benchTempPath("stream.out." + format + (format == "csv" ? ".csv" : ".bin"));
+    const BenchTags tags = {{"rows", std::to_string(kStreamRows)}, {"threads", std::to_string(pool.threadCount())}};
+    runBench(options, "stream.sequential." + format, tags, kStreamRows, [&]
+    {
+      readLimbStreamInputs(input, stream, error);
+      solveLimbStream(stream, pool, kPrecisionExact, kOrientationAngles);
+      writeLimbStreamOutputs(outputPath, stream, error);
+    });
+    LimbPipelineStats stats;
+    const auto result = runBench(options, "stream.pipeline." + format, tags, kStreamRows, [&]
+    {
+      runPipeline(input, outputPath, pool, stats, error);
+    });
+    if (result.p50 > 0.0)
+    {
+      std::printf("{\"pipeline\":%s,%s}\n", jsonString("stream.pipeline." + format).c_str(), stats.json().c_str());
+      std::fflush(stdout);
+    }
+    // With every chunk traced on its stage
+    runBench(options, "stream.pipeline." + format + ".traced", tags, kStreamRows, [&]
+    {
+      TraceEventWriter trace;
+      runPipeline(input, outputPath, pool, stats, error, kLimbPipelineChunkRows, kLimbPipelineChunks, &trace);
+    });
+    std::remove(outputPath.c_str());
+  }
+  const std::string paths[] = {csvPath, rowsPath, columnsPath};
+  for (const auto& path : paths) std::remove(path.c_str());
+  return ok ? 0 : 1;
+}
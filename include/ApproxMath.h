@@ -0,0 +1,213 @@
+#ifndef APPROXMATH_INCLUDE_H
+#define APPROXMATH_INCLUDE_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// Math policies for the solvers, selecting how the transcendentals are evaluated.
+// ExactMath uses the std functions, the approximate tiers use Chebyshev fitted polynomials after a range reduction.
+// Maximum absolute errors over the whole domain, measured against the std functions by AccuracyBench:
+//
+//            acos     atan/atan2  exp (relative)  sin/cos
+//   high     4.2e-9   9.7e-9      2.5e-9          2.4e-9
+//   fast     1.1e-5   2.0e-5      3.5e-6          1.1e-6
+//
+// Through a whole two bone solve the bend and incline angles stay within 1.5e-8 (high) and 3.1e-5 (fast) radians,
+// the orientation matrix within 2.1e-8 and 1.4e-6, and the euler angles within 2.2e-7 and 3.4e-5 radians
+// outside 3 degrees of the Y gimbal singularity.
+// sqrt is left to the hardware, which is already exact and cheap.
+
+// Precision tiers, as exposed by the node precision attributes
+enum SolvePrecision
+{
+  kPrecisionExact = 0,
+  kPrecisionHigh = 1,
+  kPrecisionFast = 2
+};
+
+struct ExactMath
+{
+  template <typename T>
+  inline static T acos(T x) { return std::acos(x); }
+
+  template <typename T>
+  inline static T atan(T x) { return std::atan(x); }
+
+  template <typename T>
+  inline static T atan2(T y, T x) { return std::atan2(y, x); }
+
+  template <typename T>
+  inline static T exp(T x) { return std::exp(x); }
+
+  template <typename T>
+  inline static void sincos(T x, T& o_sin, T& o_cos)
+  {
+    o_sin = std::sin(x);
+    o_cos = std::cos(x);
+  }
+};
+
+// Evaluates c0 + c1 x + c2 x^2 + ... with Horner's scheme
+template <typename T>
+inline static T horner(T, double c)
+{
+  return T(c);
+}
+
+template <typename T, typename... TCoefficients>
+inline static T horner(T x, double c, TCoefficients... cs)
+{
+  return T(c) + x * horner(x, cs...);
+}
+
+// Range reductions shared by the tiers, TPolynomials supplies the fitted kernels
+template <typename TPolynomials>
+struct PolynomialMath
+{
+  // Valid for x in [-1, 1], acos(x) = sqrt(1 - x) P(x) on [0, 1], and pi - acos(-x) below
+  template <typename T>
+  inline static T acos(T x)
+  {
+    const T ax = std::abs(x);
+    const T r = std::sqrt(T(1) - ax) * TPolynomials::acos(ax);
+    return x < T(0) ? T(M_PI) - r : r;
+  }
+
+  // atan on [0, 1] is a P(a^2), larger magnitudes use atan(a) = pi/2 - atan(1/a)
+  template <typename T>
+  inline static T atan(T x)
+  {
+    const T ax = std::abs(x);
+    const T a = ax > T(1) ? T(1) / ax : ax;
+    const T r = a * TPolynomials::atan(a * a);
+    return std::copysign(ax > T(1) ? T(M_PI_2) - r : r, x);
+  }
+
+  // The same polynomial for atan2, the octant is restored from the signs and the larger component
+  template <typename T>
+  inline static T atan2(T y, T x)
+  {
+    const T ax = std::abs(x);
+    const T ay = std::abs(y);
+    const T hi = ax > ay ? ax : ay;
+    if (hi == T(0)) return std::copysign(std::signbit(x) ? T(M_PI) : T(0), y);
+    const T a = (ax > ay ? ay : ax) / hi;
+    T r = a * TPolynomials::atan(a * a);
+    if (ay > ax) r = T(M_PI_2) - r;
+    if (std::signbit(x)) r = T(M_PI) - r;
+    return std::copysign(r, y);
+  }
+
+  // exp(x) = 2^n exp(r), with |r| <= ln2 / 2, and 2^n built straight in the exponent bits,
+  // results below the smallest normal are flushed to zero
+  template <typename T>
+  inline static T exp(T x)
+  {
+    if (!(x >= T(-708.39641853226408))) return x != x ? x : T(0);
+    if (x > T(709)) return T(HUGE_VAL);
+    const double n = std::floor(double(x) * M_LOG2E + 0.5);
+    const T r = x - T(n * M_LN2);
+    const std::int64_t bits = (std::int64_t(n) + 1023) << 52;
+    double scale;
+    std::memcpy(&scale, &bits, sizeof(scale));
+    return TPolynomials::exp(r) * T(scale);
+  }
+
+  // Reduced by quarter turns to [-pi/4, pi/4], where sin is odd and cos is even
+  template <typename T>
+  inline static void sincos(T x, T& o_sin, T& o_cos)
+  {
+    const double n = std::floor(double(x) * M_2_PI + 0.5);
+    const T r = x - T(n * M_PI_2);
+    const T r2 = r * r;
+    const T s = r * TPolynomials::sin(r2);
+    const T c = TPolynomials::cos(r2);
+    switch (std::int64_t(n) & 3)
+    {
+      case 0: o_sin = s; o_cos = c; break;
+      case 1: o_sin = c; o_cos = -s; break;
+      case 2: o_sin = -s; o_cos = -c; break;
+      default: o_sin = -c; o_cos = s; break;
+    }
+  }
+};
+
+// About single precision accuracy, for when the result is still compared against other solves
+struct HighPolynomials
+{
+  template <typename T>
+  inline static T acos(T x)
+  {
+    return horner(x, 1.5707963226438151, -0.21460116073177316, 0.089030136941831178, -0.050593573902801822,
+        0.032571170253725593, -0.020727665434681811, 0.011028380894054456, -0.0039745778518004548, 0.0006845318554648353);
+  }
+
+  template <typename T>
+  inline static T atan(T x2)
+  {
+    return horner(x2, 0.99999998178865579, -0.33333036709292851, 0.1999187202926431, -0.1419779779540799,
+        0.10618370642479312, -0.074568548385217232, 0.042137623745702513, -0.015731249223588546, 0.0027662835283182277);
+  }
+
+  template <typename T>
+  inline static T exp(T r)
+  {
+    return horner(r, 1.0000000000000002, 1.000000037716215, 0.50000000471177553, 0.16666415514648852,
+        0.041666352896620275, 0.0083751263984671587, 0.0013941108445916731);
+  }
+
+  template <typename T>
+  inline static T sin(T r2)
+  {
+    return horner(r2, 0.99999999691770158, -0.16666650673994587, 0.0083320357855401136, -0.00019503904246507059);
+  }
+
+  template <typename T>
+  inline static T cos(T r2)
+  {
+    return horner(r2, 1.0000000000000004, -0.49999999861201594, 0.041666636654325587, -0.0013887135667688859,
+        2.442178574055562e-05);
+  }
+};
+
+// Around 1e-4 radians on the solved angles, plenty for background characters
+struct FastPolynomials
+{
+  template <typename T>
+  inline static T acos(T x)
+  {
+    return horner(x, 1.5707854593110482, -0.21405062579737236, 0.084303826616105942, -0.035183264175977058,
+        0.0083645494676915181);
+  }
+
+  template <typename T>
+  inline static T atan(T x2)
+  {
+    return horner(x2, 0.99996479840146912, -0.33154461930872031, 0.18446355750906174, -0.09075201792466174,
+        0.023286007732980351);
+  }
+
+  template <typename T>
+  inline static T exp(T r)
+  {
+    return horner(r, 1.0, 0.99996229465075837, 0.49999372138625631, 0.16792143016522859, 0.041875644452319866);
+  }
+
+  template <typename T>
+  inline static T sin(T r2)
+  {
+    return horner(r2, 0.99999856326396053, -0.16662472194586644, 0.0081515063324685607);
+  }
+
+  template <typename T>
+  inline static T cos(T r2)
+  {
+    return horner(r2, 1.0000000000000002, -0.49999937088946611, 0.041658500645120736, -0.0013623440727146526);
+  }
+};
+
+typedef PolynomialMath<HighPolynomials> HighMath;
+typedef PolynomialMath<FastPolynomials> FastMath;
+
+#endif //APPROXMATH_INCLUDE_H
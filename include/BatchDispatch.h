@@ -0,0 +1,157 @@
+#ifndef BATCHDISPATCH_INCLUDE_H
+#define BATCHDISPATCH_INCLUDE_H
+
+#include "TwoBoneIKBatch.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// Runtime choice of instruction set for the batch solves.
+// src/kernels/BatchKernels.cpp is built once per level below, each with its own compiler flags, and linked into the
+// plugin, the core library and the tools, so one binary runs on the oldest farm node and uses AVX-512 where it can.
+// The rest of the code stays at the SSSE3 baseline of the makefile, only the kernels are called through BatchDispatch.
+// The levels agree to the batch tolerance of TwoBoneIKBatch.h, the AVX levels contract to FMA and the baseline does not.
+
+enum SimdLevel
+{
+  // The makefile baseline, SSSE3 with each pack of 4 split over two registers
+  kSimdSSE = 0,
+  // AVX2 and FMA, one 4 wide pack per register
+  kSimdAVX2 = 1,
+  // AVX-512 F, DQ and VL, one 8 wide pack per register
+  kSimdAVX512 = 2,
+  kSimdLevelCount = 3
+};
+
+// The entry points of one build of the kernels
+struct BatchKernels
+{
+  const char* name;
+  // Limbs per pack, parallel chunks are rounded to it
+  unsigned width;
+  void (*solveTwoBoneIK)(const TwoBoneIKBatch& _batch, std::size_t _count);
+  void (*solveInclineAngle)(const InclineAngleBatch& _batch, std::size_t _count);
+};
+
+// Defined in BatchKernels.cpp, only call those of levels simdLevelSupported accepts
+extern const BatchKernels kBatchKernelsSSE;
+extern const BatchKernels kBatchKernelsAVX2;
+extern const BatchKernels kBatchKernelsAVX512;
+
+inline const BatchKernels& batchKernels(SimdLevel _level)
+{
+  switch (_level)
+  {
+    case kSimdAVX512: return kBatchKernelsAVX512;
+    case kSimdAVX2: return kBatchKernelsAVX2;
+    default: return kBatchKernelsSSE;
+  }
+}
+
+// Whether this cpu and os can run the kernels of _level
+inline bool simdLevelSupported(SimdLevel _level)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  switch (_level)
+  {
+    case kSimdSSE: return __builtin_cpu_supports("ssse3");
+    case kSimdAVX2: return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    case kSimdAVX512:
+      return simdLevelSupported(kSimdAVX2) && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq") &&
+          __builtin_cpu_supports("avx512vl");
+    default: return false;
+  }
+#else
+  return _level == kSimdSSE;
+#endif
+}
+
+// The highest level this cpu runs
+inline SimdLevel bestSimdLevel()
+{
+  for (int level = kSimdLevelCount - 1; level > kSimdSSE; --level)
+  {
+    if (simdLevelSupported(SimdLevel(level))) return SimdLevel(level);
+  }
+  return kSimdSSE;
+}
+
+// Parses the names the kernels report, "sse", "avx2" or "avx512"
+inline bool parseSimdLevel(const char* _name, SimdLevel& o_level)
+{
+  for (int level = kSimdSSE; level < kSimdLevelCount; ++level)
+  {
+    if (std::strcmp(_name, batchKernels(SimdLevel(level)).name) == 0)
+    {
+      o_level = SimdLevel(level);
+      return true;
+    }
+  }
+  return false;
+}
+
+// The kernels the batch solves go through, the best level for this cpu unless select picks another.
+// The plugin selects at load and reports a bad SIMPLEIK_SIMD, code that never selects takes the environment on first use
+class BatchDispatch
+{
+public:
+  static const BatchKernels& kernels() { return batchKernels(level()); }
+
+  static SimdLevel level()
+  {
+    int current = levelStore().load(std::memory_order_acquire);
+    if (current < 0)
+    {
+      std::string error;
+      selectFromEnvironment(error);
+      current = levelStore().load(std::memory_order_acquire);
+    }
+    return SimdLevel(current);
+  }
+
+  // Fails and keeps the current level when the cpu can not run _level
+  static bool select(SimdLevel _level, std::string& o_error)
+  {
+    if (!simdLevelSupported(_level))
+    {
+      o_error = std::string("this cpu does not support ") + batchKernels(_level).name + ", using " + kernels().name;
+      return false;
+    }
+    levelStore().store(_level, std::memory_order_release);
+    return true;
+  }
+
+  // Selects the level named by SIMPLEIK_SIMD when it is set, for testing a lower level on a newer machine,
+  // otherwise the best level. An unknown or unsupported name fails and the best level is used
+  static bool selectFromEnvironment(std::string& o_error)
+  {
+    levelStore().store(bestSimdLevel(), std::memory_order_release);
+    const char* name = std::getenv("SIMPLEIK_SIMD");
+    if (!name || !*name) return true;
+    SimdLevel requested;
+    if (!parseSimdLevel(name, requested))
+    {
+      o_error = std::string("SIMPLEIK_SIMD: unknown level ") + name + ", expected sse, avx2 or avx512";
+      return false;
+    }
+    if (!select(requested, o_error))
+    {
+      o_error = "SIMPLEIK_SIMD: " + o_error;
+      return false;
+    }
+    return true;
+  }
+
+private:
+  // Negative until the first use or select
+  static std::atomic<int>& levelStore()
+  {
+    static std::atomic<int> level(-1);
+    return level;
+  }
+};
+
+#endif //BATCHDISPATCH_INCLUDE_H
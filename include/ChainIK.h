@@ -0,0 +1,210 @@
+#ifndef CHAINIK_INCLUDE_H
+#define CHAINIK_INCLUDE_H
+
+#include "Utils.h"
+#include "ChainIKSolver.h"
+#include "ChainIKStats.h"
+#include <maya/MDGContext.h>
+#include <maya/MTime.h>
+#include <atomic>
+#include <mutex>
+
+// Largest jump in evaluation time, in 24 fps frames, that still warm starts from the previous solve.
+// Playback and scrubbing step a frame or two, anything further is treated as a cut
+static constexpr double kChainIKWarmStartFrames = 2.0;
+
+template<typename TClass, const char* TTypeName>
+class ChainIKNode : public BaseNode<TClass, TTypeName>, public ChainIKStatsSource
+{
+public:
+  ChainIKNode() { ChainIKStatsRegistry::instance().add(this); }
+  ~ChainIKNode() override { ChainIKStatsRegistry::instance().remove(this); }
+
+  static MStatus initialize()
+  {
+    // Create all of our inputs
+    // target location is the position the tip of the chain is aimed at
+    createAttribute(m_inputTargetLocation, "targetLocation", DefaultValue<MVector>());
+    // One element per bone, from the root out, this decides how many bones are solved
+    createAttribute(m_inputJointLengths, "jointLengths", 0.0, true, true);
+    createAttribute(m_inputPoleVector, "poleVector", DefaultValue<MVector>());
+    createAttribute(m_inputTwist, "twist", DefaultValue<MAngle>());
+    createAttribute(m_inputSoften, "soften", 0.0);
+    createAttribute(m_inputDoSoften, "doSoften", true);
+    createAttribute(m_inputStretchStrength, "stretchStrength", 1.0);
+    // The solve stops after this many iterations, or earlier once the tip is within tolerance of the target
+    createAttribute(m_inputMaxIterations, "maxIterations", 16);
+    createAttribute(m_inputTolerance, "tolerance", 1e-6);
+    createEnumAttribute(m_inputMethod, "method", {"fabrik", "ccd"}, kChainIKFABRIK);
+    // Start from the previous frame's pose, turn off for results that do not depend on the evaluation order
+    createAttribute(m_inputWarmStart, "warmStart", true);
+
+    // One rotation per bone, relative to the parent bone
+    createAttribute(m_outputRotations, "rotations", DefaultValue<MEulerRotation>(), false, true);
+    createAttribute(m_outputStretchedLengths, "stretchedLengths", 0.0, false, true);
+    createAttribute(m_outputIterations, "iterations", 0, false);
+
+    // Tell maya about our arributes
+    addAttributes(
+        m_inputTargetLocation, m_inputJointLengths, m_inputPoleVector, m_inputTwist, m_inputSoften, m_inputDoSoften, m_inputStretchStrength,
+        m_inputMaxIterations, m_inputTolerance, m_inputMethod, m_inputWarmStart,
+        m_outputRotations, m_outputStretchedLengths, m_outputIterations
+        );
+    // Tell maya what inputs will affect our outputs
+    setAffects(
+        {m_inputTargetLocation, m_inputJointLengths},
+        m_outputRotations, m_outputStretchedLengths, m_outputIterations
+        );
+    setAffects(
+        {m_inputPoleVector, m_inputTwist, m_inputSoften, m_inputDoSoften, m_inputMaxIterations, m_inputTolerance, m_inputMethod, m_inputWarmStart},
+        m_outputRotations, m_outputIterations
+        );
+    setAffects(m_inputStretchStrength, m_outputStretchedLengths);
+
+    return MS::kSuccess;
+  }
+
+  virtual MStatus compute(const MPlug& _plug, MDataBlock& io_dataBlock)
+  {
+    if (shouldCompute(_plug, m_outputRotations, m_outputIterations))
+    {
+      AttributeData ad(io_dataBlock);
+      std::lock_guard<std::mutex> lock(m_solveMutex);
+      const auto& lengths = m_lengths;
+      ad.get(m_inputJointLengths, m_lengths);
+      // Calculate the softness value
+      const auto dsoft = ad.get<double>(m_inputSoften) * ad.get<bool>(m_inputDoSoften);
+
+      // The previous pose is only a good start for nearby times and the same bones
+      const auto time = io_dataBlock.context().getTime().as(MTime::kFilm);
+
+      const bool warmStart = ad.get<bool>(m_inputWarmStart) && m_warmStartValid &&
+        std::abs(time - m_warmStartTime) <= kChainIKWarmStartFrames && lengths == m_warmStartLengths;
+      m_rotations.resize(lengths.size());
+      const auto result = solveChainIK(
+          toVector3(ad.get<MVector>(m_inputTargetLocation)),
+          toVector3(ad.get<MVector>(m_inputPoleVector)),
+          lengths.data(),
+          lengths.size(),
+          ad.get<MAngle>(m_inputTwist).asRadians(),
+          dsoft,
+          unsigned(std::max(ad.get<int>(m_inputMaxIterations), 0)),
+          ad.get<double>(m_inputTolerance),
+          ChainIKMethod(ad.get<short>(m_inputMethod)),
+          m_pose,
+          m_rotations.data(),
+          warmStart);
+      m_warmStartValid = true;
+      m_warmStartTime = time;
+      m_warmStartLengths = lengths;
+      m_solves.fetch_add(1u, std::memory_order_relaxed);
+      if (warmStart) m_warmSolves.fetch_add(1u, std::memory_order_relaxed);
+      m_iterations.fetch_add(result.iterations, std::memory_order_relaxed);
+
+      // Output the values
+      auto& rotations = m_eulerRotations;
+      rotations.resize(m_rotations.size());
+      for (std::size_t i = 0u; i < rotations.size(); ++i) rotations[i] = toMEulerRotation(m_rotations[i]);
+      ad.set(m_outputRotations, rotations);
+      ad.set(m_outputIterations, int(result.iterations));
+      return MS::kSuccess;
+    }
+    if (shouldCompute(_plug, m_outputStretchedLengths))
+    {
+      AttributeData ad(io_dataBlock);
+      std::lock_guard<std::mutex> lock(m_solveMutex);
+      auto& lengths = m_stretchedLengths;
+      ad.get(m_inputJointLengths, lengths);
+      // Every bone stretches by the same factor, as both edges of the two bone solve do
+      const auto targetLength = toVector3(ad.get<MVector>(m_inputTargetLocation)).length();
+      const auto stretchStrength = ad.get<double>(m_inputStretchStrength);
+      double chainLength = 0.0;
+      for (auto length : lengths) chainLength += length;
+      for (auto& length : lengths) length = stretchEdge(length, targetLength, chainLength, stretchStrength);
+
+      // Output the values
+      ad.set(m_outputStretchedLengths, lengths);
+      return MS::kSuccess;
+    }
+    return MS::kUnknownParameter;
+  }
+
+  std::string statsName() const override { return this->name().asChar(); }
+
+  ChainIKWarmStartStats warmStartStats() const override
+  {
+    return {m_solves.load(std::memory_order_relaxed), m_warmSolves.load(std::memory_order_relaxed), m_iterations.load(std::memory_order_relaxed)};
+  }
+
+  void resetWarmStartStats() override
+  {
+    m_solves.store(0u, std::memory_order_relaxed);
+    m_warmSolves.store(0u, std::memory_order_relaxed);
+    m_iterations.store(0u, std::memory_order_relaxed);
+  }
+
+private:
+  // Joint positions and rotations of the last solve, kept on the node so repeated computes reuse the allocation,
+  // the positions also seed the next warm solve
+  std::mutex m_solveMutex;
+  ChainIKPose<double> m_pose;
+  std::vector<EulerRotation<double>> m_rotations;
+  // The attribute arrays, kept for the same reason
+  std::vector<double> m_lengths;
+  std::vector<MEulerRotation> m_eulerRotations;
+  std::vector<double> m_stretchedLengths;
+  // When and for which bones m_pose was solved
+  bool m_warmStartValid = false;
+  double m_warmStartTime = 0.0;
+  std::vector<double> m_warmStartLengths;
+
+  std::atomic<unsigned long long> m_solves{0u};
+  std::atomic<unsigned long long> m_warmSolves{0u};
+  std::atomic<unsigned long long> m_iterations{0u};
+
+  static Attribute m_inputTargetLocation;
+  static Attribute m_inputJointLengths;
+  static Attribute m_inputPoleVector;
+  static Attribute m_inputTwist;
+  static Attribute m_inputSoften;
+  static Attribute m_inputDoSoften;
+  static Attribute m_inputStretchStrength;
+  static Attribute m_inputMaxIterations;
+  static Attribute m_inputTolerance;
+  static Attribute m_inputMethod;
+  static Attribute m_inputWarmStart;
+  static Attribute m_outputRotations;
+  static Attribute m_outputStretchedLengths;
+  static Attribute m_outputIterations;
+};
+
+#define MEMDECL(NAME) \
+template<typename TClass, const char* TTypeName> \
+Attribute ChainIKNode<TClass, TTypeName>::NAME
+
+MEMDECL(m_inputTargetLocation);
+MEMDECL(m_inputJointLengths);
+MEMDECL(m_inputPoleVector);
+MEMDECL(m_inputTwist);
+MEMDECL(m_inputSoften);
+MEMDECL(m_inputDoSoften);
+MEMDECL(m_inputStretchStrength);
+MEMDECL(m_inputMaxIterations);
+MEMDECL(m_inputTolerance);
+MEMDECL(m_inputMethod);
+MEMDECL(m_inputWarmStart);
+MEMDECL(m_outputRotations);
+MEMDECL(m_outputStretchedLengths);
+MEMDECL(m_outputIterations);
+
+#undef MEMDECL
+
+#define CHAINIK_NODE(NodeName) \
+TEMPLATE_PARAMETER_LINKAGE char name##NodeName[] = #NodeName; \
+class NodeName : public ChainIKNode<NodeName, name##NodeName> {};
+
+CHAINIK_NODE(chainIK);
+
+#undef CHAINIK_NODE
+
+#endif //CHAINIK_INCLUDE_H
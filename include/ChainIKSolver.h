@@ -0,0 +1,390 @@
+#ifndef CHAINIKSOLVER_INCLUDE_H
+#define CHAINIKSOLVER_INCLUDE_H
+
+#include "TwoBoneIKSolver.h"
+#include <cstddef>
+#include <vector>
+
+// Iterative solve for chains of any number of bones, for spines, tails and tentacles.
+// The chain starts at the origin and, like the two bone solve, bends in the plane of the target and the pole vector.
+// A cold solve starts from the same pose, an arc bowed towards the twisted pole, so its result does not depend on history.
+// A warm solve starts from the pose of the previous solve instead, so under animation the chain keeps its shape, its
+// result then depends on history within the tolerance.
+// Either starting pose has its bends scaled until the tip is at the target distance, so FABRIK or CCD only iterate when
+// no scale gets there, for chains folded up tighter than the starting pose or a fold about the longest bone allow.
+// The joint positions are kept as contiguous x, y, z arrays, which is what every iteration loops over.
+
+enum ChainIKMethod
+{
+  // Forward and backward reaching, moves the joints along the bones
+  kChainIKFABRIK = 0,
+  // Cyclic coordinate descent, rotates the chain one joint at a time from the tip
+  kChainIKCCD = 1
+};
+
+// Joint positions of a chain, one more joint than bones, the root is the first
+template <typename T>
+struct ChainIKPose
+{
+  std::vector<T> x, y, z;
+  // Bone angles in the bend plane, scratch for fitChainIKBend
+  std::vector<T> bends;
+
+  void resize(std::size_t _joints)
+  {
+    x.resize(_joints);
+    y.resize(_joints);
+    z.resize(_joints);
+  }
+
+  std::size_t size() const { return x.size(); }
+
+  Vector3<T> joint(std::size_t _i) const { return Vector3<T>(x[_i], y[_i], z[_i]); }
+
+  void setJoint(std::size_t _i, const Vector3<T>& _p)
+  {
+    x[_i] = _p.x;
+    y[_i] = _p.y;
+    z[_i] = _p.z;
+  }
+};
+
+template <typename T>
+struct ChainIKResult
+{
+  // Iterations run before the tip reached the target, zero when the target is out of reach or the starting pose met it
+  unsigned iterations;
+  // Distance from the tip to the softened target
+  T error;
+};
+
+// Bend of the starting arc, from +kChainIKRestBend at the root to -kChainIKRestBend at the tip
+static constexpr double kChainIKRestBend = M_PI / 6.0;
+
+// Unit aim at the target, and unit up from the pole with the aim removed and the extra twist applied.
+// The fallbacks for a zero target or a pole on the aim line are those of solveRootFrame
+template <typename T>
+inline void chainIKPlane(const Vector3<T>& _targetLocation, const Vector3<T>& _poleVector, T extraTwist, Vector3<T>& o_aim, Vector3<T>& o_up)
+{
+  // With no interior angle the frame rows are the aim and up directions
+  const auto frame = solveRootFrame<T>(_targetLocation, _poleVector, T(1), T(0), T(1), extraTwist);
+  o_aim = Vector3<T>(frame.m[0][0], frame.m[0][1], frame.m[0][2]);
+  o_up = Vector3<T>(frame.m[1][0], frame.m[1][1], frame.m[1][2]);
+}
+
+// Lays the chain out as an arc bowed towards _up, or with _fold, with the longest bone along _aim and the bones before
+// it turned towards _up and those after it away by the rest bend, which unlike the arc folds down to the shortest reach
+// of a chain with one long bone
+template <typename T>
+inline void initChainIKPose(ChainIKPose<T>& io_pose, const T* _lengths, std::size_t _bones, const Vector3<T>& _aim, const Vector3<T>& _up, bool _fold = false)
+{
+  std::size_t longest = 0u;
+  for (std::size_t i = 1u; _fold && i < _bones; ++i)
+    if (_lengths[i] > _lengths[longest]) longest = i;
+  io_pose.resize(_bones + 1u);
+  io_pose.setJoint(0u, Vector3<T>());
+  for (std::size_t i = 0u; i < _bones; ++i)
+  {
+    T bend = _bones > 1u ? T(kChainIKRestBend) * (T(1) - T(2 * i) / T(_bones - 1u)) : T(0);
+    if (_fold) bend = i < longest ? T(kChainIKRestBend) : i > longest ? T(-kChainIKRestBend) : T(0);
+    const auto direction = _aim * std::cos(bend) + _up * std::sin(bend);
+    io_pose.setJoint(i + 1u, io_pose.joint(i) + direction * _lengths[i]);
+  }
+}
+
+// Seeds a warm solve from the previous pose, turned into the current bend plane by removing the _side component
+// of every joint and laying the bones back out at their lengths from the root.
+// Returns false when the pose cannot be used, a different number of joints, or a straight chain that has no bends to fit
+template <typename T>
+inline bool seedChainIKPose(
+    ChainIKPose<T>& io_pose, const T* _lengths, std::size_t _bones, T _chainLength, const Vector3<T>& _side)
+{
+  if (io_pose.size() != _bones + 1u) return false;
+  Vector3<T> parent;
+  io_pose.setJoint(0u, parent);
+  for (std::size_t i = 0u; i < _bones; ++i)
+  {
+    auto joint = io_pose.joint(i + 1u);
+    joint = joint - _side * (joint * _side);
+    const auto bone = joint - parent;
+    const T boneLength = bone.length();
+    if (!(boneLength > T(0))) return false;
+    parent = parent + bone * (_lengths[i] / boneLength);
+    io_pose.setJoint(i + 1u, parent);
+  }
+  return parent.length() < _chainLength * (T(1) - T(1e-6));
+}
+
+// Distance from the root to the tip with every bone angle scaled by _scale, and its derivative by _scale
+template <typename T>
+inline static T chainIKBendReach(const std::vector<T>& _bends, const T* _lengths, T _scale, T& o_slope, T& o_angle)
+{
+  T x = T(0), y = T(0), dx = T(0), dy = T(0);
+  for (std::size_t i = 0u; i < _bends.size(); ++i)
+  {
+    const T c = _lengths[i] * std::cos(_bends[i] * _scale);
+    const T s = _lengths[i] * std::sin(_bends[i] * _scale);
+    x += c;
+    y += s;
+    dx -= s * _bends[i];
+    dy += c * _bends[i];
+  }
+  const T reach = std::sqrt(x * x + y * y);
+  o_slope = reach > T(0) ? (x * dx + y * dy) / reach : T(0);
+  o_angle = std::atan2(y, x);
+  return reach;
+}
+
+// Scales the angle of every bone of a pose in the bend plane against the line from the root to its tip until the tip
+// is _targetLength from the root, then lays the bones out again with the tip along _aim.
+// Scaling down straightens the chain and scaling up folds it, up to the first bone turning back on itself.
+// Returns false when no scale gets within _tolerance, the pose is then only turned so its tip lies along _aim
+template <typename T>
+inline bool fitChainIKBend(
+    ChainIKPose<T>& io_pose, const T* _lengths, std::size_t _bones, T _targetLength, T _tolerance, const Vector3<T>& _aim, const Vector3<T>& _up)
+{
+  const auto tip = io_pose.joint(_bones);
+  const T tipAngle = std::atan2(tip * _up, tip * _aim);
+  auto& bends = io_pose.bends;
+  bends.resize(_bones);
+  T largest = T(0);
+  for (std::size_t i = 0u; i < _bones; ++i)
+  {
+    const auto bone = io_pose.joint(i + 1u) - io_pose.joint(i);
+    T bend = std::atan2(bone * _up, bone * _aim) - tipAngle;
+    if (bend > T(M_PI)) bend -= T(2.0 * M_PI);
+    else if (bend < T(-M_PI)) bend += T(2.0 * M_PI);
+    bends[i] = bend;
+    largest = std::max(largest, std::abs(bend));
+  }
+
+  // Bracket the scale between one that leaves the tip beyond the target and one that brings it within, stepping from
+  // the pose as it is to the first bone turning back, and looking for the closest reach wherever the tip turns away.
+  // No scale brings it within when the pose is straight already
+  static constexpr int kSteps = 8;
+  const T limit = largest > T(0) ? std::max(T(M_PI) / largest, T(1)) : T(1);
+  T slope, angle, reach;
+  T low = T(0), high = T(1);
+  bool bracketed = false;
+  for (int step = 0; step <= kSteps && !bracketed && largest > T(0); ++step)
+  {
+    const T scale = T(1) + (limit - T(1)) * T(step) / T(kSteps);
+    reach = chainIKBendReach(bends, _lengths, scale, slope, angle);
+    if (reach <= _targetLength)
+    {
+      high = scale;
+      bracketed = true;
+    }
+    else if (slope > T(0))
+    {
+      // Halve down to where the reach stops falling
+      T fall = low, rise = scale;
+      for (int i = 0; i < 64 && rise - fall > std::numeric_limits<T>::epsilon() * rise; ++i)
+      {
+        const T middle = (fall + rise) * T(0.5);
+        const T middleReach = chainIKBendReach(bends, _lengths, middle, slope, angle);
+        if (middleReach <= _targetLength)
+        {
+          high = middle;
+          bracketed = true;
+          break;
+        }
+        (slope > T(0) ? rise : fall) = middle;
+      }
+    }
+    if (!bracketed) low = scale;
+  }
+
+  // Newton steps on the scale, falling back to halving the bracket when a step leaves it
+  T scale = bracketed ? (low + high) * T(0.5) : T(1);
+  reach = chainIKBendReach(bends, _lengths, scale, slope, angle);
+  for (int i = 0; bracketed && i < 64 && std::abs(reach - _targetLength) > _tolerance * T(0.25); ++i)
+  {
+    (reach > _targetLength ? low : high) = scale;
+    const T step = slope != T(0) ? scale - (reach - _targetLength) / slope : low;
+    scale = step > low && step < high ? step : (low + high) * T(0.5);
+    reach = chainIKBendReach(bends, _lengths, scale, slope, angle);
+  }
+
+  Vector3<T> joint;
+  for (std::size_t i = 0u; i < _bones; ++i)
+  {
+    const T bend = bends[i] * scale - angle;
+    joint = joint + (_aim * std::cos(bend) + _up * std::sin(bend)) * _lengths[i];
+    io_pose.setJoint(i + 1u, joint);
+  }
+  return std::abs(reach - _targetLength) <= _tolerance;
+}
+
+// Rotation matrix with the given rows
+template <typename T>
+inline Matrix3<T> chainIKFrame(const Vector3<T>& _row0, const Vector3<T>& _row1, const Vector3<T>& _row2)
+{
+  Matrix3<T> out;
+  const Vector3<T>* rows[3] = {&_row0, &_row1, &_row2};
+  for (int r = 0; r < 3; ++r)
+  {
+    out.m[r][0] = rows[r]->x;
+    out.m[r][1] = rows[r]->y;
+    out.m[r][2] = rows[r]->z;
+  }
+  return out;
+}
+
+// Rotation of a joint relative to its parent from both world frames
+template <typename T>
+inline EulerRotation<T> chainIKLocalRotation(const Matrix3<T>& _world, const Matrix3<T>& _parent)
+{
+  // Row vectors, so the local rotation is world * inverse(parent), and the inverse of a rotation is its transpose
+  Matrix3<T> parentInverse;
+  for (int r = 0; r < 3; ++r)
+    for (int c = 0; c < 3; ++c)
+      parentInverse.m[r][c] = _parent.m[c][r];
+  return solveRootEuler(_world * parentInverse);
+}
+
+// Places joint _to at _length from joint _from, along the direction from _from to where _to was
+template <typename T>
+inline static void chainIKReach(ChainIKPose<T>& io_pose, std::size_t _from, std::size_t _to, T _length)
+{
+  const T dx = io_pose.x[_to] - io_pose.x[_from];
+  const T dy = io_pose.y[_to] - io_pose.y[_from];
+  const T dz = io_pose.z[_to] - io_pose.z[_from];
+  const T scale = _length / std::max(std::sqrt(dx * dx + dy * dy + dz * dz), std::numeric_limits<T>::min());
+  io_pose.x[_to] = io_pose.x[_from] + dx * scale;
+  io_pose.y[_to] = io_pose.y[_from] + dy * scale;
+  io_pose.z[_to] = io_pose.z[_from] + dz * scale;
+}
+
+template <typename T>
+inline static T chainIKTipError(const ChainIKPose<T>& _pose, std::size_t _tip, const Vector3<T>& _target)
+{
+  return (_pose.joint(_tip) - _target).length();
+}
+
+template <typename T>
+inline ChainIKResult<T> solveChainFABRIK(
+    ChainIKPose<T>& io_pose, const T* _lengths, std::size_t _bones, const Vector3<T>& _target, unsigned _maxIterations, T _tolerance)
+{
+  ChainIKResult<T> result = {0u, chainIKTipError(io_pose, _bones, _target)};
+  while (result.iterations < _maxIterations && result.error > _tolerance)
+  {
+    // Backward, from the target to the root
+    io_pose.setJoint(_bones, _target);
+    for (std::size_t i = _bones; i-- > 0u;) chainIKReach(io_pose, i + 1u, i, _lengths[i]);
+    // Forward, from the root back out to the tip
+    io_pose.setJoint(0u, Vector3<T>());
+    for (std::size_t i = 0u; i < _bones; ++i) chainIKReach(io_pose, i, i + 1u, _lengths[i]);
+
+    ++result.iterations;
+    result.error = chainIKTipError(io_pose, _bones, _target);
+  }
+  return result;
+}
+
+template <typename T>
+inline ChainIKResult<T> solveChainCCD(
+    ChainIKPose<T>& io_pose, std::size_t _bones, const Vector3<T>& _target, unsigned _maxIterations, T _tolerance)
+{
+  ChainIKResult<T> result = {0u, chainIKTipError(io_pose, _bones, _target)};
+  while (result.iterations < _maxIterations && result.error > _tolerance)
+  {
+    for (std::size_t j = _bones; j-- > 0u;)
+    {
+      // Rotate everything past joint j so the tip points at the target
+      const auto pivot = io_pose.joint(j);
+      const auto toTip = io_pose.joint(_bones) - pivot;
+      const auto toTarget = _target - pivot;
+      const T lengths = toTip.length() * toTarget.length();
+      if (!(lengths > T(0))) continue;
+      auto axis = toTip ^ toTarget;
+      const T sinR = axis.length() / lengths;
+      const T cosR = (toTip * toTarget) / lengths;
+      if (!(sinR > T(0))) continue;
+      axis = axis.normal();
+      for (std::size_t k = j + 1u; k <= _bones; ++k)
+      {
+        // Rodrigues' rotation about the pivot
+        const auto v = io_pose.joint(k) - pivot;
+        io_pose.setJoint(k, pivot + v * cosR + (axis ^ v) * sinR + axis * ((axis * v) * (T(1) - cosR)));
+      }
+    }
+
+    ++result.iterations;
+    result.error = chainIKTipError(io_pose, _bones, _target);
+  }
+  return result;
+}
+
+// Solves a chain of _bones bones, writing the rotation of each bone relative to its parent into o_rotations.
+// Bones point down their local X axis with local Z normal to the bend plane, the root rotation is relative to the world.
+// As in solveTwoBoneIK the distance to the target is softened over the whole chain length, stretching is left to
+// stretchEdge applied to each bone against the target distance.
+// dsoft is the soften distance, already zeroed when softening is disabled.
+// With _warmStart the solve starts from the pose io_pose holds, falling back to a cold start when it cannot be used
+template <typename T>
+inline ChainIKResult<T> solveChainIK(
+    const Vector3<T>& _targetLocation,
+    const Vector3<T>& _poleVector,
+    const T* _lengths,
+    std::size_t _bones,
+    T extraTwist,
+    T dsoft,
+    unsigned _maxIterations,
+    T _tolerance,
+    ChainIKMethod _method,
+    ChainIKPose<T>& io_pose,
+    EulerRotation<T>* o_rotations,
+    bool _warmStart = false)
+{
+  if (!_bones) return {0u, T(0)};
+  Vector3<T> aim, up;
+  chainIKPlane(_targetLocation, _poleVector, extraTwist, aim, up);
+  T chainLength = T(0);
+  for (std::size_t i = 0u; i < _bones; ++i) chainLength += _lengths[i];
+  const auto targetLength = softenEdge(_targetLocation.length(), chainLength, dsoft);
+  const auto target = aim * targetLength;
+  const auto side = aim ^ up;
+
+  ChainIKResult<T> result;
+  if (targetLength >= chainLength)
+  {
+    // Out of reach the chain lies straight along the aim, which is where either solve heads without arriving
+    io_pose.resize(_bones + 1u);
+    io_pose.setJoint(0u, Vector3<T>());
+    T reach = T(0);
+    for (std::size_t i = 0u; i < _bones; ++i) io_pose.setJoint(i + 1u, aim * (reach += _lengths[i]));
+    result = {0u, targetLength - chainLength};
+  }
+  else
+  {
+    if (!(_warmStart && seedChainIKPose(io_pose, _lengths, _bones, chainLength, side) &&
+          fitChainIKBend(io_pose, _lengths, _bones, targetLength, _tolerance, aim, up)))
+    {
+      initChainIKPose(io_pose, _lengths, _bones, aim, up);
+      if (!fitChainIKBend(io_pose, _lengths, _bones, targetLength, _tolerance, aim, up))
+      {
+        // Too close for the arc, fold the chain about its longest bone instead
+        initChainIKPose(io_pose, _lengths, _bones, aim, up, true);
+        fitChainIKBend(io_pose, _lengths, _bones, targetLength, _tolerance, aim, up);
+      }
+    }
+    result = _method == kChainIKCCD ?
+      solveChainCCD(io_pose, _bones, target, _maxIterations, _tolerance) :
+      solveChainFABRIK(io_pose, _lengths, _bones, target, _maxIterations, _tolerance);
+  }
+
+  // Each bone frame has the bone as its first row and the plane normal as its last, as in solveRootFrame
+  Matrix3<T> parent;
+  for (std::size_t i = 0u; i < _bones; ++i)
+  {
+    const auto bone = (io_pose.joint(i + 1u) - io_pose.joint(i)).normal();
+    const auto boneUp = side ^ bone;
+    const auto world = chainIKFrame(bone, boneUp, side);
+    o_rotations[i] = chainIKLocalRotation(world, parent);
+    parent = world;
+  }
+  return result;
+}
+
+#endif //CHAINIKSOLVER_INCLUDE_H
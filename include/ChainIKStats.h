@@ -0,0 +1,82 @@
+#ifndef CHAINIKSTATS_INCLUDE_H
+#define CHAINIKSTATS_INCLUDE_H
+
+#include "ComputeStats.h"
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Solve counts of one chain node since it was created or last reset, how many solves started from the previous pose,
+// and the iterations they ran in total
+struct ChainIKWarmStartStats
+{
+  unsigned long long solves;
+  unsigned long long warmSolves;
+  unsigned long long iterations;
+
+  double averageIterations() const { return solves ? double(iterations) / double(solves) : 0.0; }
+};
+
+// A chain node as the stats command sees it
+class ChainIKStatsSource
+{
+public:
+  virtual ~ChainIKStatsSource() = default;
+  virtual std::string statsName() const = 0;
+  virtual ChainIKWarmStartStats warmStartStats() const = 0;
+  virtual void resetWarmStartStats() = 0;
+};
+
+// The chain nodes alive in the scene, each adds itself when created and removes itself when deleted,
+// so computeStats -chainIK can report the warm start counts of every chain in a scene
+class ChainIKStatsRegistry
+{
+public:
+  static ChainIKStatsRegistry& instance()
+  {
+    static ChainIKStatsRegistry registry;
+    return registry;
+  }
+
+  void add(ChainIKStatsSource* _node)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_nodes.push_back(_node);
+  }
+
+  void remove(ChainIKStatsSource* _node)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_nodes.erase(std::remove(m_nodes.begin(), m_nodes.end(), _node), m_nodes.end());
+  }
+
+  // The nodes as a JSON array, in the order they were created
+  std::string json() const
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::string json = "[";
+    char buffer[256];
+    for (std::size_t i = 0u; i < m_nodes.size(); ++i)
+    {
+      const auto stats = m_nodes[i]->warmStartStats();
+      std::snprintf(buffer, sizeof(buffer), ",\"solves\":%llu,\"warm_solves\":%llu,\"iterations\":%llu,\"average_iterations\":%.3f}",
+          stats.solves, stats.warmSolves, stats.iterations, stats.averageIterations());
+      json += (i ? ",{\"node\":" : "{\"node\":") + ComputeStats::jsonName(m_nodes[i]->statsName()) + buffer;
+    }
+    return json + "]";
+  }
+
+  void reset()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto node : m_nodes) node->resetWarmStartStats();
+  }
+
+private:
+  mutable std::mutex m_mutex;
+  std::vector<ChainIKStatsSource*> m_nodes;
+};
+
+#endif //CHAINIKSTATS_INCLUDE_H
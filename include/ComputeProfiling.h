@@ -0,0 +1,115 @@
+#ifndef COMPUTEPROFILING_INCLUDE_H
+#define COMPUTEPROFILING_INCLUDE_H
+
+#include <maya/MPxNode.h>
+#include <maya/MProfiler.h>
+#include <maya/MString.h>
+#include "ComputeStats.h"
+#include <chrono>
+#include <string>
+
+// Instrumentation of the node computes, events in the maya profiler for the phases of each compute, shown under the
+// SimpleIK category in the Evaluation Toolkit and profiler, and the counts and latencies of ComputeStats.h
+
+// The profiler category, added and removed with the plugin
+struct SimpleIKProfiler
+{
+  static const char* categoryName() { return "SimpleIK"; }
+
+  static int& category()
+  {
+    static int id = -1;
+    return id;
+  }
+
+  static void registerCategory() { category() = MProfiler::addCategory(categoryName(), "SimpleIK node computes"); }
+
+  static void deregisterCategory()
+  {
+    MProfiler::removeCategory(categoryName());
+    category() = -1;
+  }
+};
+
+enum ComputePhase
+{
+  kPhaseAttributeRead = 0,
+  kPhaseSolve = 1,
+  kPhaseEulerReorder = 2,
+  kPhaseAttributeWrite = 3
+};
+
+// A profiler event covering one phase of a compute
+class ComputePhaseScope
+{
+public:
+  explicit ComputePhaseScope(ComputePhase _phase) : m_scope(SimpleIKProfiler::category(), color(_phase), name(_phase)) {}
+
+  static const char* name(ComputePhase _phase)
+  {
+    static const char* const names[] = {"Attribute read", "Solve", "Euler reorder", "Attribute write"};
+    return names[_phase];
+  }
+
+private:
+  static MProfiler::ProfilingColor color(ComputePhase _phase)
+  {
+    static const MProfiler::ProfilingColor colors[] = {MProfiler::kColorA_L2, MProfiler::kColorE_L1, MProfiler::kColorE_L3, MProfiler::kColorA_L3};
+    return colors[_phase];
+  }
+
+  MProfilingScope m_scope;
+};
+
+// Counts a compute of _node into ComputeStats, timed from construction to destruction, unless reject is called
+// for a plug the node does not compute. _type must outlive the counts
+class ComputeStatsScope
+{
+public:
+  ComputeStatsScope(const MPxNode& _node, const char* _type) : m_node(_node), m_type(_type), m_counting(ComputeStats::enabled())
+  {
+    if (m_counting) m_start = Clock::now();
+  }
+
+  ~ComputeStatsScope()
+  {
+    if (!m_counting) return;
+    const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_start).count();
+    ComputeStats::instance().addCompute(&m_node, m_type, nodeName(), std::uint64_t(nanoseconds));
+  }
+
+  ComputeStatsScope(const ComputeStatsScope&) = delete;
+  ComputeStatsScope& operator=(const ComputeStatsScope&) = delete;
+
+  void reject()
+  {
+    if (!m_counting) return;
+    ComputeStats::instance().addRejected(&m_node, m_type, nodeName());
+    m_counting = false;
+  }
+
+  // Counts a compute of _node that was solved with others in a batch, _nanoseconds being its share of the batch
+  static void addBatched(const MPxNode& _node, const char* _type, std::uint64_t _nanoseconds)
+  {
+    ComputeStats::instance().addCompute(&_node, _type, NodeName{_node}, _nanoseconds);
+  }
+
+private:
+  typedef std::chrono::steady_clock Clock;
+
+  // Only called for a node's first count after a reset
+  struct NodeName
+  {
+    const MPxNode& node;
+    std::string operator()() const { return node.name().asChar(); }
+  };
+
+  NodeName nodeName() const { return {m_node}; }
+
+  const MPxNode& m_node;
+  const char* m_type;
+  bool m_counting;
+  Clock::time_point m_start;
+};
+
+#endif //COMPUTEPROFILING_INCLUDE_H
@@ -0,0 +1,61 @@
+#ifndef COMPUTERECORDCOMMAND_INCLUDE_H
+#define COMPUTERECORDCOMMAND_INCLUDE_H
+
+#include <maya/MPxCommand.h>
+#include <maya/MArgList.h>
+#include <maya/MGlobal.h>
+#include <maya/MString.h>
+#include <maya/MFnPlugin.h>
+#include "Utils.h"
+#include "ComputeRecorder.h"
+#include <string>
+
+// Starts and stops recording the node computes, see ComputeRecorder.h.
+//   recordComputes -start <path>   records every compute to a new log at path
+//   recordComputes -stop           writes out the buffered records and closes the log
+// The result is the path of the log being written, or of the log just closed by -stop, and empty when not recording
+class ComputeRecordCommand : public MPxCommand
+{
+public:
+  static const char* name() { return NODE_NAME_PREFIX "recordComputes"; }
+
+  static void* creator() { return new ComputeRecordCommand(); }
+
+  static MStatus registerCommand(MFnPlugin& pluginFn)
+  {
+    return pluginFn.registerCommand(name(), creator);
+  }
+
+  static MStatus deregisterCommand(MFnPlugin& pluginFn)
+  {
+    return pluginFn.deregisterCommand(name());
+  }
+
+  MStatus doIt(const MArgList& _args) override
+  {
+    auto& recorder = ComputeRecorder::instance();
+    std::string error;
+    std::string result = recorder.path();
+    if (_args.length() == 2u && std::string(_args.asString(0u).asChar()) == "-start")
+    {
+      result = _args.asString(1u).asChar();
+      if (!recorder.start(result, error)) return fail(error);
+    }
+    else if (_args.length() == 1u && std::string(_args.asString(0u).asChar()) == "-stop")
+    {
+      if (!recorder.stop(error)) return fail(error);
+    }
+    else if (_args.length()) return MS::kInvalidParameter;
+    setResult(MString(result.c_str()));
+    return MS::kSuccess;
+  }
+
+private:
+  static MStatus fail(const std::string& _error)
+  {
+    MGlobal::displayError(MString(_error.c_str()));
+    return MS::kFailure;
+  }
+};
+
+#endif //COMPUTERECORDCOMMAND_INCLUDE_H
@@ -0,0 +1,359 @@
+#ifndef COMPUTERECORDER_INCLUDE_H
+#define COMPUTERECORDER_INCLUDE_H
+
+#include "LimbStream.h"
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+// Opt in recording of the two bone ik and incline angle node computes, to capture the inputs of production rigs for
+// benchmarks and regression checks.
+// Each compute appends one record of its inputs, its outputs, the node and the evaluation time to a buffer of the thread
+// it ran on, and full buffers are written to a binary log, so computes on different threads never wait on each other.
+// Recording is started and stopped by the plugin command in ComputeRecordCommand.h, or from plugin load to unload by
+// setting SIMPLEIK_RECORD to the path of the log. When it is off a compute only loads one flag.
+// Logs replay through the headless solver, see replayComputeRecords, or convert to limb streams for BatchSolve.
+
+// Logs start with this header, then hold records to the end of the file in native byte order
+struct ComputeRecordHeader
+{
+  char magic[4];
+  std::uint32_t version;
+  std::uint32_t recordSize;
+  std::uint32_t reserved;
+};
+
+static constexpr char kComputeRecordMagic[4] = {'S', 'I', 'K', 'R'};
+static constexpr std::uint32_t kComputeRecordVersion = 1u;
+// Records held per thread before they are written out
+static constexpr std::size_t kComputeRecordBufferRecords = 4096u;
+
+enum ComputeRecordNodeType : std::uint32_t
+{
+  kRecordTwoBoneIKNode = 0u,
+  kRecordInclineAngleNode = 1u
+};
+
+// Outputs solved by a compute, as bits of the output channels in limb stream order
+enum ComputeRecordOutputs : std::uint32_t
+{
+  kRecordBendAngle = 1u,
+  kRecordOrientation = 14u,
+  kRecordStretch = 48u,
+  kRecordInclineAngle = 64u
+};
+
+struct ComputeRecord
+{
+  // Hash of the node name, see computeRecordNodeId
+  std::uint64_t node;
+  // Evaluation time in frames
+  double time;
+  std::uint32_t nodeType;
+  std::uint32_t outputs;
+  std::int32_t precision;
+  std::int32_t orientationMethod;
+  // The limb stream channels, inputs the compute did not read and outputs it did not solve are zero.
+  // Targets are as the solve saw them, the two bone node clamps them away from zero components
+  double inputs[kLimbStreamInputChannels];
+  double outputValues[kLimbStreamOutputChannels];
+};
+
+// FNV-1a, stable across sessions so records of one node can be matched between logs
+inline std::uint64_t computeRecordNodeId(const char* _name)
+{
+  std::uint64_t hash = 14695981039346656037ull;
+  for (; *_name; ++_name) hash = (hash ^ std::uint64_t(static_cast<unsigned char>(*_name))) * 1099511628211ull;
+  return hash;
+}
+
+class ComputeRecorder
+{
+public:
+  // Never destroyed, as threads of static pools may exit and write out their records after static destruction starts
+  static ComputeRecorder& instance()
+  {
+    static ComputeRecorder* recorder = new ComputeRecorder();
+    return *recorder;
+  }
+
+  // The check on every compute, computes only build a record when it is set
+  static bool recording() { return enabled().load(std::memory_order_relaxed); }
+
+  bool start(const std::string& _path, std::string& o_error)
+  {
+    std::lock_guard<std::mutex> lock(m_controlMutex);
+    if (recording()) return LimbStreamIO::fail(o_error, "already recording to " + m_path);
+    std::FILE* file = std::fopen(_path.c_str(), "wb");
+    if (!file) return LimbStreamIO::fail(o_error, "could not open " + _path + " for writing");
+    ComputeRecordHeader header = {};
+    std::memcpy(header.magic, kComputeRecordMagic, 4u);
+    header.version = kComputeRecordVersion;
+    header.recordSize = sizeof(ComputeRecord);
+    if (std::fwrite(&header, sizeof(header), 1u, file) != 1u)
+    {
+      std::fclose(file);
+      return LimbStreamIO::fail(o_error, "could not write " + _path);
+    }
+    {
+      // Computes that were still appending when the last recording stopped are dropped
+      std::lock_guard<std::mutex> buffersLock(m_buffersMutex);
+      for (const auto& buffer : m_buffers)
+      {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        buffer->records.clear();
+      }
+    }
+    {
+      std::lock_guard<std::mutex> fileLock(m_fileMutex);
+      m_file = file;
+      m_writeFailed = false;
+    }
+    m_path = _path;
+    m_recorded.store(0u);
+    enabled().store(true);
+    return true;
+  }
+
+  // Writes out the records of every thread and closes the log
+  bool stop(std::string& o_error)
+  {
+    std::lock_guard<std::mutex> lock(m_controlMutex);
+    if (!recording()) return true;
+    enabled().store(false);
+    {
+      std::lock_guard<std::mutex> buffersLock(m_buffersMutex);
+      for (const auto& buffer : m_buffers)
+      {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        write(buffer->records);
+      }
+    }
+    std::lock_guard<std::mutex> fileLock(m_fileMutex);
+    const bool failed = m_writeFailed || std::fclose(m_file) != 0;
+    m_file = nullptr;
+    if (failed) return LimbStreamIO::fail(o_error, "could not write " + m_path);
+    return true;
+  }
+
+  // Starts recording to the path in SIMPLEIK_RECORD, when it is set
+  bool startFromEnvironment(std::string& o_error)
+  {
+    const char* path = std::getenv("SIMPLEIK_RECORD");
+    if (!path || !*path) return true;
+    return start(path, o_error);
+  }
+
+  // The log being written, empty when not recording
+  std::string path() const
+  {
+    std::lock_guard<std::mutex> lock(m_controlMutex);
+    return recording() ? m_path : std::string();
+  }
+
+  // Records written to the log so far, the ones still buffered are written when recording stops
+  unsigned long long recorded() const { return m_recorded.load(std::memory_order_relaxed); }
+
+  void record(const ComputeRecord& _record)
+  {
+    ThreadBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.records.push_back(_record);
+    if (buffer.records.size() >= kComputeRecordBufferRecords) write(buffer.records);
+  }
+
+private:
+  struct ThreadBuffer
+  {
+    // Only contended while recording starts or stops
+    std::mutex mutex;
+    std::vector<ComputeRecord> records;
+  };
+
+  // Owned by each recording thread, writes out its records when the thread exits
+  struct ThreadSlot
+  {
+    std::shared_ptr<ThreadBuffer> buffer;
+
+    ~ThreadSlot()
+    {
+      if (buffer) ComputeRecorder::instance().retire(buffer);
+    }
+  };
+
+  ComputeRecorder() = default;
+
+  static std::atomic<bool>& enabled()
+  {
+    static std::atomic<bool> flag(false);
+    return flag;
+  }
+
+  ThreadBuffer& threadBuffer()
+  {
+    static thread_local ThreadSlot slot;
+    if (!slot.buffer)
+    {
+      slot.buffer = std::make_shared<ThreadBuffer>();
+      slot.buffer->records.reserve(kComputeRecordBufferRecords);
+      std::lock_guard<std::mutex> lock(m_buffersMutex);
+      m_buffers.push_back(slot.buffer);
+    }
+    return *slot.buffer;
+  }
+
+  void retire(const std::shared_ptr<ThreadBuffer>& _buffer)
+  {
+    std::lock_guard<std::mutex> buffersLock(m_buffersMutex);
+    {
+      std::lock_guard<std::mutex> bufferLock(_buffer->mutex);
+      write(_buffer->records);
+    }
+    for (auto it = m_buffers.begin(); it != m_buffers.end(); ++it)
+    {
+      if (*it != _buffer) continue;
+      m_buffers.erase(it);
+      break;
+    }
+  }
+
+  // Called with the buffer's lock held, records left after the log closed are dropped
+  void write(std::vector<ComputeRecord>& io_records)
+  {
+    if (io_records.empty()) return;
+    {
+      std::lock_guard<std::mutex> lock(m_fileMutex);
+      if (m_file)
+      {
+        const bool written = std::fwrite(io_records.data(), sizeof(ComputeRecord), io_records.size(), m_file) == io_records.size();
+        m_writeFailed = m_writeFailed || !written;
+        if (written) m_recorded.fetch_add(io_records.size(), std::memory_order_relaxed);
+      }
+    }
+    io_records.clear();
+  }
+
+  // Lock order is control, buffers, a buffer, then the file
+  mutable std::mutex m_controlMutex;
+  std::string m_path;
+  std::mutex m_buffersMutex;
+  std::vector<std::shared_ptr<ThreadBuffer>> m_buffers;
+  std::mutex m_fileMutex;
+  std::FILE* m_file = nullptr;
+  bool m_writeFailed = false;
+  std::atomic<unsigned long long> m_recorded{0u};
+};
+
+inline bool readComputeRecords(const std::string& _path, std::vector<ComputeRecord>& o_records, std::string& o_error)
+{
+  std::string contents;
+  if (!LimbStreamIO::readAll(_path, contents, o_error)) return false;
+  ComputeRecordHeader header;
+  if (contents.size() < sizeof(header)) return LimbStreamIO::fail(o_error, _path + " is not a compute recording");
+  std::memcpy(&header, contents.data(), sizeof(header));
+  if (std::memcmp(header.magic, kComputeRecordMagic, 4u) != 0) return LimbStreamIO::fail(o_error, _path + " is not a compute recording");
+  if (header.version != kComputeRecordVersion || header.recordSize != sizeof(ComputeRecord))
+  {
+    return LimbStreamIO::fail(o_error, _path + " was recorded by an incompatible version");
+  }
+  const std::size_t size = contents.size() - sizeof(header);
+  if (size % sizeof(ComputeRecord)) return LimbStreamIO::fail(o_error, _path + " ends in a partial record");
+  o_records.resize(size / sizeof(ComputeRecord));
+  if (!o_records.empty()) std::memcpy(o_records.data(), contents.data() + sizeof(header), size);
+  return true;
+}
+
+// The recorded inputs as a limb stream, one row per record in log order, with the frame rounded from the evaluation
+// time and the node id as the limb
+inline void computeRecordsToLimbStream(const std::vector<ComputeRecord>& _records, LimbStream& o_stream)
+{
+  o_stream.resize(_records.size());
+  for (std::size_t i = 0u; i < _records.size(); ++i)
+  {
+    const auto& record = _records[i];
+    o_stream.frame[i] = std::int64_t(std::llround(record.time));
+    o_stream.limb[i] = std::int64_t(record.node);
+    for (std::size_t c = 0u; c < kLimbStreamInputChannels; ++c) (*o_stream.channel(c))[i] = record.inputs[c];
+    for (std::size_t c = 0u; c < kLimbStreamOutputChannels; ++c) (*o_stream.channel(kLimbStreamInputChannels + c))[i] = 0.0;
+  }
+}
+
+struct ComputeReplayStats
+{
+  std::size_t records = 0u;
+  std::size_t twoBoneIK = 0u;
+  std::size_t inclineAngle = 0u;
+  std::size_t nodes = 0u;
+  // Recorded outputs that differ from the replay at all, and by more than the tolerance
+  std::size_t changed = 0u;
+  std::size_t mismatches = 0u;
+  double maxError = 0.0;
+
+  std::string json() const
+  {
+    char buffer[256];
+    std::snprintf(buffer, sizeof(buffer),
+        "\"records\":%zu,\"twoBoneIK\":%zu,\"inclineAngle\":%zu,\"nodes\":%zu,\"changed\":%zu,\"mismatches\":%zu,\"max_error\":%.3g",
+        records, twoBoneIK, inclineAngle, nodes, changed, mismatches, maxError);
+    return buffer;
+  }
+};
+
+// Solves the recorded inputs of every record again with the headless solver, at the precision and orientation method
+// of its compute, into io_stream, which must hold computeRecordsToLimbStream of the records
+inline void solveComputeRecords(const std::vector<ComputeRecord>& _records, LimbStream& io_stream, ThreadPool& io_pool)
+{
+  const LimbStreamView view = io_stream.view();
+  io_pool.parallelFor(_records.size(), kBatchChunkSize, [&](std::size_t _begin, std::size_t _end)
+  {
+    for (std::size_t i = _begin; i < _end; ++i)
+    {
+      const auto method = TwoBoneIKOrientationMethod(_records[i].orientationMethod);
+      switch (_records[i].precision)
+      {
+        case kPrecisionHigh: solveLimbStreamRow<HighMath>(view, i, method); break;
+        case kPrecisionFast: solveLimbStreamRow<FastMath>(view, i, method); break;
+        default: solveLimbStreamRow<ExactMath>(view, i, method); break;
+      }
+    }
+  });
+}
+
+// Replays the records and compares the outputs each compute solved against the replay, the two bone frame method
+// agrees with the node to within 1e-9 and everything else is expected to match exactly
+inline ComputeReplayStats replayComputeRecords(
+    const std::vector<ComputeRecord>& _records, ThreadPool& io_pool, double _tolerance = 1e-9)
+{
+  LimbStream stream;
+  computeRecordsToLimbStream(_records, stream);
+  solveComputeRecords(_records, stream, io_pool);
+
+  ComputeReplayStats stats;
+  stats.records = _records.size();
+  std::unordered_set<std::uint64_t> nodes;
+  for (std::size_t i = 0u; i < _records.size(); ++i)
+  {
+    const auto& record = _records[i];
+    (record.nodeType == kRecordInclineAngleNode ? stats.inclineAngle : stats.twoBoneIK) += 1u;
+    nodes.insert(record.node);
+    for (std::size_t c = 0u; c < kLimbStreamOutputChannels; ++c)
+    {
+      if (!(record.outputs & (1u << c))) continue;
+      const double replayed = (*stream.channel(kLimbStreamInputChannels + c))[i];
+      if (replayed == record.outputValues[c] || (std::isnan(replayed) && std::isnan(record.outputValues[c]))) continue;
+      const double error = std::fabs(replayed - record.outputValues[c]);
+      ++stats.changed;
+      // NaN errors count as mismatches
+      if (!(error <= _tolerance)) ++stats.mismatches;
+      if (error > stats.maxError || std::isnan(error)) stats.maxError = error;
+    }
+  }
+  stats.nodes = nodes.size();
+  return stats;
+}
+
+#endif //COMPUTERECORDER_INCLUDE_H
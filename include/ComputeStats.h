@@ -0,0 +1,312 @@
+#ifndef COMPUTESTATS_INCLUDE_H
+#define COMPUTESTATS_INCLUDE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Counts of node computes, of plugs a compute rejected, and compute latency histograms, per node and per node type,
+// so the nodes that cost the most in a heavy scene can be found.
+// Each thread counts into its own entries, which only it writes, so a compute never waits on another or on a query.
+// Queries add up every thread's entries, and a reset starts a new epoch that each thread zeroes its entries for the
+// next time it counts into them. Nodes are told apart by address and named as they were at their first compute after
+// a reset.
+
+// Latencies are counted in power of two buckets of nanoseconds, bucket i holding [2^i, 2^(i+1)) and the last also
+// everything longer
+static constexpr std::size_t kLatencyBuckets = 32u;
+
+inline std::size_t latencyBucket(std::uint64_t _nanoseconds)
+{
+  std::size_t bucket = 0u;
+  while (_nanoseconds >>= 1u) ++bucket;
+  return std::min(bucket, kLatencyBuckets - 1u);
+}
+
+struct ComputeCounters
+{
+  std::uint64_t computes = 0u;
+  std::uint64_t rejected = 0u;
+  std::uint64_t totalNanoseconds = 0u;
+  std::uint64_t maxNanoseconds = 0u;
+  std::uint64_t latency[kLatencyBuckets] = {};
+
+  void merge(const ComputeCounters& _other)
+  {
+    computes += _other.computes;
+    rejected += _other.rejected;
+    totalNanoseconds += _other.totalNanoseconds;
+    maxNanoseconds = std::max(maxNanoseconds, _other.maxNanoseconds);
+    for (std::size_t b = 0u; b < kLatencyBuckets; ++b) latency[b] += _other.latency[b];
+  }
+
+  // Upper edge of the bucket holding the _quantile latency, so within a factor of two above it
+  std::uint64_t percentileNanoseconds(double _quantile) const
+  {
+    const double rank = _quantile * double(computes);
+    std::uint64_t seen = 0u;
+    for (std::size_t b = 0u; b < kLatencyBuckets; ++b)
+    {
+      seen += latency[b];
+      if (seen && double(seen) >= rank) return std::min(std::uint64_t(2u) << b, maxNanoseconds);
+    }
+    return maxNanoseconds;
+  }
+
+  // The counters as JSON members, the histogram trimmed after its last non empty bucket
+  std::string json() const
+  {
+    char buffer[256];
+    std::snprintf(buffer, sizeof(buffer),
+        "\"computes\":%llu,\"rejected\":%llu,\"total_ms\":%.3f,\"mean_ns\":%.1f,\"p50_ns\":%llu,\"p90_ns\":%llu,\"p99_ns\":%llu,\"max_ns\":%llu,"
+        "\"histogram\":[",
+        (unsigned long long)computes, (unsigned long long)rejected, double(totalNanoseconds) * 1e-6,
+        computes ? double(totalNanoseconds) / double(computes) : 0.0, (unsigned long long)percentileNanoseconds(0.5),
+        (unsigned long long)percentileNanoseconds(0.9), (unsigned long long)percentileNanoseconds(0.99), (unsigned long long)maxNanoseconds);
+    std::string json = buffer;
+    std::size_t used = kLatencyBuckets;
+    while (used && !latency[used - 1u]) --used;
+    for (std::size_t b = 0u; b < used; ++b) json += (b ? "," : "") + std::to_string(latency[b]);
+    return json + "]";
+  }
+};
+
+class ComputeStats
+{
+public:
+  struct NodeCounters
+  {
+    std::string node;
+    std::string type;
+    ComputeCounters counters;
+  };
+
+  // Never destroyed, as threads of static pools may exit and hand over their counts after static destruction starts
+  static ComputeStats& instance()
+  {
+    static ComputeStats* stats = new ComputeStats();
+    return *stats;
+  }
+
+  // Counting is on unless turned off, computes skip the clock reads when it is off
+  static bool enabled() { return enabledFlag().load(std::memory_order_relaxed); }
+  static void setEnabled(bool _enabled) { enabledFlag().store(_enabled); }
+
+  // _name is only called for the node's first count after a reset, _type must outlive the counts
+  template <typename TName>
+  void addCompute(const void* _node, const char* _type, const TName& _name, std::uint64_t _nanoseconds)
+  {
+    Entry& entry = threadEntry(_node, _type, _name);
+    bump(entry.computes, 1u);
+    bump(entry.totalNanoseconds, _nanoseconds);
+    if (_nanoseconds > entry.maxNanoseconds.load(std::memory_order_relaxed)) entry.maxNanoseconds.store(_nanoseconds, std::memory_order_relaxed);
+    bump(entry.latency[latencyBucket(_nanoseconds)], 1u);
+  }
+
+  template <typename TName>
+  void addRejected(const void* _node, const char* _type, const TName& _name)
+  {
+    bump(threadEntry(_node, _type, _name).rejected, 1u);
+  }
+
+  void reset()
+  {
+    std::lock_guard<std::mutex> lock(m_threadsMutex);
+    m_epoch.fetch_add(1u);
+    m_retired.clear();
+  }
+
+  // Every node counted since the last reset, the most total compute time first
+  std::vector<NodeCounters> nodes() const
+  {
+    std::map<const void*, NodeCounters> merged;
+    {
+      std::lock_guard<std::mutex> lock(m_threadsMutex);
+      const auto epoch = m_epoch.load();
+      merged = m_retired;
+      for (const auto& thread : m_threads)
+      {
+        std::lock_guard<std::mutex> threadLock(thread->mutex);
+        for (const auto& entry : thread->entries) mergeEntry(entry.first, entry.second, epoch, merged);
+      }
+    }
+    std::vector<NodeCounters> nodes;
+    for (auto& node : merged) nodes.push_back(node.second);
+    std::stable_sort(nodes.begin(), nodes.end(), [](const NodeCounters& _a, const NodeCounters& _b)
+    {
+      return _a.counters.totalNanoseconds > _b.counters.totalNanoseconds;
+    });
+    return nodes;
+  }
+
+  // The nodes added up by type, in the same order
+  static std::vector<NodeCounters> types(const std::vector<NodeCounters>& _nodes)
+  {
+    std::vector<NodeCounters> types;
+    for (const auto& node : _nodes)
+    {
+      auto type = std::find_if(types.begin(), types.end(), [&](const NodeCounters& _type) { return _type.type == node.type; });
+      if (type == types.end()) type = types.insert(types.end(), {std::string(), node.type, ComputeCounters()});
+      type->counters.merge(node.counters);
+    }
+    return types;
+  }
+
+  // Types then nodes as one JSON object, at most _maxNodes nodes
+  std::string json(std::size_t _maxNodes = ~std::size_t(0u)) const
+  {
+    const auto counted = nodes();
+    std::string json = std::string("{\"enabled\":") + (enabled() ? "true" : "false") + ",\"types\":[";
+    const auto byType = types(counted);
+    for (std::size_t i = 0u; i < byType.size(); ++i)
+    {
+      json += (i ? ",{\"type\":\"" : "{\"type\":\"") + byType[i].type + "\"," + byType[i].counters.json() + "}";
+    }
+    json += "],\"nodes\":[";
+    for (std::size_t i = 0u; i < counted.size() && i < _maxNodes; ++i)
+    {
+      json += (i ? ",{\"node\":" : "{\"node\":") + jsonName(counted[i].node) + ",\"type\":\"" + counted[i].type + "\"," +
+        counted[i].counters.json() + "}";
+    }
+    return json + "]}";
+  }
+
+  // _name as a JSON string
+  static std::string jsonName(const std::string& _name)
+  {
+    std::string json = "\"";
+    for (const char c : _name)
+    {
+      if (c == '"' || c == '\\') json += '\\';
+      json += c;
+    }
+    return json + "\"";
+  }
+
+private:
+  struct Entry
+  {
+    // Written by the owning thread with its thread's lock held, so queries can read them under the lock
+    std::string name;
+    const char* type = nullptr;
+    std::atomic<std::uint64_t> epoch{~std::uint64_t(0u)};
+    // Only written by the owning thread, queries may read them at any time
+    std::atomic<std::uint64_t> computes{0u};
+    std::atomic<std::uint64_t> rejected{0u};
+    std::atomic<std::uint64_t> totalNanoseconds{0u};
+    std::atomic<std::uint64_t> maxNanoseconds{0u};
+    std::atomic<std::uint64_t> latency[kLatencyBuckets];
+  };
+
+  struct ThreadCounters
+  {
+    // Taken by the owning thread only to add an entry or start a new epoch
+    std::mutex mutex;
+    std::unordered_map<const void*, Entry> entries;
+  };
+
+  // Owned by each counting thread, hands its counts over when the thread exits
+  struct ThreadSlot
+  {
+    std::shared_ptr<ThreadCounters> counters;
+
+    ~ThreadSlot()
+    {
+      if (counters) ComputeStats::instance().retire(counters);
+    }
+  };
+
+  ComputeStats() = default;
+
+  static std::atomic<bool>& enabledFlag()
+  {
+    static std::atomic<bool> flag(true);
+    return flag;
+  }
+
+  // A single writer, so the increment needs no atomic read modify write
+  static void bump(std::atomic<std::uint64_t>& io_counter, std::uint64_t _value)
+  {
+    io_counter.store(io_counter.load(std::memory_order_relaxed) + _value, std::memory_order_relaxed);
+  }
+
+  template <typename TName>
+  Entry& threadEntry(const void* _node, const char* _type, const TName& _name)
+  {
+    static thread_local ThreadSlot slot;
+    if (!slot.counters)
+    {
+      slot.counters = std::make_shared<ThreadCounters>();
+      std::lock_guard<std::mutex> lock(m_threadsMutex);
+      m_threads.push_back(slot.counters);
+    }
+    ThreadCounters& thread = *slot.counters;
+    // Only this thread adds entries, so it can look them up without the lock
+    auto it = thread.entries.find(_node);
+    if (it == thread.entries.end())
+    {
+      std::lock_guard<std::mutex> lock(thread.mutex);
+      it = thread.entries.emplace(std::piecewise_construct, std::forward_as_tuple(_node), std::forward_as_tuple()).first;
+    }
+    Entry& entry = it->second;
+    const auto epoch = m_epoch.load(std::memory_order_relaxed);
+    if (entry.epoch.load(std::memory_order_relaxed) != epoch)
+    {
+      std::string name = _name();
+      std::lock_guard<std::mutex> lock(thread.mutex);
+      entry.name.swap(name);
+      entry.type = _type;
+      for (auto* counter : {&entry.computes, &entry.rejected, &entry.totalNanoseconds, &entry.maxNanoseconds}) counter->store(0u, std::memory_order_relaxed);
+      for (auto& counter : entry.latency) counter.store(0u, std::memory_order_relaxed);
+      entry.epoch.store(epoch, std::memory_order_relaxed);
+    }
+    return entry;
+  }
+
+  // Called with the thread's lock held
+  static void mergeEntry(const void* _node, const Entry& _entry, std::uint64_t _epoch, std::map<const void*, NodeCounters>& io_merged)
+  {
+    if (_entry.epoch.load(std::memory_order_relaxed) != _epoch) return;
+    ComputeCounters counters;
+    counters.computes = _entry.computes.load(std::memory_order_relaxed);
+    counters.rejected = _entry.rejected.load(std::memory_order_relaxed);
+    counters.totalNanoseconds = _entry.totalNanoseconds.load(std::memory_order_relaxed);
+    counters.maxNanoseconds = _entry.maxNanoseconds.load(std::memory_order_relaxed);
+    for (std::size_t b = 0u; b < kLatencyBuckets; ++b) counters.latency[b] = _entry.latency[b].load(std::memory_order_relaxed);
+    auto& node = io_merged[_node];
+    if (node.node.empty())
+    {
+      node.node = _entry.name;
+      node.type = _entry.type;
+    }
+    node.counters.merge(counters);
+  }
+
+  void retire(const std::shared_ptr<ThreadCounters>& _counters)
+  {
+    std::lock_guard<std::mutex> lock(m_threadsMutex);
+    {
+      std::lock_guard<std::mutex> threadLock(_counters->mutex);
+      for (const auto& entry : _counters->entries) mergeEntry(entry.first, entry.second, m_epoch.load(), m_retired);
+    }
+    m_threads.erase(std::remove(m_threads.begin(), m_threads.end(), _counters), m_threads.end());
+  }
+
+  // Lock order is the threads, then a thread
+  mutable std::mutex m_threadsMutex;
+  std::vector<std::shared_ptr<ThreadCounters>> m_threads;
+  // Counts of exited threads
+  std::map<const void*, NodeCounters> m_retired;
+  std::atomic<std::uint64_t> m_epoch{0u};
+};
+
+#endif //COMPUTESTATS_INCLUDE_H
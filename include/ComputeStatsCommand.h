@@ -0,0 +1,70 @@
+#ifndef COMPUTESTATSCOMMAND_INCLUDE_H
+#define COMPUTESTATSCOMMAND_INCLUDE_H
+
+#include <maya/MPxCommand.h>
+#include <maya/MArgList.h>
+#include <maya/MString.h>
+#include <maya/MFnPlugin.h>
+#include "Utils.h"
+#include "ComputeStats.h"
+#include "ChainIKStats.h"
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+
+// Reports the compute counts and latencies of ComputeStats.h as a JSON string, the node types then the nodes with the
+// most total compute time first.
+//   computeStats              reports every node
+//   computeStats -nodes N     reports the N nodes with the most compute time
+//   computeStats -reset       zeroes the counts once they are reported
+//   computeStats -chainIK     adds the solves, warm starts and average iterations of every chain node as "chainIK",
+//                             which -reset zeroes too
+//   computeStats -enable      turns counting on, or -disable off, it is on when the plugin loads
+class ComputeStatsCommand : public MPxCommand
+{
+public:
+  static const char* name() { return NODE_NAME_PREFIX "computeStats"; }
+
+  static void* creator() { return new ComputeStatsCommand(); }
+
+  static MStatus registerCommand(MFnPlugin& pluginFn)
+  {
+    return pluginFn.registerCommand(name(), creator);
+  }
+
+  static MStatus deregisterCommand(MFnPlugin& pluginFn)
+  {
+    return pluginFn.deregisterCommand(name());
+  }
+
+  MStatus doIt(const MArgList& _args) override
+  {
+    bool reset = false;
+    bool chainIK = false;
+    std::size_t maxNodes = ~std::size_t(0u);
+    for (unsigned i = 0u; i < _args.length(); ++i)
+    {
+      const std::string flag = _args.asString(i).asChar();
+      if (flag == "-reset") reset = true;
+      else if (flag == "-chainIK") chainIK = true;
+      else if (flag == "-enable") ComputeStats::setEnabled(true);
+      else if (flag == "-disable") ComputeStats::setEnabled(false);
+      else if (flag == "-nodes" && i + 1u < _args.length()) maxNodes = std::size_t(std::max(std::atoi(_args.asString(++i).asChar()), 0));
+      else return MS::kInvalidParameter;
+    }
+    auto& stats = ComputeStats::instance();
+    auto json = stats.json(maxNodes);
+    if (chainIK)
+    {
+      // Inserted as the last member of the object
+      json.pop_back();
+      json += ",\"chainIK\":" + ChainIKStatsRegistry::instance().json() + "}";
+    }
+    setResult(MString(json.c_str()));
+    if (reset) stats.reset();
+    if (reset && chainIK) ChainIKStatsRegistry::instance().reset();
+    return MS::kSuccess;
+  }
+};
+
+#endif //COMPUTESTATSCOMMAND_INCLUDE_H
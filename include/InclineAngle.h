@@ -7,6 +7,10 @@
 #include <maya/MEulerRotation.h>
 #include <maya/MAngle.h>
 #include "Utils.h"
+#include "InclineAngleSolver.h"
+#include "TwoBoneIKBatch.h"
+#include "ComputeRecorder.h"
+#include "ComputeProfiling.h"
 #include <cmath>
 #include <limits>
 #include <functional>
@@ -25,51 +29,114 @@ public:
     createAttribute(m_inputEdgeB, "staticEdgeB", 0.0);
     createAttribute(m_inputSoften, "soften", 0.0);
     createAttribute(m_inputDoSoften, "doSoften", true);
+    // Trades the accuracy of the angle for speed, see ApproxMath.h for the error of each tier
+    createEnumAttribute(m_inputPrecision, "precision", {"exact", "high", "fast"}, kPrecisionExact);
 
     // bend angle should be the angle between the two bones composing the triangle arm
     createAttribute(m_outputInclineAngle, "inclineAngle", DefaultValue<MAngle>(), false);
 
     // Tell maya about our arributes
-    addAttributes(m_inputTargetLocation, m_inputEdgeA, m_inputEdgeB, m_inputSoften, m_inputDoSoften, m_outputInclineAngle);
+    addAttributes(m_inputTargetLocation, m_inputEdgeA, m_inputEdgeB, m_inputSoften, m_inputDoSoften, m_inputPrecision, m_outputInclineAngle);
     // Tell maya what inputs will affect our outputs (all of them)
-    setAffects({m_inputTargetLocation, m_inputEdgeA, m_inputEdgeB, m_inputSoften, m_inputDoSoften}, m_outputInclineAngle);
+    setAffects({m_inputTargetLocation, m_inputEdgeA, m_inputEdgeB, m_inputSoften, m_inputDoSoften, m_inputPrecision}, m_outputInclineAngle);
   
     return MS::kSuccess;
   }
 
   virtual MStatus compute(const MPlug& _plug, MDataBlock& io_dataBlock) 
   {
+    ComputeStatsScope stats(*this, TTypeName);
     if (shouldCompute(_plug, m_outputInclineAngle)) 
     {
       AttributeData ad(io_dataBlock);
-      // Get the position of our target, with no zero components
-      const auto targetLocation = makeNonZero<double>(ad.get<MVector>(m_inputTargetLocation));
-      // Get the two static edge lengths (the bones) 
-      const auto edgeA = ad.get<double>(m_inputEdgeA);
-      const auto edgeB = ad.get<double>(m_inputEdgeB);
-      // Get our dynamic edge length and clamp it into our acceptable range
-      const auto dynamicEdgeC = std::max(targetLocation.length(), edgeA - edgeB);
-      // Calculate the softness value
-      const auto dsoft = ad.get<double>(m_inputSoften) * ad.get<bool>(m_inputDoSoften);  
-      // Soften our dynamic edge if required
-      const auto edgeC = softenEdge(dynamicEdgeC, edgeA + edgeB, dsoft);
-      // Use the law of cosines to calculate interior incline angle of the triangle
-      // We add pi to get the obtuse complement angle
-      const auto inclineAngle = getAngle(edgeA, edgeC, edgeB) + std::atan(clamp(targetLocation.y / targetLocation.x, -1.0, 1.0));
-      // Output the values
-      ad.set(m_outputInclineAngle, MAngle(inclineAngle));
+      double dsoft, edgeA, edgeB;
+      Vector3<double> targetLocation;
+      short precision;
+      {
+        ComputePhaseScope phase(kPhaseAttributeRead);
+        // Calculate the softness value
+        dsoft = ad.get<double>(m_inputSoften) * ad.get<bool>(m_inputDoSoften);  
+        targetLocation = toVector3(ad.get<MVector>(m_inputTargetLocation));
+        edgeA = ad.get<double>(m_inputEdgeA);
+        edgeB = ad.get<double>(m_inputEdgeB);
+        precision = ad.get<short>(m_inputPrecision);
+      }
+      double inclineAngle;
+      {
+        ComputePhaseScope phase(kPhaseSolve);
+        switch (precision)
+        {
+          case kPrecisionHigh: inclineAngle = solveInclineAngle<double, HighMath>(targetLocation, edgeA, edgeB, dsoft); break;
+          case kPrecisionFast: inclineAngle = solveInclineAngle<double, FastMath>(targetLocation, edgeA, edgeB, dsoft); break;
+          default: inclineAngle = solveInclineAngle(targetLocation, edgeA, edgeB, dsoft); break;
+        }
+      }
+      {
+        ComputePhaseScope phase(kPhaseAttributeWrite);
+        // Output the values
+        ad.set(m_outputInclineAngle, MAngle(inclineAngle));
+      }
+      if (ComputeRecorder::recording()) record(io_dataBlock, targetLocation, edgeA, edgeB, dsoft, precision, inclineAngle);
   
       return MS::kSuccess;
     }
+    stats.reject();
     return MS::kUnknownParameter;
   }
 
+  // Batched evaluation through SimpleIKEvaluator, returns false when the node needs its own compute,
+  // as the packed solve has no approximate precision, or while computes are recorded
+  bool gatherBatchInputs(MDataBlock& io_dataBlock, InclineAngleBatchBuffers& io_batch, std::size_t _index)
+  {
+    AttributeData ad(io_dataBlock);
+    if (ComputeRecorder::recording() || ad.get<short>(m_inputPrecision) != kPrecisionExact) return false;
+    const auto targetLocation = ad.get<MVector>(m_inputTargetLocation);
+    io_batch.targetX[_index] = targetLocation.x;
+    io_batch.targetY[_index] = targetLocation.y;
+    io_batch.targetZ[_index] = targetLocation.z;
+    io_batch.edgeA[_index] = ad.get<double>(m_inputEdgeA);
+    io_batch.edgeB[_index] = ad.get<double>(m_inputEdgeB);
+    io_batch.soften[_index] = ad.get<double>(m_inputSoften) * ad.get<bool>(m_inputDoSoften);
+    return true;
+  }
+
+  void scatterBatchOutputs(MDataBlock& io_dataBlock, const InclineAngleBatchBuffers& _batch, std::size_t _index)
+  {
+    AttributeData ad(io_dataBlock);
+    ad.set(m_outputInclineAngle, MAngle(_batch.inclineAngle[_index]));
+  }
+
+  // Counts a batched solve of this node as one compute in sik_computeStats, taking _nanoseconds
+  void countBatchedCompute(std::uint64_t _nanoseconds) const { ComputeStatsScope::addBatched(*this, TTypeName, _nanoseconds); }
+
 private:
+  // Appends the compute to the recording, the target is recorded as read, the solve clamps it away from zero components
+  void record(
+      MDataBlock& io_dataBlock, const Vector3<double>& _targetLocation, double _edgeA, double _edgeB, double _dsoft, short _precision,
+      double _inclineAngle)
+  {
+    ComputeRecord record = {};
+    record.node = computeRecordNodeId(this->name().asChar());
+    record.time = io_dataBlock.context().getTime().as(MTime::kFilm);
+    record.nodeType = kRecordInclineAngleNode;
+    record.outputs = kRecordInclineAngle;
+    record.precision = _precision;
+    record.inputs[0] = _targetLocation.x;
+    record.inputs[1] = _targetLocation.y;
+    record.inputs[2] = _targetLocation.z;
+    record.inputs[6] = _edgeA;
+    record.inputs[7] = _edgeB;
+    record.inputs[9] = _dsoft;
+    record.outputValues[6] = _inclineAngle;
+    ComputeRecorder::instance().record(record);
+  }
+
   static Attribute m_inputTargetLocation;
   static Attribute m_inputEdgeA;
   static Attribute m_inputEdgeB;
   static Attribute m_inputSoften;
   static Attribute m_inputDoSoften;
+  static Attribute m_inputPrecision;
   static Attribute m_outputInclineAngle;
 };
 
@@ -82,6 +149,7 @@ MEMDECL(m_inputEdgeA);
 MEMDECL(m_inputEdgeB);
 MEMDECL(m_inputSoften);
 MEMDECL(m_inputDoSoften);
+MEMDECL(m_inputPrecision);
 MEMDECL(m_outputInclineAngle);
 
 #undef MEMDECL
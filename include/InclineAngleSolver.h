@@ -0,0 +1,22 @@
+#ifndef INCLINEANGLESOLVER_INCLUDE_H
+#define INCLINEANGLESOLVER_INCLUDE_H
+
+#include "SolverMath.h"
+
+// Solves the incline of a two bone limb, a subset of solveTwoBoneIK
+// dsoft is the soften distance, already zeroed when softening is disabled
+template <typename T, typename TMath = ExactMath>
+inline T solveInclineAngle(const Vector3<T>& _targetLocation, T edgeA, T edgeB, T dsoft)
+{
+  // Get the position of our target, with no zero components
+  const auto targetLocation = makeNonZero<T>(_targetLocation);
+  // Get our dynamic edge length and clamp it into our acceptable range
+  const auto dynamicEdgeC = std::max(targetLocation.length(), edgeA - edgeB);
+  // Soften our dynamic edge if required
+  const auto edgeC = softenEdge<T, TMath>(dynamicEdgeC, edgeA + edgeB, dsoft);
+  // Use the law of cosines to calculate interior incline angle of the triangle
+  // We add pi to get the obtuse complement angle
+  return getAngle<T, TMath>(edgeA, edgeC, edgeB) + TMath::atan(clamp(targetLocation.y / targetLocation.x, T(-1.0), T(1.0)));
+}
+
+#endif //INCLINEANGLESOLVER_INCLUDE_H
@@ -0,0 +1,322 @@
+#ifndef LIMBCOLUMNS_INCLUDE_H
+#define LIMBCOLUMNS_INCLUDE_H
+
+#include "LimbStream.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Columnar limb stream files, the channels of LimbStream.h stored one column after another, so a recorded take is
+// memory mapped and solved in place with no parsing or copying, and takes larger than memory stream through the
+// page cache a window at a time.
+// A file starts with a LimbColumnsHeader, then one LimbColumnsEntry per column present, then the columns.
+// Every column starts on a kLimbColumnsAlignment boundary and holds one little endian value per row,
+// 64 bit integers for the frame and limb and doubles for the channels.
+// Files are read and written in native byte order, so they are only opened on little endian hosts.
+// Input files hold the frame, limb and input channels, output files the frame, limb and output channels,
+// and a file may hold both.
+
+struct LimbColumnsHeader
+{
+  char magic[4];
+  std::uint32_t version;
+  std::uint64_t rows;
+  std::uint32_t columns;
+  std::uint32_t alignment;
+};
+
+struct LimbColumnsEntry
+{
+  // kLimbColumnFrame, kLimbColumnLimb, or kLimbColumnChannels plus a LimbStream channel index
+  std::uint32_t column;
+  std::uint32_t reserved;
+  // From the start of the file
+  std::uint64_t offset;
+};
+
+static constexpr char kLimbColumnsMagic[4] = {'S', 'I', 'K', 'C'};
+static constexpr std::uint32_t kLimbColumnsVersion = 1u;
+// Page aligned, so columns map and advise independently and the solve loads are never split over cache lines
+static constexpr std::uint32_t kLimbColumnsAlignment = 4096u;
+static constexpr std::uint32_t kLimbColumnFrame = 0u;
+static constexpr std::uint32_t kLimbColumnLimb = 1u;
+static constexpr std::uint32_t kLimbColumnChannels = 2u;
+static constexpr std::uint32_t kLimbColumnCount = kLimbColumnChannels + kLimbStreamInputChannels + kLimbStreamOutputChannels;
+// Rows solved between releases of the mapped pages, 2 MB of each column, a whole number of pages and batch chunks
+static constexpr std::size_t kLimbColumnsWindowRows = 1u << 18;
+
+inline bool isLimbColumns(const std::string& _path)
+{
+  return _path.size() >= 5u && _path.compare(_path.size() - 5u, 5u, ".sikc") == 0;
+}
+
+inline bool isLittleEndianHost()
+{
+  const std::uint32_t one = 1u;
+  unsigned char first;
+  std::memcpy(&first, &one, 1u);
+  return first == 1u;
+}
+
+// Columns of an input file and of an output file
+inline std::vector<std::uint32_t> limbColumnsInputs()
+{
+  std::vector<std::uint32_t> columns = {kLimbColumnFrame, kLimbColumnLimb};
+  for (std::uint32_t c = 0u; c < kLimbStreamInputChannels; ++c) columns.push_back(kLimbColumnChannels + c);
+  return columns;
+}
+
+inline std::vector<std::uint32_t> limbColumnsOutputs()
+{
+  std::vector<std::uint32_t> columns = {kLimbColumnFrame, kLimbColumnLimb};
+  for (std::uint32_t c = 0u; c < kLimbStreamOutputChannels; ++c) columns.push_back(kLimbColumnChannels + kLimbStreamInputChannels + c);
+  return columns;
+}
+
+// A whole file mapped into memory, read only when opened and read write when created
+class MappedFile
+{
+public:
+  MappedFile() = default;
+  ~MappedFile() { close(); }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  bool open(const std::string& _path, std::string& o_error) { return map(_path, O_RDONLY, 0u, o_error); }
+
+  // Creates or truncates the file to _size zeroed bytes
+  bool create(const std::string& _path, std::size_t _size, std::string& o_error) { return map(_path, O_RDWR | O_CREAT | O_TRUNC, _size, o_error); }
+
+  // Unmaps the file, the pages of a created file are written back by the kernel
+  void close()
+  {
+    if (m_data) munmap(m_data, m_size);
+    if (m_fd >= 0) ::close(m_fd);
+    m_data = nullptr;
+    m_size = 0u;
+    m_fd = -1;
+  }
+
+  char* data() const { return m_data; }
+  std::size_t size() const { return m_size; }
+
+  // Lets the kernel drop the mapped pages wholly inside [_begin, _end), they are read back from the file if touched
+  // again, and for a created file are written back first
+  void release(std::size_t _begin, std::size_t _end)
+  {
+    const std::size_t page = std::size_t(sysconf(_SC_PAGESIZE));
+    _begin = (_begin + page - 1u) / page * page;
+    _end = std::min(_end, m_size) / page * page;
+    if (m_data && _end > _begin) madvise(m_data + _begin, _end - _begin, MADV_DONTNEED);
+  }
+
+private:
+  bool map(const std::string& _path, int _flags, std::size_t _size, std::string& o_error)
+  {
+    close();
+    m_fd = ::open(_path.c_str(), _flags, 0644);
+    if (m_fd < 0) return LimbStreamIO::fail(o_error, "cannot open " + _path + ": " + std::strerror(errno));
+    struct stat status;
+    if (_flags & O_CREAT)
+    {
+      if (ftruncate(m_fd, off_t(_size)) != 0) return failed(_path, o_error);
+    }
+    else if (fstat(m_fd, &status) != 0) return failed(_path, o_error);
+    else _size = std::size_t(status.st_size);
+    m_size = _size;
+    if (!m_size) return true;
+    void* data = mmap(nullptr, m_size, (_flags & O_CREAT) ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, m_fd, 0);
+    if (data == MAP_FAILED) return failed(_path, o_error);
+    m_data = static_cast<char*>(data);
+    // Solves and conversions walk the file front to back
+    madvise(m_data, m_size, MADV_SEQUENTIAL);
+    return true;
+  }
+
+  bool failed(const std::string& _path, std::string& o_error)
+  {
+    const std::string reason = std::strerror(errno);
+    close();
+    return LimbStreamIO::fail(o_error, "cannot map " + _path + ": " + reason);
+  }
+
+  char* m_data = nullptr;
+  std::size_t m_size = 0u;
+  int m_fd = -1;
+};
+
+// A columnar file mapped into memory, read only when opened and read write when created
+class LimbColumnsFile
+{
+public:
+  bool open(const std::string& _path, std::string& o_error)
+  {
+    close();
+    if (!isLittleEndianHost()) return LimbStreamIO::fail(o_error, "columnar limb streams are little endian, this host is not");
+    if (!m_file.open(_path, o_error)) return false;
+    LimbColumnsHeader header;
+    if (m_file.size() < sizeof(header)) return invalid(_path, o_error);
+    std::memcpy(&header, m_file.data(), sizeof(header));
+    if (std::memcmp(header.magic, kLimbColumnsMagic, 4u) || header.version != kLimbColumnsVersion)
+    {
+      close();
+      return LimbStreamIO::fail(o_error, _path + " is not a version " + std::to_string(kLimbColumnsVersion) + " columnar limb stream");
+    }
+    if (header.columns > kLimbColumnCount || m_file.size() < sizeof(header) + header.columns * sizeof(LimbColumnsEntry)) return invalid(_path, o_error);
+    m_rows = header.rows;
+    for (std::uint32_t i = 0u; i < header.columns; ++i)
+    {
+      LimbColumnsEntry entry;
+      std::memcpy(&entry, m_file.data() + sizeof(header) + i * sizeof(entry), sizeof(entry));
+      // Columns must be aligned for the solve and lie wholly inside the file
+      if (entry.column >= kLimbColumnCount || !entry.offset || entry.offset % sizeof(double) ||
+          entry.offset > m_file.size() || (m_file.size() - entry.offset) / sizeof(double) < m_rows)
+      {
+        return invalid(_path, o_error);
+      }
+      m_offsets[entry.column] = entry.offset;
+    }
+    return true;
+  }
+
+  // Creates a file of _rows rows holding _columns, its contents zeroed until written through the column pointers
+  bool create(const std::string& _path, std::uint64_t _rows, const std::vector<std::uint32_t>& _columns, std::string& o_error)
+  {
+    close();
+    if (!isLittleEndianHost()) return LimbStreamIO::fail(o_error, "columnar limb streams are little endian, this host is not");
+    LimbColumnsHeader header;
+    std::memcpy(header.magic, kLimbColumnsMagic, 4u);
+    header.version = kLimbColumnsVersion;
+    header.rows = _rows;
+    header.columns = std::uint32_t(_columns.size());
+    header.alignment = kLimbColumnsAlignment;
+    std::vector<LimbColumnsEntry> entries(_columns.size());
+    std::uint64_t offset = alignColumn(sizeof(header) + entries.size() * sizeof(LimbColumnsEntry));
+    for (std::size_t i = 0u; i < entries.size(); ++i)
+    {
+      entries[i].column = _columns[i];
+      entries[i].reserved = 0u;
+      entries[i].offset = offset;
+      offset = alignColumn(offset + _rows * sizeof(double));
+    }
+    if (!m_file.create(_path, std::size_t(offset), o_error)) return false;
+    std::memcpy(m_file.data(), &header, sizeof(header));
+    if (!entries.empty()) std::memcpy(m_file.data() + sizeof(header), entries.data(), entries.size() * sizeof(LimbColumnsEntry));
+    m_rows = _rows;
+    for (const auto& entry : entries) m_offsets[entry.column] = entry.offset;
+    return true;
+  }
+
+  void close()
+  {
+    m_file.close();
+    m_rows = 0u;
+    std::fill(m_offsets, m_offsets + kLimbColumnCount, std::uint64_t(0u));
+  }
+
+  std::uint64_t rows() const { return m_rows; }
+  bool has(std::uint32_t _column) const { return m_offsets[_column] != 0u; }
+
+  const std::int64_t* frame() const { return column<std::int64_t>(kLimbColumnFrame); }
+  const std::int64_t* limb() const { return column<std::int64_t>(kLimbColumnLimb); }
+  std::int64_t* frame() { return column<std::int64_t>(kLimbColumnFrame); }
+  std::int64_t* limb() { return column<std::int64_t>(kLimbColumnLimb); }
+
+  // Indexed as LimbStream::channel
+  const double* channel(std::size_t _index) const { return column<double>(kLimbColumnChannels + std::uint32_t(_index)); }
+  double* channel(std::size_t _index) { return column<double>(kLimbColumnChannels + std::uint32_t(_index)); }
+
+  // Releases the mapped pages of rows [_begin, _end) of every column, see MappedFile::release.
+  // This keeps takes larger than memory from pushing everything else out of it
+  void release(std::size_t _begin, std::size_t _end)
+  {
+    for (std::uint32_t c = 0u; c < kLimbColumnCount; ++c)
+    {
+      if (m_offsets[c]) m_file.release(std::size_t(m_offsets[c]) + _begin * sizeof(double), std::size_t(m_offsets[c]) + _end * sizeof(double));
+    }
+  }
+
+private:
+  static std::uint64_t alignColumn(std::uint64_t _offset)
+  {
+    return (_offset + kLimbColumnsAlignment - 1u) / kLimbColumnsAlignment * kLimbColumnsAlignment;
+  }
+
+  template <typename T>
+  T* column(std::uint32_t _column) const
+  {
+    return m_offsets[_column] ? reinterpret_cast<T*>(m_file.data() + m_offsets[_column]) : nullptr;
+  }
+
+  bool invalid(const std::string& _path, std::string& o_error)
+  {
+    close();
+    return LimbStreamIO::fail(o_error, _path + " is truncated or has an invalid column table");
+  }
+
+  MappedFile m_file;
+  std::uint64_t m_rows = 0u;
+  // Zero for columns not in the file, no column can start at the header
+  std::uint64_t m_offsets[kLimbColumnCount] = {};
+};
+
+// Solves the mapped input file into the mapped output file a window at a time, the solve reading and writing the
+// mapped columns in place, then releasing each window's pages. The output has the same rows as the input,
+// and every row gives exactly what solveLimbStream gives in memory. With io_trace the solve chunks and the copy and
+// release of each window are traced
+inline bool solveLimbColumns(
+    LimbColumnsFile& io_input, LimbColumnsFile& io_output, ThreadPool& io_pool, SolvePrecision _precision, TwoBoneIKOrientationMethod _method,
+    bool _packed, std::string& o_error, TraceEventWriter* io_trace = nullptr)
+{
+  for (const auto column : limbColumnsInputs())
+  {
+    if (!io_input.has(column)) return LimbStreamIO::fail(o_error, "the input is missing the " + std::string(column < kLimbColumnChannels ?
+        (column == kLimbColumnFrame ? "frame" : "limb") : LimbStream::channelName(column - kLimbColumnChannels)) + " column");
+  }
+  for (const auto column : limbColumnsOutputs())
+  {
+    if (!io_output.has(column) || io_output.rows() != io_input.rows()) return LimbStreamIO::fail(o_error, "the output columns do not match the input");
+  }
+  const std::size_t rows = std::size_t(io_input.rows());
+  const double* in[kLimbStreamInputChannels];
+  double* out[kLimbStreamOutputChannels];
+  for (std::size_t c = 0u; c < kLimbStreamInputChannels; ++c) in[c] = io_input.channel(c);
+  for (std::size_t c = 0u; c < kLimbStreamOutputChannels; ++c) out[c] = io_output.channel(kLimbStreamInputChannels + c);
+
+  for (std::size_t begin = 0u; begin < rows; begin += kLimbColumnsWindowRows)
+  {
+    const std::size_t end = std::min(begin + kLimbColumnsWindowRows, rows);
+    const LimbStreamView window = {
+      {
+        in[0] + begin, in[1] + begin, in[2] + begin, in[3] + begin, in[4] + begin, in[5] + begin,
+        in[6] + begin, in[7] + begin, in[8] + begin, in[9] + begin, in[10] + begin,
+        out[0] + begin, out[1] + begin, out[2] + begin, out[3] + begin, out[4] + begin, out[5] + begin
+      },
+      out[6] + begin
+    };
+    solveLimbStream(window, end - begin, io_pool, _precision, _method, _packed, io_trace);
+    TraceEventWriter::Scope trace(io_trace, "release", end - begin);
+    std::memcpy(io_output.frame() + begin, io_input.frame() + begin, (end - begin) * sizeof(std::int64_t));
+    std::memcpy(io_output.limb() + begin, io_input.limb() + begin, (end - begin) * sizeof(std::int64_t));
+    io_input.release(begin, end);
+    io_output.release(begin, end);
+  }
+  return true;
+}
+
+// Writes a stream's inputs to a new columnar file
+inline bool writeLimbColumnsInputs(const std::string& _path, LimbStream& _stream, std::string& o_error)
+{
+  LimbColumnsFile file;
+  if (!file.create(_path, _stream.size(), limbColumnsInputs(), o_error)) return false;
+  const std::size_t rows = _stream.size();
+  if (!rows) return true;
+  std::memcpy(file.frame(), _stream.frame.data(), rows * sizeof(std::int64_t));
+  std::memcpy(file.limb(), _stream.limb.data(), rows * sizeof(std::int64_t));
+  for (std::size_t c = 0u; c < kLimbStreamInputChannels; ++c) std::memcpy(file.channel(c), _stream.channel(c)->data(), rows * sizeof(double));
+  return true;
+}
+
+#endif //LIMBCOLUMNS_INCLUDE_H
@@ -0,0 +1,224 @@
+#ifndef LIMBPIPELINE_INCLUDE_H
+#define LIMBPIPELINE_INCLUDE_H
+
+#include "LimbStream.h"
+#include "SpscQueue.h"
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+// Streaming solve of a limb stream as three stages on their own threads, a reader decoding chunks of rows,
+// the solve, and a writer encoding the results, so reading and writing overlap the math.
+// The stages pass a fixed set of chunks round a ring of bounded SpscQueues, reader to solver to writer and back to
+// the reader, so memory is the same for a take of any length and a stage that falls behind holds up the others
+// instead of queueing without bound. The reader and writer take any file the stream reader and writer do, including
+// named pipes, so a live capture feed can stand in for a recorded take.
+// Each stage times its work apart from its waits on the queues, and the consumers sample the queue occupancy, so the
+// bottleneck is the busiest stage, the one whose input queue runs full and whose output queue runs empty.
+
+// Rows per chunk, a whole number of batch chunks so the solve splits each over the pool exactly as a whole take
+static constexpr std::size_t kLimbPipelineChunkRows = 4u * kBatchChunkSize;
+// Chunks in flight, enough for each stage to hold one with the queues between them half full
+static constexpr std::size_t kLimbPipelineChunks = 8u;
+
+struct LimbPipelineStageStats
+{
+  std::size_t chunks = 0u;
+  std::size_t rows = 0u;
+  // Time spent on the stage's own work, and waiting for a chunk to work on or for room to pass it on
+  double busySeconds = 0.0;
+  double waitSeconds = 0.0;
+
+  double rowsPerSecond() const { return busySeconds > 0.0 ? double(rows) / busySeconds : 0.0; }
+};
+
+struct LimbPipelineQueueStats
+{
+  std::size_t capacity = 0u;
+  // Chunks queued each time the consumer took one
+  std::size_t samples = 0u;
+  std::size_t occupancySum = 0u;
+  std::size_t maxOccupancy = 0u;
+
+  double meanOccupancy() const { return samples ? double(occupancySum) / double(samples) : 0.0; }
+
+  void sample(std::size_t _occupancy)
+  {
+    ++samples;
+    occupancySum += _occupancy;
+    maxOccupancy = std::max(maxOccupancy, _occupancy);
+  }
+};
+
+struct LimbPipelineStats
+{
+  enum Stage { kRead = 0, kSolve = 1, kWrite = 2, kStageCount = 3 };
+
+  LimbPipelineStageStats stages[kStageCount];
+  // Reader to solver, and solver to writer
+  LimbPipelineQueueStats toSolve;
+  LimbPipelineQueueStats toWrite;
+  std::size_t frames = 0u;
+  double seconds = 0.0;
+
+  static const char* stageName(int _stage)
+  {
+    static const char* const names[kStageCount] = {"read", "solve", "write"};
+    return names[_stage];
+  }
+
+  // The stage with the most work, which sets the pace of the others
+  int bottleneck() const
+  {
+    int busiest = kRead;
+    for (int s = kSolve; s < kStageCount; ++s)
+    {
+      if (stages[s].busySeconds > stages[busiest].busySeconds) busiest = s;
+    }
+    return busiest;
+  }
+
+  // The stage and queue figures as JSON members, for the tools and benchmarks to print
+  std::string json() const
+  {
+    char buffer[256];
+    std::string json = "\"stages\":{";
+    for (int s = 0; s < kStageCount; ++s)
+    {
+      std::snprintf(buffer, sizeof(buffer), "%s\"%s\":{\"busy_s\":%.6f,\"wait_s\":%.6f,\"rows_per_s\":%.1f}",
+          s ? "," : "", stageName(s), stages[s].busySeconds, stages[s].waitSeconds, stages[s].rowsPerSecond());
+      json += buffer;
+    }
+    std::snprintf(buffer, sizeof(buffer),
+        "},\"queues\":{\"toSolve\":{\"capacity\":%zu,\"mean\":%.2f,\"max\":%zu},\"toWrite\":{\"capacity\":%zu,\"mean\":%.2f,\"max\":%zu}},\"bottleneck\":\"%s\"",
+        toSolve.capacity, toSolve.meanOccupancy(), toSolve.maxOccupancy, toWrite.capacity, toWrite.meanOccupancy(), toWrite.maxOccupancy,
+        stageName(bottleneck()));
+    return json + buffer;
+  }
+};
+
+// Solves the stream from _reader into _writer, which must both be open, returning once the reader reaches the end of
+// the stream and the writer has every row. The solve is solveLimbStream's, and the outputs are the same rows in the
+// same order as solving the whole take at once. With io_trace every chunk is traced on the stage that handled it
+inline bool runLimbPipeline(
+    LimbStreamReader& io_reader,
+    LimbStreamWriter& io_writer,
+    ThreadPool& io_pool,
+    SolvePrecision _precision,
+    TwoBoneIKOrientationMethod _method,
+    bool _packed,
+    LimbPipelineStats& o_stats,
+    std::string& o_error,
+    std::size_t _chunkRows = kLimbPipelineChunkRows,
+    std::size_t _chunks = kLimbPipelineChunks,
+    TraceEventWriter* io_trace = nullptr)
+{
+  typedef std::chrono::steady_clock Clock;
+  auto seconds = [](const Clock::time_point& _from, const Clock::time_point& _to) { return std::chrono::duration<double>(_to - _from).count(); };
+  const auto start = Clock::now();
+  o_stats = LimbPipelineStats();
+  _chunks = std::max<std::size_t>(_chunks, 2u);
+
+  // An empty chunk marks the end of the stream, and is passed down the pipeline like any other
+  std::vector<LimbStream> chunks(_chunks);
+  SpscQueue<LimbStream*> toRead(_chunks);
+  SpscQueue<LimbStream*> toSolve(_chunks);
+  SpscQueue<LimbStream*> toWrite(_chunks);
+  for (auto& chunk : chunks) toRead.tryPush(&chunk);
+  o_stats.toSolve.capacity = toSolve.capacity();
+  o_stats.toWrite.capacity = toWrite.capacity();
+  // Set by a stage that fails, so the others stop waiting on it
+  std::atomic<bool> stop(false);
+  std::string readError;
+  std::string writeError;
+
+  std::thread reader([&]()
+  {
+    auto& stats = o_stats.stages[LimbPipelineStats::kRead];
+    if (io_trace) io_trace->nameThread("reader");
+    for (;;)
+    {
+      LimbStream* chunk = nullptr;
+      const auto waitStart = Clock::now();
+      if (!toRead.pop(chunk, stop)) return;
+      const auto readStart = Clock::now();
+      stats.waitSeconds += seconds(waitStart, readStart);
+      if (!io_reader.read(*chunk, _chunkRows, readError)) stop.store(true);
+      const auto readEnd = Clock::now();
+      stats.busySeconds += seconds(readStart, readEnd);
+      if (io_trace) io_trace->add("read", readStart, readEnd, chunk->size());
+      if (stop.load()) return;
+      ++stats.chunks;
+      stats.rows += chunk->size();
+      if (!toSolve.push(chunk, stop)) return;
+      stats.waitSeconds += seconds(readEnd, Clock::now());
+      if (!chunk->size()) return;
+    }
+  });
+
+  std::thread writer([&]()
+  {
+    auto& stats = o_stats.stages[LimbPipelineStats::kWrite];
+    bool firstRow = true;
+    std::int64_t lastFrame = 0;
+    if (io_trace) io_trace->nameThread("writer");
+    for (;;)
+    {
+      LimbStream* chunk = nullptr;
+      const auto waitStart = Clock::now();
+      o_stats.toWrite.sample(toWrite.size());
+      if (!toWrite.pop(chunk, stop)) return;
+      const auto writeStart = Clock::now();
+      stats.waitSeconds += seconds(waitStart, writeStart);
+      if (!chunk->size()) return;
+      if (!io_writer.write(*chunk, writeError)) stop.store(true);
+      // Frames are counted as runs of rows with the same frame, as recordings are grouped by frame
+      for (std::size_t i = 0u; i < chunk->size(); ++i)
+      {
+        o_stats.frames += firstRow || chunk->frame[i] != lastFrame;
+        lastFrame = chunk->frame[i];
+        firstRow = false;
+      }
+      const auto writeEnd = Clock::now();
+      stats.busySeconds += seconds(writeStart, writeEnd);
+      if (io_trace) io_trace->add("write", writeStart, writeEnd, chunk->size());
+      if (stop.load()) return;
+      ++stats.chunks;
+      stats.rows += chunk->size();
+      if (!toRead.push(chunk, stop)) return;
+      stats.waitSeconds += seconds(writeEnd, Clock::now());
+    }
+  });
+
+  // The solve runs on the calling thread, which also works as the first thread of the pool
+  auto& stats = o_stats.stages[LimbPipelineStats::kSolve];
+  if (io_trace) io_trace->nameThread("solver");
+  for (;;)
+  {
+    LimbStream* chunk = nullptr;
+    const auto waitStart = Clock::now();
+    o_stats.toSolve.sample(toSolve.size());
+    if (!toSolve.pop(chunk, stop)) break;
+    const auto solveStart = Clock::now();
+    stats.waitSeconds += seconds(waitStart, solveStart);
+    solveLimbStream(*chunk, io_pool, _precision, _method, _packed, io_trace);
+    const auto solveEnd = Clock::now();
+    stats.busySeconds += seconds(solveStart, solveEnd);
+    if (chunk->size())
+    {
+      ++stats.chunks;
+      stats.rows += chunk->size();
+    }
+    if (!toWrite.push(chunk, stop)) break;
+    stats.waitSeconds += seconds(solveEnd, Clock::now());
+    if (!chunk->size()) break;
+  }
+  reader.join();
+  writer.join();
+  o_stats.seconds = seconds(start, Clock::now());
+  if (!readError.empty()) return LimbStreamIO::fail(o_error, readError);
+  if (!writeError.empty()) return LimbStreamIO::fail(o_error, writeError);
+  return true;
+}
+
+#endif //LIMBPIPELINE_INCLUDE_H
@@ -0,0 +1,647 @@
+#ifndef LIMBSTREAM_INCLUDE_H
+#define LIMBSTREAM_INCLUDE_H
+
+#include "InclineAngleSolver.h"
+#include "TwoBoneIKParallel.h"
+#include "TwoBoneIKSolver.h"
+#include "TraceEvents.h"
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// Recorded animation for offline solves, one row per limb per frame with the inputs of the two bone ik and
+// incline angle nodes, solved headless to the outputs both nodes would give in scene.
+// Streams are read and written as CSV, or as a native byte order binary of fixed size rows when the file name does not
+// end in .csv. CSV files start with a header naming their columns, in any order, and values are written with 17
+// significant digits so they read back bit for bit.
+// Inputs are frame, limb, targetX, targetY, targetZ, poleX, poleY, poleZ, edgeA, edgeB, twist (radians),
+// soften (the soften distance, zero when softening is disabled) and stretchStrength, all required.
+// Outputs are frame, limb, bendAngle, orientationX, orientationY, orientationZ (radians), stretchedEdgeA,
+// stretchedEdgeB and inclineAngle (radians).
+
+// Binary streams start with this header, then each row holds the frame and limb as 64 bit integers followed by the
+// channels in the order listed above as doubles
+struct LimbStreamHeader
+{
+  char magic[4];
+  std::uint32_t version;
+  std::uint64_t rows;
+};
+
+static constexpr char kLimbStreamInputMagic[4] = {'S', 'I', 'K', 'I'};
+static constexpr char kLimbStreamOutputMagic[4] = {'S', 'I', 'K', 'O'};
+static constexpr std::uint32_t kLimbStreamVersion = 1u;
+static constexpr std::size_t kLimbStreamInputChannels = 11u;
+static constexpr std::size_t kLimbStreamOutputChannels = 7u;
+// Header row count of binary streams written before their length is known, such as to a pipe, the rows then run to the
+// end of the file
+static constexpr std::uint64_t kLimbStreamRowsToEnd = ~std::uint64_t(0u);
+
+// Non owning view of the channels of a stream, held in a LimbStream or mapped from a file
+struct LimbStreamView
+{
+  TwoBoneIKBatch limbs;
+  double* inclineAngle;
+};
+
+struct LimbStream
+{
+  std::vector<std::int64_t> frame;
+  std::vector<std::int64_t> limb;
+  // The two bone inputs and outputs, the incline angle shares the target, edges and soften
+  TwoBoneIKBatchBuffers limbs;
+  std::vector<double> inclineAngle;
+
+  void resize(std::size_t _rows)
+  {
+    frame.resize(_rows);
+    limb.resize(_rows);
+    limbs.resize(_rows);
+    inclineAngle.resize(_rows);
+  }
+
+  std::size_t size() const { return frame.size(); }
+
+  LimbStreamView view() { return {limbs.view(), inclineAngle.data()}; }
+
+  // Channels in file order, the outputs starting at kLimbStreamInputChannels
+  std::vector<double>* channel(std::size_t _index)
+  {
+    std::vector<double>* channels[kLimbStreamInputChannels + kLimbStreamOutputChannels] = {
+      &limbs.targetX, &limbs.targetY, &limbs.targetZ, &limbs.poleX, &limbs.poleY, &limbs.poleZ,
+      &limbs.edgeA, &limbs.edgeB, &limbs.twist, &limbs.soften, &limbs.stretchStrength,
+      &limbs.bendAngle, &limbs.orientationX, &limbs.orientationY, &limbs.orientationZ, &limbs.stretchedEdgeA, &limbs.stretchedEdgeB,
+      &inclineAngle
+    };
+    return channels[_index];
+  }
+
+  static const char* channelName(std::size_t _index)
+  {
+    static const char* const names[kLimbStreamInputChannels + kLimbStreamOutputChannels] = {
+      "targetX", "targetY", "targetZ", "poleX", "poleY", "poleZ", "edgeA", "edgeB", "twist", "soften", "stretchStrength",
+      "bendAngle", "orientationX", "orientationY", "orientationZ", "stretchedEdgeA", "stretchedEdgeB", "inclineAngle"
+    };
+    return names[_index];
+  }
+};
+
+inline bool isLimbStreamCSV(const std::string& _path)
+{
+  return _path.size() >= 4u && _path.compare(_path.size() - 4u, 4u, ".csv") == 0;
+}
+
+namespace LimbStreamIO
+{
+
+inline bool fail(std::string& o_error, const std::string& _message)
+{
+  o_error = _message;
+  return false;
+}
+
+// Closes the file on every return path
+struct File
+{
+  std::FILE* file;
+  File(const std::string& _path, const char* _mode) : file(std::fopen(_path.c_str(), _mode)) {}
+  ~File() { if (file) std::fclose(file); }
+};
+
+inline bool readAll(const std::string& _path, std::string& o_contents, std::string& o_error)
+{
+  File in(_path, "rb");
+  if (!in.file) return fail(o_error, "cannot open " + _path + ": " + std::strerror(errno));
+  std::fseek(in.file, 0, SEEK_END);
+  const long size = std::ftell(in.file);
+  std::fseek(in.file, 0, SEEK_SET);
+  o_contents.resize(size > 0 ? std::size_t(size) : 0u);
+  if (size > 0 && std::fread(&o_contents[0], 1u, o_contents.size(), in.file) != o_contents.size()) return fail(o_error, "cannot read " + _path);
+  return true;
+}
+
+static constexpr std::size_t kRowHeaderSize = 2u * sizeof(std::int64_t);
+static constexpr std::size_t kInputRowSize = kRowHeaderSize + kLimbStreamInputChannels * sizeof(double);
+
+// The line in [_begin, _end) less its terminator is empty
+inline bool isBlankLine(const char* _begin, const char* _end)
+{
+  return _begin == _end || (_end == _begin + 1 && *_begin == '\r');
+}
+
+// Rows of a CSV stream after its header, not counting blank lines
+inline std::size_t countCSVRows(const char* _data, std::size_t _size)
+{
+  std::size_t rows = 0u;
+  const char* const end = _data + _size;
+  const char* cursor = static_cast<const char*>(std::memchr(_data, '\n', _size));
+  while (cursor && ++cursor < end)
+  {
+    const char* rowEnd = static_cast<const char*>(std::memchr(cursor, '\n', std::size_t(end - cursor)));
+    if (!rowEnd) rowEnd = end;
+    if (!isBlankLine(cursor, rowEnd)) ++rows;
+    cursor = rowEnd < end ? rowEnd : nullptr;
+  }
+  return rows;
+}
+
+// Maps each column of the CSV header line in [_begin, _end) to its place in a row, frame and limb first then the
+// input channels, or -1 for columns that are not read
+inline bool parseCSVHeader(const std::string& _path, const char* _begin, const char* _end, std::vector<int>& o_columnOf, std::string& o_error)
+{
+  std::string header(_begin, _end);
+  if (!header.empty() && header.back() == '\r') header.pop_back();
+  o_columnOf.clear();
+  std::size_t found = 0u;
+  std::size_t begin = 0u;
+  while (begin <= header.size())
+  {
+    std::size_t comma = header.find(',', begin);
+    if (comma == std::string::npos) comma = header.size();
+    const std::string name = header.substr(begin, comma - begin);
+    int column = -1;
+    if (name == "frame") column = 0;
+    else if (name == "limb") column = 1;
+    for (std::size_t c = 0u; c < kLimbStreamInputChannels && column < 0; ++c)
+    {
+      if (name == LimbStream::channelName(c)) column = int(2u + c);
+    }
+    if (column >= 0) ++found;
+    o_columnOf.push_back(column);
+    begin = comma + 1u;
+  }
+  if (found != 2u + kLimbStreamInputChannels)
+  {
+    return fail(o_error, _path + " needs the columns frame, limb and every input channel, see LimbStream.h");
+  }
+  return true;
+}
+
+// Parses the non blank CSV row in [_begin, _end), line _line of the file, with the columns mapped by parseCSVHeader.
+// Values are copied out before parsing, so the row needs no terminator and can be mapped
+inline bool parseCSVRow(
+    const std::string& _path, std::size_t _line, const char* _begin, const char* _end, const std::vector<int>& _columnOf,
+    std::int64_t* o_ids, double* o_channels, std::string& o_error)
+{
+  if (_end > _begin && _end[-1] == '\r') --_end;
+  char field[64];
+  const char* cursor = _begin;
+  for (std::size_t c = 0u; c < _columnOf.size(); ++c)
+  {
+    const char* fieldEnd = static_cast<const char*>(std::memchr(cursor, ',', std::size_t(_end - cursor)));
+    if (!fieldEnd) fieldEnd = _end;
+    if ((fieldEnd == _end) != (c + 1u == _columnOf.size()))
+    {
+      return fail(o_error, _path + ":" + std::to_string(_line) + (fieldEnd == _end ? " has too few columns" : " has too many columns"));
+    }
+    const std::size_t length = std::size_t(fieldEnd - cursor);
+    if (_columnOf[c] >= 0)
+    {
+      if (!length || length >= sizeof(field)) return fail(o_error, _path + ":" + std::to_string(_line) + " has a missing or invalid value");
+      std::memcpy(field, cursor, length);
+      field[length] = '\0';
+      char* parsed = nullptr;
+      if (_columnOf[c] < 2) o_ids[_columnOf[c]] = std::strtoll(field, &parsed, 10);
+      else o_channels[_columnOf[c] - 2] = std::strtod(field, &parsed);
+      while (*parsed == ' ') ++parsed;
+      if (parsed == field || *parsed) return fail(o_error, _path + ":" + std::to_string(_line) + " has a missing or invalid value");
+    }
+    cursor = fieldEnd + (fieldEnd < _end ? 1 : 0);
+  }
+  return true;
+}
+
+// Parses the CSV input stream in [_data, _data + _size), calling _row(frame, limb, channels) for every row with the
+// input channels in file order
+template <typename TRow>
+inline bool parseCSV(const std::string& _path, const char* _data, std::size_t _size, const TRow& _row, std::string& o_error)
+{
+  const char* cursor = _data;
+  const char* const end = _data + _size;
+  auto lineEnd = [&]() { const char* e = static_cast<const char*>(std::memchr(cursor, '\n', std::size_t(end - cursor))); return e ? e : end; };
+
+  std::vector<int> columnOf;
+  const char* headerEnd = lineEnd();
+  if (!parseCSVHeader(_path, cursor, headerEnd, columnOf, o_error)) return false;
+  cursor = headerEnd < end ? headerEnd + 1 : end;
+
+  std::int64_t ids[2];
+  double channels[kLimbStreamInputChannels];
+  for (std::size_t line = 2u; cursor < end; ++line)
+  {
+    const char* rowEnd = lineEnd();
+    if (!isBlankLine(cursor, rowEnd))
+    {
+      if (!parseCSVRow(_path, line, cursor, rowEnd, columnOf, ids, channels, o_error)) return false;
+      _row(ids[0], ids[1], channels);
+    }
+    cursor = rowEnd < end ? rowEnd + 1 : end;
+  }
+  return true;
+}
+
+inline bool readCSV(const std::string& _path, const std::string& _contents, LimbStream& o_stream, std::string& o_error)
+{
+  o_stream.resize(countCSVRows(_contents.data(), _contents.size()));
+  std::size_t row = 0u;
+  return parseCSV(_path, _contents.data(), _contents.size(), [&](std::int64_t _frame, std::int64_t _limb, const double* _channels)
+  {
+    o_stream.frame[row] = _frame;
+    o_stream.limb[row] = _limb;
+    for (std::size_t c = 0u; c < kLimbStreamInputChannels; ++c) (*o_stream.channel(c))[row] = _channels[c];
+    ++row;
+  }, o_error);
+}
+
+// Checks the magic and version of a binary input header
+inline bool checkBinaryHeader(const std::string& _path, const LimbStreamHeader& _header, std::string& o_error)
+{
+  if (std::memcmp(_header.magic, kLimbStreamInputMagic, 4u) || _header.version != kLimbStreamVersion)
+  {
+    return fail(o_error, _path + " is not a version " + std::to_string(kLimbStreamVersion) + " limb input stream");
+  }
+  return true;
+}
+
+// Unpacks _rows binary input rows from _data into rows [_first, _first + _rows) of the stream
+inline void unpackBinaryRows(const char* _data, std::size_t _rows, LimbStream& io_stream, std::size_t _first)
+{
+  for (std::size_t i = _first; i < _first + _rows; ++i, _data += kInputRowSize)
+  {
+    std::memcpy(&io_stream.frame[i], _data, sizeof(std::int64_t));
+    std::memcpy(&io_stream.limb[i], _data + sizeof(std::int64_t), sizeof(std::int64_t));
+    for (std::size_t c = 0u; c < kLimbStreamInputChannels; ++c)
+    {
+      std::memcpy(&(*io_stream.channel(c))[i], _data + kRowHeaderSize + c * sizeof(double), sizeof(double));
+    }
+  }
+}
+
+inline bool readBinary(const std::string& _path, const std::string& _contents, LimbStream& o_stream, std::string& o_error)
+{
+  LimbStreamHeader header;
+  if (_contents.size() < sizeof(header)) return fail(o_error, _path + " is too short for a limb stream");
+  std::memcpy(&header, _contents.data(), sizeof(header));
+  if (!checkBinaryHeader(_path, header, o_error)) return false;
+  const std::size_t available = (_contents.size() - sizeof(header)) / kInputRowSize;
+  if (header.rows == kLimbStreamRowsToEnd) header.rows = available;
+  if (available < header.rows) return fail(o_error, _path + " is shorter than its header says");
+
+  o_stream.resize(std::size_t(header.rows));
+  unpackBinaryRows(_contents.data() + sizeof(header), std::size_t(header.rows), o_stream, 0u);
+  return true;
+}
+
+// Appends rows [_begin, _end) of the channels [_first, _first + _count), after the frame and limb of every row
+inline void appendRows(
+    std::string& io_buffer, bool _csv, LimbStream& _stream, std::size_t _begin, std::size_t _end, std::size_t _first, std::size_t _count)
+{
+  char value[32];
+  for (std::size_t i = _begin; i < _end; ++i)
+  {
+    if (_csv)
+    {
+      io_buffer += std::to_string(_stream.frame[i]);
+      io_buffer += ',';
+      io_buffer += std::to_string(_stream.limb[i]);
+      for (std::size_t c = _first; c < _first + _count; ++c)
+      {
+        io_buffer += ',';
+        io_buffer.append(value, std::size_t(std::snprintf(value, sizeof(value), "%.17g", (*_stream.channel(c))[i])));
+      }
+      io_buffer += '\n';
+    }
+    else
+    {
+      io_buffer.append(reinterpret_cast<const char*>(&_stream.frame[i]), sizeof(std::int64_t));
+      io_buffer.append(reinterpret_cast<const char*>(&_stream.limb[i]), sizeof(std::int64_t));
+      for (std::size_t c = _first; c < _first + _count; ++c) io_buffer.append(reinterpret_cast<const char*>(&(*_stream.channel(c))[i]), sizeof(double));
+    }
+  }
+}
+
+// Appends the CSV header row or the binary header for _rows rows
+inline void appendHeader(std::string& io_buffer, bool _csv, const char* _magic, std::uint64_t _rows, std::size_t _first, std::size_t _count)
+{
+  if (_csv)
+  {
+    io_buffer += "frame,limb";
+    for (std::size_t c = _first; c < _first + _count; ++c) io_buffer += std::string(",") + LimbStream::channelName(c);
+    io_buffer += '\n';
+    return;
+  }
+  LimbStreamHeader header;
+  std::memcpy(header.magic, _magic, 4u);
+  header.version = kLimbStreamVersion;
+  header.rows = _rows;
+  io_buffer.append(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+// Writes the channels [_first, _first + _count) after the frame and limb of every row
+inline bool write(const std::string& _path, LimbStream& _stream, const char* _magic, std::size_t _first, std::size_t _count, std::string& o_error)
+{
+  File out(_path, "wb");
+  if (!out.file) return fail(o_error, "cannot open " + _path + ": " + std::strerror(errno));
+  const bool csv = isLimbStreamCSV(_path);
+  std::string buffer;
+  buffer.reserve(1u << 20);
+  appendHeader(buffer, csv, _magic, _stream.size(), _first, _count);
+  // Encoded a block of rows at a time, so the buffer stays around a megabyte
+  static constexpr std::size_t kBlockRows = 4096u;
+  for (std::size_t begin = 0u; begin < _stream.size(); begin += kBlockRows)
+  {
+    appendRows(buffer, csv, _stream, begin, std::min(begin + kBlockRows, _stream.size()), _first, _count);
+    if (std::fwrite(buffer.data(), 1u, buffer.size(), out.file) != buffer.size()) return fail(o_error, "cannot write " + _path);
+    buffer.clear();
+  }
+  if (std::fwrite(buffer.data(), 1u, buffer.size(), out.file) != buffer.size() || std::fflush(out.file) != 0) return fail(o_error, "cannot write " + _path);
+  return true;
+}
+
+}
+
+// Reads the inputs of a stream, leaving the outputs sized to match
+inline bool readLimbStreamInputs(const std::string& _path, LimbStream& o_stream, std::string& o_error)
+{
+  std::string contents;
+  if (!LimbStreamIO::readAll(_path, contents, o_error)) return false;
+  return isLimbStreamCSV(_path) ?
+    LimbStreamIO::readCSV(_path, contents, o_stream, o_error) :
+    LimbStreamIO::readBinary(_path, contents, o_stream, o_error);
+}
+
+inline bool writeLimbStreamInputs(const std::string& _path, LimbStream& _stream, std::string& o_error)
+{
+  return LimbStreamIO::write(_path, _stream, kLimbStreamInputMagic, 0u, kLimbStreamInputChannels, o_error);
+}
+
+inline bool writeLimbStreamOutputs(const std::string& _path, LimbStream& _stream, std::string& o_error)
+{
+  return LimbStreamIO::write(_path, _stream, kLimbStreamOutputMagic, kLimbStreamInputChannels, kLimbStreamOutputChannels, o_error);
+}
+
+// Reads the inputs of a stream a chunk of rows at a time, from files or pipes, holding no more than one read
+// buffer however long the stream is
+class LimbStreamReader
+{
+public:
+  LimbStreamReader() = default;
+  ~LimbStreamReader() { close(); }
+
+  LimbStreamReader(const LimbStreamReader&) = delete;
+  LimbStreamReader& operator=(const LimbStreamReader&) = delete;
+
+  bool open(const std::string& _path, std::string& o_error)
+  {
+    close();
+    m_path = _path;
+    m_csv = isLimbStreamCSV(_path);
+    m_file = std::fopen(_path.c_str(), "rb");
+    if (!m_file) return LimbStreamIO::fail(o_error, "cannot open " + _path + ": " + std::strerror(errno));
+    if (m_csv)
+    {
+      const char* end = nullptr;
+      if (!nextLine(end, o_error)) return false;
+      if (!end) return LimbStreamIO::fail(o_error, _path + " has no header");
+      if (!LimbStreamIO::parseCSVHeader(_path, m_buffer.data() + m_begin, end, m_columnOf, o_error)) return false;
+      m_begin = std::size_t(end - m_buffer.data()) + 1u;
+      m_line = 1u;
+      return true;
+    }
+    LimbStreamHeader header;
+    if (std::fread(&header, sizeof(header), 1u, m_file) != 1u) return LimbStreamIO::fail(o_error, _path + " is too short for a limb stream");
+    if (!LimbStreamIO::checkBinaryHeader(_path, header, o_error)) return false;
+    m_remaining = header.rows;
+    return true;
+  }
+
+  void close()
+  {
+    if (m_file) std::fclose(m_file);
+    m_file = nullptr;
+    m_buffer.clear();
+    m_begin = 0u;
+    m_end = false;
+  }
+
+  // Reads up to _maxRows rows into io_chunk, resizing it to the rows read, which is none at the end of the stream
+  bool read(LimbStream& io_chunk, std::size_t _maxRows, std::string& o_error)
+  {
+    io_chunk.resize(_maxRows);
+    std::size_t rows = 0u;
+    if (m_csv)
+    {
+      std::int64_t ids[2];
+      double channels[kLimbStreamInputChannels];
+      while (rows < _maxRows)
+      {
+        const char* end = nullptr;
+        if (!nextLine(end, o_error)) return false;
+        if (!end) break;
+        const char* begin = m_buffer.data() + m_begin;
+        ++m_line;
+        m_begin = std::size_t(end - m_buffer.data()) + 1u;
+        if (LimbStreamIO::isBlankLine(begin, end)) continue;
+        if (!LimbStreamIO::parseCSVRow(m_path, m_line, begin, end, m_columnOf, ids, channels, o_error)) return false;
+        io_chunk.frame[rows] = ids[0];
+        io_chunk.limb[rows] = ids[1];
+        for (std::size_t c = 0u; c < kLimbStreamInputChannels; ++c) (*io_chunk.channel(c))[rows] = channels[c];
+        ++rows;
+      }
+    }
+    else
+    {
+      const std::size_t wanted = std::size_t(std::min<std::uint64_t>(_maxRows, m_remaining));
+      m_buffer.resize(wanted * LimbStreamIO::kInputRowSize);
+      const std::size_t bytes = wanted ? std::fread(&m_buffer[0], 1u, m_buffer.size(), m_file) : 0u;
+      rows = bytes / LimbStreamIO::kInputRowSize;
+      if (bytes % LimbStreamIO::kInputRowSize) return LimbStreamIO::fail(o_error, m_path + " ends part way through a row");
+      if (rows < wanted && m_remaining != kLimbStreamRowsToEnd) return LimbStreamIO::fail(o_error, m_path + " is shorter than its header says");
+      if (m_remaining != kLimbStreamRowsToEnd) m_remaining -= rows;
+      LimbStreamIO::unpackBinaryRows(m_buffer.data(), rows, io_chunk, 0u);
+    }
+    io_chunk.resize(rows);
+    return true;
+  }
+
+private:
+  // Sets o_end to the end of the next line from m_begin, reading more of the file as needed,
+  // or to null when the stream has no more lines. A last line with no newline ends at the end of the buffer
+  bool nextLine(const char*& o_end, std::string& o_error)
+  {
+    static constexpr std::size_t kReadSize = 1u << 16;
+    for (std::size_t searched = m_begin;;)
+    {
+      const char* data = m_buffer.data();
+      const void* newline = std::memchr(data + searched, '\n', m_buffer.size() - searched);
+      if (newline)
+      {
+        o_end = static_cast<const char*>(newline);
+        return true;
+      }
+      if (m_end)
+      {
+        // Give the last line a terminator so it parses like the others
+        if (m_begin < m_buffer.size())
+        {
+          m_buffer += '\n';
+          o_end = m_buffer.data() + m_buffer.size() - 1u;
+        }
+        else o_end = nullptr;
+        return true;
+      }
+      // Drop the lines already parsed and read on
+      m_buffer.erase(0u, m_begin);
+      searched = m_buffer.size();
+      m_begin = 0u;
+      m_buffer.resize(searched + kReadSize);
+      const std::size_t bytes = std::fread(&m_buffer[searched], 1u, kReadSize, m_file);
+      m_buffer.resize(searched + bytes);
+      if (bytes < kReadSize)
+      {
+        if (std::ferror(m_file)) return LimbStreamIO::fail(o_error, "cannot read " + m_path);
+        m_end = true;
+      }
+    }
+  }
+
+  std::string m_path;
+  std::FILE* m_file = nullptr;
+  bool m_csv = false;
+  // Unparsed CSV, from m_begin, or the binary rows of the last read
+  std::string m_buffer;
+  std::size_t m_begin = 0u;
+  bool m_end = false;
+  std::vector<int> m_columnOf;
+  std::size_t m_line = 0u;
+  std::uint64_t m_remaining = 0u;
+};
+
+// Writes the outputs of a stream a chunk of rows at a time, to files or pipes.
+// A binary stream's length is filled in by close when the file can seek, otherwise its rows run to the end
+class LimbStreamWriter
+{
+public:
+  LimbStreamWriter() = default;
+  ~LimbStreamWriter()
+  {
+    std::string error;
+    close(error);
+  }
+
+  LimbStreamWriter(const LimbStreamWriter&) = delete;
+  LimbStreamWriter& operator=(const LimbStreamWriter&) = delete;
+
+  bool open(const std::string& _path, std::string& o_error)
+  {
+    close(o_error);
+    m_path = _path;
+    m_csv = isLimbStreamCSV(_path);
+    m_rows = 0u;
+    m_file = std::fopen(_path.c_str(), "wb");
+    if (!m_file) return LimbStreamIO::fail(o_error, "cannot open " + _path + ": " + std::strerror(errno));
+    m_buffer.clear();
+    LimbStreamIO::appendHeader(m_buffer, m_csv, kLimbStreamOutputMagic, kLimbStreamRowsToEnd, kLimbStreamInputChannels, kLimbStreamOutputChannels);
+    return flush(o_error);
+  }
+
+  bool write(LimbStream& _chunk, std::string& o_error)
+  {
+    LimbStreamIO::appendRows(m_buffer, m_csv, _chunk, 0u, _chunk.size(), kLimbStreamInputChannels, kLimbStreamOutputChannels);
+    m_rows += _chunk.size();
+    return flush(o_error);
+  }
+
+  bool close(std::string& o_error)
+  {
+    if (!m_file) return true;
+    bool ok = std::fflush(m_file) == 0;
+    if (ok && !m_csv && std::fseek(m_file, 0, SEEK_SET) == 0)
+    {
+      m_buffer.clear();
+      LimbStreamIO::appendHeader(m_buffer, false, kLimbStreamOutputMagic, m_rows, 0u, 0u);
+      ok = std::fwrite(m_buffer.data(), 1u, m_buffer.size(), m_file) == m_buffer.size();
+    }
+    ok = std::fclose(m_file) == 0 && ok;
+    m_file = nullptr;
+    return ok || LimbStreamIO::fail(o_error, "cannot write " + m_path);
+  }
+
+private:
+  bool flush(std::string& o_error)
+  {
+    const bool ok = std::fwrite(m_buffer.data(), 1u, m_buffer.size(), m_file) == m_buffer.size();
+    m_buffer.clear();
+    return ok || LimbStreamIO::fail(o_error, "cannot write " + m_path);
+  }
+
+  std::string m_path;
+  std::FILE* m_file = nullptr;
+  bool m_csv = false;
+  std::uint64_t m_rows = 0u;
+  std::string m_buffer;
+};
+
+// Solves one row exactly as the two bone ik and incline angle node computes do,
+// specialized on the features of the row as the node specializes on those of its compute
+template <typename TMath>
+inline void solveLimbStreamRow(const LimbStreamView& _stream, std::size_t _row, TwoBoneIKOrientationMethod _method)
+{
+  const auto& limbs = _stream.limbs;
+  const Vector3<double> targetLocation(limbs.targetX[_row], limbs.targetY[_row], limbs.targetZ[_row]);
+  // The two bone node clamps the target away from zero components for both orientation methods
+  const auto solution = solveTwoBoneIKFeatures<double, TMath>(
+      makeNonZero<double>(targetLocation), Vector3<double>(limbs.poleX[_row], limbs.poleY[_row], limbs.poleZ[_row]),
+      limbs.edgeA[_row], limbs.edgeB[_row], limbs.twist[_row], limbs.soften[_row], limbs.stretchStrength[_row], _method);
+  limbs.bendAngle[_row] = solution.bendAngle;
+  limbs.orientationX[_row] = solution.orientation.x;
+  limbs.orientationY[_row] = solution.orientation.y;
+  limbs.orientationZ[_row] = solution.orientation.z;
+  limbs.stretchedEdgeA[_row] = solution.stretchedEdgeA;
+  limbs.stretchedEdgeB[_row] = solution.stretchedEdgeB;
+  _stream.inclineAngle[_row] = solveInclineAngle<double, TMath>(targetLocation, limbs.edgeA[_row], limbs.edgeB[_row], limbs.soften[_row]);
+}
+
+// Solves _rows rows over the pool, rows are independent so frames and limbs are split alike.
+// With _packed the exact angles solve goes through the packed batch solve instead, as the SimpleIK evaluator does,
+// which agrees with the node computes within the error documented in TwoBoneIKBatch.h.
+// With io_trace each chunk is traced as a solve on the thread that ran it, the packed solve as one
+inline void solveLimbStream(
+    const LimbStreamView& _stream, std::size_t _rows, ThreadPool& io_pool, SolvePrecision _precision, TwoBoneIKOrientationMethod _method,
+    bool _packed = false, TraceEventWriter* io_trace = nullptr)
+{
+  if (_packed && _precision == kPrecisionExact && _method == kOrientationAngles)
+  {
+    TraceEventWriter::Scope trace(io_trace, "solve", _rows);
+    const auto& limbs = _stream.limbs;
+    solveTwoBoneIKBatchParallel(limbs, _rows, io_pool);
+    const InclineAngleBatch incline = {limbs.targetX, limbs.targetY, limbs.targetZ, limbs.edgeA, limbs.edgeB, limbs.soften, _stream.inclineAngle};
+    solveInclineAngleBatchParallel(incline, _rows, io_pool);
+    return;
+  }
+  io_pool.parallelFor(_rows, kBatchChunkSize, [&](std::size_t _begin, std::size_t _end)
+  {
+    TraceEventWriter::Scope trace(io_trace, "solve", _end - _begin);
+    for (std::size_t i = _begin; i < _end; ++i)
+    {
+      switch (_precision)
+      {
+        case kPrecisionHigh: solveLimbStreamRow<HighMath>(_stream, i, _method); break;
+        case kPrecisionFast: solveLimbStreamRow<FastMath>(_stream, i, _method); break;
+        default: solveLimbStreamRow<ExactMath>(_stream, i, _method); break;
+      }
+    }
+  });
+}
+
+inline void solveLimbStream(
+    LimbStream& io_stream, ThreadPool& io_pool, SolvePrecision _precision, TwoBoneIKOrientationMethod _method, bool _packed = false,
+    TraceEventWriter* io_trace = nullptr)
+{
+  solveLimbStream(io_stream.view(), io_stream.size(), io_pool, _precision, _method, _packed, io_trace);
+}
+
+#endif //LIMBSTREAM_INCLUDE_H
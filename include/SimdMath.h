@@ -0,0 +1,228 @@
+#ifndef SIMDMATH_INCLUDE_H
+#define SIMDMATH_INCLUDE_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <cfloat>
+
+// Packs of doubles built on the GCC vector extensions.
+// The compiler lowers a pack to SSE or AVX registers depending on the target flags,
+// so the same kernel source serves every instruction set.
+// Passing wide packs by value changes the ABI when AVX is off, which is fine as everything here is inlined,
+// so builds pass -Wno-psabi to silence the note GCC emits for every instantiation.
+template <unsigned TWidth>
+struct SimdPack
+{
+  static constexpr unsigned width = TWidth;
+  typedef double Real __attribute__((vector_size(TWidth * sizeof(double))));
+  typedef std::int64_t Mask __attribute__((vector_size(TWidth * sizeof(std::int64_t))));
+  typedef std::int32_t Index __attribute__((vector_size(TWidth * sizeof(std::int32_t))));
+};
+
+template <typename V>
+struct SimdTraits
+{
+  static constexpr unsigned width = sizeof(V) / sizeof(double);
+  typedef typename SimdPack<width>::Mask Mask;
+  typedef typename SimdPack<width>::Index Index;
+};
+
+// The transcendental functions below are branchless ports of the Cephes double precision routines,
+// they are accurate to a couple of ulp over the ranges the solvers use
+
+template <typename V>
+inline static V simdBroadcast(double x)
+{
+  return V{} + x;
+}
+
+template <typename V>
+inline static V simdLoad(const double* p)
+{
+  V v;
+  std::memcpy(&v, p, sizeof(V));
+  return v;
+}
+
+template <typename V>
+inline static void simdStore(double* p, V v)
+{
+  std::memcpy(p, &v, sizeof(V));
+}
+
+template <typename V, typename M>
+inline static V simdSelect(M mask, V a, V b)
+{
+  return (V)(((M)a & mask) | ((M)b & ~mask));
+}
+
+template <typename V>
+inline static V simdAbs(V x)
+{
+  typedef typename SimdTraits<V>::Mask M;
+  return (V)((M)x & INT64_MAX);
+}
+
+// Copies the sign of s onto the magnitude of x
+template <typename V>
+inline static V simdCopySign(V x, V s)
+{
+  typedef typename SimdTraits<V>::Mask M;
+  return (V)(((M)x & INT64_MAX) | ((M)s & INT64_MIN));
+}
+
+template <typename V>
+inline static V simdMin(V a, V b)
+{
+  return simdSelect(a < b, a, b);
+}
+
+template <typename V>
+inline static V simdMax(V a, V b)
+{
+  return simdSelect(a > b, a, b);
+}
+
+template <typename V>
+inline static V simdClamp(V x, V lower, V upper)
+{
+  return simdMax(lower, simdMin(x, upper));
+}
+
+// Hides a value from the optimizer, -ffast-math would otherwise fold the split constant
+// argument reductions below back into a single multiply and lose their extra precision
+template <typename V>
+inline static V simdOpaque(V x)
+{
+#if defined(__AVX512F__)
+  __asm__("" : "+v"(x));
+#elif defined(__AVX__)
+  if (sizeof(V) <= 32u) __asm__("" : "+x"(x)); else __asm__("" : "+m"(x));
+#else
+  if (sizeof(V) <= 16u) __asm__("" : "+x"(x)); else __asm__("" : "+m"(x));
+#endif
+  return x;
+}
+
+// Written per lane, the compiler emits a single packed sqrt for this loop
+template <typename V>
+inline static V simdSqrt(V x)
+{
+  V out;
+  for (unsigned i = 0u; i < SimdTraits<V>::width; ++i)
+    out[i] = __builtin_sqrt(x[i]);
+  return out;
+}
+
+// Only valid for |x| < 2^31, which covers every reduction in this file
+template <typename V>
+inline static V simdFloor(V x)
+{
+  typedef typename SimdTraits<V>::Index I;
+  const V truncated = __builtin_convertvector(__builtin_convertvector(x, I), V);
+  return simdSelect(truncated > x, truncated - 1.0, truncated);
+}
+
+template <typename V>
+inline static V simdExp(V x)
+{
+  typedef typename SimdTraits<V>::Mask M;
+  static constexpr double maxLog =  7.09782712893383996843E2;
+  static constexpr double minLog = -7.08396418532264106224E2;
+  static constexpr double log2e  =  1.4426950408889634073599;
+  static constexpr double c1 = 6.93145751953125E-1;
+  static constexpr double c2 = 1.42860682030941723212E-6;
+
+  const V clamped = simdClamp(x, simdBroadcast<V>(minLog), simdBroadcast<V>(maxLog));
+  // Express exp(x) as exp(g) * 2^n
+  const V n = simdFloor(log2e * clamped + 0.5);
+  const V g = simdOpaque(clamped - n * c1) - n * c2;
+
+  const V gg = g * g;
+  const V p = g * ((1.26177193074810590878E-4 * gg + 3.02994407707441961300E-2) * gg + 9.99999999999999999910E-1);
+  const V q = ((3.00198505138664455042E-6 * gg + 2.52448340349684104192E-3) * gg + 2.27265548208155028766E-1) * gg + 2.00000000000000000009E0;
+  const V r = 1.0 + 2.0 * (p / (q - p));
+
+  // Build 2^n directly in the exponent bits, adding 2^52 places the integer in the low mantissa bits
+  const M biased = (M)(n + (1023.0 + 4503599627370496.0)) - (M)simdBroadcast<V>(4503599627370496.0);
+  const V scale = (V)(biased << 52);
+  return simdSelect(x < minLog, V{}, r * scale);
+}
+
+// Arc tangent over the whole real line, infinities map to +-pi/2
+template <typename V>
+inline static V simdAtan(V x)
+{
+  static constexpr double t3p8 = 2.41421356237309504880;
+  static constexpr double moreBits = 6.123233995736765886130E-17;
+  const V ax = simdAbs(x);
+
+  // Reduce the argument into [0, 0.66]
+  const auto large = ax > t3p8;
+  const auto medium = (ax > 0.66) & ~large;
+  V reduced = simdSelect(large, -1.0 / ax, ax);
+  reduced = simdSelect(medium, (ax - 1.0) / (ax + 1.0), reduced);
+  V offset = simdSelect(large, simdBroadcast<V>(M_PI_2), V{});
+  offset = simdSelect(medium, simdBroadcast<V>(M_PI_4), offset);
+  V extra = simdSelect(large, simdBroadcast<V>(moreBits), V{});
+  extra = simdSelect(medium, simdBroadcast<V>(0.5 * moreBits), extra);
+
+  const V z = reduced * reduced;
+  const V p = (((-8.750608600031904122785E-1 * z - 1.615753718733365076637E1) * z - 7.500855792314704667340E1) * z - 1.228866684490136173410E2) * z - 6.485021904942025371773E1;
+  const V q = ((((z + 2.485846490142306297962E1) * z + 1.650270098316988542046E2) * z + 4.328810604912902668951E2) * z + 4.853903996359136964868E2) * z + 1.945506571482613964425E2;
+  const V result = offset + (reduced * z * p / q + reduced + extra);
+  return simdCopySign(result, x);
+}
+
+// Quadrant aware arc tangent of y/x, the ratio is formed from the smaller over the larger magnitude
+// so no infinities are produced, atan2(0, 0) returns 0
+template <typename V>
+inline static V simdAtan2(V y, V x)
+{
+  const V ax = simdAbs(x);
+  const V ay = simdAbs(y);
+  const V big = simdMax(simdMax(ax, ay), simdBroadcast<V>(DBL_MIN));
+  const V small = simdMin(ax, ay);
+  V angle = simdAtan(small / big);
+  angle = simdSelect(ay > ax, M_PI_2 - angle, angle);
+  angle = simdSelect(x < 0.0, M_PI - angle, angle);
+  return simdCopySign(angle, y);
+}
+
+// Uses acos(x) = atan2(sqrt(1 - x^2), x) which stays finite at +-1
+template <typename V>
+inline static V simdAcos(V x)
+{
+  return simdAtan2(simdSqrt((1.0 - x) * (1.0 + x)), x);
+}
+
+// Sine and cosine sharing one argument reduction, valid for |x| < 1e9
+template <typename V>
+inline static void simdSinCos(V x, V& o_sin, V& o_cos)
+{
+  static constexpr double fourOverPi = 1.27323954473516268615;
+  static constexpr double dp1 = 7.85398125648498535156E-1;
+  static constexpr double dp2 = 3.77489470793079817668E-8;
+  static constexpr double dp3 = 2.69515142907905952645E-15;
+  const V ax = simdAbs(x);
+
+  // Find the octant, rounding odd octants up so we reduce about a multiple of pi/2
+  V octant = simdFloor(ax * fourOverPi);
+  octant = octant + (octant - 2.0 * simdFloor(octant * 0.5));
+  const V j = octant - 8.0 * simdFloor(octant * 0.125);
+
+  const V z = simdOpaque(simdOpaque(ax - octant * dp1) - octant * dp2) - octant * dp3;
+  const V zz = z * z;
+  const V s = z + z * zz * (((((1.58962301576546568060E-10 * zz - 2.50507477628578072866E-8) * zz + 2.75573136213857245213E-6) * zz - 1.98412698295895385996E-4) * zz + 8.33333333332211858878E-3) * zz - 1.66666666666666307295E-1);
+  const V c = 1.0 - 0.5 * zz + zz * zz * (((((-1.13585365213876817300E-11 * zz + 2.08757008419747316778E-9) * zz - 2.75573141792967388112E-7) * zz + 2.48015872888517045348E-5) * zz - 1.38888888888730564116E-3) * zz + 4.16666666666665929218E-2);
+
+  // Octants 2 and 6 swap the polynomials, 4 and 6 negate the sine, 2 and 4 negate the cosine
+  const auto swap = (j == 2.0) | (j == 6.0);
+  const V sinOut = simdSelect(swap, c, s);
+  const V cosOut = simdSelect(swap, s, c);
+  o_sin = sinOut * simdSelect((x < 0.0) ^ (j > 3.0), simdBroadcast<V>(-1.0), simdBroadcast<V>(1.0));
+  o_cos = cosOut * simdSelect((j == 2.0) | (j == 4.0), simdBroadcast<V>(-1.0), simdBroadcast<V>(1.0));
+}
+
+#endif //SIMDMATH_INCLUDE_H
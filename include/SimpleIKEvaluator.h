@@ -0,0 +1,428 @@
+#ifndef SIMPLEIKEVALUATOR_INCLUDE_H
+#define SIMPLEIKEVALUATOR_INCLUDE_H
+
+#include <maya/MPxCustomEvaluator.h>
+#include <maya/MCustomEvaluatorClusterNode.h>
+#include <maya/MEvaluationNode.h>
+#include <maya/MEvaluationNodeIterator.h>
+#include <maya/MEvaluationGraph.h>
+#include <maya/MPxCommand.h>
+#include <maya/MArgList.h>
+#include <maya/MIntArray.h>
+#include <maya/MFnDependencyNode.h>
+#include <maya/MPlug.h>
+#include <maya/MPlugArray.h>
+#include <maya/MFnPlugin.h>
+#include <maya/MThreadUtils.h>
+#include "TwoBoneIK.h"
+#include "InclineAngle.h"
+#include "TwoBoneIKParallel.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Custom evaluator that claims the SimpleIK nodes of the evaluation graph,
+// gathers their inputs into packed arrays, solves each node type in one batch on the shared thread pool and scatters the outputs back.
+// Nodes using options the packed solve does not cover are evaluated by their own compute within the cluster.
+// Claimed nodes may feed each other, so the cluster is split into levels by their connections, each level only reading
+// outputs of the levels before it, and every level is gathered, solved and scattered before the next is gathered.
+// The packed solve agrees with the per node compute to 1e-9 radians, and to 1e-7 at the fully extended and folded limits,
+// see TwoBoneIKBatch.h. It only covers the exact precision, nodes set to an approximate one are computed on their own.
+class SimpleIKEvaluator : public MPxCustomEvaluator
+{
+public:
+  // Node counts of the last evaluated frame, and running totals
+  struct Stats
+  {
+    unsigned long long frames;
+    unsigned long long clusters;
+    unsigned long long batchedNodes;
+    unsigned long long fallbackNodes;
+    unsigned long long totalBatchedNodes;
+    unsigned long long totalFallbackNodes;
+  };
+
+  static const char* name() { return "SimpleIK"; }
+
+  static void* creator() { return new SimpleIKEvaluator(); }
+
+  static MStatus registerEvaluator(MFnPlugin& pluginFn, unsigned _priority)
+  {
+    return pluginFn.registerEvaluator(name(), _priority, creator);
+  }
+
+  static MStatus deregisterEvaluator(MFnPlugin& pluginFn)
+  {
+    return pluginFn.deregisterEvaluator(name());
+  }
+
+  static Stats stats()
+  {
+    const auto& counters = globalCounters();
+    return {
+      counters.frames.load(std::memory_order_relaxed),
+      counters.clusters.load(std::memory_order_relaxed),
+      counters.batchedNodes.load(std::memory_order_relaxed),
+      counters.fallbackNodes.load(std::memory_order_relaxed),
+      counters.totalBatchedNodes.load(std::memory_order_relaxed),
+      counters.totalFallbackNodes.load(std::memory_order_relaxed)
+    };
+  }
+
+  static void resetStats()
+  {
+    auto& counters = globalCounters();
+    for (auto* counter : {
+        &counters.frames, &counters.clusters, &counters.batchedNodes, &counters.fallbackNodes,
+        &counters.totalBatchedNodes, &counters.totalFallbackNodes, &counters.frameClusters,
+        &counters.frameBatchedNodes, &counters.frameFallbackNodes})
+    {
+      counter->store(0u, std::memory_order_relaxed);
+    }
+  }
+
+  SimpleIKEvaluator()
+  {
+    // Neighbouring SimpleIK nodes are merged into one cluster, so they share a batch
+    setConsolidation(kConsolidateR);
+  }
+
+  bool markIfSupported(const MEvaluationNode* _node) override
+  {
+    MStatus status;
+    MFnDependencyNode fn(_node->dependencyNode(&status), &status);
+    if (!status) return false;
+    MPxNode* userNode = fn.userNode();
+    return dynamic_cast<twoBoneIK*>(userNode) || dynamic_cast<inclineAngle*>(userNode);
+  }
+
+  // Clusters share no data, so they can be evaluated alongside each other, except those with levels big enough to be
+  // split over the plugin pool, which runs one job at a time, so they would only wait on each other's jobs
+  MCustomEvaluatorClusterNode::SchedulingType schedulingType(const MCustomEvaluatorClusterNode* _cluster) override
+  {
+    std::lock_guard<std::mutex> lock(m_clustersMutex);
+    const auto found = m_clusters.find(_cluster);
+    return found != m_clusters.end() && found->second.usesPool ? MCustomEvaluatorClusterNode::kSerial : MCustomEvaluatorClusterNode::kParallel;
+  }
+
+  bool clusterInitialize(const MCustomEvaluatorClusterNode* _cluster) override
+  {
+    std::vector<MEvaluationNode> nodes;
+    std::vector<MPxNode*> userNodes;
+    for (auto it = _cluster->iterator(); !it.isDone(); it.next())
+    {
+      nodes.push_back(it.currentEvaluationNode());
+      userNodes.push_back(MFnDependencyNode(nodes.back().dependencyNode()).userNode());
+    }
+
+    Cluster cluster;
+    const auto levels = dependencyLevels(nodes, userNodes);
+    for (std::size_t i = 0u; i < nodes.size(); ++i)
+    {
+      if (cluster.levels.size() <= levels[i]) cluster.levels.resize(levels[i] + 1u);
+      auto& level = cluster.levels[levels[i]];
+      if (auto* ik = dynamic_cast<twoBoneIK*>(userNodes[i])) level.twoBoneIKNodes.push_back({nodes[i], ik});
+      else if (auto* incline = dynamic_cast<inclineAngle*>(userNodes[i])) level.inclineAngleNodes.push_back({nodes[i], incline});
+    }
+    // Sized for the largest level once, so evaluating never allocates
+    std::size_t twoBoneIKCount = 0u, inclineAngleCount = 0u;
+    for (const auto& level : cluster.levels)
+    {
+      twoBoneIKCount = std::max(twoBoneIKCount, level.twoBoneIKNodes.size());
+      inclineAngleCount = std::max(inclineAngleCount, level.inclineAngleNodes.size());
+    }
+    cluster.twoBoneIKBatch.resize(twoBoneIKCount);
+    cluster.inclineAngleBatch.resize(inclineAngleCount);
+    cluster.twoBoneIKBatched.reserve(twoBoneIKCount);
+    cluster.inclineAngleBatched.reserve(inclineAngleCount);
+    // Levels of up to one chunk are solved on the calling thread, see ThreadPool::parallelFor
+    cluster.usesPool = std::max(twoBoneIKCount, inclineAngleCount) > batchChunkSize(kBatchChunkSize, BatchDispatch::kernels().width);
+
+    std::lock_guard<std::mutex> lock(m_clustersMutex);
+    m_clusters[_cluster] = std::move(cluster);
+    return true;
+  }
+
+  void clusterTerminate(const MCustomEvaluatorClusterNode* _cluster) override
+  {
+    std::lock_guard<std::mutex> lock(m_clustersMutex);
+    m_clusters.erase(_cluster);
+  }
+
+  void preEvaluate(const MEvaluationGraph*) override
+  {
+    auto& counters = globalCounters();
+    counters.frameClusters.store(0u, std::memory_order_relaxed);
+    counters.frameBatchedNodes.store(0u, std::memory_order_relaxed);
+    counters.frameFallbackNodes.store(0u, std::memory_order_relaxed);
+  }
+
+  void postEvaluate(const MEvaluationGraph*) override
+  {
+    auto& counters = globalCounters();
+    const auto batched = counters.frameBatchedNodes.load(std::memory_order_relaxed);
+    const auto fallback = counters.frameFallbackNodes.load(std::memory_order_relaxed);
+    counters.frames.fetch_add(1u, std::memory_order_relaxed);
+    counters.clusters.store(counters.frameClusters.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    counters.batchedNodes.store(batched, std::memory_order_relaxed);
+    counters.fallbackNodes.store(fallback, std::memory_order_relaxed);
+    counters.totalBatchedNodes.fetch_add(batched, std::memory_order_relaxed);
+    counters.totalFallbackNodes.fetch_add(fallback, std::memory_order_relaxed);
+  }
+
+  void clusterEvaluate(const MCustomEvaluatorClusterNode* _cluster) override
+  {
+    Cluster* cluster = nullptr;
+    {
+      std::lock_guard<std::mutex> lock(m_clustersMutex);
+      const auto found = m_clusters.find(_cluster);
+      if (found == m_clusters.end())
+      {
+        _cluster->evaluate();
+        return;
+      }
+      cluster = &found->second;
+    }
+    unsigned long long batched = 0u, fallback = 0u;
+    for (auto& level : cluster->levels) evaluateLevel(_cluster, *cluster, level, batched, fallback);
+
+    auto& counters = globalCounters();
+    counters.frameClusters.fetch_add(1u, std::memory_order_relaxed);
+    counters.frameBatchedNodes.fetch_add(batched, std::memory_order_relaxed);
+    counters.frameFallbackNodes.fetch_add(fallback, std::memory_order_relaxed);
+  }
+
+private:
+  template <typename TNode>
+  struct ClusterEntry
+  {
+    MEvaluationNode node;
+    TNode* userNode;
+  };
+
+  // Nodes with no input connected to another node of the same level
+  struct Level
+  {
+    std::vector<ClusterEntry<twoBoneIK>> twoBoneIKNodes;
+    std::vector<ClusterEntry<inclineAngle>> inclineAngleNodes;
+  };
+
+  struct Cluster
+  {
+    std::vector<Level> levels;
+    // Shared by the levels, which are evaluated one after the other
+    TwoBoneIKBatchBuffers twoBoneIKBatch;
+    InclineAngleBatchBuffers inclineAngleBatch;
+    // Which twoBoneIK nodes of the level were gathered, element i of the batch belongs to node twoBoneIKBatched[i]
+    std::vector<std::size_t> twoBoneIKBatched;
+    std::vector<std::size_t> inclineAngleBatched;
+    // Whether a level is solved on the plugin pool rather than on the calling thread
+    bool usesPool = false;
+  };
+
+  struct Counters
+  {
+    std::atomic<unsigned long long> frames{0u};
+    std::atomic<unsigned long long> clusters{0u};
+    std::atomic<unsigned long long> batchedNodes{0u};
+    std::atomic<unsigned long long> fallbackNodes{0u};
+    std::atomic<unsigned long long> totalBatchedNodes{0u};
+    std::atomic<unsigned long long> totalFallbackNodes{0u};
+    // The frame being evaluated, clusters may add to these concurrently
+    std::atomic<unsigned long long> frameClusters{0u};
+    std::atomic<unsigned long long> frameBatchedNodes{0u};
+    std::atomic<unsigned long long> frameFallbackNodes{0u};
+  };
+
+  // The level of each node, one past the highest level of the cluster nodes connected to its inputs.
+  // Connections are only read here, when the graph is partitioned, never while it is evaluated
+  static std::vector<std::size_t> dependencyLevels(const std::vector<MEvaluationNode>& _nodes, const std::vector<MPxNode*>& _userNodes)
+  {
+    // Indices of the cluster nodes upstream of each node
+    std::vector<std::vector<std::size_t>> upstream(_nodes.size());
+    for (std::size_t i = 0u; i < _nodes.size(); ++i)
+    {
+      MPlugArray inputs;
+      MFnDependencyNode(_nodes[i].dependencyNode()).getConnections(inputs);
+      for (unsigned p = 0u; p < inputs.length(); ++p)
+      {
+        MPlugArray sources;
+        if (!inputs[p].connectedTo(sources, true, false)) continue;
+        for (unsigned s = 0u; s < sources.length(); ++s)
+        {
+          const auto source = std::find(_userNodes.begin(), _userNodes.end(), MFnDependencyNode(sources[s].node()).userNode());
+          if (source != _userNodes.end() && source != _userNodes.begin() + i) upstream[i].push_back(std::size_t(source - _userNodes.begin()));
+        }
+      }
+    }
+    // The evaluation graph has no cycles, so each pass settles at least one more node
+    std::vector<std::size_t> levels(_nodes.size(), 0u);
+    for (std::size_t pass = 0u; pass < _nodes.size(); ++pass)
+    {
+      bool changed = false;
+      for (std::size_t i = 0u; i < _nodes.size(); ++i)
+      {
+        for (auto source : upstream[i])
+        {
+          if (levels[i] > levels[source]) continue;
+          levels[i] = levels[source] + 1u;
+          changed = true;
+        }
+      }
+      if (!changed) break;
+    }
+    return levels;
+  }
+
+  // Gathers, solves and scatters one level, nodes that cannot be batched are computed in the gather.
+  // Batched nodes never run their compute, so each is counted in sik_computeStats here, as one compute taking its
+  // share of the gather, solve and scatter time of its type, the fallback computes counting themselves
+  static void evaluateLevel(
+      const MCustomEvaluatorClusterNode* _cluster, Cluster& io_cluster, Level& io_level, unsigned long long& io_batched,
+      unsigned long long& io_fallback)
+  {
+    typedef std::chrono::steady_clock Clock;
+    const bool counting = ComputeStats::enabled();
+    const auto now = [counting]() { return counting ? Clock::now() : Clock::time_point(); };
+    Clock::duration fallbackTime[2] = {};
+
+    // Gather
+    const auto gatherStart = now();
+    io_cluster.twoBoneIKBatched.clear();
+    for (std::size_t i = 0u; i < io_level.twoBoneIKNodes.size(); ++i)
+    {
+      auto& entry = io_level.twoBoneIKNodes[i];
+      MDataBlock dataBlock = entry.node.datablock();
+      if (entry.userNode->gatherBatchInputs(dataBlock, io_cluster.twoBoneIKBatch, io_cluster.twoBoneIKBatched.size()))
+      {
+        io_cluster.twoBoneIKBatched.push_back(i);
+      }
+      else
+      {
+        const auto fallbackStart = now();
+        _cluster->evaluateNode(entry.node);
+        fallbackTime[0] += now() - fallbackStart;
+        ++io_fallback;
+      }
+    }
+    const auto gatherSplit = now();
+    io_cluster.inclineAngleBatched.clear();
+    for (std::size_t i = 0u; i < io_level.inclineAngleNodes.size(); ++i)
+    {
+      auto& entry = io_level.inclineAngleNodes[i];
+      MDataBlock dataBlock = entry.node.datablock();
+      if (entry.userNode->gatherBatchInputs(dataBlock, io_cluster.inclineAngleBatch, io_cluster.inclineAngleBatched.size()))
+      {
+        io_cluster.inclineAngleBatched.push_back(i);
+      }
+      else
+      {
+        const auto fallbackStart = now();
+        _cluster->evaluateNode(entry.node);
+        fallbackTime[1] += now() - fallbackStart;
+        ++io_fallback;
+      }
+    }
+
+    // Solve
+    const auto solveStart = now();
+    const auto twoBoneIKCount = io_cluster.twoBoneIKBatched.size();
+    solveTwoBoneIKBatchParallel(io_cluster.twoBoneIKBatch.view(), twoBoneIKCount, pluginThreadPool(MThreadUtils::getNumThreads()));
+    const auto solveSplit = now();
+    const auto inclineAngleCount = io_cluster.inclineAngleBatched.size();
+    solveInclineAngleBatchParallel(io_cluster.inclineAngleBatch.view(), inclineAngleCount, pluginThreadPool(MThreadUtils::getNumThreads()));
+
+    // Scatter
+    const auto scatterStart = now();
+    for (std::size_t i = 0u; i < twoBoneIKCount; ++i)
+    {
+      auto& entry = io_level.twoBoneIKNodes[io_cluster.twoBoneIKBatched[i]];
+      MDataBlock dataBlock = entry.node.datablock();
+      entry.userNode->scatterBatchOutputs(dataBlock, io_cluster.twoBoneIKBatch, i);
+    }
+    const auto scatterSplit = now();
+    for (std::size_t i = 0u; i < inclineAngleCount; ++i)
+    {
+      auto& entry = io_level.inclineAngleNodes[io_cluster.inclineAngleBatched[i]];
+      MDataBlock dataBlock = entry.node.datablock();
+      entry.userNode->scatterBatchOutputs(dataBlock, io_cluster.inclineAngleBatch, i);
+    }
+    const auto scatterEnd = now();
+    io_batched += twoBoneIKCount + inclineAngleCount;
+
+    if (!counting) return;
+    const auto twoBoneIKTime = (gatherSplit - gatherStart - fallbackTime[0]) + (solveSplit - solveStart) + (scatterSplit - scatterStart);
+    const auto inclineAngleTime = (solveStart - gatherSplit - fallbackTime[1]) + (scatterStart - solveSplit) + (scatterEnd - scatterSplit);
+    for (std::size_t i = 0u; i < twoBoneIKCount; ++i)
+    {
+      io_level.twoBoneIKNodes[io_cluster.twoBoneIKBatched[i]].userNode->countBatchedCompute(nodeShare(twoBoneIKTime, twoBoneIKCount));
+    }
+    for (std::size_t i = 0u; i < inclineAngleCount; ++i)
+    {
+      io_level.inclineAngleNodes[io_cluster.inclineAngleBatched[i]].userNode->countBatchedCompute(nodeShare(inclineAngleTime, inclineAngleCount));
+    }
+  }
+
+  // One node's share of a batch of _count nodes taking _time, in nanoseconds
+  static std::uint64_t nodeShare(std::chrono::steady_clock::duration _time, std::size_t _count)
+  {
+    return std::uint64_t(std::max<long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(_time).count(), 0)) / _count;
+  }
+
+  // Shared by every instance, so the stats command can read them without the evaluator
+  static Counters& globalCounters()
+  {
+    static Counters counters;
+    return counters;
+  }
+
+  std::mutex m_clustersMutex;
+  std::map<const MCustomEvaluatorClusterNode*, Cluster> m_clusters;
+};
+
+// Reports the evaluator stats as an int array of
+// frames, clusters, batched nodes and fallback nodes of the last frame, then the batched and fallback totals.
+// Values past the int range are clamped, -reset zeroes every counter
+class SimpleIKEvaluatorStatsCommand : public MPxCommand
+{
+public:
+  static const char* name() { return NODE_NAME_PREFIX "evaluatorStats"; }
+
+  static void* creator() { return new SimpleIKEvaluatorStatsCommand(); }
+
+  static MStatus registerCommand(MFnPlugin& pluginFn)
+  {
+    return pluginFn.registerCommand(name(), creator);
+  }
+
+  static MStatus deregisterCommand(MFnPlugin& pluginFn)
+  {
+    return pluginFn.deregisterCommand(name());
+  }
+
+  MStatus doIt(const MArgList& _args) override
+  {
+    for (unsigned i = 0u; i < _args.length(); ++i)
+    {
+      if (std::string(_args.asString(i).asChar()) != "-reset") return MS::kInvalidParameter;
+      SimpleIKEvaluator::resetStats();
+    }
+    const auto stats = SimpleIKEvaluator::stats();
+    MIntArray result;
+    for (auto value : {
+        stats.frames, stats.clusters, stats.batchedNodes, stats.fallbackNodes, stats.totalBatchedNodes, stats.totalFallbackNodes})
+    {
+      result.append(int(std::min<unsigned long long>(value, INT_MAX)));
+    }
+    setResult(result);
+    return MS::kSuccess;
+  }
+};
+
+#endif //SIMPLEIKEVALUATOR_INCLUDE_H
@@ -0,0 +1,99 @@
+#ifndef SOLVERMATH_INCLUDE_H
+#define SOLVERMATH_INCLUDE_H
+
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include "SolverTypes.h"
+#include "ApproxMath.h"
+
+// Scalar helpers shared by the solvers, these work with any vector type exposing x, y, z and length()
+// The helpers using transcendentals take a math policy from ApproxMath.h, defaulting to the std functions
+
+template <typename T>
+inline static T sqr(T x) {return x*x;}
+
+template <typename T>
+inline static T clamp(const T& n, const T& lower, const T& upper)
+{
+  return std::max(lower, std::min(n, upper));
+}
+
+template <typename T, typename TMath = ExactMath>
+inline static T getAngle(T a, T b, T c)
+{
+  static constexpr T two = 2.0;
+  return TMath::acos(clamp((sqr(a) + sqr(b) - sqr(c)) / (two * a * b), T(-1.0), T(1.0)));
+}
+
+template <typename T>
+inline static int psign(T val)
+{
+    return (0.0 <= val) - (val < 0.0);
+}
+
+template <typename T, typename TVector = Vector3<T>>
+inline static T distPointToOLine(TVector P, TVector A)
+{
+    const auto diff = A.y * P.x - A.x * P.y;
+    const auto d = std::abs(diff) / A.length() * -psign(diff);
+    return d;
+}
+
+template<typename T>
+inline static T fitInBoundsSigned(T val, T lower, T upper)
+{
+  return std::max(clamp(val, lower, upper), clamp(val, -upper, -lower)) * psign(val);
+}
+
+template <typename T, typename TVector>
+inline static typename std::enable_if<std::is_class<TVector>::value, TVector>::type makeNonZero(const TVector& val)
+{
+  static constexpr auto smallest = std::numeric_limits<T>::min();
+  return TVector(
+      std::max(std::abs(val.x), smallest) * psign(val.x),
+      std::max(std::abs(val.y), smallest) * psign(val.y),
+      std::max(std::abs(val.z), smallest) * psign(val.z)
+      );
+}
+
+template <typename T>
+inline static T makeNonZero(T&& val)
+{
+  static constexpr auto smallest = std::numeric_limits<T>::min();
+  return std::max(std::abs(val), smallest) * psign(val);
+}
+
+template<typename T, typename TMath = ExactMath>
+inline static T softenEdge(T hardEdge, T chainLength, T dsoft)
+{
+  static constexpr T one  = 1.0;
+  static constexpr T zero = 0.0;
+  const auto da = chainLength - dsoft;
+  const auto softEdge = da + dsoft * (one - TMath::exp((da-hardEdge)/dsoft));
+  return (hardEdge > da && da > zero) ? softEdge : hardEdge;
+}
+
+template <typename T>
+inline static T dlerp(T a, T b, T t)
+{
+  static constexpr T one  = 1.0;
+  return (one - t) * a + t * b;
+}
+
+template<typename T>
+inline static T stretchEdge(T hardEdge, T baseEdge, T chainLength, T strength)
+{
+  static constexpr T one = 1.0;
+  return dlerp(one, std::max(one, baseEdge / chainLength), strength) * hardEdge;
+}
+
+// The counterpart of stretchEdge, shortens the edge when the base is shorter than the chain
+template<typename T>
+inline static T squashEdge(T hardEdge, T baseEdge, T chainLength, T strength)
+{
+  static constexpr T one = 1.0;
+  return dlerp(one, std::min(one, baseEdge / chainLength), strength) * hardEdge;
+}
+
+#endif //SOLVERMATH_INCLUDE_H
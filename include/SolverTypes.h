@@ -0,0 +1,231 @@
+#ifndef SOLVERTYPES_INCLUDE_H
+#define SOLVERTYPES_INCLUDE_H
+
+#include <algorithm>
+#include <cmath>
+
+// Small vector and rotation types for the headless solver core.
+// They follow the maya conventions (row vectors, euler rotation orders) so results match the plugin.
+
+template <typename T>
+struct Vector3
+{
+  enum Axis { kXaxis, kYaxis, kZaxis };
+
+  T x = T(0);
+  T y = T(0);
+  T z = T(0);
+
+  Vector3() = default;
+  Vector3(T _x, T _y, T _z = T(0)) : x(_x), y(_y), z(_z) {}
+
+  Vector3 operator+(const Vector3& _r) const { return Vector3(x + _r.x, y + _r.y, z + _r.z); }
+  Vector3 operator-(const Vector3& _r) const { return Vector3(x - _r.x, y - _r.y, z - _r.z); }
+  Vector3 operator-() const { return Vector3(-x, -y, -z); }
+  Vector3 operator*(T _s) const { return Vector3(x * _s, y * _s, z * _s); }
+  Vector3 operator/(T _s) const { return Vector3(x / _s, y / _s, z / _s); }
+  // Dot product
+  T operator*(const Vector3& _r) const { return x * _r.x + y * _r.y + z * _r.z; }
+  // Cross product
+  Vector3 operator^(const Vector3& _r) const
+  {
+    return Vector3(y * _r.z - z * _r.y, z * _r.x - x * _r.z, x * _r.y - y * _r.x);
+  }
+  bool operator==(const Vector3& _r) const { return x == _r.x && y == _r.y && z == _r.z; }
+
+  T length() const { return std::sqrt(x * x + y * y + z * z); }
+
+  Vector3 normal() const
+  {
+    const T l = length();
+    return l > T(0) ? *this / l : *this;
+  }
+
+  // Right handed rotation about one of the world axes
+  Vector3 rotateBy(Axis _axis, T _angle) const
+  {
+    const T c = std::cos(_angle);
+    const T s = std::sin(_angle);
+    switch (_axis)
+    {
+      case kXaxis: return Vector3(x, y * c - z * s, y * s + z * c);
+      case kYaxis: return Vector3(x * c + z * s, y, -x * s + z * c);
+      default: return Vector3(x * c - y * s, x * s + y * c, z);
+    }
+  }
+};
+
+// Rotation matrix, rows are the rotated basis vectors
+template <typename T>
+struct Matrix3
+{
+  T m[3][3] = {{T(1), T(0), T(0)}, {T(0), T(1), T(0)}, {T(0), T(0), T(1)}};
+
+  const T* operator[](unsigned _row) const { return m[_row]; }
+  T* operator[](unsigned _row) { return m[_row]; }
+
+  Matrix3 operator*(const Matrix3& _rhs) const
+  {
+    Matrix3 out;
+    for (int i = 0; i < 3; ++i)
+      for (int j = 0; j < 3; ++j)
+        out.m[i][j] = m[i][0] * _rhs.m[0][j] + m[i][1] * _rhs.m[1][j] + m[i][2] * _rhs.m[2][j];
+    return out;
+  }
+};
+
+template <typename T>
+struct EulerRotation
+{
+  // Same values as MEulerRotation::RotationOrder
+  enum RotationOrder { kXYZ, kYZX, kZXY, kXZY, kYXZ, kZYX };
+
+  T x = T(0);
+  T y = T(0);
+  T z = T(0);
+  RotationOrder order = kXYZ;
+
+  EulerRotation() = default;
+  EulerRotation(T _x, T _y, T _z, RotationOrder _order = kXYZ) : x(_x), y(_y), z(_z), order(_order) {}
+
+  // The first axis in the order is applied first
+  Matrix3<T> asMatrix() const
+  {
+    const T angles[3] = {x, y, z};
+    const auto axes = orderAxes(order);
+    Matrix3<T> out;
+    for (int i = 0; i < 3; ++i) out = out * axisMatrix(axes[i], angles[axes[i]]);
+    return out;
+  }
+
+  static EulerRotation decompose(const Matrix3<T>& _m, RotationOrder _order)
+  {
+    const auto axes = orderAxes(_order);
+    const int i = axes[0];
+    const int j = axes[1];
+    const int k = axes[2];
+    // Cyclic orders (xyz, yzx, zxy) have positive parity
+    const T s = ((j - i + 3) % 3 == 1) ? T(1) : T(-1);
+    // Read the matrix as column vectors to use the usual decomposition
+    auto c = [&_m](int _r, int _c) { return _m.m[_c][_r]; };
+    T angles[3];
+    angles[j] = std::asin(std::max(T(-1), std::min(-s * c(k, i), T(1))));
+    angles[i] = std::atan2(s * c(k, j), c(k, k));
+    angles[k] = std::atan2(s * c(j, i), c(i, i));
+    return EulerRotation(angles[0], angles[1], angles[2], _order);
+  }
+
+  // The result applies this rotation followed by the other, and keeps this order
+  EulerRotation operator*(const EulerRotation& _other) const
+  {
+    return decompose(asMatrix() * _other.asMatrix(), order);
+  }
+
+  EulerRotation& operator*=(const EulerRotation& _other)
+  {
+    return *this = *this * _other;
+  }
+
+  EulerRotation& reorderIt(RotationOrder _order)
+  {
+    return *this = decompose(asMatrix(), _order);
+  }
+
+private:
+  struct Axes
+  {
+    int a[3];
+    int operator[](int _i) const { return a[_i]; }
+  };
+
+  static Axes orderAxes(RotationOrder _order)
+  {
+    static const Axes table[6] = {{{0, 1, 2}}, {{1, 2, 0}}, {{2, 0, 1}}, {{0, 2, 1}}, {{1, 0, 2}}, {{2, 1, 0}}};
+    return table[_order];
+  }
+
+  static Matrix3<T> axisMatrix(int _axis, T _angle)
+  {
+    const T c = std::cos(_angle);
+    const T s = std::sin(_angle);
+    const int a = (_axis + 1) % 3;
+    const int b = (_axis + 2) % 3;
+    Matrix3<T> out;
+    out.m[a][a] = c;
+    out.m[a][b] = s;
+    out.m[b][a] = -s;
+    out.m[b][b] = c;
+    return out;
+  }
+};
+
+// Unit quaternion, with the same conventions as MQuaternion
+template <typename T>
+struct Quaternion
+{
+  T x = T(0);
+  T y = T(0);
+  T z = T(0);
+  T w = T(1);
+
+  Quaternion() = default;
+  Quaternion(T _x, T _y, T _z, T _w) : x(_x), y(_y), z(_z), w(_w) {}
+
+  // Converts a rotation matrix, picking the largest component to divide by so the result stays accurate
+  static Quaternion fromMatrix(const Matrix3<T>& _m)
+  {
+    const auto& m = _m.m;
+    const T trace = m[0][0] + m[1][1] + m[2][2];
+    Quaternion q;
+    if (trace > T(0))
+    {
+      const T s = std::sqrt(trace + T(1)) * T(2);
+      q.w = T(0.25) * s;
+      q.x = (m[1][2] - m[2][1]) / s;
+      q.y = (m[2][0] - m[0][2]) / s;
+      q.z = (m[0][1] - m[1][0]) / s;
+    }
+    else if (m[0][0] > m[1][1] && m[0][0] > m[2][2])
+    {
+      const T s = std::sqrt(T(1) + m[0][0] - m[1][1] - m[2][2]) * T(2);
+      q.w = (m[1][2] - m[2][1]) / s;
+      q.x = T(0.25) * s;
+      q.y = (m[1][0] + m[0][1]) / s;
+      q.z = (m[2][0] + m[0][2]) / s;
+    }
+    else if (m[1][1] > m[2][2])
+    {
+      const T s = std::sqrt(T(1) + m[1][1] - m[0][0] - m[2][2]) * T(2);
+      q.w = (m[2][0] - m[0][2]) / s;
+      q.x = (m[1][0] + m[0][1]) / s;
+      q.y = T(0.25) * s;
+      q.z = (m[2][1] + m[1][2]) / s;
+    }
+    else
+    {
+      const T s = std::sqrt(T(1) + m[2][2] - m[0][0] - m[1][1]) * T(2);
+      q.w = (m[0][1] - m[1][0]) / s;
+      q.x = (m[2][0] + m[0][2]) / s;
+      q.y = (m[2][1] + m[1][2]) / s;
+      q.z = T(0.25) * s;
+    }
+    return q;
+  }
+
+  Matrix3<T> asMatrix() const
+  {
+    Matrix3<T> out;
+    out.m[0][0] = T(1) - T(2) * (y * y + z * z);
+    out.m[0][1] = T(2) * (x * y + z * w);
+    out.m[0][2] = T(2) * (x * z - y * w);
+    out.m[1][0] = T(2) * (x * y - z * w);
+    out.m[1][1] = T(1) - T(2) * (x * x + z * z);
+    out.m[1][2] = T(2) * (y * z + x * w);
+    out.m[2][0] = T(2) * (x * z + y * w);
+    out.m[2][1] = T(2) * (y * z - x * w);
+    out.m[2][2] = T(1) - T(2) * (x * x + y * y);
+    return out;
+  }
+};
+
+#endif //SOLVERTYPES_INCLUDE_H
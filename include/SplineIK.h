@@ -0,0 +1,168 @@
+#ifndef SPLINEIK_INCLUDE_H
+#define SPLINEIK_INCLUDE_H
+
+#include "Utils.h"
+#include "SplineIKSolver.h"
+#include <atomic>
+#include <mutex>
+
+template<typename TClass, const char* TTypeName>
+class SplineIKNode : public BaseNode<TClass, TTypeName>
+{
+public:
+
+  static MStatus initialize()
+  {
+    // Create all of our inputs
+    // The curve passes through every control point, in order from the root
+    createAttribute(m_inputControlPoints, "controlPoints", DefaultValue<MVector>(), true, true);
+    // One element per bone, from the root out, this decides how many bones are laid along the curve
+    createAttribute(m_inputJointLengths, "jointLengths", 0.0, true, true);
+    createAttribute(m_inputUpVector, "upVector", MVector(0.0, 1.0, 0.0));
+    createAttribute(m_inputStartTwist, "startTwist", DefaultValue<MAngle>());
+    createAttribute(m_inputEndTwist, "endTwist", DefaultValue<MAngle>());
+    createAttribute(m_inputStretchStrength, "stretchStrength", 1.0);
+    createAttribute(m_inputSquashStrength, "squashStrength", 0.0);
+
+    // One element per bone, positions of the bone roots and rotations relative to the parent bone
+    createAttribute(m_outputPositions, "positions", DefaultValue<MVector>(), false, true);
+    createAttribute(m_outputRotations, "rotations", DefaultValue<MEulerRotation>(), false, true);
+    createAttribute(m_outputStretchedLengths, "stretchedLengths", 0.0, false, true);
+
+    // Tell maya about our arributes
+    addAttributes(
+        m_inputControlPoints, m_inputJointLengths, m_inputUpVector, m_inputStartTwist, m_inputEndTwist, m_inputStretchStrength, m_inputSquashStrength,
+        m_outputPositions, m_outputRotations, m_outputStretchedLengths
+        );
+    // Tell maya what inputs will affect our outputs
+    setAffects(
+        {m_inputControlPoints, m_inputJointLengths, m_inputStretchStrength, m_inputSquashStrength},
+        m_outputPositions, m_outputRotations, m_outputStretchedLengths
+        );
+    setAffects({m_inputUpVector, m_inputStartTwist, m_inputEndTwist}, m_outputRotations);
+
+    return MS::kSuccess;
+  }
+
+  virtual MStatus compute(const MPlug& _plug, MDataBlock& io_dataBlock)
+  {
+    if (shouldCompute(_plug, m_outputPositions, m_outputRotations, m_outputStretchedLengths))
+    {
+      AttributeData ad(io_dataBlock);
+      std::lock_guard<std::mutex> lock(m_solveMutex);
+      const auto& controlPoints = m_controlPoints;
+      const auto& lengths = m_lengths;
+      ad.get(m_inputControlPoints, m_controlPoints);
+      ad.get(m_inputJointLengths, m_lengths);
+      const auto numBones = lengths.size();
+
+      // Only a change of control points needs a new arc length table
+      m_points.resize(controlPoints.size());
+      bool pointsChanged = m_points.size() != m_tablePoints.size() || !m_tableValid;
+      for (std::size_t i = 0u; i < controlPoints.size(); ++i)
+      {
+        m_points[i] = toVector3(controlPoints[i]);
+        pointsChanged = pointsChanged || !(m_points[i] == m_tablePoints[i]);
+      }
+      if (pointsChanged)
+      {
+        m_table.build(m_points.data(), m_points.size());
+        m_tablePoints = m_points;
+        m_tableValid = true;
+        m_tableBuilds.fetch_add(1u, std::memory_order_relaxed);
+      }
+
+      m_stretchedLengths.resize(numBones);
+      m_rotations.resize(numBones);
+      solveSplineIK(
+          m_points.data(),
+          m_points.size(),
+          m_table,
+          lengths.data(),
+          numBones,
+          toVector3(ad.get<MVector>(m_inputUpVector)),
+          ad.get<MAngle>(m_inputStartTwist).asRadians(),
+          ad.get<MAngle>(m_inputEndTwist).asRadians(),
+          ad.get<double>(m_inputStretchStrength),
+          ad.get<double>(m_inputSquashStrength),
+          m_pose,
+          m_stretchedLengths.data(),
+          m_rotations.data());
+
+      // Output the values
+      auto& positions = m_positions;
+      auto& rotations = m_eulerRotations;
+      positions.resize(numBones);
+      rotations.resize(numBones);
+      for (std::size_t i = 0u; i < numBones; ++i)
+      {
+        positions[i] = MVector(m_pose.x[i], m_pose.y[i], m_pose.z[i]);
+        rotations[i] = toMEulerRotation(m_rotations[i]);
+      }
+      ad.set(m_outputPositions, positions);
+      ad.set(m_outputRotations, rotations);
+      ad.set(m_outputStretchedLengths, m_stretchedLengths);
+      return MS::kSuccess;
+    }
+    return MS::kUnknownParameter;
+  }
+
+  // Number of times the arc length table was built, once per change of the control points
+  unsigned long long arcLengthTableBuilds() const { return m_tableBuilds.load(std::memory_order_relaxed); }
+
+private:
+  // The curve and its arc length table, kept until the control points change,
+  // and the joints of the last solve, kept so repeated computes reuse the allocations
+  std::mutex m_solveMutex;
+  std::vector<Vector3<double>> m_points;
+  std::vector<Vector3<double>> m_tablePoints;
+  bool m_tableValid = false;
+  SplineIKArcLengthTable<double> m_table;
+  std::atomic<unsigned long long> m_tableBuilds{0u};
+  ChainIKPose<double> m_pose;
+  std::vector<double> m_stretchedLengths;
+  std::vector<EulerRotation<double>> m_rotations;
+  // The attribute arrays, kept for the same reason
+  std::vector<MVector> m_controlPoints;
+  std::vector<double> m_lengths;
+  std::vector<MVector> m_positions;
+  std::vector<MEulerRotation> m_eulerRotations;
+
+  static Attribute m_inputControlPoints;
+  static Attribute m_inputJointLengths;
+  static Attribute m_inputUpVector;
+  static Attribute m_inputStartTwist;
+  static Attribute m_inputEndTwist;
+  static Attribute m_inputStretchStrength;
+  static Attribute m_inputSquashStrength;
+  static Attribute m_outputPositions;
+  static Attribute m_outputRotations;
+  static Attribute m_outputStretchedLengths;
+};
+
+#define MEMDECL(NAME) \
+template<typename TClass, const char* TTypeName> \
+Attribute SplineIKNode<TClass, TTypeName>::NAME
+
+MEMDECL(m_inputControlPoints);
+MEMDECL(m_inputJointLengths);
+MEMDECL(m_inputUpVector);
+MEMDECL(m_inputStartTwist);
+MEMDECL(m_inputEndTwist);
+MEMDECL(m_inputStretchStrength);
+MEMDECL(m_inputSquashStrength);
+MEMDECL(m_outputPositions);
+MEMDECL(m_outputRotations);
+MEMDECL(m_outputStretchedLengths);
+
+#undef MEMDECL
+
+#define SPLINEIK_NODE(NodeName) \
+TEMPLATE_PARAMETER_LINKAGE char name##NodeName[] = #NodeName; \
+class NodeName : public SplineIKNode<NodeName, name##NodeName> {};
+
+SPLINEIK_NODE(splineIK);
+
+#undef SPLINEIK_NODE
+
+#endif //SPLINEIK_INCLUDE_H
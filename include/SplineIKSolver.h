@@ -0,0 +1,154 @@
+#ifndef SPLINEIKSOLVER_INCLUDE_H
+#define SPLINEIKSOLVER_INCLUDE_H
+
+#include "ChainIKSolver.h"
+
+// Spline ik, a chain laid along a curve by arc length, for spines, necks and tails.
+// The curve is a uniform Catmull-Rom spline passing through every control point, with the end segments continued
+// by mirroring the neighbouring point. Its arc length parameterization only depends on the control points, so it is
+// sampled once into a SplineIKArcLengthTable that nodes keep while only the lengths, stretch or twist change.
+// Joints lie at increasing arc lengths, so placing a whole chain is one forward walk over the table with no searching.
+
+// Samples per curve segment, the table error in arc length falls with the square of this
+static constexpr unsigned kSplineIKSamplesPerSegment = 32u;
+
+// Point at parameter _u in [0, _count - 1], control point k is at parameter k
+template <typename T>
+inline Vector3<T> splineIKPoint(const Vector3<T>* _points, std::size_t _count, T _u)
+{
+  if (_count < 2u) return _count ? _points[0] : Vector3<T>();
+  const std::size_t k = std::min(std::size_t(std::max(_u, T(0))), _count - 2u);
+  const T t = _u - T(k);
+  const auto& p1 = _points[k];
+  const auto& p2 = _points[k + 1u];
+  const auto p0 = k > 0u ? _points[k - 1u] : p1 * T(2) - p2;
+  const auto p3 = k + 2u < _count ? _points[k + 2u] : p2 * T(2) - p1;
+  const T t2 = t * t;
+  const T t3 = t2 * t;
+  return (p1 * T(2) + (p2 - p0) * t + (p0 * T(2) - p1 * T(5) + p2 * T(4) - p3) * t2 + (p1 * T(3) - p0 - p2 * T(3) + p3) * t3) * T(0.5);
+}
+
+template <typename T>
+struct SplineIKArcLengthTable
+{
+  // Curve parameter and arc length from the start at every sample, both increasing
+  std::vector<T> param;
+  std::vector<T> length;
+  // Unit direction the curve leaves its last point in, which the chain follows past the end of the curve
+  Vector3<T> endTangent = Vector3<T>(1, 0, 0);
+
+  T totalLength() const { return length.empty() ? T(0) : length.back(); }
+
+  void build(const Vector3<T>* _points, std::size_t _count, unsigned _samplesPerSegment = kSplineIKSamplesPerSegment)
+  {
+    const std::size_t segments = _count > 1u ? _count - 1u : 0u;
+    const std::size_t samples = segments * std::max(_samplesPerSegment, 1u) + 1u;
+    param.resize(samples);
+    length.resize(samples);
+    param[0] = T(0);
+    length[0] = T(0);
+    auto previous = splineIKPoint(_points, _count, T(0));
+    for (std::size_t i = 1u; i < samples; ++i)
+    {
+      param[i] = T(segments) * T(i) / T(samples - 1u);
+      const auto point = splineIKPoint(_points, _count, param[i]);
+      length[i] = length[i - 1u] + (point - previous).length();
+      previous = point;
+    }
+
+    // The last chord of the samples, or of the control points when that is degenerate
+    endTangent = Vector3<T>(1, 0, 0);
+    if (segments)
+    {
+      for (const auto& tangent : {previous - splineIKPoint(_points, _count, param[samples - 2u]), _points[_count - 1u] - _points[_count - 2u]})
+      {
+        const T tangentLength = tangent.length();
+        if (tangentLength > T(0))
+        {
+          endTangent = tangent / tangentLength;
+          break;
+        }
+      }
+    }
+  }
+};
+
+// Places a joint at each arc length of _lengths laid end to end from the curve start, with the lengths already stretched.
+// Past the end of the curve the joints continue straight along its end tangent
+template <typename T>
+inline void splineIKJoints(
+    const Vector3<T>* _points, std::size_t _count, const SplineIKArcLengthTable<T>& _table, const T* _lengths, std::size_t _bones,
+    ChainIKPose<T>& o_pose)
+{
+  o_pose.resize(_bones + 1u);
+  const T total = _table.totalLength();
+  const auto end = splineIKPoint(_points, _count, _table.param.empty() ? T(0) : _table.param.back());
+  std::size_t sample = 0u;
+  T arcLength = T(0);
+  for (std::size_t j = 0u; j <= _bones; ++j)
+  {
+    if (j) arcLength += _lengths[j - 1u];
+    if (!(arcLength < total))
+    {
+      o_pose.setJoint(j, end + _table.endTangent * (arcLength - total));
+      continue;
+    }
+    // The arc lengths only increase, so the walk carries on from the previous joint's sample
+    while (_table.length[sample + 1u] < arcLength) ++sample;
+    const T span = _table.length[sample + 1u] - _table.length[sample];
+    const T f = span > T(0) ? (arcLength - _table.length[sample]) / span : T(0);
+    o_pose.setJoint(j, splineIKPoint(_points, _count, _table.param[sample] + f * (_table.param[sample + 1u] - _table.param[sample])));
+  }
+}
+
+// Lays a chain of _bones bones along the curve and writes the stretched bone lengths and the rotation of each bone
+// relative to its parent, the root rotation is relative to the world.
+// As in solveChainIK bones point down their local X axis, here with local Y towards _upVector, turned about the bone
+// by a twist blended from startTwist on the first bone to endTwist on the last.
+// The bones stretch as stretchEdge does when the curve is longer than the chain, and squash as squashEdge does when it
+// is shorter, a chain that does not squash runs on past the end of the curve
+template <typename T>
+inline void solveSplineIK(
+    const Vector3<T>* _points,
+    std::size_t _count,
+    const SplineIKArcLengthTable<T>& _table,
+    const T* _lengths,
+    std::size_t _bones,
+    const Vector3<T>& _upVector,
+    T startTwist,
+    T endTwist,
+    T stretchStrength,
+    T squashStrength,
+    ChainIKPose<T>& io_pose,
+    T* o_stretchedLengths,
+    EulerRotation<T>* o_rotations)
+{
+  if (!_bones) return;
+  T chainLength = T(0);
+  for (std::size_t i = 0u; i < _bones; ++i) chainLength += _lengths[i];
+  const T curveLength = _table.totalLength();
+  for (std::size_t i = 0u; i < _bones; ++i)
+  {
+    o_stretchedLengths[i] = chainLength > T(0) ?
+      squashEdge(stretchEdge(_lengths[i], curveLength, chainLength, stretchStrength), curveLength, chainLength, squashStrength) :
+      _lengths[i];
+  }
+  splineIKJoints(_points, _count, _table, o_stretchedLengths, _bones, io_pose);
+
+  // The same frame as the two bone root with no interior angle, the bone as the aim and the up vector as the pole,
+  // with the twist blended by the arc length of each bone's root joint, so the last bone has all of endTwist
+  const T lastRoot = chainLength - _lengths[_bones - 1u];
+  Matrix3<T> parent;
+  T arcLength = T(0);
+  for (std::size_t i = 0u; i < _bones; ++i)
+  {
+    const T blend = lastRoot > T(0) ? arcLength / lastRoot : T(0);
+    arcLength += _lengths[i];
+    const auto world = solveRootFrame<T>(
+        io_pose.joint(i + 1u) - io_pose.joint(i), _upVector, T(1), T(0), T(1), dlerp(startTwist, endTwist, blend));
+    o_rotations[i] = chainIKLocalRotation(world, parent);
+    parent = world;
+  }
+}
+
+#endif //SPLINEIKSOLVER_INCLUDE_H
@@ -0,0 +1,103 @@
+#ifndef SPSCQUEUE_INCLUDE_H
+#define SPSCQUEUE_INCLUDE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <thread>
+
+// Bounded lock free queue between one producer thread and one consumer thread.
+// The ring holds a power of two slots and the head and tail only ever increase, each written by one side only,
+// so a push or pop is one acquire load of the other side's index and one release store of its own.
+// The indices sit on their own cache lines so the two sides do not invalidate each other's line on every call.
+template <typename T>
+class SpscQueue
+{
+public:
+  // Holds at least _capacity values
+  explicit SpscQueue(std::size_t _capacity)
+    : m_mask(roundUpPowerOfTwo(_capacity) - 1u), m_slots(new T[m_mask + 1u])
+  {
+  }
+
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue& operator=(const SpscQueue&) = delete;
+
+  std::size_t capacity() const { return m_mask + 1u; }
+
+  // Values queued, from either thread, the other side may have moved on by the time it returns
+  std::size_t size() const { return m_tail.value.load(std::memory_order_acquire) - m_head.value.load(std::memory_order_acquire); }
+
+  // Producer side, false when the queue is full
+  bool tryPush(const T& _value)
+  {
+    const std::size_t tail = m_tail.value.load(std::memory_order_relaxed);
+    if (tail - m_head.value.load(std::memory_order_acquire) > m_mask) return false;
+    m_slots[tail & m_mask] = _value;
+    m_tail.value.store(tail + 1u, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side, false when the queue is empty
+  bool tryPop(T& o_value)
+  {
+    const std::size_t head = m_head.value.load(std::memory_order_relaxed);
+    if (head == m_tail.value.load(std::memory_order_acquire)) return false;
+    o_value = m_slots[head & m_mask];
+    m_head.value.store(head + 1u, std::memory_order_release);
+    return true;
+  }
+
+  // Blocking forms, these wait until they succeed or _stop is set, returning false when stopped
+  bool push(const T& _value, const std::atomic<bool>& _stop)
+  {
+    for (unsigned spins = 0u; !tryPush(_value); ++spins)
+    {
+      if (_stop.load(std::memory_order_relaxed)) return false;
+      backOff(spins);
+    }
+    return true;
+  }
+
+  bool pop(T& o_value, const std::atomic<bool>& _stop)
+  {
+    for (unsigned spins = 0u; !tryPop(o_value); ++spins)
+    {
+      if (_stop.load(std::memory_order_relaxed)) return false;
+      backOff(spins);
+    }
+    return true;
+  }
+
+private:
+  static std::size_t roundUpPowerOfTwo(std::size_t _value)
+  {
+    std::size_t power = 1u;
+    while (power < _value) power <<= 1u;
+    return power;
+  }
+
+  // Spins briefly for a value that is nearly ready, then yields, then sleeps, so a thread waiting on a slow stage or a
+  // live feed does not hold a core
+  static void backOff(unsigned _spins)
+  {
+    if (_spins < 64u) return;
+    if (_spins < 256u) std::this_thread::yield();
+    else std::this_thread::sleep_for(std::chrono::microseconds(50));
+  }
+
+  struct alignas(64) Index
+  {
+    std::atomic<std::size_t> value{0u};
+  };
+
+  const std::size_t m_mask;
+  std::unique_ptr<T[]> m_slots;
+  // Next slot to pop, written by the consumer
+  Index m_head;
+  // Next slot to push, written by the producer
+  Index m_tail;
+};
+
+#endif //SPSCQUEUE_INCLUDE_H
@@ -0,0 +1,200 @@
+#ifndef THREADPOOL_INCLUDE_H
+#define THREADPOOL_INCLUDE_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work stealing pool for splitting a range of independent work items over threads.
+// Each parallelFor cuts the range into fixed size chunks and deals them out in contiguous runs, one run per thread.
+// Threads take chunks from the front of their own run, and once it is empty steal from the back of the others,
+// so uneven chunks balance out without a shared queue.
+// Chunk boundaries depend only on the chunk size, never on the thread count, so work that is deterministic
+// per chunk gives the same result on any number of threads.
+// The calling thread works as the first thread of the pool, and jobs from several callers run one after another.
+// A job must not start another job on the same pool.
+class ThreadPool
+{
+public:
+  // Total number of threads, including the caller, at least one
+  explicit ThreadPool(unsigned _threads = defaultThreadCount())
+    : m_threadCount(std::max(1u, _threads)), m_queues(new Queue[m_threadCount])
+  {
+    for (unsigned i = 1u; i < m_threadCount; ++i)
+    {
+      m_workers.emplace_back([this, i]() { workerLoop(i); });
+    }
+  }
+
+  ~ThreadPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_wakeMutex);
+      m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto& worker : m_workers) worker.join();
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  unsigned threadCount() const { return m_threadCount; }
+
+  static unsigned defaultThreadCount()
+  {
+    return std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  // Pool shared by headless callers, sized to the hardware, the plugin nodes use pluginThreadPool in TwoBoneIKParallel.h
+  static ThreadPool& shared()
+  {
+    static ThreadPool pool;
+    return pool;
+  }
+
+  // Calls _function(begin, end) for every chunk of [0, _count), returning once all have run
+  template <typename TFunction>
+  void parallelFor(std::size_t _count, std::size_t _chunk, const TFunction& _function)
+  {
+    if (!_count) return;
+    _chunk = std::max<std::size_t>(_chunk, 1u);
+    // A single chunk is not worth waking anyone for
+    if (_count <= _chunk || m_threadCount == 1u)
+    {
+      for (std::size_t begin = 0u; begin < _count; begin += _chunk) _function(begin, std::min(begin + _chunk, _count));
+      return;
+    }
+    run(_count, _chunk, &invoke<TFunction>, &_function);
+  }
+
+private:
+  typedef void (*InvokeFunction)(const void*, std::size_t, std::size_t);
+
+  template <typename TFunction>
+  static void invoke(const void* _function, std::size_t _begin, std::size_t _end)
+  {
+    (*static_cast<const TFunction*>(_function))(_begin, _end);
+  }
+
+  // Chunk indices still to run from one thread's share, padded so neighbouring queues do not share a cache line
+  struct Queue
+  {
+    std::mutex mutex;
+    std::size_t begin = 0u;
+    std::size_t end = 0u;
+    char padding[64];
+  };
+
+  struct Job
+  {
+    InvokeFunction invoke = nullptr;
+    const void* function = nullptr;
+    std::size_t count = 0u;
+    std::size_t chunk = 0u;
+  };
+
+  void run(std::size_t _count, std::size_t _chunk, InvokeFunction _invoke, const void* _function)
+  {
+    std::lock_guard<std::mutex> jobLock(m_jobMutex);
+    m_job.invoke = _invoke;
+    m_job.function = _function;
+    m_job.count = _count;
+    m_job.chunk = _chunk;
+    const std::size_t chunks = (_count + _chunk - 1u) / _chunk;
+    m_remaining.store(chunks, std::memory_order_relaxed);
+    for (unsigned i = 0u; i < m_threadCount; ++i)
+    {
+      std::lock_guard<std::mutex> lock(m_queues[i].mutex);
+      m_queues[i].begin = chunks * i / m_threadCount;
+      m_queues[i].end = chunks * (i + 1u) / m_threadCount;
+    }
+    {
+      std::lock_guard<std::mutex> lock(m_wakeMutex);
+      ++m_generation;
+    }
+    m_wake.notify_all();
+
+    work(0u);
+    // The last chunks may still be running on other threads
+    std::unique_lock<std::mutex> lock(m_doneMutex);
+    m_done.wait(lock, [this]() { return m_remaining.load(std::memory_order_acquire) == 0u; });
+  }
+
+  void workerLoop(unsigned _index)
+  {
+    unsigned long long seen = 0u;
+    for (;;)
+    {
+      {
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        m_wake.wait(lock, [&]() { return m_stop || m_generation != seen; });
+        if (m_stop) return;
+        seen = m_generation;
+      }
+      work(_index);
+    }
+  }
+
+  void work(unsigned _index)
+  {
+    std::size_t chunk;
+    while (pop(_index, chunk) || steal(_index, chunk))
+    {
+      // The job is read after taking the chunk, which orders it after run() filled the queues
+      const std::size_t begin = chunk * m_job.chunk;
+      m_job.invoke(m_job.function, begin, std::min(begin + m_job.chunk, m_job.count));
+      if (m_remaining.fetch_sub(1u, std::memory_order_acq_rel) == 1u)
+      {
+        std::lock_guard<std::mutex> lock(m_doneMutex);
+        m_done.notify_one();
+      }
+    }
+  }
+
+  bool pop(unsigned _index, std::size_t& o_chunk)
+  {
+    auto& queue = m_queues[_index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.begin == queue.end) return false;
+    o_chunk = queue.begin++;
+    return true;
+  }
+
+  bool steal(unsigned _index, std::size_t& o_chunk)
+  {
+    for (unsigned i = 1u; i < m_threadCount; ++i)
+    {
+      auto& queue = m_queues[(_index + i) % m_threadCount];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (queue.begin == queue.end) continue;
+      o_chunk = --queue.end;
+      return true;
+    }
+    return false;
+  }
+
+  const unsigned m_threadCount;
+  std::unique_ptr<Queue[]> m_queues;
+  std::vector<std::thread> m_workers;
+
+  // Serializes jobs from different callers
+  std::mutex m_jobMutex;
+  Job m_job;
+  std::atomic<std::size_t> m_remaining{0u};
+
+  std::mutex m_wakeMutex;
+  std::condition_variable m_wake;
+  unsigned long long m_generation = 0u;
+  bool m_stop = false;
+
+  std::mutex m_doneMutex;
+  std::condition_variable m_done;
+};
+
+#endif //THREADPOOL_INCLUDE_H
@@ -0,0 +1,150 @@
+#ifndef TRACEEVENTS_INCLUDE_H
+#define TRACEEVENTS_INCLUDE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Timed phases of a headless run, written as Chrome trace event JSON for chrome://tracing or Perfetto, so the read,
+// solve and write phases of a farm run can be inspected as the node computes are in the maya profiler.
+// Phases are recorded as complete events on the thread that ran them, timed from the construction of the writer.
+// The writer is passed by pointer and a null writer records nothing, so untraced runs only pay for the null checks.
+class TraceEventWriter
+{
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  // Times a phase on the calling thread from construction to destruction
+  class Scope
+  {
+  public:
+    Scope(TraceEventWriter* io_writer, const char* _name, std::size_t _rows = 0u)
+      : m_writer(io_writer), m_name(_name), m_rows(_rows)
+    {
+      if (m_writer) m_begin = Clock::now();
+    }
+
+    ~Scope()
+    {
+      if (m_writer) m_writer->add(m_name, m_begin, Clock::now(), m_rows);
+    }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+  private:
+    TraceEventWriter* m_writer;
+    const char* m_name;
+    std::size_t m_rows;
+    Clock::time_point m_begin;
+  };
+
+  explicit TraceEventWriter(const char* _category = "SimpleIK") : m_category(_category), m_start(Clock::now()) {}
+
+  // A phase that ran on the calling thread, _rows is shown with the event when non zero.
+  // _name must outlive the writer
+  void add(const char* _name, Clock::time_point _begin, Clock::time_point _end, std::size_t _rows = 0u)
+  {
+    const Event event = {_name, threadId(), microseconds(_begin), microseconds(_end) - microseconds(_begin), _rows};
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_events.push_back(event);
+  }
+
+  // Labels the calling thread in the viewer
+  void nameThread(const std::string& _name)
+  {
+    const unsigned id = threadId();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_threadNames.push_back(std::make_pair(id, _name));
+  }
+
+  std::size_t size() const
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_events.size();
+  }
+
+  // Rows of every event named _name
+  std::size_t rows(const std::string& _name) const
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::size_t rows = 0u;
+    for (const auto& event : m_events) rows += _name == event.name ? event.rows : 0u;
+    return rows;
+  }
+
+  std::string json() const
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    char buffer[256];
+    bool first = true;
+    for (const auto& thread : m_threadNames)
+    {
+      std::snprintf(buffer, sizeof(buffer), "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+          first ? "" : ",", thread.first, thread.second.c_str());
+      json += buffer;
+      first = false;
+    }
+    for (const auto& event : m_events)
+    {
+      std::snprintf(buffer, sizeof(buffer), "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f",
+          first ? "" : ",", event.name, m_category, event.thread, event.begin, event.duration);
+      json += buffer;
+      if (event.rows)
+      {
+        std::snprintf(buffer, sizeof(buffer), ",\"args\":{\"rows\":%zu}", event.rows);
+        json += buffer;
+      }
+      json += "}";
+      first = false;
+    }
+    return json + "]}\n";
+  }
+
+  bool write(const std::string& _path, std::string& o_error) const
+  {
+    const std::string contents = json();
+    std::FILE* file = std::fopen(_path.c_str(), "wb");
+    bool written = file && std::fwrite(contents.data(), 1u, contents.size(), file) == contents.size();
+    if (file) written = std::fclose(file) == 0 && written;
+    if (!written) o_error = "could not write " + _path;
+    return written;
+  }
+
+private:
+  struct Event
+  {
+    const char* name;
+    unsigned thread;
+    double begin;
+    double duration;
+    std::size_t rows;
+  };
+
+  // Small ids in the order threads first record, which the viewer shows as rows
+  static unsigned threadId()
+  {
+    static std::atomic<unsigned> next(1u);
+    static thread_local const unsigned id = next.fetch_add(1u);
+    return id;
+  }
+
+  double microseconds(Clock::time_point _time) const
+  {
+    return std::chrono::duration<double, std::micro>(_time - m_start).count();
+  }
+
+  const char* m_category;
+  const Clock::time_point m_start;
+  mutable std::mutex m_mutex;
+  std::vector<Event> m_events;
+  std::vector<std::pair<unsigned, std::string>> m_threadNames;
+};
+
+#endif //TRACEEVENTS_INCLUDE_H
@@ -2,6 +2,15 @@
 #define TWOBONEIK_INCLUDE_H
 
 #include "Utils.h"
+#include "TwoBoneIKSolver.h"
+#include "TwoBoneIKBatch.h"
+#include "BatchDispatch.h"
+#include "ComputeRecorder.h"
+#include "ComputeProfiling.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
 
 template<typename TClass, const char* TTypeName>
 class TwoBoneIKNode : public BaseNode<TClass, TTypeName> 
@@ -20,23 +29,62 @@ public:
     createAttribute(m_inputSoften, "soften", 0.0);
     createAttribute(m_inputDoSoften, "doSoften", true);
     createAttribute(m_inputStretchStrength, "stretchStrength", 1.0);
+    // Opt in to skipping the solve when the inputs have not changed since the last compute
+    createAttribute(m_inputCacheSolve, "cacheSolve", false);
+    // Trades the accuracy of the angles for speed, see ApproxMath.h for the error of each tier
+    createEnumAttribute(m_inputPrecision, "precision", {"exact", "high", "fast"}, kPrecisionExact);
+    // Builds the orientation from angles, or straight from the aim and pole directions
+    createEnumAttribute(m_inputOrientationMethod, "orientationMethod", {"angles", "frame"}, kOrientationAngles);
 
     // bend angle should be the angle between the two bones composing the triangle arm
     createAttribute(m_outputBendAngle, "bendAngle", DefaultValue<MAngle>(), false);
     // This is the orientation of the entire arm, so should be on the root joint 
     createAttribute(m_outputOrientation, "orientation", DefaultValue<MEulerRotation>(), false);
+    // The same orientation as a quaternion and as a rotation matrix, these skip the euler composition
+    createAttribute(m_outputOrientationQuaternion, "orientationQuaternion", DefaultValue<MQuaternion>(), false);
+    createAttribute(m_outputOrientationMatrix, "orientationMatrix", DefaultValue<MMatrix>(), false);
     createAttribute(m_outputStretchedEdgeA, "stretchedEdgeA", 0.0, false);
     createAttribute(m_outputStretchedEdgeB, "stretchedEdgeB", 0.0, false);
 
+    // Sub frame samples for motion blur and substeps, one element per sample time solved in one compute.
+    // The edges, twist, soften, stretch and precision are shared by every sample, the number of sample targets
+    // decides how many are solved and the last pole element drives the samples past it, or poleVector when none is set
+    createAttribute(m_inputSampleTargetLocation, "sampleTargetLocation", DefaultValue<MVector>(), true, true);
+    createAttribute(m_inputSamplePoleVector, "samplePoleVector", DefaultValue<MVector>(), true, true);
+    createAttribute(m_outputSampleBendAngle, "sampleBendAngle", DefaultValue<MAngle>(), false, true);
+    createAttribute(m_outputSampleOrientation, "sampleOrientation", DefaultValue<MEulerRotation>(), false, true);
+    createAttribute(m_outputSampleStretchedEdgeA, "sampleStretchedEdgeA", 0.0, false, true);
+    createAttribute(m_outputSampleStretchedEdgeB, "sampleStretchedEdgeB", 0.0, false, true);
+
     // Tell maya about our arributes
     addAttributes(
-        m_inputTargetLocation, m_inputEdgeA, m_inputEdgeB, m_inputPoleVector, m_inputTwist, m_inputSoften, m_inputDoSoften, m_inputStretchStrength,
-        m_outputBendAngle, m_outputOrientation, m_outputStretchedEdgeA, m_outputStretchedEdgeB
+        m_inputTargetLocation, m_inputEdgeA, m_inputEdgeB, m_inputPoleVector, m_inputTwist, m_inputSoften, m_inputDoSoften, m_inputStretchStrength, m_inputCacheSolve, m_inputPrecision, m_inputOrientationMethod,
+        m_outputBendAngle, m_outputOrientation, m_outputOrientationQuaternion, m_outputOrientationMatrix,
+        m_outputStretchedEdgeA, m_outputStretchedEdgeB,
+        m_inputSampleTargetLocation, m_inputSamplePoleVector,
+        m_outputSampleBendAngle, m_outputSampleOrientation, m_outputSampleStretchedEdgeA, m_outputSampleStretchedEdgeB
+        );
+    // Tell maya what inputs will affect our outputs, the triangle edges drive everything
+    setAffects(
+        {m_inputTargetLocation, m_inputEdgeA, m_inputEdgeB}, 
+        m_outputBendAngle, m_outputOrientation, m_outputOrientationQuaternion, m_outputOrientationMatrix,
+        m_outputStretchedEdgeA, m_outputStretchedEdgeB
+        );
+    // Softening and precision only change the angles, stretching works from the unsoftened edge
+    setAffects(
+        {m_inputSoften, m_inputDoSoften, m_inputPrecision}, 
+        m_outputBendAngle, m_outputOrientation, m_outputOrientationQuaternion, m_outputOrientationMatrix
         );
-    // Tell maya what inputs will affect our outputs (all of them)
     setAffects(
-        {m_inputTargetLocation, m_inputEdgeA, m_inputEdgeB, m_inputPoleVector, m_inputTwist, m_inputSoften, m_inputDoSoften, m_inputStretchStrength}, 
-        m_outputBendAngle, m_outputOrientation, m_outputStretchedEdgeA, m_outputStretchedEdgeB
+        {m_inputPoleVector, m_inputTwist, m_inputOrientationMethod}, 
+        m_outputOrientation, m_outputOrientationQuaternion, m_outputOrientationMatrix
+        );
+    setAffects(m_inputStretchStrength, m_outputStretchedEdgeA, m_outputStretchedEdgeB);
+    // The samples are solved together, so every shared input affects all of their outputs
+    setAffects(
+        {m_inputSampleTargetLocation, m_inputSamplePoleVector, m_inputEdgeA, m_inputEdgeB, m_inputPoleVector, m_inputTwist, m_inputSoften,
+          m_inputDoSoften, m_inputStretchStrength, m_inputPrecision, m_inputOrientationMethod},
+        m_outputSampleBendAngle, m_outputSampleOrientation, m_outputSampleStretchedEdgeA, m_outputSampleStretchedEdgeB
         );
   
     return MS::kSuccess;
@@ -44,81 +92,525 @@ public:
 
   virtual MStatus compute(const MPlug& _plug, MDataBlock& io_dataBlock) 
   {
-    if (shouldCompute(_plug, m_outputBendAngle, m_outputOrientation, m_outputStretchedEdgeA, m_outputStretchedEdgeB)) 
-    {
-      AttributeData ad(io_dataBlock);
-      // Get the position of our target, with no zero components
-      const auto targetLocation = makeNonZero<double>(ad.get<MVector>(m_inputTargetLocation));
-      // Get the two static edge lengths (the bones) 
-      const auto edgeA = ad.get<double>(m_inputEdgeA);
-      const auto edgeB = ad.get<double>(m_inputEdgeB);
-      // Get the pole vector to calculate twist
-      const auto poleVector = ad.get<MVector>(m_inputPoleVector);
-      // Calculate the distance from our pole vector to the target (on the xz plane) 
-      const auto d = distPointToOLine<double>({poleVector.x, poleVector.z}, {targetLocation.x, targetLocation.z});
-      // Calculate the world, exterior y rotation, when x is negative we do 180 - angle
-      const auto worldY = M_PI * (targetLocation.x < 0) - std::atan(targetLocation.z / targetLocation.x);
-      // We use the Z as a start vector, and rotate it with the arm so that it remains relative,
-      // it is then used to get the normal to our z rotated triangle base
-      const auto rotatedZ = MVector(0.0, 0.0, -1.0).rotateBy(MVector::Axis::kYaxis, worldY);
-      // This is a cross product
-      const auto N = (targetLocation ^ rotatedZ).normal();
-      // Dot product the vector from our pole to the target, to get the relative height of the pole
-      const auto h = makeNonZero((poleVector - targetLocation) * N);
-      // Twist is essentially now a rotated version of atan(Y/X),
-      // we correct using +180 for negative heights
-      const auto extraTwist = ad.get<MAngle>(m_inputTwist).asRadians();
-      const auto twist = M_PI * (h < 0) + std::atan(d / h) + extraTwist;
-      // Get our dynamic edge length and clamp it into our acceptable range
-      const auto dynamicEdgeC = std::max(targetLocation.length(), edgeA - edgeB);
+    ComputeStatsScope stats(*this, TTypeName);
+    if (shouldCompute(_plug, m_outputSampleBendAngle, m_outputSampleOrientation, m_outputSampleStretchedEdgeA, m_outputSampleStretchedEdgeB))
+    {
+      return computeSamples(io_dataBlock);
+    }
+    // Only the requested output is solved, compounds may be pulled through one of their children
+    unsigned outputs = 0u;
+    if (shouldCompute(_plug, m_outputBendAngle)) outputs |= kBendAngle;
+    if (shouldCompute(_plug, m_outputOrientation, m_outputOrientation.attrX, m_outputOrientation.attrY, m_outputOrientation.attrZ))
+    {
+      outputs |= kOrientation;
+    }
+    if (shouldCompute(
+          _plug, m_outputOrientationQuaternion, m_outputOrientationQuaternion.attrX, m_outputOrientationQuaternion.attrY,
+          m_outputOrientationQuaternion.attrZ, m_outputOrientationQuaternion.attrW))
+    {
+      outputs |= kOrientationQuaternion;
+    }
+    if (shouldCompute(_plug, m_outputOrientationMatrix)) outputs |= kOrientationMatrix;
+    if (shouldCompute(_plug, m_outputStretchedEdgeA, m_outputStretchedEdgeB)) outputs |= kStretch;
+    if (!outputs)
+    {
+      stats.reject();
+      return MS::kUnknownParameter;
+    }
+
+    // Connected outputs dirtied by the same input change will be pulled in the same evaluation, so they are solved in
+    // this pass too, the euler orientation in particular is only solved when something uses it. Outputs the change
+    // left clean, such as the orientation when only the stretch changed, are not solved again
+    const unsigned connected = m_connected.load(std::memory_order_relaxed);
+    const auto dirty = [&](Connection _connection, const MObject& _output)
+    {
+      return (connected & (1u << _connection)) && !io_dataBlock.isClean(_output);
+    };
+    if (dirty(kConnectionBendAngle, m_outputBendAngle)) outputs |= kBendAngle;
+    if (dirty(kConnectionOrientation, m_outputOrientation)) outputs |= kOrientation;
+    if (dirty(kConnectionOrientationQuaternion, m_outputOrientationQuaternion)) outputs |= kOrientationQuaternion;
+    if (dirty(kConnectionOrientationMatrix, m_outputOrientationMatrix)) outputs |= kOrientationMatrix;
+    if (dirty(kConnectionStretchedEdgeA, m_outputStretchedEdgeA) || dirty(kConnectionStretchedEdgeB, m_outputStretchedEdgeB))
+    {
+      outputs |= kStretch;
+    }
+
+    AttributeData ad(io_dataBlock);
+    if (ad.get<bool>(m_inputCacheSolve)) return computeCached(io_dataBlock, outputs);
+
+    TwoBoneIKSolution<double> solution;
+    Matrix3<double> matrix;
+    const SolveInputs inputs = readInputs(ad, outputs);
+    solve(inputs, outputs, solution, matrix);
+    writeOutputs(ad, outputs, solution, matrix);
+    if (ComputeRecorder::recording()) record(io_dataBlock, inputs, outputs, solution);
+    return MS::kSuccess;
+  }
+
+  // Number of computes served entirely from the solve cache, and number that had to solve
+  struct SolveCacheStats
+  {
+    unsigned long long hits;
+    unsigned long long misses;
+  };
+
+  SolveCacheStats solveCacheStats() const
+  {
+    return {m_cacheHits.load(std::memory_order_relaxed), m_cacheMisses.load(std::memory_order_relaxed)};
+  }
+
+  // Batched evaluation, SimpleIKEvaluator gathers the inputs of many nodes into one packed solve.
+  // Writes this node's inputs into element _index of the batch, or returns false when the node needs its own compute,
+  // the packed solve has no solve cache, approximate precision or frame orientation, and does not output the quaternion,
+  // matrix or samples. While computes are recorded every node computes on its own, so the log holds the whole rig
+  bool gatherBatchInputs(MDataBlock& io_dataBlock, TwoBoneIKBatchBuffers& io_batch, std::size_t _index)
+  {
+    AttributeData ad(io_dataBlock);
+    if (ComputeRecorder::recording() || ad.get<bool>(m_inputCacheSolve) || ad.get<short>(m_inputPrecision) != kPrecisionExact ||
+        ad.get<short>(m_inputOrientationMethod) != kOrientationAngles ||
+        (m_connected.load(std::memory_order_relaxed) & kUnbatchedConnections))
+    {
+      return false;
+    }
+    const auto targetLocation = ad.get<MVector>(m_inputTargetLocation);
+    const auto poleVector = ad.get<MVector>(m_inputPoleVector);
+    io_batch.targetX[_index] = targetLocation.x;
+    io_batch.targetY[_index] = targetLocation.y;
+    io_batch.targetZ[_index] = targetLocation.z;
+    io_batch.poleX[_index] = poleVector.x;
+    io_batch.poleY[_index] = poleVector.y;
+    io_batch.poleZ[_index] = poleVector.z;
+    io_batch.edgeA[_index] = ad.get<double>(m_inputEdgeA);
+    io_batch.edgeB[_index] = ad.get<double>(m_inputEdgeB);
+    io_batch.twist[_index] = ad.get<MAngle>(m_inputTwist).asRadians();
+    io_batch.soften[_index] = ad.get<double>(m_inputSoften) * ad.get<bool>(m_inputDoSoften);
+    io_batch.stretchStrength[_index] = ad.get<double>(m_inputStretchStrength);
+    return true;
+  }
+
+  void scatterBatchOutputs(MDataBlock& io_dataBlock, const TwoBoneIKBatchBuffers& _batch, std::size_t _index)
+  {
+    AttributeData ad(io_dataBlock);
+    ad.set(m_outputBendAngle, MAngle(_batch.bendAngle[_index]));
+    ad.set(m_outputOrientation, MEulerRotation(_batch.orientationX[_index], _batch.orientationY[_index], _batch.orientationZ[_index]));
+    ad.set(m_outputStretchedEdgeA, _batch.stretchedEdgeA[_index]);
+    ad.set(m_outputStretchedEdgeB, _batch.stretchedEdgeB[_index]);
+  }
+
+  // Counts a batched solve of this node as one compute in sik_computeStats, taking _nanoseconds
+  void countBatchedCompute(std::uint64_t _nanoseconds) const { ComputeStatsScope::addBatched(*this, TTypeName, _nanoseconds); }
+
+  // Maya reports each connection to or from the node outside of compute, the connected outputs are kept as a mask
+  // so computes and the evaluator test one atomic rather than looking up plugs
+  MStatus connectionMade(const MPlug& _plug, const MPlug& _otherPlug, bool _asSrc) override
+  {
+    countConnection(_plug, _asSrc, 1);
+    return MPxNode::connectionMade(_plug, _otherPlug, _asSrc);
+  }
+
+  MStatus connectionBroken(const MPlug& _plug, const MPlug& _otherPlug, bool _asSrc) override
+  {
+    countConnection(_plug, _asSrc, -1);
+    return MPxNode::connectionBroken(_plug, _otherPlug, _asSrc);
+  }
+
+private:
+  // Every input of the solve, compared bitwise against the last compute
+  struct SolveInputs
+  {
+    Vector3<double> targetLocation;
+    Vector3<double> poleVector;
+    double edgeA;
+    double edgeB;
+    double twist;
+    double dsoft;
+    double stretchStrength;
+    // 64 bit so the struct has no padding to compare
+    std::int64_t precision;
+    std::int64_t orientationMethod;
+  };
+
+  // Output groups, the quaternion and matrix share one solve
+  enum Outputs : unsigned
+  {
+    kBendAngle = 1u,
+    kOrientation = 2u,
+    kOrientationQuaternion = 4u,
+    kOrientationMatrix = 8u,
+    kStretch = 16u,
+    kAllOutputs = 31u
+  };
+
+  // Reads the inputs needed by the given outputs, the others are left zeroed
+  SolveInputs readInputs(AttributeData& io_ad, unsigned _outputs)
+  {
+    ComputePhaseScope phase(kPhaseAttributeRead);
+    SolveInputs inputs = {};
+    // Get the position of our target, with no zero components
+    inputs.targetLocation = makeNonZero<double>(toVector3(io_ad.get<MVector>(m_inputTargetLocation)));
+    inputs.edgeA = io_ad.get<double>(m_inputEdgeA);
+    inputs.edgeB = io_ad.get<double>(m_inputEdgeB);
+    if (_outputs & kStretch) inputs.stretchStrength = io_ad.get<double>(m_inputStretchStrength);
+    if (_outputs & ~kStretch)
+    {
       // Calculate the softness value
-      const auto dsoft = ad.get<double>(m_inputSoften) * ad.get<bool>(m_inputDoSoften);  
-      const auto chainLength = edgeA + edgeB;
-      // Soften our dynamic edge if required
-      const auto edgeC = softenEdge(dynamicEdgeC, chainLength, dsoft);
-      // Use the law of cosines to calculate interior bend angle of the triangle
-      // We add pi to get the obtuse complement angle
-      const auto bendAngle = getAngle(edgeA, edgeB, edgeC) + M_PI;
-
-      // Using law of cosines to get the interior angle of the triangle, this is the interior Z rotation
-      MEulerRotation rot(0.0, 0.0, getAngle(edgeA, edgeC, edgeB), MEulerRotation::RotationOrder::kZXY);
+      inputs.dsoft = io_ad.get<double>(m_inputSoften) * io_ad.get<bool>(m_inputDoSoften);
+      inputs.precision = io_ad.get<short>(m_inputPrecision);
+    }
+    if (_outputs & (kOrientation | kOrientationQuaternion | kOrientationMatrix))
+    {
+      inputs.poleVector = toVector3(io_ad.get<MVector>(m_inputPoleVector));
+      inputs.twist = io_ad.get<MAngle>(m_inputTwist).asRadians();
+      inputs.orientationMethod = io_ad.get<short>(m_inputOrientationMethod);
+    }
+    return inputs;
+  }
+
+  // The solve of one compute specialized on its precision and on the features its inputs use, so rigs that leave
+  // soften, stretch, twist or the pole unused skip their math, both are picked once per compute
+  void solve(const SolveInputs& _in, unsigned _outputs, TwoBoneIKSolution<double>& io_solution, Matrix3<double>& io_matrix)
+  {
+    ComputePhaseScope phase(kPhaseSolve);
+    const auto features = twoBoneIKFeatures(_in.poleVector, _in.edgeA, _in.edgeB, _in.twist, _in.dsoft, _in.stretchStrength);
+    switch (_in.precision)
+    {
+      case kPrecisionHigh: solve<HighMath>(features, _in, _outputs, io_solution, io_matrix); break;
+      case kPrecisionFast: solve<FastMath>(features, _in, _outputs, io_solution, io_matrix); break;
+      default: solve<ExactMath>(features, _in, _outputs, io_solution, io_matrix); break;
+    }
+  }
+
+  // The arguments of a solve, for dispatchTwoBoneIKFeatures
+  template <typename TMath>
+  struct FeatureSolve
+  {
+    TwoBoneIKNode& node;
+    const SolveInputs& in;
+    unsigned outputs;
+    TwoBoneIKSolution<double>& solution;
+    Matrix3<double>& matrix;
+
+    template <unsigned TFeatures>
+    void solve() const { node.template solve<TMath, TFeatures>(in, outputs, solution, matrix); }
+  };
+
+  template <typename TMath>
+  void solve(unsigned _features, const SolveInputs& _in, unsigned _outputs, TwoBoneIKSolution<double>& io_solution, Matrix3<double>& io_matrix)
+  {
+    const FeatureSolve<TMath> solver = {*this, _in, _outputs, io_solution, io_matrix};
+    dispatchTwoBoneIKFeatures(_features, solver);
+  }
+
+  template <typename TMath, unsigned TFeatures>
+  void solve(const SolveInputs& _in, unsigned _outputs, TwoBoneIKSolution<double>& io_solution, Matrix3<double>& io_matrix)
+  {
+    if (_outputs & kStretch)
+    {
+      // Both edges share all of their inputs, so they are solved together
+      const auto dynamicEdgeC = solveDynamicEdge(_in.targetLocation, _in.edgeA, _in.edgeB);
+      const auto chainLength = _in.edgeA + _in.edgeB;
+      io_solution.stretchedEdgeA = solveStretchedEdge<double, TFeatures>(_in.edgeA, dynamicEdgeC, chainLength, _in.stretchStrength);
+      io_solution.stretchedEdgeB = solveStretchedEdge<double, TFeatures>(_in.edgeB, dynamicEdgeC, chainLength, _in.stretchStrength);
+    }
+    if (_outputs & ~kStretch)
+    {
+      const auto edgeC = solveTwoBoneIKEdges<double, TMath, TFeatures>(_in.targetLocation, _in.edgeA, _in.edgeB, _in.dsoft).edgeC;
+      if (_outputs & kBendAngle) io_solution.bendAngle = solveBendAngle<double, TMath>(_in.edgeA, _in.edgeB, edgeC);
+      if (_in.orientationMethod == kOrientationFrame)
+      {
+        // The euler rotation is decomposed from the frame, so every orientation output shares it
+        if (_outputs & (kOrientation | kOrientationQuaternion | kOrientationMatrix))
+        {
+          io_matrix = solveRootFrame<double, TMath, TFeatures>(_in.targetLocation, _in.poleVector, _in.edgeA, _in.edgeB, edgeC, _in.twist);
+        }
+        if (_outputs & kOrientation)
+        {
+          ComputePhaseScope phase(kPhaseEulerReorder);
+          io_solution.orientation = solveRootEuler<double, TMath>(io_matrix);
+        }
+        return;
+      }
+      if (_outputs & kOrientation)
       {
-        // Get the rotated base edge length of the triangle
-        const auto hypot = std::sqrt(sqr(targetLocation.x) + sqr(targetLocation.z));
-        // This rotation is the twist, height adjustment and the Y rotation
-        const MEulerRotation exterior(
-            // Apply our twist as x rotation
-            twist, 
-            // The world Y rotation, corrected for each quadrant
-            worldY,
-            // This angle needs to have an incline based on the targetLocation.y of the locator
-            std::atan(targetLocation.y / hypot), 
-            // We need to apply our Z rotation first, as the Y rotation affects the plane on which it is applied
-            MEulerRotation::RotationOrder::kXZY
-            );
-
-        // Multiply so that the interior Z rotation comes first
-        rot *= exterior;
+        // The euler rotation is composed from the world Y, incline and twist angles and reordered to XYZ in one pass
+        ComputePhaseScope phase(kPhaseEulerReorder);
+        io_solution.orientation = solveRootOrientation<double, TMath, TFeatures>(_in.targetLocation, _in.poleVector, _in.edgeA, _in.edgeB, edgeC, _in.twist, TMath());
       }
-      // Reorder the rotations to the standard maya convention
-      rot.reorderIt(MEulerRotation::RotationOrder::kXYZ);
+      if (_outputs & (kOrientationQuaternion | kOrientationMatrix))
+      {
+        io_matrix = solveRootMatrix<double, TMath, TFeatures>(_in.targetLocation, _in.poleVector, _in.edgeA, _in.edgeB, edgeC, _in.twist);
+      }
+    }
+  }
 
-      const auto stretchStrength = ad.get<double>(m_inputStretchStrength);
-      const auto stretchedEdgeA = stretchEdge(edgeA, dynamicEdgeC, chainLength, stretchStrength);
-      const auto stretchedEdgeB = stretchEdge(edgeB, dynamicEdgeC, chainLength, stretchStrength);
-  
-      // Output the values
-      ad.set(m_outputBendAngle, MAngle(bendAngle));
-      ad.set(m_outputOrientation, rot);
-      ad.set(m_outputStretchedEdgeA, stretchedEdgeA);
-      ad.set(m_outputStretchedEdgeB, stretchedEdgeB);
-  
-      return MS::kSuccess;
+  void writeOutputs(AttributeData& io_ad, unsigned _outputs, const TwoBoneIKSolution<double>& _solution, const Matrix3<double>& _matrix)
+  {
+    ComputePhaseScope phase(kPhaseAttributeWrite);
+    if (_outputs & kBendAngle) io_ad.set(m_outputBendAngle, MAngle(_solution.bendAngle));
+    if (_outputs & kOrientation) io_ad.set(m_outputOrientation, toMEulerRotation(_solution.orientation));
+    if (_outputs & kOrientationQuaternion) io_ad.set(m_outputOrientationQuaternion, toMQuaternion(Quaternion<double>::fromMatrix(_matrix)));
+    if (_outputs & kOrientationMatrix) io_ad.set(m_outputOrientationMatrix, toMMatrix(_matrix));
+    if (_outputs & kStretch)
+    {
+      io_ad.set(m_outputStretchedEdgeA, _solution.stretchedEdgeA);
+      io_ad.set(m_outputStretchedEdgeB, _solution.stretchedEdgeB);
     }
-    return MS::kUnknownParameter;
   }
 
-private:
+  MStatus computeCached(MDataBlock& io_dataBlock, unsigned _outputs)
+  {
+    AttributeData ad(io_dataBlock);
+    const SolveInputs inputs = readInputs(ad, kAllOutputs);
+
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    if (!bitwiseEqual(inputs, m_cacheInputs))
+    {
+      m_cacheInputs = inputs;
+      m_cacheSolved = 0u;
+    }
+    // Outputs are solved on demand, so a partial pull only pays for what it asks for
+    unsigned missing = _outputs & ~m_cacheSolved;
+    (missing ? m_cacheMisses : m_cacheHits).fetch_add(1u, std::memory_order_relaxed);
+    if (missing & (kOrientationQuaternion | kOrientationMatrix)) missing |= kOrientationQuaternion | kOrientationMatrix;
+
+    solve(m_cacheInputs, missing, m_cacheSolution, m_cacheMatrix);
+    m_cacheSolved |= missing;
+
+    // Output the values
+    writeOutputs(ad, _outputs, m_cacheSolution, m_cacheMatrix);
+    if (ComputeRecorder::recording()) record(io_dataBlock, m_cacheInputs, _outputs, m_cacheSolution);
+    return MS::kSuccess;
+  }
+
+  // Solves every sample in one compute. The shared inputs are read once, and with the exact precision and angles
+  // orientation the samples go through the packed solve as one small batch, which agrees with one compute per sample
+  // to the tolerance of TwoBoneIKBatch.h. Other precisions and the frame orientation go through the scalar solve
+  // picked once for all of them. The solve cache and the recording cover the single limb outputs only
+  MStatus computeSamples(MDataBlock& io_dataBlock)
+  {
+    AttributeData ad(io_dataBlock);
+    std::lock_guard<std::mutex> lock(m_samplesMutex);
+    SolveInputs shared;
+    std::size_t count;
+    {
+      ComputePhaseScope phase(kPhaseAttributeRead);
+      shared = readInputs(ad, kAllOutputs);
+      auto& targetLocations = m_sampleArrays.targetLocations;
+      auto& poleVectors = m_sampleArrays.poleVectors;
+      ad.get(m_inputSampleTargetLocation, targetLocations);
+      ad.get(m_inputSamplePoleVector, poleVectors);
+
+      count = targetLocations.size();
+      m_samples.resize(count);
+      for (std::size_t i = 0u; i < count; ++i)
+      {
+        const MVector poleVector = poleVectors.empty() ? toMVector(shared.poleVector) : poleVectors[std::min(i, poleVectors.size() - 1)];
+        m_samples.targetX[i] = targetLocations[i].x;
+        m_samples.targetY[i] = targetLocations[i].y;
+        m_samples.targetZ[i] = targetLocations[i].z;
+        m_samples.poleX[i] = poleVector.x;
+        m_samples.poleY[i] = poleVector.y;
+        m_samples.poleZ[i] = poleVector.z;
+      }
+      std::fill(m_samples.edgeA.begin(), m_samples.edgeA.end(), shared.edgeA);
+      std::fill(m_samples.edgeB.begin(), m_samples.edgeB.end(), shared.edgeB);
+      std::fill(m_samples.twist.begin(), m_samples.twist.end(), shared.twist);
+      std::fill(m_samples.soften.begin(), m_samples.soften.end(), shared.dsoft);
+      std::fill(m_samples.stretchStrength.begin(), m_samples.stretchStrength.end(), shared.stretchStrength);
+    }
+    {
+      ComputePhaseScope phase(kPhaseSolve);
+      if (shared.precision == kPrecisionExact && shared.orientationMethod == kOrientationAngles)
+      {
+        // A few samples fill a pack or two, so they are solved on this thread rather than split over the pool
+        BatchDispatch::kernels().solveTwoBoneIK(m_samples.view(), count);
+      }
+      else
+      {
+        // The packed kernels only cover the exact precision and angles orientation, the other samples go through the
+        // solve of a single compute. They only differ in their target and pole, so they share the features of their union
+        unsigned features = twoBoneIKFeatures(Vector3<double>(), shared.edgeA, shared.edgeB, shared.twist, shared.dsoft, shared.stretchStrength);
+        for (std::size_t i = 0u; i < count; ++i)
+        {
+          if (m_samples.poleX[i] != 0.0 || m_samples.poleY[i] != 0.0 || m_samples.poleZ[i] != 0.0) features |= kFeaturePole;
+        }
+        switch (shared.precision)
+        {
+          case kPrecisionHigh: solveSamples<HighMath>(features, shared, count); break;
+          case kPrecisionFast: solveSamples<FastMath>(features, shared, count); break;
+          default: solveSamples<ExactMath>(features, shared, count); break;
+        }
+      }
+    }
+    {
+      ComputePhaseScope phase(kPhaseAttributeWrite);
+      auto& bendAngles = m_sampleArrays.bendAngles;
+      auto& orientations = m_sampleArrays.orientations;
+      bendAngles.resize(count);
+      orientations.resize(count);
+      for (std::size_t i = 0u; i < count; ++i)
+      {
+        bendAngles[i] = MAngle(m_samples.bendAngle[i]);
+        orientations[i] = MEulerRotation(m_samples.orientationX[i], m_samples.orientationY[i], m_samples.orientationZ[i]);
+      }
+      ad.set(m_outputSampleBendAngle, bendAngles);
+      ad.set(m_outputSampleOrientation, orientations);
+      ad.set(m_outputSampleStretchedEdgeA, m_samples.stretchedEdgeA);
+      ad.set(m_outputSampleStretchedEdgeB, m_samples.stretchedEdgeB);
+    }
+    return MS::kSuccess;
+  }
+
+  // The arguments of a sample solve, for dispatchTwoBoneIKFeatures
+  template <typename TMath>
+  struct SampleSolve
+  {
+    TwoBoneIKNode& node;
+    const SolveInputs& shared;
+    std::size_t count;
+
+    template <unsigned TFeatures>
+    void solve() const { node.template solveSamples<TMath, TFeatures>(shared, count); }
+  };
+
+  template <typename TMath>
+  void solveSamples(unsigned _features, const SolveInputs& _shared, std::size_t _count)
+  {
+    const SampleSolve<TMath> solver = {*this, _shared, _count};
+    dispatchTwoBoneIKFeatures(_features, solver);
+  }
+
+  // Solves the samples in m_samples with the single limb solve, only the target and pole change between them
+  template <typename TMath, unsigned TFeatures>
+  void solveSamples(const SolveInputs& _shared, std::size_t _count)
+  {
+    SolveInputs in = _shared;
+    TwoBoneIKSolution<double> solution;
+    Matrix3<double> matrix;
+    for (std::size_t i = 0u; i < _count; ++i)
+    {
+      in.targetLocation = makeNonZero<double>(Vector3<double>(m_samples.targetX[i], m_samples.targetY[i], m_samples.targetZ[i]));
+      in.poleVector = Vector3<double>(m_samples.poleX[i], m_samples.poleY[i], m_samples.poleZ[i]);
+      solve<TMath, TFeatures>(in, kBendAngle | kOrientation | kStretch, solution, matrix);
+      m_samples.bendAngle[i] = solution.bendAngle;
+      m_samples.orientationX[i] = solution.orientation.x;
+      m_samples.orientationY[i] = solution.orientation.y;
+      m_samples.orientationZ[i] = solution.orientation.z;
+      m_samples.stretchedEdgeA[i] = solution.stretchedEdgeA;
+      m_samples.stretchedEdgeB[i] = solution.stretchedEdgeB;
+    }
+  }
+
+  // Appends the compute to the recording, the quaternion and matrix are not recorded as limb streams have no channels for them
+  void record(MDataBlock& io_dataBlock, const SolveInputs& _in, unsigned _outputs, const TwoBoneIKSolution<double>& _solution)
+  {
+    ComputeRecord record = {};
+    record.node = computeRecordNodeId(this->name().asChar());
+    record.time = io_dataBlock.context().getTime().as(MTime::kFilm);
+    record.nodeType = kRecordTwoBoneIKNode;
+    record.precision = std::int32_t(_in.precision);
+    record.orientationMethod = std::int32_t(_in.orientationMethod);
+    const double inputs[kLimbStreamInputChannels] = {
+      _in.targetLocation.x, _in.targetLocation.y, _in.targetLocation.z, _in.poleVector.x, _in.poleVector.y, _in.poleVector.z,
+      _in.edgeA, _in.edgeB, _in.twist, _in.dsoft, _in.stretchStrength
+    };
+    std::copy(inputs, inputs + kLimbStreamInputChannels, record.inputs);
+    if (_outputs & kBendAngle)
+    {
+      record.outputs |= kRecordBendAngle;
+      record.outputValues[0] = _solution.bendAngle;
+    }
+    if (_outputs & kOrientation)
+    {
+      record.outputs |= kRecordOrientation;
+      record.outputValues[1] = _solution.orientation.x;
+      record.outputValues[2] = _solution.orientation.y;
+      record.outputValues[3] = _solution.orientation.z;
+    }
+    if (_outputs & kStretch)
+    {
+      record.outputs |= kRecordStretch;
+      record.outputValues[4] = _solution.stretchedEdgeA;
+      record.outputValues[5] = _solution.stretchedEdgeB;
+    }
+    ComputeRecorder::instance().record(record);
+  }
+
+  // Output plugs counted as connections are made and broken, the stretched edges and samples each have their own count
+  enum Connection
+  {
+    kConnectionBendAngle,
+    kConnectionOrientation,
+    kConnectionOrientationQuaternion,
+    kConnectionOrientationMatrix,
+    kConnectionStretchedEdgeA,
+    kConnectionStretchedEdgeB,
+    kConnectionSampleBendAngle,
+    kConnectionSampleOrientation,
+    kConnectionSampleStretchedEdgeA,
+    kConnectionSampleStretchedEdgeB,
+    kConnectionCount
+  };
+
+  // Connected outputs the packed solve of the evaluator does not write
+  static constexpr unsigned kUnbatchedConnections =
+    (1u << kConnectionOrientationQuaternion) | (1u << kConnectionOrientationMatrix) | (1u << kConnectionSampleBendAngle) |
+    (1u << kConnectionSampleOrientation) | (1u << kConnectionSampleStretchedEdgeA) | (1u << kConnectionSampleStretchedEdgeB);
+
+  // The output a plug belongs to, compound outputs may only have some of their children connected
+  static int connection(const MPlug& _plug)
+  {
+    const Attribute* const outputs[kConnectionCount] = {
+      &m_outputBendAngle, &m_outputOrientation, &m_outputOrientationQuaternion, &m_outputOrientationMatrix, &m_outputStretchedEdgeA,
+      &m_outputStretchedEdgeB, &m_outputSampleBendAngle, &m_outputSampleOrientation, &m_outputSampleStretchedEdgeA,
+      &m_outputSampleStretchedEdgeB};
+    const MObject attribute = _plug.attribute();
+    for (int i = 0; i < kConnectionCount; ++i)
+    {
+      for (const MObject* attr : {&outputs[i]->attr, &outputs[i]->attrX, &outputs[i]->attrY, &outputs[i]->attrZ, &outputs[i]->attrW})
+      {
+        if (!attr->isNull() && *attr == attribute) return i;
+      }
+    }
+    return -1;
+  }
+
+  void countConnection(const MPlug& _plug, bool _asSrc, int _change)
+  {
+    const int output = _asSrc ? connection(_plug) : -1;
+    if (output < 0) return;
+    m_connectionCounts[output] = std::max(m_connectionCounts[output] + _change, 0);
+    unsigned connected = 0u;
+    for (int i = 0; i < kConnectionCount; ++i) connected |= m_connectionCounts[i] ? 1u << i : 0u;
+    m_connected.store(connected, std::memory_order_relaxed);
+  }
+
+  // The sample inputs and solutions in packed form, and the attribute arrays in maya types,
+  // kept on the node so repeated computes reuse the allocations
+  std::mutex m_samplesMutex;
+  TwoBoneIKBatchBuffers m_samples;
+  struct SampleArrays
+  {
+    std::vector<MVector> targetLocations;
+    std::vector<MVector> poleVectors;
+    std::vector<MAngle> bendAngles;
+    std::vector<MEulerRotation> orientations;
+  } m_sampleArrays;
+
+  // The solve cache, only used when cacheSolve is on
+  std::mutex m_cacheMutex;
+  SolveInputs m_cacheInputs = {};
+  TwoBoneIKSolution<double> m_cacheSolution = {};
+  Matrix3<double> m_cacheMatrix;
+  // Which outputs of m_cacheSolution are valid for m_cacheInputs
+  unsigned m_cacheSolved = 0u;
+  std::atomic<unsigned long long> m_cacheHits{0u};
+  std::atomic<unsigned long long> m_cacheMisses{0u};
+
+  // Connections of each output, only changed from connectionMade and connectionBroken, and the outputs that have any
+  int m_connectionCounts[kConnectionCount] = {};
+  std::atomic<unsigned> m_connected{0u};
+
   static Attribute m_inputTargetLocation;
   static Attribute m_inputEdgeA;
   static Attribute m_inputEdgeB;
@@ -127,10 +619,21 @@ private:
   static Attribute m_inputSoften;
   static Attribute m_inputDoSoften;
   static Attribute m_inputStretchStrength;
+  static Attribute m_inputCacheSolve;
+  static Attribute m_inputPrecision;
+  static Attribute m_inputOrientationMethod;
   static Attribute m_outputBendAngle;
   static Attribute m_outputOrientation; 
+  static Attribute m_outputOrientationQuaternion;
+  static Attribute m_outputOrientationMatrix;
   static Attribute m_outputStretchedEdgeA;
   static Attribute m_outputStretchedEdgeB;
+  static Attribute m_inputSampleTargetLocation;
+  static Attribute m_inputSamplePoleVector;
+  static Attribute m_outputSampleBendAngle;
+  static Attribute m_outputSampleOrientation;
+  static Attribute m_outputSampleStretchedEdgeA;
+  static Attribute m_outputSampleStretchedEdgeB;
 };
 
 #define MEMDECL(NAME) \
@@ -145,10 +648,21 @@ MEMDECL(m_inputTwist);
 MEMDECL(m_inputSoften);
 MEMDECL(m_inputDoSoften);
 MEMDECL(m_inputStretchStrength);
+MEMDECL(m_inputCacheSolve);
+MEMDECL(m_inputPrecision);
+MEMDECL(m_inputOrientationMethod);
 MEMDECL(m_outputBendAngle);
 MEMDECL(m_outputOrientation);
+MEMDECL(m_outputOrientationQuaternion);
+MEMDECL(m_outputOrientationMatrix);
 MEMDECL(m_outputStretchedEdgeA);
 MEMDECL(m_outputStretchedEdgeB);
+MEMDECL(m_inputSampleTargetLocation);
+MEMDECL(m_inputSamplePoleVector);
+MEMDECL(m_outputSampleBendAngle);
+MEMDECL(m_outputSampleOrientation);
+MEMDECL(m_outputSampleStretchedEdgeA);
+MEMDECL(m_outputSampleStretchedEdgeB);
 
 #undef MEMDECL
 
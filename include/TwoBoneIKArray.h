@@ -0,0 +1,181 @@
+#ifndef TWOBONEIKARRAY_INCLUDE_H
+#define TWOBONEIKARRAY_INCLUDE_H
+
+#include <maya/MThreadUtils.h>
+#include "TwoBoneIK.h"
+#include "TwoBoneIKParallel.h"
+
+// Fetches the per limb value at index i, falling back to the last connected element,
+// so a single element can drive every limb, and to the default when nothing is connected
+template <typename T>
+inline static T limbValue(const std::vector<T>& values, std::size_t i, const T& fallback)
+{
+  if (values.empty()) return fallback;
+  return values[std::min(i, values.size() - 1)];
+}
+
+template<typename TClass, const char* TTypeName>
+class TwoBoneIKArrayNode : public BaseNode<TClass, TTypeName>
+{
+public:
+
+  static MStatus initialize()
+  {
+    // Create all of our inputs, these mirror the single limb node but hold one element per limb
+    // The number of target locations decides how many limbs are solved
+    createAttribute(m_inputTargetLocation, "targetLocation", DefaultValue<MVector>(), true, true);
+    createAttribute(m_inputEdgeA, "staticEdgeA", 0.0, true, true);
+    createAttribute(m_inputEdgeB, "staticEdgeB", 0.0, true, true);
+    createAttribute(m_inputPoleVector, "poleVector", DefaultValue<MVector>(), true, true);
+    createAttribute(m_inputTwist, "twist", DefaultValue<MAngle>(), true, true);
+    createAttribute(m_inputSoften, "soften", 0.0, true, true);
+    createAttribute(m_inputStretchStrength, "stretchStrength", 1.0, true, true);
+    // Softening is toggled for the whole batch
+    createAttribute(m_inputDoSoften, "doSoften", true);
+
+    // One output element per solved limb
+    createAttribute(m_outputBendAngle, "bendAngle", DefaultValue<MAngle>(), false, true);
+    createAttribute(m_outputOrientation, "orientation", DefaultValue<MEulerRotation>(), false, true);
+    createAttribute(m_outputStretchedEdgeA, "stretchedEdgeA", 0.0, false, true);
+    createAttribute(m_outputStretchedEdgeB, "stretchedEdgeB", 0.0, false, true);
+
+    // Tell maya about our arributes
+    addAttributes(
+        m_inputTargetLocation, m_inputEdgeA, m_inputEdgeB, m_inputPoleVector, m_inputTwist, m_inputSoften, m_inputDoSoften, m_inputStretchStrength,
+        m_outputBendAngle, m_outputOrientation, m_outputStretchedEdgeA, m_outputStretchedEdgeB
+        );
+    // Tell maya what inputs will affect our outputs (all of them)
+    setAffects(
+        {m_inputTargetLocation, m_inputEdgeA, m_inputEdgeB, m_inputPoleVector, m_inputTwist, m_inputSoften, m_inputDoSoften, m_inputStretchStrength},
+        m_outputBendAngle, m_outputOrientation, m_outputStretchedEdgeA, m_outputStretchedEdgeB
+        );
+
+    return MS::kSuccess;
+  }
+
+  virtual MStatus compute(const MPlug& _plug, MDataBlock& io_dataBlock)
+  {
+    if (shouldCompute(_plug, m_outputBendAngle, m_outputOrientation, m_outputStretchedEdgeA, m_outputStretchedEdgeB))
+    {
+      AttributeData ad(io_dataBlock);
+      // Read every input array once, the whole batch is solved in this compute
+      auto& targetLocations = m_arrays.targetLocations;
+      auto& poleVectors = m_arrays.poleVectors;
+      auto& edgesA = m_arrays.edgesA;
+      auto& edgesB = m_arrays.edgesB;
+      auto& twists = m_arrays.twists;
+      auto& softens = m_arrays.softens;
+      auto& stretchStrengths = m_arrays.stretchStrengths;
+      ad.get(m_inputTargetLocation, targetLocations);
+      ad.get(m_inputPoleVector, poleVectors);
+      ad.get(m_inputEdgeA, edgesA);
+      ad.get(m_inputEdgeB, edgesB);
+      ad.get(m_inputTwist, twists);
+      ad.get(m_inputSoften, softens);
+      ad.get(m_inputStretchStrength, stretchStrengths);
+      const auto doSoften = ad.get<bool>(m_inputDoSoften);
+
+      // Gather into packed arrays so the limbs can be solved several at a time
+      const auto numLimbs = targetLocations.size();
+      m_batch.resize(numLimbs);
+      for (std::size_t i = 0u; i < numLimbs; ++i)
+      {
+        const auto& targetLocation = targetLocations[i];
+        const auto poleVector = limbValue(poleVectors, i, DefaultValue<MVector>());
+        m_batch.targetX[i] = targetLocation.x;
+        m_batch.targetY[i] = targetLocation.y;
+        m_batch.targetZ[i] = targetLocation.z;
+        m_batch.poleX[i] = poleVector.x;
+        m_batch.poleY[i] = poleVector.y;
+        m_batch.poleZ[i] = poleVector.z;
+        m_batch.edgeA[i] = limbValue(edgesA, i, 0.0);
+        m_batch.edgeB[i] = limbValue(edgesB, i, 0.0);
+        m_batch.twist[i] = limbValue(twists, i, DefaultValue<MAngle>()).asRadians();
+        m_batch.soften[i] = limbValue(softens, i, 0.0) * doSoften;
+        m_batch.stretchStrength[i] = limbValue(stretchStrengths, i, 1.0);
+      }
+
+      // Large batches are split over the shared pool, with the same result as solving on one thread
+      solveTwoBoneIKBatchParallel(m_batch.view(), numLimbs, pluginThreadPool(MThreadUtils::getNumThreads()));
+
+      // Scatter back into maya types
+      auto& bendAngles = m_arrays.bendAngles;
+      auto& orientations = m_arrays.orientations;
+      bendAngles.resize(numLimbs);
+      orientations.resize(numLimbs);
+      for (std::size_t i = 0u; i < numLimbs; ++i)
+      {
+        bendAngles[i] = MAngle(m_batch.bendAngle[i]);
+        orientations[i] = MEulerRotation(m_batch.orientationX[i], m_batch.orientationY[i], m_batch.orientationZ[i]);
+      }
+
+      // Output the values
+      ad.set(m_outputBendAngle, bendAngles);
+      ad.set(m_outputOrientation, orientations);
+      ad.set(m_outputStretchedEdgeA, m_batch.stretchedEdgeA);
+      ad.set(m_outputStretchedEdgeB, m_batch.stretchedEdgeB);
+
+      return MS::kSuccess;
+    }
+    return MS::kUnknownParameter;
+  }
+
+private:
+  // Packed limb data, kept on the node so repeated computes reuse the allocation
+  TwoBoneIKBatchBuffers m_batch;
+  // The attribute arrays in maya types, kept for the same reason
+  struct AttributeArrays
+  {
+    std::vector<MVector> targetLocations;
+    std::vector<MVector> poleVectors;
+    std::vector<double> edgesA;
+    std::vector<double> edgesB;
+    std::vector<MAngle> twists;
+    std::vector<double> softens;
+    std::vector<double> stretchStrengths;
+    std::vector<MAngle> bendAngles;
+    std::vector<MEulerRotation> orientations;
+  } m_arrays;
+
+  static Attribute m_inputTargetLocation;
+  static Attribute m_inputEdgeA;
+  static Attribute m_inputEdgeB;
+  static Attribute m_inputPoleVector;
+  static Attribute m_inputTwist;
+  static Attribute m_inputSoften;
+  static Attribute m_inputDoSoften;
+  static Attribute m_inputStretchStrength;
+  static Attribute m_outputBendAngle;
+  static Attribute m_outputOrientation;
+  static Attribute m_outputStretchedEdgeA;
+  static Attribute m_outputStretchedEdgeB;
+};
+
+#define MEMDECL(NAME) \
+template<typename TClass, const char* TTypeName> \
+Attribute TwoBoneIKArrayNode<TClass, TTypeName>::NAME
+
+MEMDECL(m_inputTargetLocation);
+MEMDECL(m_inputEdgeA);
+MEMDECL(m_inputEdgeB);
+MEMDECL(m_inputPoleVector);
+MEMDECL(m_inputTwist);
+MEMDECL(m_inputSoften);
+MEMDECL(m_inputDoSoften);
+MEMDECL(m_inputStretchStrength);
+MEMDECL(m_outputBendAngle);
+MEMDECL(m_outputOrientation);
+MEMDECL(m_outputStretchedEdgeA);
+MEMDECL(m_outputStretchedEdgeB);
+
+#undef MEMDECL
+
+#define TWOBONEIKARRAY_NODE(NodeName) \
+TEMPLATE_PARAMETER_LINKAGE char name##NodeName[] = #NodeName; \
+class NodeName : public TwoBoneIKArrayNode<NodeName, name##NodeName> {};
+
+TWOBONEIKARRAY_NODE(twoBoneIKArray);
+
+#undef TWOBONEIKARRAY_NODE
+
+#endif //TWOBONEIKARRAY_INCLUDE_H
@@ -0,0 +1,346 @@
+#ifndef TWOBONEIKBATCH_INCLUDE_H
+#define TWOBONEIKBATCH_INCLUDE_H
+
+#include "SimdMath.h"
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+// Structure of arrays two bone solve, this mirrors solveTwoBoneIK lane for lane,
+// using the packed transcendentals from SimdMath.h in place of the std ones.
+// The root orientation is composed as a rotation matrix and decomposed straight to XYZ,
+// rather than going through two euler rotations and a reorder.
+// Against the scalar path the bend angle, stretched edges and orientation matrix agree to 1e-12,
+// and the XYZ orientation angles agree to 1e-9 radians modulo 2pi.
+// The exceptions are the fully extended and fully folded limits, where acos turns a last bit difference
+// in its argument into up to 1e-7 radians (only seen when one build contracts to FMA and the other does not),
+// and the +-90 degree Y gimbal singularity, where the euler angles are not unique.
+// InclineAngleBatch mirrors solveInclineAngle the same way.
+
+// Number of limbs solved per instruction stream, SSE builds split each pack over two registers
+static constexpr unsigned kTwoBoneIKBatchWidth = 4u;
+
+// Non owning views of the packed limb data, one element per limb
+struct TwoBoneIKBatch
+{
+  // Inputs
+  const double* targetX;
+  const double* targetY;
+  const double* targetZ;
+  const double* poleX;
+  const double* poleY;
+  const double* poleZ;
+  const double* edgeA;
+  const double* edgeB;
+  // Extra twist in radians
+  const double* twist;
+  // Soften distance, zero when softening is disabled
+  const double* soften;
+  const double* stretchStrength;
+  // Outputs, the bend angle and orientation are in radians
+  double* bendAngle;
+  double* orientationX;
+  double* orientationY;
+  double* orientationZ;
+  double* stretchedEdgeA;
+  double* stretchedEdgeB;
+};
+
+// Owning storage for a batch, reused between solves so resizing only allocates when the batch grows
+struct TwoBoneIKBatchBuffers
+{
+  std::vector<double> targetX, targetY, targetZ;
+  std::vector<double> poleX, poleY, poleZ;
+  std::vector<double> edgeA, edgeB, twist, soften, stretchStrength;
+  std::vector<double> bendAngle, orientationX, orientationY, orientationZ, stretchedEdgeA, stretchedEdgeB;
+
+  void resize(std::size_t _count)
+  {
+    for (auto* channel : {
+        &targetX, &targetY, &targetZ, &poleX, &poleY, &poleZ, &edgeA, &edgeB, &twist, &soften, &stretchStrength,
+        &bendAngle, &orientationX, &orientationY, &orientationZ, &stretchedEdgeA, &stretchedEdgeB})
+    {
+      channel->resize(_count);
+    }
+  }
+
+  std::size_t size() const { return targetX.size(); }
+
+  TwoBoneIKBatch view()
+  {
+    return {
+      targetX.data(), targetY.data(), targetZ.data(), poleX.data(), poleY.data(), poleZ.data(),
+      edgeA.data(), edgeB.data(), twist.data(), soften.data(), stretchStrength.data(),
+      bendAngle.data(), orientationX.data(), orientationY.data(), orientationZ.data(), stretchedEdgeA.data(), stretchedEdgeB.data()
+    };
+  }
+};
+
+// The limbs from _offset on, so one batch can be split into ranges solved separately.
+// Ranges other than the last should cover whole packs, the tail of each range goes through the padded scratch batch
+inline TwoBoneIKBatch offsetBatch(const TwoBoneIKBatch& _batch, std::size_t _offset)
+{
+  return {
+    _batch.targetX + _offset, _batch.targetY + _offset, _batch.targetZ + _offset,
+    _batch.poleX + _offset, _batch.poleY + _offset, _batch.poleZ + _offset,
+    _batch.edgeA + _offset, _batch.edgeB + _offset, _batch.twist + _offset, _batch.soften + _offset, _batch.stretchStrength + _offset,
+    _batch.bendAngle + _offset, _batch.orientationX + _offset, _batch.orientationY + _offset, _batch.orientationZ + _offset,
+    _batch.stretchedEdgeA + _offset, _batch.stretchedEdgeB + _offset
+  };
+}
+
+// Structure of arrays incline solve, the subset of the limb data used by solveInclineAngle
+struct InclineAngleBatch
+{
+  // Inputs
+  const double* targetX;
+  const double* targetY;
+  const double* targetZ;
+  const double* edgeA;
+  const double* edgeB;
+  // Soften distance, zero when softening is disabled
+  const double* soften;
+  // Output in radians
+  double* inclineAngle;
+};
+
+struct InclineAngleBatchBuffers
+{
+  std::vector<double> targetX, targetY, targetZ, edgeA, edgeB, soften;
+  std::vector<double> inclineAngle;
+
+  void resize(std::size_t _count)
+  {
+    for (auto* channel : {&targetX, &targetY, &targetZ, &edgeA, &edgeB, &soften, &inclineAngle})
+    {
+      channel->resize(_count);
+    }
+  }
+
+  std::size_t size() const { return targetX.size(); }
+
+  InclineAngleBatch view()
+  {
+    return {targetX.data(), targetY.data(), targetZ.data(), edgeA.data(), edgeB.data(), soften.data(), inclineAngle.data()};
+  }
+};
+
+inline InclineAngleBatch offsetBatch(const InclineAngleBatch& _batch, std::size_t _offset)
+{
+  return {
+    _batch.targetX + _offset, _batch.targetY + _offset, _batch.targetZ + _offset,
+    _batch.edgeA + _offset, _batch.edgeB + _offset, _batch.soften + _offset, _batch.inclineAngle + _offset
+  };
+}
+
+// Packed counterparts of the Utils.h helpers
+
+template <typename V>
+inline static V simdPSign(V val)
+{
+  return simdSelect(val < 0.0, simdBroadcast<V>(-1.0), simdBroadcast<V>(1.0));
+}
+
+template <typename V>
+inline static V simdMakeNonZero(V val)
+{
+  return simdMax(simdAbs(val), simdBroadcast<V>(DBL_MIN)) * simdPSign(val);
+}
+
+template <typename V>
+inline static V simdGetAngle(V a, V b, V c)
+{
+  return simdAcos(simdClamp((a * a + b * b - c * c) / (2.0 * a * b), simdBroadcast<V>(-1.0), simdBroadcast<V>(1.0)));
+}
+
+template <typename V>
+inline static V simdSoftenEdge(V hardEdge, V chainLength, V dsoft)
+{
+  const V da = chainLength - dsoft;
+  const V softEdge = da + dsoft * (1.0 - simdExp((da - hardEdge) / dsoft));
+  return simdSelect((hardEdge > da) & (da > 0.0), softEdge, hardEdge);
+}
+
+template <typename V>
+inline static V simdStretchEdge(V hardEdge, V baseEdge, V chainLength, V strength)
+{
+  const V scale = simdMax(simdBroadcast<V>(1.0), baseEdge / chainLength);
+  return ((1.0 - strength) + strength * scale) * hardEdge;
+}
+
+// Solves TWidth limbs starting at the given offset
+template <typename V>
+inline static void solveTwoBoneIKPack(const TwoBoneIKBatch& _batch, std::size_t _offset)
+{
+  // Get the position of our target, with no zero components
+  const V tx = simdMakeNonZero(simdLoad<V>(_batch.targetX + _offset));
+  const V ty = simdMakeNonZero(simdLoad<V>(_batch.targetY + _offset));
+  const V tz = simdMakeNonZero(simdLoad<V>(_batch.targetZ + _offset));
+  const V px = simdLoad<V>(_batch.poleX + _offset);
+  const V py = simdLoad<V>(_batch.poleY + _offset);
+  const V pz = simdLoad<V>(_batch.poleZ + _offset);
+  const V edgeA = simdLoad<V>(_batch.edgeA + _offset);
+  const V edgeB = simdLoad<V>(_batch.edgeB + _offset);
+
+  // Signed distance from the pole to the target line on the xz plane, as distPointToOLine
+  const V targetLengthXZ = simdSqrt(tx * tx + tz * tz);
+  const V d = (tx * pz - tz * px) / targetLengthXZ;
+  // World Y rotation, corrected when x is negative
+  const V worldY = simdSelect(tx < 0.0, simdBroadcast<V>(M_PI), V{}) - simdAtan(tz / tx);
+  V sinY, cosY;
+  simdSinCos(worldY, sinY, cosY);
+  // Normal of the z rotated triangle base, the cross of the target with -Z rotated by worldY
+  const V rx = -sinY;
+  const V rz = -cosY;
+  V nx = ty * rz;
+  V ny = tz * rx - tx * rz;
+  V nz = -ty * rx;
+  const V nLength = simdSqrt(nx * nx + ny * ny + nz * nz);
+  nx = nx / nLength;
+  ny = ny / nLength;
+  nz = nz / nLength;
+  // Relative height of the pole, used to correct the twist for negative heights
+  const V h = simdMakeNonZero((px - tx) * nx + (py - ty) * ny + (pz - tz) * nz);
+  const V twist = simdSelect(h < 0.0, simdBroadcast<V>(M_PI), V{}) + simdAtan(d / h) + simdLoad<V>(_batch.twist + _offset);
+  const V incline = simdAtan(ty / targetLengthXZ);
+
+  // Clamp and soften the dynamic edge
+  const V targetLength = simdSqrt(tx * tx + ty * ty + tz * tz);
+  const V dynamicEdgeC = simdMax(targetLength, edgeA - edgeB);
+  const V chainLength = edgeA + edgeB;
+  const V edgeC = simdSoftenEdge(dynamicEdgeC, chainLength, simdLoad<V>(_batch.soften + _offset));
+
+  simdStore(_batch.bendAngle + _offset, simdGetAngle(edgeA, edgeB, edgeC) + M_PI);
+  const V interior = simdGetAngle(edgeA, edgeC, edgeB);
+
+  // Compose interior Z, then twist X, incline Z and world Y, as row vector matrices
+  V sinA, cosA, sinT, cosT, sinI, cosI;
+  simdSinCos(interior, sinA, cosA);
+  simdSinCos(twist, sinT, cosT);
+  simdSinCos(incline, sinI, cosI);
+  // Rows of incline * worldY
+  const V b00 = cosI * cosY, b01 = sinI, b02 = -cosI * sinY;
+  const V b10 = -sinI * cosY, b11 = cosI, b12 = sinI * sinY;
+  const V b20 = sinY, b22 = cosY;
+  // Rows of twist * incline * worldY, the first row is unchanged
+  const V x10 = cosT * b10 + sinT * b20, x11 = cosT * b11, x12 = cosT * b12 + sinT * b22;
+  const V x22 = -sinT * b12 + cosT * b22;
+  // The interior rotation mixes the first two rows
+  const V m00 = cosA * b00 + sinA * x10;
+  const V m01 = cosA * b01 + sinA * x11;
+  const V m02 = cosA * b02 + sinA * x12;
+  const V m12 = -sinA * b02 + cosA * x12;
+
+  // Decompose to XYZ order
+  simdStore(_batch.orientationX + _offset, simdAtan2(m12, x22));
+  simdStore(_batch.orientationY + _offset, simdAtan2(-m02, simdSqrt(m00 * m00 + m01 * m01)));
+  simdStore(_batch.orientationZ + _offset, simdAtan2(m01, m00));
+
+  const V stretchStrength = simdLoad<V>(_batch.stretchStrength + _offset);
+  simdStore(_batch.stretchedEdgeA + _offset, simdStretchEdge(edgeA, dynamicEdgeC, chainLength, stretchStrength));
+  simdStore(_batch.stretchedEdgeB + _offset, simdStretchEdge(edgeB, dynamicEdgeC, chainLength, stretchStrength));
+}
+
+// Solves TWidth inclines starting at the given offset, as solveInclineAngle
+template <typename V>
+inline static void solveInclineAnglePack(const InclineAngleBatch& _batch, std::size_t _offset)
+{
+  // Get the position of our target, with no zero components
+  const V tx = simdMakeNonZero(simdLoad<V>(_batch.targetX + _offset));
+  const V ty = simdMakeNonZero(simdLoad<V>(_batch.targetY + _offset));
+  const V tz = simdMakeNonZero(simdLoad<V>(_batch.targetZ + _offset));
+  const V edgeA = simdLoad<V>(_batch.edgeA + _offset);
+  const V edgeB = simdLoad<V>(_batch.edgeB + _offset);
+
+  // Clamp and soften the dynamic edge
+  const V dynamicEdgeC = simdMax(simdSqrt(tx * tx + ty * ty + tz * tz), edgeA - edgeB);
+  const V edgeC = simdSoftenEdge(dynamicEdgeC, edgeA + edgeB, simdLoad<V>(_batch.soften + _offset));
+  const V slope = simdClamp(ty / tx, simdBroadcast<V>(-1.0), simdBroadcast<V>(1.0));
+  simdStore(_batch.inclineAngle + _offset, simdGetAngle(edgeA, edgeC, edgeB) + simdAtan(slope));
+}
+
+// Solves _count limbs, the tail that does not fill a pack is copied through a padded scratch batch.
+// Like the pack solves this has internal linkage and calls nothing inline with external linkage, so BatchKernels.cpp
+// can build it once per instruction set into one binary without the linker merging the builds
+template <typename V>
+inline static void solveTwoBoneIKPacks(const TwoBoneIKBatch& _batch, std::size_t _count)
+{
+  constexpr unsigned width = SimdTraits<V>::width;
+  const std::size_t packed = _count - _count % width;
+  for (std::size_t i = 0u; i < packed; i += width)
+  {
+    solveTwoBoneIKPack<V>(_batch, i);
+  }
+
+  const std::size_t tail = _count - packed;
+  if (tail)
+  {
+    // Pad with a valid limb so the unused lanes stay finite
+    double in[11][width];
+    double out[6][width];
+    const double* sources[11] = {
+      _batch.targetX, _batch.targetY, _batch.targetZ, _batch.poleX, _batch.poleY, _batch.poleZ,
+      _batch.edgeA, _batch.edgeB, _batch.twist, _batch.soften, _batch.stretchStrength
+    };
+    for (unsigned c = 0u; c < 11u; ++c)
+    {
+      for (unsigned i = 0u; i < width; ++i) in[c][i] = i < tail ? sources[c][packed + i] : 1.0;
+    }
+
+    const TwoBoneIKBatch scratch = {
+      in[0], in[1], in[2], in[3], in[4], in[5], in[6], in[7], in[8], in[9], in[10],
+      out[0], out[1], out[2], out[3], out[4], out[5]
+    };
+    solveTwoBoneIKPack<V>(scratch, 0u);
+
+    double* destinations[6] = {
+      _batch.bendAngle, _batch.orientationX, _batch.orientationY, _batch.orientationZ, _batch.stretchedEdgeA, _batch.stretchedEdgeB
+    };
+    for (unsigned c = 0u; c < 6u; ++c)
+    {
+      for (std::size_t i = 0u; i < tail; ++i) destinations[c][packed + i] = out[c][i];
+    }
+  }
+}
+
+template <typename V>
+inline static void solveInclineAnglePacks(const InclineAngleBatch& _batch, std::size_t _count)
+{
+  constexpr unsigned width = SimdTraits<V>::width;
+  const std::size_t packed = _count - _count % width;
+  for (std::size_t i = 0u; i < packed; i += width)
+  {
+    solveInclineAnglePack<V>(_batch, i);
+  }
+
+  const std::size_t tail = _count - packed;
+  if (tail)
+  {
+    // Pad with a valid limb so the unused lanes stay finite
+    double in[6][width];
+    double out[width];
+    const double* sources[6] = {_batch.targetX, _batch.targetY, _batch.targetZ, _batch.edgeA, _batch.edgeB, _batch.soften};
+    for (unsigned c = 0u; c < 6u; ++c)
+    {
+      for (unsigned i = 0u; i < width; ++i) in[c][i] = i < tail ? sources[c][packed + i] : 1.0;
+    }
+
+    const InclineAngleBatch scratch = {in[0], in[1], in[2], in[3], in[4], in[5], out};
+    solveInclineAnglePack<V>(scratch, 0u);
+    for (std::size_t i = 0u; i < tail; ++i) _batch.inclineAngle[packed + i] = out[i];
+  }
+}
+
+template <unsigned TWidth = kTwoBoneIKBatchWidth>
+inline void solveTwoBoneIKBatch(const TwoBoneIKBatch& _batch, std::size_t _count)
+{
+  solveTwoBoneIKPacks<typename SimdPack<TWidth>::Real>(_batch, _count);
+}
+
+template <unsigned TWidth = kTwoBoneIKBatchWidth>
+inline void solveInclineAngleBatch(const InclineAngleBatch& _batch, std::size_t _count)
+{
+  solveInclineAnglePacks<typename SimdPack<TWidth>::Real>(_batch, _count);
+}
+
+#endif //TWOBONEIKBATCH_INCLUDE_H
@@ -0,0 +1,78 @@
+#ifndef TWOBONEIKPARALLEL_INCLUDE_H
+#define TWOBONEIKPARALLEL_INCLUDE_H
+
+#include "TwoBoneIKBatch.h"
+#include "BatchDispatch.h"
+#include "ThreadPool.h"
+
+// Multi threaded batch solves, for crowds of tens to hundreds of thousands of limbs.
+// The limbs are cut into cache sized chunks that the pool threads share out by work stealing,
+// every chunk is a whole number of packs, so each limb is solved exactly as by the single threaded solve
+// and the output is bitwise identical whatever the number of threads. Nothing is allocated per solve.
+
+// Limbs per chunk, 136 KB of two bone limb data, which stays within a per core L2
+static constexpr std::size_t kBatchChunkSize = 1024u;
+
+// Pool the plugin nodes split their batches over, created by the first call with _threads threads, which the nodes
+// take from the threads maya evaluates with rather than the hardware, so a session limited to fewer threads is not
+// oversubscribed. Later calls get the same pool. Headless tools size their own ThreadPool
+inline ThreadPool& pluginThreadPool(int _threads)
+{
+  static ThreadPool pool(unsigned(std::max(_threads, 1)));
+  return pool;
+}
+
+// Rounds a chunk size to whole packs
+inline std::size_t batchChunkSize(std::size_t _chunk, unsigned _width)
+{
+  return std::max<std::size_t>((_chunk + _width - 1u) / _width * _width, _width);
+}
+
+template <unsigned TWidth>
+inline std::size_t batchChunkSize(std::size_t _chunk)
+{
+  return batchChunkSize(_chunk, TWidth);
+}
+
+template <unsigned TWidth = kTwoBoneIKBatchWidth>
+inline void solveTwoBoneIKBatchParallel(
+    const TwoBoneIKBatch& _batch, std::size_t _count, ThreadPool& io_pool, std::size_t _chunk = kBatchChunkSize)
+{
+  io_pool.parallelFor(_count, batchChunkSize<TWidth>(_chunk), [&_batch](std::size_t _begin, std::size_t _end)
+  {
+    solveTwoBoneIKBatch<TWidth>(offsetBatch(_batch, _begin), _end - _begin);
+  });
+}
+
+template <unsigned TWidth = kTwoBoneIKBatchWidth>
+inline void solveInclineAngleBatchParallel(
+    const InclineAngleBatch& _batch, std::size_t _count, ThreadPool& io_pool, std::size_t _chunk = kBatchChunkSize)
+{
+  io_pool.parallelFor(_count, batchChunkSize<TWidth>(_chunk), [&_batch](std::size_t _begin, std::size_t _end)
+  {
+    solveInclineAngleBatch<TWidth>(offsetBatch(_batch, _begin), _end - _begin);
+  });
+}
+
+// Solves through the kernels BatchDispatch picked for this cpu, the overloads callers get without a width
+inline void solveTwoBoneIKBatchParallel(
+    const TwoBoneIKBatch& _batch, std::size_t _count, ThreadPool& io_pool, std::size_t _chunk = kBatchChunkSize)
+{
+  const BatchKernels& kernels = BatchDispatch::kernels();
+  io_pool.parallelFor(_count, batchChunkSize(_chunk, kernels.width), [&_batch, &kernels](std::size_t _begin, std::size_t _end)
+  {
+    kernels.solveTwoBoneIK(offsetBatch(_batch, _begin), _end - _begin);
+  });
+}
+
+inline void solveInclineAngleBatchParallel(
+    const InclineAngleBatch& _batch, std::size_t _count, ThreadPool& io_pool, std::size_t _chunk = kBatchChunkSize)
+{
+  const BatchKernels& kernels = BatchDispatch::kernels();
+  io_pool.parallelFor(_count, batchChunkSize(_chunk, kernels.width), [&_batch, &kernels](std::size_t _begin, std::size_t _end)
+  {
+    kernels.solveInclineAngle(offsetBatch(_batch, _begin), _end - _begin);
+  });
+}
+
+#endif //TWOBONEIKPARALLEL_INCLUDE_H
@@ -0,0 +1,413 @@
+#ifndef TWOBONEIKSOLVER_INCLUDE_H
+#define TWOBONEIKSOLVER_INCLUDE_H
+
+#include "SolverMath.h"
+
+// The outputs of a single solved two bone limb
+template <typename T>
+struct TwoBoneIKSolution
+{
+  T bendAngle;
+  EulerRotation<T> orientation;
+  T stretchedEdgeA;
+  T stretchedEdgeB;
+};
+
+// The base edge of the limb triangle, shared by every output
+template <typename T>
+struct TwoBoneIKEdges
+{
+  // Distance to the target, clamped into the reachable range
+  T dynamicEdgeC;
+  // The dynamic edge after softening
+  T edgeC;
+};
+
+// Features of a limb that most rigs leave constant. Every stage and the full solve can be specialized on a mask of
+// the features a limb uses, which compiles out the math of the others, see twoBoneIKFeatures for when a limb may
+// drop a feature and dispatchTwoBoneIKFeatures to pick the specialization at runtime
+enum TwoBoneIKFeatures : unsigned
+{
+  // A soften distance, without one softening reduces to clamping the base edge to the chain
+  kFeatureSoften = 1u,
+  // A stretch strength, without one the edges keep their length
+  kFeatureStretch = 2u,
+  // An extra twist, without one no sin or cos is taken for it
+  kFeatureTwist = 4u,
+  // A pole vector, without one the frame orientation aims its up vector at world Y straight away
+  kFeaturePole = 8u,
+  kAllFeatures = 15u
+};
+
+// The features a limb needs to solve as the general solve does, zero or negative zero inputs drop their feature.
+// Stretching is kept for chains with no length, as their stretch divides by zero
+template <typename T>
+inline unsigned twoBoneIKFeatures(const Vector3<T>& _poleVector, T edgeA, T edgeB, T extraTwist, T dsoft, T stretchStrength)
+{
+  return (dsoft != T(0) ? kFeatureSoften : 0u) |
+    (stretchStrength != T(0) || !(edgeA + edgeB > T(0)) ? kFeatureStretch : 0u) |
+    (extraTwist != T(0) ? kFeatureTwist : 0u) |
+    (_poleVector * _poleVector != T(0) ? kFeaturePole : 0u);
+}
+
+// Calls _solver.template solve<TFeatures>() with TFeatures the given mask, so the mask is only tested once
+template <typename TSolver>
+inline auto dispatchTwoBoneIKFeatures(unsigned _features, TSolver& _solver) -> decltype(_solver.template solve<kAllFeatures>())
+{
+  switch (_features & kAllFeatures)
+  {
+#define TWOBONEIK_FEATURES_CASE(F) case F: return _solver.template solve<F>();
+    TWOBONEIK_FEATURES_CASE(0u) TWOBONEIK_FEATURES_CASE(1u) TWOBONEIK_FEATURES_CASE(2u) TWOBONEIK_FEATURES_CASE(3u)
+    TWOBONEIK_FEATURES_CASE(4u) TWOBONEIK_FEATURES_CASE(5u) TWOBONEIK_FEATURES_CASE(6u) TWOBONEIK_FEATURES_CASE(7u)
+    TWOBONEIK_FEATURES_CASE(8u) TWOBONEIK_FEATURES_CASE(9u) TWOBONEIK_FEATURES_CASE(10u) TWOBONEIK_FEATURES_CASE(11u)
+    TWOBONEIK_FEATURES_CASE(12u) TWOBONEIK_FEATURES_CASE(13u) TWOBONEIK_FEATURES_CASE(14u)
+#undef TWOBONEIK_FEATURES_CASE
+    default: return _solver.template solve<kAllFeatures>();
+  }
+}
+
+// The stages below let callers solve a single output, they all expect a target with no zero components.
+// Those using transcendentals take a math policy from ApproxMath.h, so background limbs can trade accuracy for speed.
+
+template <typename T>
+inline T solveDynamicEdge(const Vector3<T>& targetLocation, T edgeA, T edgeB)
+{
+  return std::max(targetLocation.length(), edgeA - edgeB);
+}
+
+template <typename T, typename TMath = ExactMath, unsigned TFeatures = kAllFeatures>
+inline TwoBoneIKEdges<T> solveTwoBoneIKEdges(const Vector3<T>& targetLocation, T edgeA, T edgeB, T dsoft)
+{
+  TwoBoneIKEdges<T> edges;
+  // Get our dynamic edge length and clamp it into our acceptable range
+  edges.dynamicEdgeC = solveDynamicEdge(targetLocation, edgeA, edgeB);
+  // Soften our dynamic edge if required, with no soften distance softenEdge gives the chain length past it
+  const auto chainLength = edgeA + edgeB;
+  edges.edgeC = (TFeatures & kFeatureSoften) ? softenEdge<T, TMath>(edges.dynamicEdgeC, chainLength, dsoft) :
+    (edges.dynamicEdgeC > chainLength && chainLength > T(0) ? chainLength : edges.dynamicEdgeC);
+  return edges;
+}
+
+// The stretched edge, which is the edge itself without a stretch strength
+template <typename T, unsigned TFeatures = kAllFeatures>
+inline T solveStretchedEdge(T edge, T dynamicEdgeC, T chainLength, T stretchStrength)
+{
+  return (TFeatures & kFeatureStretch) ? stretchEdge(edge, dynamicEdgeC, chainLength, stretchStrength) : edge;
+}
+
+template <typename T, typename TMath = ExactMath>
+inline T solveBendAngle(T edgeA, T edgeB, T edgeC)
+{
+  // Use the law of cosines to calculate interior bend angle of the triangle
+  // We add pi to get the obtuse complement angle
+  return getAngle<T, TMath>(edgeA, edgeB, edgeC) + T(M_PI);
+}
+
+// TFeatures drops the twist and pole math, with no pole the twist is only the pi correction for the sign of h
+template <typename T, unsigned TFeatures = kAllFeatures>
+inline EulerRotation<T> solveRootOrientation(
+    const Vector3<T>& targetLocation,
+    const Vector3<T>& _poleVector,
+    T edgeA,
+    T edgeB,
+    T edgeC,
+    T extraTwist)
+{
+  // Calculate the world, exterior y rotation, when x is negative we do 180 - angle
+  const auto worldY = T(M_PI) * (targetLocation.x < 0) - std::atan(targetLocation.z / targetLocation.x);
+  // We use the Z as a start vector, and rotate it with the arm so that it remains relative,
+  // it is then used to get the normal to our z rotated triangle base
+  const auto rotatedZ = Vector3<T>(0.0, 0.0, -1.0).rotateBy(Vector3<T>::kYaxis, worldY);
+  // This is a cross product
+  const auto N = (targetLocation ^ rotatedZ).normal();
+  // Dot product the vector from our pole to the target, to get the relative height of the pole
+  const auto h = makeNonZero(((TFeatures & kFeaturePole) ? _poleVector - targetLocation : -targetLocation) * N);
+  // Twist is essentially now a rotated version of atan(Y/X),
+  // we correct using +180 for negative heights
+  auto twist = T(M_PI) * (h < 0);
+  if (TFeatures & kFeaturePole)
+  {
+    // Calculate the distance from our pole vector to the target (on the xz plane)
+    twist += std::atan(distPointToOLine<T>({_poleVector.x, _poleVector.z}, {targetLocation.x, targetLocation.z}) / h);
+  }
+  if (TFeatures & kFeatureTwist) twist += extraTwist;
+
+  // Using law of cosines to get the interior angle of the triangle, this is the interior Z rotation
+  EulerRotation<T> rot(0.0, 0.0, getAngle(edgeA, edgeC, edgeB), EulerRotation<T>::kZXY);
+  {
+    // Get the rotated base edge length of the triangle
+    const auto hypot = std::sqrt(sqr(targetLocation.x) + sqr(targetLocation.z));
+    // This rotation is the twist, height adjustment and the Y rotation
+    const EulerRotation<T> exterior(
+        // Apply our twist as x rotation
+        twist, 
+        // The world Y rotation, corrected for each quadrant
+        worldY,
+        // This angle needs to have an incline based on the targetLocation.y of the locator
+        std::atan(targetLocation.y / hypot), 
+        // We need to apply our Z rotation first, as the Y rotation affects the plane on which it is applied
+        EulerRotation<T>::kXZY
+        );
+
+    // Multiply so that the interior Z rotation comes first
+    rot *= exterior;
+  }
+  // Reorder the rotations to the standard maya convention
+  rot.reorderIt(EulerRotation<T>::kXYZ);
+  return rot;
+}
+
+// The cosine and sine of the direction of (x, y), scaled by the larger component first so tiny vectors do not underflow
+template <typename T>
+inline void polarDirection(T x, T y, T& o_cos, T& o_sin)
+{
+  const auto largest = std::max(std::abs(x), std::abs(y));
+  x /= largest;
+  y /= largest;
+  const auto length = std::sqrt(sqr(x) + sqr(y));
+  o_cos = x / length;
+  o_sin = y / length;
+}
+
+// The root orientation as a rotation matrix, whose rows are the rotated basis vectors.
+// This is the same rotation as solveRootOrientation, but the sines and cosines of the world Y, incline, twist and
+// interior angles all follow algebraically from the target and pole, so no angle is formed and no euler rotation is
+// composed or reordered, only a non zero extra twist needs a sin and cos.
+template <typename T, typename TMath = ExactMath, unsigned TFeatures = kAllFeatures>
+inline Matrix3<T> solveRootMatrix(
+    const Vector3<T>& targetLocation,
+    const Vector3<T>& _poleVector,
+    T edgeA,
+    T edgeB,
+    T edgeC,
+    T extraTwist)
+{
+  // World Y rotation from the target on the xz plane, the quadrant correction is implied by the signs,
+  // and the incline from the target height
+  T cosY, sinY, cosI, sinI;
+  const auto hypotSq = sqr(targetLocation.x) + sqr(targetLocation.z);
+  if (hypotSq > std::numeric_limits<T>::min() / std::numeric_limits<T>::epsilon())
+  {
+    const auto hypot = std::sqrt(hypotSq);
+    const auto targetLength = std::sqrt(hypotSq + sqr(targetLocation.y));
+    cosY = targetLocation.x / hypot;
+    sinY = -targetLocation.z / hypot;
+    cosI = hypot / targetLength;
+    sinI = targetLocation.y / targetLength;
+  }
+  else
+  {
+    // Targets on the Y axis, makeNonZero leaves their x and z so small that the squares underflow.
+    // They aim straight up or down as in solveRootOrientation, only the world Y rotation needs their direction
+    polarDirection(targetLocation.x, -targetLocation.z, cosY, sinY);
+    cosI = T(0);
+    sinI = T(psign(targetLocation.y));
+  }
+  // The incline and world Y rotations take x to the target direction, y to the triangle normal used by
+  // solveRootOrientation, and z to the horizontal side vector
+  const Vector3<T> aim(cosI * cosY, sinI, -cosI * sinY);
+  const Vector3<T> up(-sinI * cosY, cosI, sinI * sinY);
+  const Vector3<T> side(sinY, T(0), cosY);
+
+  // The pole offset along the side and up vectors, as the d and h of solveRootOrientation
+  const auto d = _poleVector * side;
+  const auto h = makeNonZero((_poleVector - targetLocation) * up);
+  // Twist is atan(d/h), corrected by pi for negative heights, which is the direction of (h, d)
+  const auto r = std::sqrt(sqr(d) + sqr(h));
+  auto cosT = h / r;
+  auto sinT = d / r;
+  if ((TFeatures & kFeatureTwist) && extraTwist != T(0))
+  {
+    T sinE, cosE;
+    TMath::sincos(extraTwist, sinE, cosE);
+    const auto c = cosT * cosE - sinT * sinE;
+    sinT = sinT * cosE + cosT * sinE;
+    cosT = c;
+  }
+  const auto twistedUp = up * cosT + side * sinT;
+  const auto twistedSide = side * cosT - up * sinT;
+
+  // The interior angle from the law of cosines, as getAngle
+  const auto cosA = clamp((sqr(edgeA) + sqr(edgeC) - sqr(edgeB)) / (T(2) * edgeA * edgeC), T(-1.0), T(1.0));
+  const auto sinA = std::sqrt(T(1) - sqr(cosA));
+  const auto row0 = aim * cosA + twistedUp * sinA;
+  const auto row1 = twistedUp * cosA - aim * sinA;
+
+  Matrix3<T> out;
+  const Vector3<T>* rows[3] = {&row0, &row1, &twistedSide};
+  for (int i = 0; i < 3; ++i)
+  {
+    out.m[i][0] = rows[i]->x;
+    out.m[i][1] = rows[i]->y;
+    out.m[i][2] = rows[i]->z;
+  }
+  return out;
+}
+
+// How the root orientation is constructed
+enum TwoBoneIKOrientationMethod
+{
+  // From the world Y, incline and twist angles, as the original solve
+  kOrientationAngles = 0,
+  // Straight from the aim and pole directions, see solveRootFrame
+  kOrientationFrame = 1
+};
+
+// The root orientation as a rotation matrix, built from the aim and pole directions without forming any angle.
+// The twisted up vector is the pole projected onto the plane perpendicular to the aim, which is the direction
+// solveRootMatrix reaches through the twist angle, so there are no quadrant corrections and no makeNonZero clamping.
+// Only a non zero extra twist needs a sin and cos, the interior angle comes from the law of cosines without acos.
+// Degenerate inputs fall back deterministically, a target at the root aims down X, and a pole on the aim line
+// gives the untwisted frame whose up vector is world Y projected off the aim, or -X when aiming along Y.
+template <typename T, typename TMath = ExactMath, unsigned TFeatures = kAllFeatures>
+inline Matrix3<T> solveRootFrame(
+    const Vector3<T>& _targetLocation,
+    const Vector3<T>& _poleVector,
+    T edgeA,
+    T edgeB,
+    T edgeC,
+    T extraTwist)
+{
+  static constexpr T epsilonSq = std::numeric_limits<T>::epsilon() * std::numeric_limits<T>::epsilon();
+  const auto targetLengthSq = _targetLocation * _targetLocation;
+  const auto aim = targetLengthSq > T(0) ? _targetLocation * (T(1) / std::sqrt(targetLengthSq)) : Vector3<T>(1, 0, 0);
+
+  // Remove the aim component of the pole, falling back when nothing is left, as is always the case with no pole
+  auto perpendicular = [&aim](const Vector3<T>& _v) { return _v - aim * (_v * aim); };
+  auto up = (TFeatures & kFeaturePole) ? perpendicular(_poleVector) : Vector3<T>(0, 0, 0);
+  auto upLengthSq = up * up;
+  if (!(TFeatures & kFeaturePole) || !(upLengthSq > epsilonSq * (_poleVector * _poleVector)))
+  {
+    up = perpendicular(Vector3<T>(0, 1, 0));
+    upLengthSq = up * up;
+    if (!(upLengthSq > epsilonSq))
+    {
+      up = perpendicular(Vector3<T>(-1, 0, 0));
+      upLengthSq = up * up;
+    }
+  }
+  up = up * (T(1) / std::sqrt(upLengthSq));
+  auto side = aim ^ up;
+  if ((TFeatures & kFeatureTwist) && extraTwist != T(0))
+  {
+    T sinE, cosE;
+    TMath::sincos(extraTwist, sinE, cosE);
+    const auto twistedUp = up * cosE + side * sinE;
+    side = side * cosE - up * sinE;
+    up = twistedUp;
+  }
+
+  // The interior angle from the law of cosines, as getAngle
+  const auto cosA = clamp((sqr(edgeA) + sqr(edgeC) - sqr(edgeB)) / (T(2) * edgeA * edgeC), T(-1.0), T(1.0));
+  const auto sinA = std::sqrt(T(1) - sqr(cosA));
+  const auto row0 = aim * cosA + up * sinA;
+  const auto row1 = up * cosA - aim * sinA;
+
+  Matrix3<T> out;
+  const Vector3<T>* rows[3] = {&row0, &row1, &side};
+  for (int i = 0; i < 3; ++i)
+  {
+    out.m[i][0] = rows[i]->x;
+    out.m[i][1] = rows[i]->y;
+    out.m[i][2] = rows[i]->z;
+  }
+  return out;
+}
+
+// Decomposes a root matrix to the XYZ euler rotation solveRootOrientation would give,
+// away from the +-90 degree Y gimbal singularity where the angles are not unique
+template <typename T, typename TMath = ExactMath>
+inline EulerRotation<T> solveRootEuler(const Matrix3<T>& _matrix)
+{
+  const auto& m = _matrix.m;
+  return EulerRotation<T>(
+      TMath::atan2(m[1][2], m[2][2]),
+      TMath::atan2(-m[0][2], std::sqrt(sqr(m[0][0]) + sqr(m[0][1]))),
+      TMath::atan2(m[0][1], m[0][0]));
+}
+
+// The root orientation using the given math policy, the exact policy keeps the original euler composition,
+// the approximate ones decompose the root matrix as that only needs three atan2
+template <typename T, typename TMath = ExactMath, unsigned TFeatures = kAllFeatures>
+inline EulerRotation<T> solveRootOrientation(
+    const Vector3<T>& targetLocation,
+    const Vector3<T>& _poleVector,
+    T edgeA,
+    T edgeB,
+    T edgeC,
+    T extraTwist,
+    TMath)
+{
+  if (std::is_same<TMath, ExactMath>::value)
+  {
+    return solveRootOrientation<T, TFeatures>(targetLocation, _poleVector, edgeA, edgeB, edgeC, extraTwist);
+  }
+  return solveRootEuler<T, TMath>(solveRootMatrix<T, TMath, TFeatures>(targetLocation, _poleVector, edgeA, edgeB, edgeC, extraTwist));
+}
+
+// Solves one two bone limb, this has no maya dependency so it can also run headless
+// dsoft is the soften distance, already zeroed when softening is disabled.
+// TFeatures drops the math of unused features, the limb must not need any feature it leaves out
+template <typename T, typename TMath = ExactMath, unsigned TFeatures = kAllFeatures>
+inline TwoBoneIKSolution<T> solveTwoBoneIK(
+    const Vector3<T>& _targetLocation, 
+    const Vector3<T>& _poleVector, 
+    T edgeA, 
+    T edgeB, 
+    T extraTwist, 
+    T dsoft, 
+    T stretchStrength,
+    TwoBoneIKOrientationMethod _method = kOrientationAngles)
+{
+  // Get the position of our target, with no zero components, the frame method does not need them clamped
+  const auto targetLocation = _method == kOrientationFrame ? _targetLocation : makeNonZero<T>(_targetLocation);
+  const auto edges = solveTwoBoneIKEdges<T, TMath, TFeatures>(targetLocation, edgeA, edgeB, dsoft);
+  const auto chainLength = edgeA + edgeB;
+
+  TwoBoneIKSolution<T> solution;
+  solution.bendAngle = solveBendAngle<T, TMath>(edgeA, edgeB, edges.edgeC);
+  solution.orientation = _method == kOrientationFrame ?
+    solveRootEuler<T, TMath>(solveRootFrame<T, TMath, TFeatures>(targetLocation, _poleVector, edgeA, edgeB, edges.edgeC, extraTwist)) :
+    solveRootOrientation<T, TMath, TFeatures>(targetLocation, _poleVector, edgeA, edgeB, edges.edgeC, extraTwist, TMath());
+  solution.stretchedEdgeA = solveStretchedEdge<T, TFeatures>(edgeA, edges.dynamicEdgeC, chainLength, stretchStrength);
+  solution.stretchedEdgeB = solveStretchedEdge<T, TFeatures>(edgeB, edges.dynamicEdgeC, chainLength, stretchStrength);
+  return solution;
+}
+
+// The arguments of solveTwoBoneIK, for dispatchTwoBoneIKFeatures
+template <typename T, typename TMath = ExactMath>
+struct TwoBoneIKFeatureSolve
+{
+  const Vector3<T>& targetLocation;
+  const Vector3<T>& poleVector;
+  T edgeA;
+  T edgeB;
+  T extraTwist;
+  T dsoft;
+  T stretchStrength;
+  TwoBoneIKOrientationMethod method;
+
+  template <unsigned TFeatures>
+  TwoBoneIKSolution<T> solve() const
+  {
+    return solveTwoBoneIK<T, TMath, TFeatures>(targetLocation, poleVector, edgeA, edgeB, extraTwist, dsoft, stretchStrength, method);
+  }
+};
+
+// solveTwoBoneIK specialized on the features this limb uses
+template <typename T, typename TMath = ExactMath>
+inline TwoBoneIKSolution<T> solveTwoBoneIKFeatures(
+    const Vector3<T>& _targetLocation,
+    const Vector3<T>& _poleVector,
+    T edgeA,
+    T edgeB,
+    T extraTwist,
+    T dsoft,
+    T stretchStrength,
+    TwoBoneIKOrientationMethod _method = kOrientationAngles)
+{
+  const TwoBoneIKFeatureSolve<T, TMath> solver = {_targetLocation, _poleVector, edgeA, edgeB, extraTwist, dsoft, stretchStrength, _method};
+  return dispatchTwoBoneIKFeatures(twoBoneIKFeatures(_poleVector, edgeA, edgeB, extraTwist, dsoft, stretchStrength), solver);
+}
+
+#endif //TWOBONEIKSOLVER_INCLUDE_H
@@ -6,6 +6,7 @@
 #define SIMPLEIKUTILS_INCLUDE_H
 
 #include <cmath>
+#include <cstring>
 #include <string>
 #include <type_traits>
 #include <vector>
@@ -18,6 +19,7 @@
 #include <maya/MMatrix.h>
 #include <maya/MFnCompoundAttribute.h>
 #include <maya/MFnDependencyNode.h>
+#include <maya/MFnEnumAttribute.h>
 #include <maya/MFnMatrixAttribute.h>
 #include <maya/MFnNumericAttribute.h>
 #include <maya/MFnUnitAttribute.h>
@@ -25,6 +27,8 @@
 #include <maya/MVector.h>
 #include <maya/MQuaternion.h>
 
+#include "SolverMath.h"
+
 #define TEMPLATE_PARAMETER_LINKAGE extern constexpr
 
 struct Attribute
@@ -245,6 +249,20 @@ inline void createAttribute(Attribute& attr, const char* name, const MEulerRotat
     attrFn.setUsesArrayDataBuilder(isArray);
 }
 
+// Enum attributes are created from their field names, with values counting up from zero
+inline void createEnumAttribute(Attribute& attr, const char* name, const std::vector<const char*>& fields, short value = 0, bool isInput = true)
+{
+    MFnEnumAttribute attrFn;
+    attr.attr = attrFn.create(name, name, value);
+    for (std::size_t i = 0; i < fields.size(); ++i)
+    {
+        attrFn.addField(fields[i], short(i));
+    }
+    attrFn.setKeyable(isInput);
+    attrFn.setStorable(isInput);
+    attrFn.setWritable(isInput);
+}
+
 inline void createCompoundAttribute(Attribute& attr, const std::vector<Attribute>& children, const char* name, bool isInput = true, bool isArray = false)
 {
     MFnCompoundAttribute cAttrFn;
@@ -269,43 +287,122 @@ inline TType getAttribute(MDataBlock& dataBlock, const Attribute& attribute);
 template <typename TType>
 inline TType getAttribute(MDataBlock& dataBlock, const Attribute& attribute, const Attribute& childAttribute);
 
+// Reads and writes of one array element, shared by the array attribute I/O
+template <typename TType>
+inline TType getElement(MDataHandle handle, const Attribute& attribute);
+
 template <>
-inline double getAttribute(MDataBlock& dataBlock, const Attribute& attribute)
+inline double getElement(MDataHandle handle, const Attribute&)
 {
-    MDataHandle handle = dataBlock.inputValue(attribute);
     return handle.asDouble();
 }
 
 template <>
-inline std::vector<double> getAttribute(MDataBlock& dataBlock, const Attribute& attribute)
+inline int getElement(MDataHandle handle, const Attribute&)
+{
+    return handle.asInt();
+}
+
+template <>
+inline MAngle getElement(MDataHandle handle, const Attribute&)
+{
+    return handle.asAngle();
+}
+
+template <>
+inline MVector getElement(MDataHandle handle, const Attribute&)
+{
+    return handle.asVector();
+}
+
+template <>
+inline MMatrix getElement(MDataHandle handle, const Attribute&)
+{
+    return handle.asMatrix();
+}
+
+template <>
+inline MEulerRotation getElement(MDataHandle handle, const Attribute& attribute)
+{
+    const double x = handle.child(attribute.attrX).asAngle().asRadians();
+    const double y = handle.child(attribute.attrY).asAngle().asRadians();
+    const double z = handle.child(attribute.attrZ).asAngle().asRadians();
+    
+    return MEulerRotation(x, y, z);
+}
+
+template <>
+inline MQuaternion getElement(MDataHandle handle, const Attribute& attribute)
+{
+    const double x = handle.child(attribute.attrX).asDouble();
+    const double y = handle.child(attribute.attrY).asDouble();
+    const double z = handle.child(attribute.attrZ).asDouble();
+    const double w = handle.child(attribute.attrW).asDouble();
+    
+    return MQuaternion(x, y, z, w);
+}
+
+template <typename TType>
+inline void setElement(MDataHandle handle, const Attribute&, const TType& value)
+{
+    handle.set(value);
+}
+
+template <>
+inline void setElement(MDataHandle handle, const Attribute& attribute, const MEulerRotation& value)
+{
+    handle.child(attribute.attrX).set(MAngle(value.x));
+    handle.child(attribute.attrY).set(MAngle(value.y));
+    handle.child(attribute.attrZ).set(MAngle(value.z));
+}
+
+// Reads an array into o_values, reusing its allocation, so a node that keeps the buffer does not allocate per compute
+template <typename TType>
+inline void getAttribute(MDataBlock& dataBlock, const Attribute& attribute, std::vector<TType>& o_values)
 {
-    std::vector<double> out;
     MArrayDataHandle arrayHandle = dataBlock.inputArrayValue(attribute);
     
-    out.resize(arrayHandle.elementCount());
-    for (unsigned index = 0u; index < arrayHandle.elementCount(); ++index)
+    o_values.resize(arrayHandle.elementCount());
+    for (auto& value : o_values)
     {
-        out[index] = arrayHandle.inputValue().asDouble();
+        value = getElement<TType>(arrayHandle.inputValue(), attribute);
         arrayHandle.next();
     }
-    
-    return out;
 }
 
-template <>
-inline std::vector<double> getAttribute(MDataBlock& dataBlock, const Attribute& attribute, const Attribute& childAttribute)
+template <typename TType>
+inline void getAttribute(MDataBlock& dataBlock, const Attribute& attribute, const Attribute& childAttribute, std::vector<TType>& o_values)
 {
-    std::vector<double> out;
     MArrayDataHandle arrayHandle = dataBlock.inputArrayValue(attribute);
     
-    out.resize(arrayHandle.elementCount());
-    for (unsigned index = 0u; index < arrayHandle.elementCount(); ++index)
+    o_values.resize(arrayHandle.elementCount());
+    for (auto& value : o_values)
     {
-        MDataHandle handle = arrayHandle.inputValue();
-        out[index] = handle.child(childAttribute).asDouble();
+        value = getElement<TType>(arrayHandle.inputValue().child(childAttribute), childAttribute);
         arrayHandle.next();
     }
-    
+}
+
+template <>
+inline double getAttribute(MDataBlock& dataBlock, const Attribute& attribute)
+{
+    MDataHandle handle = dataBlock.inputValue(attribute);
+    return handle.asDouble();
+}
+
+template <>
+inline std::vector<double> getAttribute(MDataBlock& dataBlock, const Attribute& attribute)
+{
+    std::vector<double> out;
+    getAttribute(dataBlock, attribute, out);
+    return out;
+}
+
+template <>
+inline std::vector<double> getAttribute(MDataBlock& dataBlock, const Attribute& attribute, const Attribute& childAttribute)
+{
+    std::vector<double> out;
+    getAttribute(dataBlock, attribute, childAttribute, out);
     return out;
 }
 
@@ -320,15 +417,7 @@ template <>
 inline std::vector<int> getAttribute(MDataBlock& dataBlock, const Attribute& attribute)
 {
     std::vector<int> out;
-    MArrayDataHandle arrayHandle = dataBlock.inputArrayValue(attribute);
-    
-    out.resize(arrayHandle.elementCount());
-    for (unsigned index = 0u; index < arrayHandle.elementCount(); ++index)
-    {
-        out[index] = arrayHandle.inputValue().asInt();
-        arrayHandle.next();
-    }
-    
+    getAttribute(dataBlock, attribute, out);
     return out;
 }
 
@@ -336,16 +425,7 @@ template <>
 inline std::vector<int> getAttribute(MDataBlock& dataBlock, const Attribute& attribute, const Attribute& childAttribute)
 {
     std::vector<int> out;
-    MArrayDataHandle arrayHandle = dataBlock.inputArrayValue(attribute);
-    
-    out.resize(arrayHandle.elementCount());
-    for (unsigned index = 0u; index < arrayHandle.elementCount(); ++index)
-    {
-        MDataHandle handle = arrayHandle.inputValue();
-        out[index] = handle.child(childAttribute).asInt();
-        arrayHandle.next();
-    }
-    
+    getAttribute(dataBlock, attribute, childAttribute, out);
     return out;
 }
 
@@ -356,6 +436,13 @@ inline bool getAttribute(MDataBlock& dataBlock, const Attribute& attribute)
     return handle.asBool();
 }
 
+template <>
+inline short getAttribute(MDataBlock& dataBlock, const Attribute& attribute)
+{
+    MDataHandle handle = dataBlock.inputValue(attribute);
+    return handle.asShort();
+}
+
 template <>
 inline MAngle getAttribute(MDataBlock& dataBlock, const Attribute& attribute)
 {
@@ -367,15 +454,7 @@ template <>
 inline std::vector<MAngle> getAttribute(MDataBlock& dataBlock, const Attribute& attribute)
 {
     std::vector<MAngle> out;
-    MArrayDataHandle arrayHandle = dataBlock.inputArrayValue(attribute);
-    
-    out.resize(arrayHandle.elementCount());
-    for (unsigned index = 0u; index < arrayHandle.elementCount(); ++index)
-    {
-        out[index] = arrayHandle.inputValue().asAngle();
-        arrayHandle.next();
-    }
-    
+    getAttribute(dataBlock, attribute, out);
     return out;
 }
 
@@ -383,16 +462,7 @@ template <>
 inline std::vector<MAngle> getAttribute(MDataBlock& dataBlock, const Attribute& attribute, const Attribute& childAttribute)
 {
     std::vector<MAngle> out;
-    MArrayDataHandle arrayHandle = dataBlock.inputArrayValue(attribute);
-    
-    out.resize(arrayHandle.elementCount());
-    for (unsigned index = 0u; index < arrayHandle.elementCount(); ++index)
-    {
-        MDataHandle handle = arrayHandle.inputValue();
-        out[index] = handle.child(childAttribute).asAngle();
-        arrayHandle.next();
-    }
-    
+    getAttribute(dataBlock, attribute, childAttribute, out);
     return out;
 }
 
@@ -407,15 +477,7 @@ template <>
 inline std::vector<MVector> getAttribute(MDataBlock& dataBlock, const Attribute& attribute)
 {
     std::vector<MVector> out;
-    MArrayDataHandle arrayHandle = dataBlock.inputArrayValue(attribute);
-    
-    out.resize(arrayHandle.elementCount());
-    for (unsigned index = 0u; index < arrayHandle.elementCount(); ++index)
-    {
-        out[index] = arrayHandle.inputValue().asVector();
-        arrayHandle.next();
-    }
-    
+    getAttribute(dataBlock, attribute, out);
     return out;
 }
 
@@ -423,16 +485,7 @@ template <>
 inline std::vector<MVector> getAttribute(MDataBlock& dataBlock, const Attribute& attribute, const Attribute& childAttribute)
 {
     std::vector<MVector> out;
-    MArrayDataHandle arrayHandle = dataBlock.inputArrayValue(attribute);
-    
-    out.resize(arrayHandle.elementCount());
-    for (unsigned index = 0u; index < arrayHandle.elementCount(); ++index)
-    {
-        MDataHandle handle = arrayHandle.inputValue();
-        out[index] = handle.child(childAttribute).asVector();
-        arrayHandle.next();
-    }
-    
+    getAttribute(dataBlock, attribute, childAttribute, out);
     return out;
 }
 
@@ -447,15 +500,7 @@ template <>
 inline std::vector<MMatrix> getAttribute(MDataBlock& dataBlock, const Attribute& attribute)
 {
     std::vector<MMatrix> out;
-    MArrayDataHandle arrayHandle = dataBlock.inputArrayValue(attribute);
-    
-    out.resize(arrayHandle.elementCount());
-    for (unsigned index = 0u; index < arrayHandle.elementCount(); ++index)
-    {
-        out[index] = arrayHandle.inputValue().asMatrix();
-        arrayHandle.next();
-    }
-    
+    getAttribute(dataBlock, attribute, out);
     return out;
 }
 
@@ -463,16 +508,7 @@ template <>
 inline std::vector<MMatrix> getAttribute(MDataBlock& dataBlock, const Attribute& attribute, const Attribute& childAttribute)
 {
     std::vector<MMatrix> out;
-    MArrayDataHandle arrayHandle = dataBlock.inputArrayValue(attribute);
-    
-    out.resize(arrayHandle.elementCount());
-    for (unsigned index = 0u; index < arrayHandle.elementCount(); ++index)
-    {
-        MDataHandle handle = arrayHandle.inputValue();
-        out[index] = handle.child(childAttribute).asMatrix();
-        arrayHandle.next();
-    }
-    
+    getAttribute(dataBlock, attribute, childAttribute, out);
     return out;
 }
 
@@ -492,21 +528,7 @@ template <>
 inline std::vector<MEulerRotation> getAttribute(MDataBlock& dataBlock, const Attribute& attribute)
 {
     std::vector<MEulerRotation> out;
-    MArrayDataHandle arrayHandle = dataBlock.inputArrayValue(attribute);
-    
-    out.resize(arrayHandle.elementCount());
-    for (unsigned index = 0u; index < arrayHandle.elementCount(); ++index)
-    {
-        MDataHandle handle = arrayHandle.inputValue();
-        
-        const double x = handle.child(attribute.attrX).asAngle().asRadians();
-        const double y = handle.child(attribute.attrY).asAngle().asRadians();
-        const double z = handle.child(attribute.attrZ).asAngle().asRadians();
-        
-        out[index] = MEulerRotation(x, y, z);
-        arrayHandle.next();
-    }
-    
+    getAttribute(dataBlock, attribute, out);
     return out;
 }
 
@@ -514,22 +536,7 @@ template <>
 inline std::vector<MEulerRotation> getAttribute(MDataBlock& dataBlock, const Attribute& attribute, const Attribute& childAttribute)
 {
     std::vector<MEulerRotation> out;
-    MArrayDataHandle arrayHandle = dataBlock.inputArrayValue(attribute);
-    
-    out.resize(arrayHandle.elementCount());
-    for (unsigned index = 0u; index < arrayHandle.elementCount(); ++index)
-    {
-        MDataHandle handle = arrayHandle.inputValue();
-        MDataHandle childHandle = handle.child(childAttribute);
-        
-        const double x = childHandle.child(childAttribute.attrX).asAngle().asRadians();
-        const double y = childHandle.child(childAttribute.attrY).asAngle().asRadians();
-        const double z = childHandle.child(childAttribute.attrZ).asAngle().asRadians();
-        
-        out[index] = MEulerRotation(x, y, z);
-        arrayHandle.next();
-    }
-    
+    getAttribute(dataBlock, attribute, childAttribute, out);
     return out;
 }
 
@@ -550,22 +557,7 @@ template <>
 inline std::vector<MQuaternion> getAttribute(MDataBlock& dataBlock, const Attribute& attribute)
 {
     std::vector<MQuaternion> out;
-    MArrayDataHandle arrayHandle = dataBlock.inputArrayValue(attribute);
-    
-    out.resize(arrayHandle.elementCount());
-    for (unsigned index = 0u; index < arrayHandle.elementCount(); ++index)
-    {
-        MDataHandle handle = arrayHandle.inputValue();
-        
-        const double x = handle.child(attribute.attrX).asDouble();
-        const double y = handle.child(attribute.attrY).asDouble();
-        const double z = handle.child(attribute.attrZ).asDouble();
-        const double w = handle.child(attribute.attrW).asDouble();
-        
-        out[index] = MQuaternion(x, y, z, w);
-        arrayHandle.next();
-    }
-    
+    getAttribute(dataBlock, attribute, out);
     return out;
 }
 
@@ -573,23 +565,7 @@ template <>
 inline std::vector<MQuaternion> getAttribute(MDataBlock& dataBlock, const Attribute& attribute, const Attribute& childAttribute)
 {
     std::vector<MQuaternion> out;
-    MArrayDataHandle arrayHandle = dataBlock.inputArrayValue(attribute);
-    
-    out.resize(arrayHandle.elementCount());
-    for (unsigned index = 0u; index < arrayHandle.elementCount(); ++index)
-    {
-        MDataHandle handle = arrayHandle.inputValue();
-        MDataHandle childHandle = handle.child(childAttribute);
-        
-        const double x = childHandle.child(childAttribute.attrX).asDouble();
-        const double y = childHandle.child(childAttribute.attrY).asDouble();
-        const double z = childHandle.child(childAttribute.attrZ).asDouble();
-        const double w = childHandle.child(childAttribute.attrW).asDouble();
-        
-        out[index] = MQuaternion(x, y, z, w);
-        arrayHandle.next();
-    }
-    
+    getAttribute(dataBlock, attribute, childAttribute, out);
     return out;
 }
 
@@ -654,22 +630,50 @@ inline void setAttribute(MDataBlock& dataBlock, const Attribute& attribute, MQua
     outputWHandle.setClean();
 }
 
+// Whether the elements of an array are at logical indices 0 to n - 1 in order, as a sparse array may have holes
+inline bool isDenseArray(MArrayDataHandle& handle)
+{
+    for (unsigned i = 0u; i < handle.elementCount(); ++i)
+    {
+        handle.jumpToArrayElement(i);
+        if (handle.elementIndex() != i) return false;
+    }
+    return true;
+}
+
+// Writes an array, updating the elements in place when the count is unchanged and the array has no holes, so a
+// steady array does not allocate, and building a new array at indices 0 to n - 1 otherwise
 template <typename TType>
 inline void setAttribute(MDataBlock& dataBlock, const Attribute& attribute, const std::vector<TType>& values)
 {
     MArrayDataHandle handle = dataBlock.outputArrayValue(attribute);
-    MArrayDataBuilder builder(attribute, unsigned(values.size()));
     
-    for (const auto& value : values)
+    if (handle.elementCount() == values.size() && isDenseArray(handle))
     {
-        MDataHandle itemHandle = builder.addLast();
-        itemHandle.set(value);
+        handle.jumpToArrayElement(0u);
+        for (const auto& value : values)
+        {
+            setElement(handle.outputValue(), attribute, value);
+            handle.next();
+        }
+    }
+    else
+    {
+        MArrayDataBuilder builder(attribute, unsigned(values.size()));
+        for (const auto& value : values) setElement(builder.addLast(), attribute, value);
+        handle.set(builder);
     }
-    
-    handle.set(builder);
     handle.setAllClean();
 }
 
+// Compares the bytes of two plain values, so a cached key only matches exactly the same inputs
+template <typename T>
+inline static bool bitwiseEqual(const T& _a, const T& _b)
+{
+  static_assert(std::is_trivially_copyable<T>::value, "bitwiseEqual needs a trivially copyable type");
+  return std::memcmp(&_a, &_b, sizeof(T)) == 0;
+}
+
 template <typename ...Ts>
 inline static bool shouldCompute(const MPlug& _plug, Ts&&... _attrs)
 {
@@ -702,121 +706,74 @@ inline static void setAffects(std::initializer_list<std::reference_wrapper<Attri
   }
 }
 
-template <typename T>
-inline static T sqr(T x) {return x*x;}
-
-template <typename T>
-inline static T clamp(const T& n, const T& lower, const T& upper) 
+// Conversions between the maya types and the headless solver types
+inline Vector3<double> toVector3(const MVector& v)
 {
-  return std::max(lower, std::min(n, upper));
+  return Vector3<double>(v.x, v.y, v.z);
 }
 
-template <typename T>
-inline static T getAngle(T a, T b, T c)
+inline MVector toMVector(const Vector3<double>& v)
 {
-  static constexpr T two = 2.0;
-  return std::acos(clamp((sqr(a) + sqr(b) - sqr(c)) / (two * a * b), -1.0, 1.0));
+  return MVector(v.x, v.y, v.z);
 }
 
-template <typename T>
-inline static int psign(T val) 
+inline MEulerRotation toMEulerRotation(const EulerRotation<double>& r)
 {
-    return (0.0 <= val) - (val < 0.0);
+  return MEulerRotation(r.x, r.y, r.z, MEulerRotation::RotationOrder(r.order));
 }
 
-template <typename T>
-inline static T distPointToOLine(MVector P, MVector A)
+inline MQuaternion toMQuaternion(const Quaternion<double>& q)
 {
-    const auto diff = A.y * P.x - A.x * P.y;
-    const auto d = std::abs(diff) / A.length() * -psign(diff);
-    return d;
+  return MQuaternion(q.x, q.y, q.z, q.w);
 }
 
-template<typename T>
-inline static T fitInBoundsSigned(T val, T lower, T upper)
+// Places the rotation in the upper 3x3 of a transform matrix
+inline MMatrix toMMatrix(const Matrix3<double>& m)
 {
-  return std::max(clamp(val, lower, upper), clamp(val, -upper, -lower)) * psign(val);
-}
-
-template <typename T>
-inline static MVector makeNonZero(MVector val)
-{
-  static constexpr auto smallest = std::numeric_limits<T>::min();
-  return MVector(
-      std::max(std::abs(val.x), smallest) * psign(val.x),
-      std::max(std::abs(val.y), smallest) * psign(val.y),
-      std::max(std::abs(val.z), smallest) * psign(val.z)
-      );
-}
-
-template <typename T>
-inline static T makeNonZero(T&& val)
-{
-  static constexpr auto smallest = std::numeric_limits<T>::min();
-  return std::max(std::abs(val), smallest) * psign(val);
-}
-
-template<typename T>
-inline static T softenEdge(T hardEdge, T chainLength, T dsoft)
-{
-  static constexpr T one  = 1.0;
-  static constexpr T zero = 0.0;
-  const auto da = chainLength - dsoft;
-  const auto softEdge = da + dsoft * (one - std::exp((da-hardEdge)/dsoft));
-  return (hardEdge > da && da > zero) ? softEdge : hardEdge;
-}
-
-template <typename T>
-inline static T dlerp(T a, T b, T t)
-{
-  static constexpr T one  = 1.0;
-  return (one - t) * a + t * b;
-}
-
-template<typename T>
-inline static T stretchEdge(T hardEdge, T baseEdge, T chainLength, T strength)
-{
-  static constexpr T one = 1.0;
-  return dlerp(one, std::max(one, baseEdge / chainLength), strength) * hardEdge;
+  MMatrix out;
+  for (unsigned i = 0u; i < 3u; ++i)
+    for (unsigned j = 0u; j < 3u; ++j)
+      out[i][j] = m[i][j];
+  return out;
 }
 
 // MAngle operator overloads
-MAngle operator+(const MAngle& a, const MAngle& b)
+inline MAngle operator+(const MAngle& a, const MAngle& b)
 {
     return MAngle(a.asRadians() + b.asRadians());
 }
 
-MAngle operator-(const MAngle& a, const MAngle& b)
+inline MAngle operator-(const MAngle& a, const MAngle& b)
 {
     return MAngle(a.asRadians() - b.asRadians());
 }
 
-MAngle operator*(const MAngle& a, double b)
+inline MAngle operator*(const MAngle& a, double b)
 {
     return MAngle(a.asRadians() * b);
 }
 
-MAngle operator*(const MAngle& a, int b)
+inline MAngle operator*(const MAngle& a, int b)
 {
     return MAngle(a.asRadians() * b);
 }
 
-MAngle operator/(const MAngle& a, double b)
+inline MAngle operator/(const MAngle& a, double b)
 {
     return MAngle(a.asRadians() / b);
 }
 
-MAngle operator/(const MAngle& a, int b)
+inline MAngle operator/(const MAngle& a, int b)
 {
     return MAngle(a.asRadians() / b);
 }
 
-MAngle operator-(const MAngle& a)
+inline MAngle operator-(const MAngle& a)
 {
     return MAngle(-a.asRadians());
 }
 
-MQuaternion operator*(const MQuaternion& a, double b)
+inline MQuaternion operator*(const MQuaternion& a, double b)
 {
     return MQuaternion(a.x * b, a.y * b, a.z * b, a.w * b);
 }
@@ -839,10 +796,24 @@ public:
     return getAttribute<TType>(m_dataBlock, attribute);
   }
 
+  // Array reads into a buffer the caller keeps between computes
+  template <typename TType>
+  inline void get(const Attribute& attribute, std::vector<TType>& o_values)
+  {
+    getAttribute(m_dataBlock, attribute, o_values);
+  }
+
+  template <typename TType>
+  inline void get(const Attribute& attribute, const Attribute& childAttribute, std::vector<TType>& o_values)
+  {
+    getAttribute(m_dataBlock, attribute, childAttribute, o_values);
+  }
+
+  // Deduce the setter so that std::vector values resolve to the array overloads
   template <typename TType>
-  inline void set(const Attribute& attribute, TType value)
+  inline void set(const Attribute& attribute, const TType& value)
   {
-    setAttribute<TType>(m_dataBlock, attribute, value);
+    setAttribute(m_dataBlock, attribute, value);
   }
 };
 
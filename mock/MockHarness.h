@@ -0,0 +1,252 @@
+// Helpers for driving real node classes through the Maya stand-in.
+// Nodes are created from the registered types, and attributes are looked up by name.
+#ifndef SIMPLEIKMOCKHARNESS_INCLUDE_H
+#define SIMPLEIKMOCKHARNESS_INCLUDE_H
+
+#include "MockMaya.h"
+#include "Utils.h"
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+class MockNodeHarness
+{
+public:
+  MockNodeHarness(const std::string& _typeName, const std::string& _nodeName)
+    : m_typeName(_typeName), m_node(MockRegistry::instance().createNode(_typeName, _nodeName))
+  {}
+
+  bool isValid() const { return m_node != nullptr; }
+  MPxNode& node() { return *m_node; }
+  MDataBlock& dataBlock() { return m_node->m_mockDataBlock; }
+
+  // Rebuilds the Attribute used by the node, compounds of three or four children get their x, y, z, w handles
+  Attribute attribute(const std::string& _name) const
+  {
+    Attribute out;
+    out = MockRegistry::instance().findAttribute(m_typeName, _name);
+    if (out.attr.isNull()) return out;
+    const auto& children = out.attr.mockAttribute()->children;
+    MObject* handles[4] = {&out.attrX, &out.attrY, &out.attrZ, &out.attrW};
+    for (std::size_t i = 0u; i < children.size() && i < 4u; ++i) *handles[i] = MObject(out.attr, children[i]);
+    return out;
+  }
+
+  // Sets an input and marks the outputs it affects dirty
+  template <typename TType>
+  void set(const std::string& _name, const TType& _value)
+  {
+    const auto input = attribute(_name).attr;
+    dataBlock().inputValue(input).set(_value);
+    for (const auto& output : affected(input)) dataBlock().mockSetDirty(output);
+  }
+
+  // Marks every output of every node dirty, as a new frame would
+  static void dirtyAll() { ++MockData::generation(); }
+
+  // Replaces every element of an array input
+  template <typename TType>
+  void setArray(const std::string& _name, const std::vector<TType>& _values)
+  {
+    const auto attr = attribute(_name);
+    auto handle = dataBlock().outputArrayValue(attr);
+    MArrayDataBuilder builder(attr, unsigned(_values.size()));
+    for (const auto& value : _values) builder.addLast().set(value);
+    handle.set(builder);
+  }
+
+  template <typename TType>
+  TType get(const std::string& _name)
+  {
+    return getAttribute<TType>(dataBlock(), attribute(_name));
+  }
+
+  // Euler outputs are compounds of angles, read them back child by child
+  MEulerRotation getEuler(const std::string& _name)
+  {
+    const auto attr = attribute(_name);
+    auto handle = dataBlock().outputValue(attr);
+    return MEulerRotation(
+        handle.child(attr.attrX).asAngle().asRadians(),
+        handle.child(attr.attrY).asAngle().asRadians(),
+        handle.child(attr.attrZ).asAngle().asRadians());
+  }
+
+  std::vector<MEulerRotation> getEulerArray(const std::string& _name)
+  {
+    const auto attr = attribute(_name);
+    auto handle = dataBlock().outputArrayValue(attr);
+    std::vector<MEulerRotation> out(handle.elementCount());
+    for (auto& value : out)
+    {
+      auto element = handle.inputValue();
+      value = MEulerRotation(
+          element.child(attr.attrX).asAngle().asRadians(),
+          element.child(attr.attrY).asAngle().asRadians(),
+          element.child(attr.attrZ).asAngle().asRadians());
+      handle.next();
+    }
+    return out;
+  }
+
+  // Connects an output plug to a node outside the harness, as seen through MPlug::isConnected and connectionMade
+  void connect(const std::string& _name)
+  {
+    const auto output = attribute(_name).attr;
+    if (m_node->m_mockConnected.insert(output.mockAttribute()).second)
+    {
+      m_node->connectionMade(MPlug(m_node->thisMObject(), output), MPlug(), true);
+    }
+  }
+
+  // Connects an output of this node to an input of _destination, which then reads the value this node last wrote
+  void connect(const std::string& _output, MockNodeHarness& _destination, const std::string& _input)
+  {
+    const auto output = attribute(_output).attr;
+    const auto input = _destination.attribute(_input).attr;
+    _destination.dataBlock().mockShare(input, dataBlock(), output);
+    m_node->m_mockConnected.insert(output.mockAttribute());
+    _destination.m_node->m_mockConnected.insert(input.mockAttribute());
+    const MPlug source(m_node->thisMObject(), output);
+    const MPlug destination(_destination.m_node->thisMObject(), input);
+    _destination.m_node->m_mockSources.push_back({destination, source});
+    m_node->connectionMade(source, destination, true);
+    _destination.m_node->connectionMade(destination, source, false);
+  }
+
+  // Breaks a connection made with connect(_name)
+  void disconnect(const std::string& _name)
+  {
+    const auto output = attribute(_name).attr;
+    if (m_node->m_mockConnected.erase(output.mockAttribute()))
+    {
+      m_node->connectionBroken(MPlug(m_node->thisMObject(), output), MPlug(), true);
+    }
+  }
+
+  MStatus compute(const std::string& _output)
+  {
+    return m_node->compute(MPlug(m_node->thisMObject(), attribute(_output)), dataBlock());
+  }
+
+private:
+  // The attributes _input affects, looked up once per input
+  const std::vector<MObject>& affected(const MObject& _input)
+  {
+    auto found = m_affected.find(_input.mockAttribute());
+    if (found != m_affected.end()) return found->second;
+    auto& affected = m_affected[_input.mockAttribute()];
+    const auto& registry = MockRegistry::instance();
+    if (const auto type = registry.nodeType(m_typeName))
+    {
+      for (const auto& attr : type->attributes)
+        if (registry.doesAffect(_input, attr)) affected.push_back(attr);
+    }
+    return affected;
+  }
+
+  std::string m_typeName;
+  std::unique_ptr<MPxNode> m_node;
+  std::map<const MockAttribute*, std::vector<MObject>> m_affected;
+};
+
+// Stand-in for the evaluation manager over a fixed set of nodes.
+// Each registered custom evaluator, highest priority first, claims the nodes it supports into a single cluster,
+// and the nodes left unclaimed are evaluated one by one. Every evaluate() is one frame
+class MockEvaluationGraph
+{
+public:
+  explicit MockEvaluationGraph(const std::vector<MPxNode*>& _nodes)
+  {
+    auto evaluators = MockRegistry::instance().evaluators;
+    std::stable_sort(evaluators.begin(), evaluators.end(), [](const MockRegistry::Evaluator& _a, const MockRegistry::Evaluator& _b)
+    {
+      return _a.priority > _b.priority;
+    });
+    std::vector<bool> claimed(_nodes.size(), false);
+    for (const auto& entry : evaluators)
+    {
+      std::unique_ptr<Partition> partition(new Partition());
+      partition->name = entry.name;
+      partition->evaluator.reset(static_cast<MPxCustomEvaluator*>(entry.creator()));
+      std::vector<std::size_t> marked;
+      for (std::size_t i = 0u; i < _nodes.size(); ++i)
+      {
+        const MEvaluationNode node(_nodes[i]);
+        if (claimed[i] || !partition->evaluator->markIfSupported(&node)) continue;
+        partition->cluster.m_mockNodes.push_back(node);
+        marked.push_back(i);
+      }
+      // A cluster the evaluator declines is evaluated normally
+      if (!marked.empty() && partition->evaluator->clusterInitialize(&partition->cluster))
+      {
+        for (auto i : marked) claimed[i] = true;
+      }
+      else
+      {
+        partition->cluster.m_mockNodes.clear();
+      }
+      m_partitions.push_back(std::move(partition));
+    }
+    for (std::size_t i = 0u; i < _nodes.size(); ++i)
+    {
+      if (!claimed[i]) m_unclaimed.push_back(_nodes[i]);
+    }
+  }
+
+  ~MockEvaluationGraph()
+  {
+    for (auto& partition : m_partitions)
+    {
+      if (!partition->cluster.m_mockNodes.empty()) partition->evaluator->clusterTerminate(&partition->cluster);
+    }
+  }
+
+  void evaluate()
+  {
+    for (auto& partition : m_partitions) partition->evaluator->preEvaluate(&m_graph);
+    for (auto& partition : m_partitions)
+    {
+      if (!partition->cluster.m_mockNodes.empty()) partition->evaluator->clusterEvaluate(&partition->cluster);
+    }
+    for (auto node : m_unclaimed) MockRegistry::instance().evaluateNode(node);
+    for (auto& partition : m_partitions) partition->evaluator->postEvaluate(&m_graph);
+  }
+
+  // How the named evaluator schedules its cluster
+  MCustomEvaluatorClusterNode::SchedulingType schedulingType(const std::string& _evaluator) const
+  {
+    for (const auto& partition : m_partitions)
+    {
+      if (partition->name == _evaluator) return partition->evaluator->schedulingType(&partition->cluster);
+    }
+    return MCustomEvaluatorClusterNode::kSerial;
+  }
+
+  // Number of nodes claimed by the named evaluator
+  std::size_t clusterSize(const std::string& _evaluator) const
+  {
+    for (const auto& partition : m_partitions)
+    {
+      if (partition->name == _evaluator) return partition->cluster.m_mockNodes.size();
+    }
+    return 0u;
+  }
+
+private:
+  struct Partition
+  {
+    std::string name;
+    std::unique_ptr<MPxCustomEvaluator> evaluator;
+    MCustomEvaluatorClusterNode cluster;
+  };
+
+  MEvaluationGraph m_graph;
+  // Evaluators keep pointers to their clusters, so each partition stays where it was allocated
+  std::vector<std::unique_ptr<Partition>> m_partitions;
+  std::vector<MPxNode*> m_unclaimed;
+};
+
+#endif //SIMPLEIKMOCKHARNESS_INCLUDE_H
@@ -0,0 +1,11 @@
+// Static data for the Maya stand-in, link this once into any binary built against the mock headers.
+#include "MockMaya.h"
+
+const MMatrix MMatrix::identity = MMatrix();
+const MVector MVector::zero = MVector();
+const MVector MVector::xAxis = MVector(1.0, 0.0, 0.0);
+const MVector MVector::yAxis = MVector(0.0, 1.0, 0.0);
+const MVector MVector::zAxis = MVector(0.0, 0.0, 1.0);
+const MEulerRotation MEulerRotation::identity = MEulerRotation();
+const MQuaternion MQuaternion::identity = MQuaternion();
+const MObject MObject::kNullObj = MObject();
@@ -0,0 +1,1255 @@
+// Minimal stand-in for the subset of the Maya API used by SimpleIK.
+// It exists so the real node classes can be compiled, run and profiled without a Maya install,
+// the data block stores plain values keyed by attribute and performs no dirty propagation.
+#ifndef SIMPLEIKMOCKMAYA_INCLUDE_H
+#define SIMPLEIKMOCKMAYA_INCLUDE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#define MNoVersionString
+#define MNoPluginEntry
+
+// Status codes
+namespace MS
+{
+  enum MStatusCode
+  {
+    kSuccess = 0,
+    kFailure,
+    kInvalidParameter,
+    kUnknownParameter,
+    kNotImplemented
+  };
+}
+
+class MStatus
+{
+public:
+  MStatus() = default;
+  MStatus(MS::MStatusCode _code) : m_code(_code) {}
+  bool error() const { return m_code != MS::kSuccess; }
+  operator bool() const { return m_code == MS::kSuccess; }
+  bool operator==(const MStatus& _other) const { return m_code == _other.m_code; }
+  bool operator==(MS::MStatusCode _code) const { return m_code == _code; }
+  bool operator!=(MS::MStatusCode _code) const { return m_code != _code; }
+  MS::MStatusCode statusCode() const { return m_code; }
+private:
+  MS::MStatusCode m_code = MS::kSuccess;
+};
+
+#define CHECK_MSTATUS(_status) \
+do { if ((_status).error()) std::fprintf(stderr, "MStatus error at %s:%d\n", __FILE__, __LINE__); } while (0)
+
+#define CHECK_MSTATUS_AND_RETURN_IT(_status) \
+do { MStatus _s = (_status); if (_s.error()) return _s; } while (0)
+
+class MString
+{
+public:
+  MString() = default;
+  MString(const char* _str) : m_str(_str ? _str : "") {}
+  MString(const std::string& _str) : m_str(_str) {}
+  const char* asChar() const { return m_str.c_str(); }
+  unsigned length() const { return unsigned(m_str.size()); }
+  MString& operator+=(const MString& _other) { m_str += _other.m_str; return *this; }
+  MString operator+(const MString& _other) const { return MString(m_str + _other.m_str); }
+  bool operator==(const MString& _other) const { return m_str == _other.m_str; }
+private:
+  std::string m_str;
+};
+
+class MTypeId
+{
+public:
+  MTypeId(unsigned _id = 0) : m_id(_id) {}
+  unsigned id() const { return m_id; }
+  bool operator==(const MTypeId& _other) const { return m_id == _other.m_id; }
+  bool operator!=(const MTypeId& _other) const { return m_id != _other.m_id; }
+private:
+  unsigned m_id;
+};
+
+// Math types, these all use Maya's row vector convention
+class MAngle
+{
+public:
+  enum Unit { kInvalid, kRadians, kDegrees };
+  MAngle() = default;
+  MAngle(double _value, Unit _unit = kRadians) : m_radians(_unit == kDegrees ? _value * M_PI / 180.0 : _value) {}
+  double asRadians() const { return m_radians; }
+  double asDegrees() const { return m_radians * 180.0 / M_PI; }
+  double value() const { return m_radians; }
+private:
+  double m_radians = 0.0;
+};
+
+class MMatrix
+{
+public:
+  MMatrix()
+  {
+    for (int i = 0; i < 4; ++i)
+      for (int j = 0; j < 4; ++j)
+        matrix[i][j] = double(i == j);
+  }
+  explicit MMatrix(const double _m[4][4])
+  {
+    for (int i = 0; i < 4; ++i)
+      for (int j = 0; j < 4; ++j)
+        matrix[i][j] = _m[i][j];
+  }
+  double operator()(unsigned _row, unsigned _col) const { return matrix[_row][_col]; }
+  double& operator()(unsigned _row, unsigned _col) { return matrix[_row][_col]; }
+  const double* operator[](unsigned _row) const { return matrix[_row]; }
+  double* operator[](unsigned _row) { return matrix[_row]; }
+  MMatrix operator*(const MMatrix& _rhs) const
+  {
+    MMatrix out;
+    for (int i = 0; i < 4; ++i)
+      for (int j = 0; j < 4; ++j)
+      {
+        double sum = 0.0;
+        for (int k = 0; k < 4; ++k) sum += matrix[i][k] * _rhs.matrix[k][j];
+        out.matrix[i][j] = sum;
+      }
+    return out;
+  }
+  MMatrix transpose() const
+  {
+    MMatrix out;
+    for (int i = 0; i < 4; ++i)
+      for (int j = 0; j < 4; ++j)
+        out.matrix[i][j] = matrix[j][i];
+    return out;
+  }
+  bool operator==(const MMatrix& _rhs) const
+  {
+    for (int i = 0; i < 4; ++i)
+      for (int j = 0; j < 4; ++j)
+        if (matrix[i][j] != _rhs.matrix[i][j]) return false;
+    return true;
+  }
+  static const MMatrix identity;
+  double matrix[4][4];
+};
+
+class MEulerRotation;
+
+class MVector
+{
+public:
+  enum Axis { kXaxis, kYaxis, kZaxis, kWaxis };
+  MVector() = default;
+  MVector(double _x, double _y, double _z = 0.0) : x(_x), y(_y), z(_z) {}
+  explicit MVector(const double _d[3]) : x(_d[0]), y(_d[1]), z(_d[2]) {}
+  MVector operator+(const MVector& _r) const { return MVector(x + _r.x, y + _r.y, z + _r.z); }
+  MVector operator-(const MVector& _r) const { return MVector(x - _r.x, y - _r.y, z - _r.z); }
+  MVector operator-() const { return MVector(-x, -y, -z); }
+  MVector operator*(double _s) const { return MVector(x * _s, y * _s, z * _s); }
+  MVector operator/(double _s) const { return MVector(x / _s, y / _s, z / _s); }
+  MVector& operator+=(const MVector& _r) { x += _r.x; y += _r.y; z += _r.z; return *this; }
+  MVector& operator-=(const MVector& _r) { x -= _r.x; y -= _r.y; z -= _r.z; return *this; }
+  MVector& operator*=(double _s) { x *= _s; y *= _s; z *= _s; return *this; }
+  // Dot product
+  double operator*(const MVector& _r) const { return x * _r.x + y * _r.y + z * _r.z; }
+  // Cross product
+  MVector operator^(const MVector& _r) const
+  {
+    return MVector(y * _r.z - z * _r.y, z * _r.x - x * _r.z, x * _r.y - y * _r.x);
+  }
+  // Row vector multiply
+  MVector operator*(const MMatrix& _m) const
+  {
+    return MVector(
+        x * _m.matrix[0][0] + y * _m.matrix[1][0] + z * _m.matrix[2][0],
+        x * _m.matrix[0][1] + y * _m.matrix[1][1] + z * _m.matrix[2][1],
+        x * _m.matrix[0][2] + y * _m.matrix[1][2] + z * _m.matrix[2][2]);
+  }
+  double operator[](unsigned _i) const { return _i == 0 ? x : (_i == 1 ? y : z); }
+  double length() const { return std::sqrt(x * x + y * y + z * z); }
+  MVector normal() const { const double l = length(); return l > 0.0 ? *this / l : *this; }
+  MStatus normalize() { *this = normal(); return MS::kSuccess; }
+  bool operator==(const MVector& _r) const { return x == _r.x && y == _r.y && z == _r.z; }
+  MVector rotateBy(Axis _axis, double _angle) const
+  {
+    const double c = std::cos(_angle);
+    const double s = std::sin(_angle);
+    switch (_axis)
+    {
+      case kXaxis: return MVector(x, y * c - z * s, y * s + z * c);
+      case kYaxis: return MVector(x * c + z * s, y, -x * s + z * c);
+      case kZaxis: return MVector(x * c - y * s, x * s + y * c, z);
+      default: return *this;
+    }
+  }
+  static const MVector zero;
+  static const MVector xAxis;
+  static const MVector yAxis;
+  static const MVector zAxis;
+  double x = 0.0;
+  double y = 0.0;
+  double z = 0.0;
+};
+
+inline MVector operator*(double _s, const MVector& _v) { return _v * _s; }
+
+class MFloatVector
+{
+public:
+  MFloatVector() = default;
+  MFloatVector(float _x, float _y, float _z) : x(_x), y(_y), z(_z) {}
+  float x = 0.0f;
+  float y = 0.0f;
+  float z = 0.0f;
+};
+
+class MEulerRotation
+{
+public:
+  enum RotationOrder { kXYZ, kYZX, kZXY, kXZY, kYXZ, kZYX };
+  MEulerRotation() = default;
+  MEulerRotation(double _x, double _y, double _z, RotationOrder _order = kXYZ) : x(_x), y(_y), z(_z), order(_order) {}
+  explicit MEulerRotation(const MVector& _v, RotationOrder _order = kXYZ) : x(_v.x), y(_v.y), z(_v.z), order(_order) {}
+
+  MMatrix asMatrix() const
+  {
+    const double angles[3] = {x, y, z};
+    int axes[3];
+    orderAxes(order, axes);
+    MMatrix out;
+    for (int a : axes) out = out * axisMatrix(a, angles[a]);
+    return out;
+  }
+
+  static MEulerRotation decompose(const MMatrix& _m, RotationOrder _order)
+  {
+    int axes[3];
+    orderAxes(_order, axes);
+    const int i = axes[0];
+    const int j = axes[1];
+    const int k = axes[2];
+    // Even permutations of xyz use the positive parity
+    const double s = ((j - i + 3) % 3 == 1) ? 1.0 : -1.0;
+    // Column convention view of the row vector matrix
+    auto c = [&_m](int r, int col) { return _m.matrix[col][r]; };
+    double angles[3];
+    const double sj = -s * c(k, i);
+    angles[j] = std::asin(std::max(-1.0, std::min(sj, 1.0)));
+    angles[i] = std::atan2(s * c(k, j), c(k, k));
+    angles[k] = std::atan2(s * c(j, i), c(i, i));
+    return MEulerRotation(angles[0], angles[1], angles[2], _order);
+  }
+
+  MEulerRotation operator*(const MEulerRotation& _other) const
+  {
+    return decompose(asMatrix() * _other.asMatrix(), order);
+  }
+  MEulerRotation& operator*=(const MEulerRotation& _other)
+  {
+    *this = *this * _other;
+    return *this;
+  }
+  MEulerRotation reorder(RotationOrder _order) const { return decompose(asMatrix(), _order); }
+  MStatus reorderIt(RotationOrder _order)
+  {
+    *this = reorder(_order);
+    return MS::kSuccess;
+  }
+  MVector asVector() const { return MVector(x, y, z); }
+  bool operator==(const MEulerRotation& _r) const { return x == _r.x && y == _r.y && z == _r.z && order == _r.order; }
+
+  static const MEulerRotation identity;
+  double x = 0.0;
+  double y = 0.0;
+  double z = 0.0;
+  RotationOrder order = kXYZ;
+
+private:
+  static void orderAxes(RotationOrder _order, int* o_axes)
+  {
+    static const int table[6][3] = {{0, 1, 2}, {1, 2, 0}, {2, 0, 1}, {0, 2, 1}, {1, 0, 2}, {2, 1, 0}};
+    for (int i = 0; i < 3; ++i) o_axes[i] = table[_order][i];
+  }
+  static MMatrix axisMatrix(int _axis, double _angle)
+  {
+    const double c = std::cos(_angle);
+    const double s = std::sin(_angle);
+    MMatrix m;
+    const int a = (_axis + 1) % 3;
+    const int b = (_axis + 2) % 3;
+    m.matrix[a][a] = c;
+    m.matrix[a][b] = s;
+    m.matrix[b][a] = -s;
+    m.matrix[b][b] = c;
+    return m;
+  }
+};
+
+class MQuaternion
+{
+public:
+  MQuaternion() = default;
+  MQuaternion(double _x, double _y, double _z, double _w) : x(_x), y(_y), z(_z), w(_w) {}
+  static const MQuaternion identity;
+  double x = 0.0;
+  double y = 0.0;
+  double z = 0.0;
+  double w = 1.0;
+};
+
+class MTime
+{
+public:
+  enum Unit { kInvalid, kSeconds, kFilm };
+  MTime(double _value = 0.0, Unit _unit = kFilm) : m_value(_value), m_unit(_unit) {}
+  double value() const { return m_value; }
+  double as(Unit _unit) const { return _unit == m_unit ? m_value : (_unit == kSeconds ? m_value / 24.0 : m_value * 24.0); }
+  Unit unit() const { return m_unit; }
+private:
+  double m_value;
+  Unit m_unit;
+};
+
+class MDGContext
+{
+public:
+  MDGContext() = default;
+  explicit MDGContext(const MTime& _time) : m_time(_time), m_isNormal(false) {}
+  MTime getTime() const { return m_time; }
+  bool isNormal() const { return m_isNormal; }
+  static MDGContext& current()
+  {
+    static MDGContext ctx;
+    return ctx;
+  }
+private:
+  MTime m_time;
+  bool m_isNormal = true;
+};
+
+// Attribute definitions, an MObject refers to one of these or to a node
+struct MockAttribute
+{
+  enum Kind { kNumeric, kUnit, kMatrix, kCompound, kEnum, kTyped };
+  std::string name;
+  Kind kind = kNumeric;
+  int numericType = 0;
+  double defaultValue = 0.0;
+  MMatrix defaultMatrix;
+  bool isArray = false;
+  bool writable = true;
+  const MockAttribute* parent = nullptr;
+  std::vector<const MockAttribute*> children;
+  std::vector<std::pair<std::string, short>> fields;
+};
+
+class MPxNode;
+
+class MObject
+{
+public:
+  MObject() = default;
+  explicit MObject(std::shared_ptr<MockAttribute> _attr) : m_attr(std::move(_attr)) {}
+  // Refers to a child attribute, keeping its parent alive
+  MObject(const MObject& _parent, const MockAttribute* _child)
+    : m_attr(_parent.m_attr, const_cast<MockAttribute*>(_child)) {}
+  explicit MObject(MPxNode* _node) : m_node(_node) {}
+  bool isNull() const { return !m_attr && !m_node; }
+  bool operator==(const MObject& _other) const { return m_attr == _other.m_attr && m_node == _other.m_node; }
+  bool operator!=(const MObject& _other) const { return !(*this == _other); }
+  MockAttribute* mockAttribute() const { return m_attr.get(); }
+  MPxNode* mockNode() const { return m_node; }
+  static const MObject kNullObj;
+private:
+  std::shared_ptr<MockAttribute> m_attr;
+  MPxNode* m_node = nullptr;
+};
+
+// Data storage, compounds hold one child per child attribute and arrays hold logical indexed elements
+struct MockData
+{
+  const MockAttribute* attr = nullptr;
+  double number = 0.0;
+  MMatrix matrix;
+  std::vector<std::shared_ptr<MockData>> children;
+  std::vector<std::pair<unsigned, std::shared_ptr<MockData>>> elements;
+  // Data set clean in an earlier generation reads as dirty, see MockNodeHarness::dirtyAll
+  std::uint64_t cleanGeneration = 0u;
+
+  static std::uint64_t& generation()
+  {
+    static std::uint64_t current = 1u;
+    return current;
+  }
+
+  static std::shared_ptr<MockData> create(const MockAttribute* _attr, bool _element = false)
+  {
+    auto data = std::make_shared<MockData>();
+    data->attr = _attr;
+    data->number = _attr->defaultValue;
+    data->matrix = _attr->defaultMatrix;
+    // Array roots hold elements, each element is built when it is added
+    if (_attr->isArray && !_element) return data;
+    for (auto child : _attr->children) data->children.push_back(create(child));
+    return data;
+  }
+
+  MockData* child(const MockAttribute* _attr)
+  {
+    for (auto& c : children)
+      if (c->attr == _attr) return c.get();
+    return nullptr;
+  }
+};
+
+class MArrayDataBuilder;
+
+class MDataHandle
+{
+public:
+  MDataHandle() = default;
+  explicit MDataHandle(MockData* _data) : m_data(_data) {}
+
+  double asDouble() const { return m_data->number; }
+  float asFloat() const { return float(m_data->number); }
+  int asInt() const { return int(m_data->number); }
+  short asShort() const { return short(m_data->number); }
+  bool asBool() const { return m_data->number != 0.0; }
+  MAngle asAngle() const { return MAngle(m_data->number); }
+  MTime asTime() const { return MTime(m_data->number); }
+  const MMatrix& asMatrix() const { return m_data->matrix; }
+  MVector asVector() const
+  {
+    return MVector(m_data->children[0]->number, m_data->children[1]->number, m_data->children[2]->number);
+  }
+
+  MDataHandle child(const MObject& _attr) const { return MDataHandle(m_data->child(_attr.mockAttribute())); }
+
+  void set(double _v) { m_data->number = _v; }
+  void set(float _v) { m_data->number = _v; }
+  void set(int _v) { m_data->number = _v; }
+  void set(short _v) { m_data->number = _v; }
+  void set(bool _v) { m_data->number = _v; }
+  void set(const MAngle& _v) { m_data->number = _v.asRadians(); }
+  void set(const MMatrix& _v) { m_data->matrix = _v; }
+  void set(const MVector& _v) { set3(_v.x, _v.y, _v.z); }
+  void set(const MFloatVector& _v) { set3(_v.x, _v.y, _v.z); }
+  void set3Double(double _x, double _y, double _z) { set3(_x, _y, _z); }
+  void setClean() { m_data->cleanGeneration = MockData::generation(); }
+  MockData* mockData() const { return m_data; }
+
+private:
+  void set3(double _x, double _y, double _z)
+  {
+    m_data->children[0]->number = _x;
+    m_data->children[1]->number = _y;
+    m_data->children[2]->number = _z;
+  }
+  MockData* m_data = nullptr;
+};
+
+class MArrayDataBuilder
+{
+public:
+  MArrayDataBuilder() = default;
+  MArrayDataBuilder(const MObject& _attr, unsigned _numElements)
+    : m_attr(_attr.mockAttribute()), m_data(std::make_shared<MockData>())
+  {
+    m_data->attr = m_attr;
+    m_data->elements.reserve(_numElements);
+  }
+  MDataHandle addLast()
+  {
+    const unsigned index = m_data->elements.empty() ? 0u : m_data->elements.back().first + 1u;
+    return addElement(index);
+  }
+  MDataHandle addElement(unsigned _index)
+  {
+    for (auto& e : m_data->elements)
+      if (e.first == _index) return MDataHandle(e.second.get());
+    m_data->elements.emplace_back(_index, MockData::create(m_attr, true));
+    return MDataHandle(m_data->elements.back().second.get());
+  }
+  MStatus removeElement(unsigned _index)
+  {
+    for (auto it = m_data->elements.begin(); it != m_data->elements.end(); ++it)
+      if (it->first == _index)
+      {
+        m_data->elements.erase(it);
+        return MS::kSuccess;
+      }
+    return MS::kFailure;
+  }
+  unsigned elementCount() const { return unsigned(m_data->elements.size()); }
+  MStatus growArray(unsigned _amount) { m_data->elements.reserve(m_data->elements.size() + _amount); return MS::kSuccess; }
+  std::shared_ptr<MockData> mockData() const { return m_data; }
+private:
+  const MockAttribute* m_attr = nullptr;
+  std::shared_ptr<MockData> m_data;
+};
+
+class MArrayDataHandle
+{
+public:
+  MArrayDataHandle() = default;
+  MArrayDataHandle(MockData* _data, std::shared_ptr<MockData>* _slot) : m_data(_data), m_slot(_slot) {}
+
+  unsigned elementCount() const { return unsigned(m_data->elements.size()); }
+  MDataHandle inputValue() const { return MDataHandle(m_data->elements[m_current].second.get()); }
+  MDataHandle outputValue() const { return inputValue(); }
+  unsigned elementIndex() const { return m_data->elements[m_current].first; }
+  MStatus next()
+  {
+    if (m_current + 1 >= m_data->elements.size())
+    {
+      m_current = unsigned(m_data->elements.size());
+      return MS::kFailure;
+    }
+    ++m_current;
+    return MS::kSuccess;
+  }
+  MStatus jumpToArrayElement(unsigned _position)
+  {
+    if (_position >= m_data->elements.size()) return MS::kFailure;
+    m_current = _position;
+    return MS::kSuccess;
+  }
+  MStatus jumpToElement(unsigned _index)
+  {
+    for (unsigned i = 0u; i < m_data->elements.size(); ++i)
+      if (m_data->elements[i].first == _index)
+      {
+        m_current = i;
+        return MS::kSuccess;
+      }
+    return MS::kFailure;
+  }
+  MArrayDataBuilder builder() const
+  {
+    MArrayDataBuilder out(MObject(), elementCount());
+    auto data = out.mockData();
+    data->attr = m_data->attr;
+    data->elements = m_data->elements;
+    return out;
+  }
+  MStatus set(const MArrayDataBuilder& _builder)
+  {
+    *m_slot = _builder.mockData();
+    (*m_slot)->attr = m_data->attr;
+    m_data = m_slot->get();
+    m_current = 0u;
+    return MS::kSuccess;
+  }
+  MStatus setAllClean() { return MS::kSuccess; }
+  MStatus setClean() { return MS::kSuccess; }
+private:
+  MockData* m_data = nullptr;
+  std::shared_ptr<MockData>* m_slot = nullptr;
+  unsigned m_current = 0u;
+};
+
+// Copies refer to the same node data, as with maya's data block handles
+class MDataBlock
+{
+public:
+  MDataHandle inputValue(const MObject& _attr) { return MDataHandle(data(_attr.mockAttribute()).get()); }
+  MDataHandle outputValue(const MObject& _attr) { return inputValue(_attr); }
+  MArrayDataHandle inputArrayValue(const MObject& _attr)
+  {
+    auto& slot = rootSlot(_attr.mockAttribute());
+    return MArrayDataHandle(slot.get(), &slot);
+  }
+  MArrayDataHandle outputArrayValue(const MObject& _attr) { return inputArrayValue(_attr); }
+  MDGContext context() const { return m_context; }
+  void setContext(const MDGContext& _context) { m_context = _context; }
+  // A compound is clean when it was set clean itself or all its children were
+  bool isClean(const MObject& _attr)
+  {
+    const auto attr = _attr.mockAttribute();
+    return isClean(attr->parent ? *data(attr) : *rootSlot(attr));
+  }
+  MStatus setClean(const MObject& _attr)
+  {
+    data(_attr.mockAttribute())->cleanGeneration = MockData::generation();
+    return MS::kSuccess;
+  }
+  // Marks _attr and its children dirty, as maya does for the outputs affected by a changed input
+  void mockSetDirty(const MObject& _attr) { setDirty(*data(_attr.mockAttribute())); }
+  // Makes _attr read the data of _sourceAttr on _source, as a connected input reads the output upstream of it.
+  // Array data is replaced when written, so only non array plugs can share their data
+  void mockShare(const MObject& _attr, MDataBlock& _source, const MObject& _sourceAttr)
+  {
+    (*m_values)[_attr.mockAttribute()] = _source.rootSlot(_sourceAttr.mockAttribute());
+  }
+
+private:
+  static bool isClean(const MockData& _data)
+  {
+    if (_data.cleanGeneration == MockData::generation()) return true;
+    if (_data.children.empty()) return false;
+    for (const auto& child : _data.children)
+      if (!isClean(*child)) return false;
+    return true;
+  }
+  static void setDirty(MockData& io_data)
+  {
+    io_data.cleanGeneration = 0u;
+    for (auto& child : io_data.children) setDirty(*child);
+  }
+  std::shared_ptr<MockData>& rootSlot(const MockAttribute* _attr)
+  {
+    auto& slot = (*m_values)[_attr];
+    if (!slot) slot = MockData::create(_attr);
+    return slot;
+  }
+  std::shared_ptr<MockData> data(const MockAttribute* _attr)
+  {
+    // Child attributes live inside their parent's data
+    if (_attr->parent)
+    {
+      auto parent = data(_attr->parent);
+      for (auto& c : parent->children)
+        if (c->attr == _attr) return c;
+    }
+    return rootSlot(_attr);
+  }
+  std::shared_ptr<std::map<const MockAttribute*, std::shared_ptr<MockData>>> m_values =
+    std::make_shared<std::map<const MockAttribute*, std::shared_ptr<MockData>>>();
+  MDGContext m_context;
+};
+
+class MPlugArray;
+
+class MPlug
+{
+public:
+  MPlug() = default;
+  MPlug(const MObject& _node, const MObject& _attr) : m_node(_node.mockNode()), m_attr(_attr) {}
+  MObject attribute() const { return m_attr; }
+  MObject node() const { return MObject(m_node); }
+  bool isNull() const { return m_attr.isNull(); }
+  bool isConnected() const;
+  bool connectedTo(MPlugArray& o_plugs, bool _asDst, bool _asSrc, MStatus* o_status = nullptr) const;
+  bool operator==(const MObject& _attr) const { return m_attr == _attr; }
+  bool operator==(const MPlug& _other) const { return m_attr == _other.m_attr && m_node == _other.m_node; }
+  bool operator!=(const MObject& _attr) const { return !(*this == _attr); }
+  MString name() const;
+  MString partialName() const { return MString(m_attr.mockAttribute() ? m_attr.mockAttribute()->name : ""); }
+private:
+  MPxNode* m_node = nullptr;
+  MObject m_attr;
+};
+
+class MPlugArray
+{
+public:
+  unsigned length() const { return unsigned(m_plugs.size()); }
+  MStatus append(const MPlug& _plug) { m_plugs.push_back(_plug); return MS::kSuccess; }
+  const MPlug& operator[](unsigned _i) const { return m_plugs[_i]; }
+private:
+  std::vector<MPlug> m_plugs;
+};
+
+// Global registry of the node types and attribute graph, shared by every node type
+struct MockRegistry
+{
+  typedef void* (*CreatorFunction)();
+
+  struct NodeType
+  {
+    std::string name;
+    MTypeId typeId;
+    CreatorFunction creator = nullptr;
+    std::vector<MObject> attributes;
+  };
+
+  // Custom evaluators and commands registered through MFnPlugin
+  struct Evaluator
+  {
+    std::string name;
+    unsigned priority = 0u;
+    CreatorFunction creator = nullptr;
+  };
+
+  struct Command
+  {
+    std::string name;
+    CreatorFunction creator = nullptr;
+  };
+
+  std::vector<MObject> attributes;
+  std::set<std::pair<const MockAttribute*, const MockAttribute*>> affects;
+  std::vector<NodeType> nodeTypes;
+  std::vector<Evaluator> evaluators;
+  std::vector<Command> commands;
+  // The result set by the last command that ran
+  std::string commandStringResult;
+  std::vector<int> commandIntResult;
+  // Profiler categories by id, and the events of profiling scopes as category and event name, only kept while
+  // profiling is set so the benchmarks do not time the bookkeeping
+  std::vector<std::string> profilerCategories;
+  bool profiling = false;
+  std::vector<std::pair<int, std::string>> profilerEvents;
+
+  static MockRegistry& instance()
+  {
+    static MockRegistry registry;
+    return registry;
+  }
+  bool doesAffect(const MObject& _in, const MObject& _out) const
+  {
+    return affects.count({_in.mockAttribute(), _out.mockAttribute()}) != 0u;
+  }
+  const NodeType* nodeType(const std::string& _name) const
+  {
+    for (const auto& type : nodeTypes)
+      if (type.name == _name) return &type;
+    return nullptr;
+  }
+  // Finds an attribute, or a child of one, added by the given node type
+  MObject findAttribute(const std::string& _typeName, const std::string& _attrName) const
+  {
+    const auto type = nodeType(_typeName);
+    if (!type) return MObject();
+    for (const auto& attr : type->attributes)
+    {
+      if (attr.mockAttribute()->name == _attrName) return attr;
+    }
+    return MObject();
+  }
+  const NodeType* nodeType(const MTypeId& _typeId) const
+  {
+    for (const auto& type : nodeTypes)
+      if (type.typeId == _typeId) return &type;
+    return nullptr;
+  }
+  // Creates a node of a registered type, the caller owns it
+  inline MPxNode* createNode(const std::string& _typeName, const std::string& _nodeName) const;
+  // Evaluates a node as the evaluation manager would without a custom evaluator, computing each of its outputs
+  inline void evaluateNode(MPxNode* _node) const;
+  // Runs a registered command, its result is left in commandStringResult or commandIntResult
+  inline MStatus executeCommand(const std::string& _name, const std::vector<std::string>& _args = {});
+};
+
+class MPxNode
+{
+public:
+  enum SchedulingType { kParallel, kSerial, kGloballySerial, kUntrusted };
+  virtual ~MPxNode() = default;
+  virtual MStatus compute(const MPlug&, MDataBlock&) { return MS::kUnknownParameter; }
+  virtual SchedulingType schedulingType() const { return kSerial; }
+  virtual void postConstructor() {}
+  virtual MStatus setDependentsDirty(const MPlug&, MPlugArray&) { return MS::kSuccess; }
+  virtual MStatus connectionMade(const MPlug&, const MPlug&, bool) { return MS::kUnknownParameter; }
+  virtual MStatus connectionBroken(const MPlug&, const MPlug&, bool) { return MS::kUnknownParameter; }
+  MObject thisMObject() const { return MObject(const_cast<MPxNode*>(this)); }
+  MDataBlock forceCache(MDGContext& = MDGContext::current()) { return m_mockDataBlock; }
+  MTypeId typeId() const { return m_mockTypeId; }
+  MString name() const { return MString(m_mockName); }
+
+  static MStatus addAttribute(const MObject& _attr)
+  {
+    auto& registry = MockRegistry::instance();
+    registry.attributes.push_back(_attr);
+    // Attributes are added while their node type is initialized, children are reachable by name too
+    if (!registry.nodeTypes.empty())
+    {
+      auto& typeAttributes = registry.nodeTypes.back().attributes;
+      typeAttributes.push_back(_attr);
+      for (auto child : _attr.mockAttribute()->children)
+      {
+        typeAttributes.push_back(MObject(_attr, child));
+      }
+    }
+    return MS::kSuccess;
+  }
+  static MStatus attributeAffects(const MObject& _when, const MObject& _affects)
+  {
+    MockRegistry::instance().affects.insert({_when.mockAttribute(), _affects.mockAttribute()});
+    return MS::kSuccess;
+  }
+
+  // Mock state, the data block of this node and the plugs the test harness considers connected,
+  // with the source of each input connected to another node
+  MDataBlock m_mockDataBlock;
+  std::set<const MockAttribute*> m_mockConnected;
+  std::vector<std::pair<MPlug, MPlug>> m_mockSources;
+  MTypeId m_mockTypeId;
+  std::string m_mockName;
+};
+
+inline MPxNode* MockRegistry::createNode(const std::string& _typeName, const std::string& _nodeName) const
+{
+  const auto type = nodeType(_typeName);
+  if (!type) return nullptr;
+  auto node = static_cast<MPxNode*>(type->creator());
+  node->m_mockTypeId = type->typeId;
+  node->m_mockName = _nodeName;
+  node->postConstructor();
+  return node;
+}
+
+inline void MockRegistry::evaluateNode(MPxNode* _node) const
+{
+  const auto type = nodeType(_node->typeId());
+  if (!type) return;
+  for (const auto& attr : type->attributes)
+  {
+    // Outputs are the attributes that cannot be written, compounds are computed through their parent
+    const auto mockAttr = attr.mockAttribute();
+    if (mockAttr->writable || mockAttr->parent) continue;
+    _node->compute(MPlug(_node->thisMObject(), attr), _node->m_mockDataBlock);
+  }
+}
+
+inline bool MPlug::isConnected() const
+{
+  return m_node && m_node->m_mockConnected.count(m_attr.mockAttribute()) != 0u;
+}
+
+// Only connections between two nodes made through the harness have a peer, and only sources are reported
+inline bool MPlug::connectedTo(MPlugArray& o_plugs, bool _asDst, bool, MStatus* o_status) const
+{
+  o_plugs = MPlugArray();
+  if (_asDst && m_node)
+  {
+    for (const auto& source : m_node->m_mockSources)
+      if (source.first == *this) o_plugs.append(source.second);
+  }
+  if (o_status) *o_status = MS::kSuccess;
+  return o_plugs.length() != 0u;
+}
+
+inline MString MPlug::name() const
+{
+  return MString((m_node ? m_node->m_mockName : std::string()) + "." + partialName().asChar());
+}
+
+// Attribute function sets
+class MFnAttribute
+{
+public:
+  MFnAttribute() = default;
+  explicit MFnAttribute(const MObject& _attr) : m_attr(_attr) {}
+  MStatus setKeyable(bool) { return MS::kSuccess; }
+  MStatus setStorable(bool) { return MS::kSuccess; }
+  MStatus setWritable(bool _state) { attr()->writable = _state; return MS::kSuccess; }
+  MStatus setReadable(bool) { return MS::kSuccess; }
+  MStatus setHidden(bool) { return MS::kSuccess; }
+  MStatus setConnectable(bool) { return MS::kSuccess; }
+  MStatus setCached(bool) { return MS::kSuccess; }
+  MStatus setArray(bool _state) { attr()->isArray = _state; return MS::kSuccess; }
+  MStatus setUsesArrayDataBuilder(bool) { return MS::kSuccess; }
+  MStatus setIndexMatters(bool) { return MS::kSuccess; }
+  MStatus setAffectsAppearance(bool) { return MS::kSuccess; }
+  MString name() const { return MString(attr()->name); }
+  bool isArray() const { return attr()->isArray; }
+protected:
+  MObject make(const char* _name, MockAttribute::Kind _kind)
+  {
+    auto attr = std::make_shared<MockAttribute>();
+    attr->name = _name;
+    attr->kind = _kind;
+    m_attr = MObject(attr);
+    return m_attr;
+  }
+  MockAttribute* attr() const { return m_attr.mockAttribute(); }
+  static void adopt(const MObject& _parent, const MObject& _child)
+  {
+    _parent.mockAttribute()->children.push_back(_child.mockAttribute());
+    _child.mockAttribute()->parent = _parent.mockAttribute();
+  }
+  MObject m_attr;
+};
+
+class MFnNumericData
+{
+public:
+  enum Type { kInvalid, kBoolean, kByte, kChar, kShort, k2Short, k3Short, kInt, k2Int, k3Int, kFloat, k2Float, k3Float, kDouble, k2Double, k3Double, k4Double, kAddr };
+};
+
+class MFnNumericAttribute : public MFnAttribute
+{
+public:
+  MObject create(const MString& _name, const MString&, MFnNumericData::Type _type, double _default = 0.0, MStatus* o_status = nullptr)
+  {
+    make(_name.asChar(), MockAttribute::kNumeric);
+    attr()->numericType = _type;
+    attr()->defaultValue = _default;
+    if (o_status) *o_status = MS::kSuccess;
+    return m_attr;
+  }
+  MObject create(const MString& _name, const MString&, const MObject& _x, const MObject& _y, const MObject& _z, MStatus* o_status = nullptr)
+  {
+    make(_name.asChar(), MockAttribute::kNumeric);
+    attr()->numericType = MFnNumericData::k3Double;
+    adopt(m_attr, _x);
+    adopt(m_attr, _y);
+    adopt(m_attr, _z);
+    if (o_status) *o_status = MS::kSuccess;
+    return m_attr;
+  }
+  MStatus setMin(double) { return MS::kSuccess; }
+  MStatus setMax(double) { return MS::kSuccess; }
+  MStatus setSoftMin(double) { return MS::kSuccess; }
+  MStatus setSoftMax(double) { return MS::kSuccess; }
+  MStatus setDefault(double _v) { attr()->defaultValue = _v; return MS::kSuccess; }
+};
+
+class MFnUnitAttribute : public MFnAttribute
+{
+public:
+  enum Type { kInvalid, kAngle, kDistance, kTime };
+  MObject create(const MString& _name, const MString&, const MAngle& _default, MStatus* o_status = nullptr)
+  {
+    make(_name.asChar(), MockAttribute::kUnit);
+    attr()->defaultValue = _default.asRadians();
+    if (o_status) *o_status = MS::kSuccess;
+    return m_attr;
+  }
+  MObject create(const MString& _name, const MString&, const MTime& _default, MStatus* o_status = nullptr)
+  {
+    make(_name.asChar(), MockAttribute::kUnit);
+    attr()->defaultValue = _default.value();
+    if (o_status) *o_status = MS::kSuccess;
+    return m_attr;
+  }
+};
+
+class MFnMatrixAttribute : public MFnAttribute
+{
+public:
+  enum Type { kFloat, kDouble };
+  MObject create(const MString& _name, const MString&, Type = kDouble, MStatus* o_status = nullptr)
+  {
+    make(_name.asChar(), MockAttribute::kMatrix);
+    if (o_status) *o_status = MS::kSuccess;
+    return m_attr;
+  }
+  MStatus setDefault(const MMatrix& _m) { attr()->defaultMatrix = _m; return MS::kSuccess; }
+};
+
+class MFnCompoundAttribute : public MFnAttribute
+{
+public:
+  MObject create(const MString& _name, const MString&, MStatus* o_status = nullptr)
+  {
+    make(_name.asChar(), MockAttribute::kCompound);
+    if (o_status) *o_status = MS::kSuccess;
+    return m_attr;
+  }
+  MStatus addChild(const MObject& _child)
+  {
+    adopt(m_attr, _child);
+    return MS::kSuccess;
+  }
+};
+
+class MFnEnumAttribute : public MFnAttribute
+{
+public:
+  MObject create(const MString& _name, const MString&, short _default = 0, MStatus* o_status = nullptr)
+  {
+    make(_name.asChar(), MockAttribute::kEnum);
+    attr()->defaultValue = _default;
+    if (o_status) *o_status = MS::kSuccess;
+    return m_attr;
+  }
+  MStatus addField(const MString& _name, short _value)
+  {
+    attr()->fields.emplace_back(_name.asChar(), _value);
+    return MS::kSuccess;
+  }
+};
+
+class MFnDependencyNode
+{
+public:
+  MFnDependencyNode() = default;
+  explicit MFnDependencyNode(const MObject& _node, MStatus* o_status = nullptr) : m_node(_node.mockNode())
+  {
+    if (o_status) *o_status = m_node ? MS::kSuccess : MS::kFailure;
+  }
+  MPxNode* userNode() const { return m_node; }
+  MTypeId typeId() const { return m_node ? m_node->typeId() : MTypeId(); }
+  MString name() const { return m_node ? m_node->name() : MString(); }
+  // The inputs connected to another node
+  MStatus getConnections(MPlugArray& o_plugs) const
+  {
+    o_plugs = MPlugArray();
+    if (!m_node) return MS::kFailure;
+    for (const auto& source : m_node->m_mockSources) o_plugs.append(source.first);
+    return MS::kSuccess;
+  }
+private:
+  MPxNode* m_node = nullptr;
+};
+
+// Evaluation manager, the graph is partitioned into clusters of nodes claimed by a custom evaluator
+class MEvaluationNode
+{
+public:
+  MEvaluationNode() = default;
+  explicit MEvaluationNode(MPxNode* _node) : m_node(_node) {}
+  MObject dependencyNode(MStatus* o_status = nullptr) const
+  {
+    if (o_status) *o_status = m_node ? MS::kSuccess : MS::kFailure;
+    return MObject(m_node);
+  }
+  MDataBlock datablock(MStatus* o_status = nullptr) const
+  {
+    if (o_status) *o_status = m_node ? MS::kSuccess : MS::kFailure;
+    return m_node->m_mockDataBlock;
+  }
+  MPxNode* mockNode() const { return m_node; }
+private:
+  MPxNode* m_node = nullptr;
+};
+
+class MEvaluationNodeIterator
+{
+public:
+  explicit MEvaluationNodeIterator(const std::vector<MEvaluationNode>& _nodes) : m_nodes(&_nodes) {}
+  bool isDone() const { return m_current >= m_nodes->size(); }
+  void next() { ++m_current; }
+  MEvaluationNode currentEvaluationNode(MStatus* o_status = nullptr) const
+  {
+    if (o_status) *o_status = isDone() ? MS::kFailure : MS::kSuccess;
+    return isDone() ? MEvaluationNode() : (*m_nodes)[m_current];
+  }
+private:
+  const std::vector<MEvaluationNode>* m_nodes;
+  std::size_t m_current = 0u;
+};
+
+class MEvaluationGraph
+{
+};
+
+class MCustomEvaluatorClusterNode
+{
+public:
+  enum SchedulingType { kParallel, kSerial, kGloballySerial, kUntrusted };
+  MEvaluationNodeIterator iterator(MStatus* o_status = nullptr) const
+  {
+    if (o_status) *o_status = MS::kSuccess;
+    return MEvaluationNodeIterator(m_mockNodes);
+  }
+  // Evaluates one node of the cluster as it would be without the custom evaluator
+  void evaluateNode(const MEvaluationNode& _node, MStatus* o_status = nullptr) const
+  {
+    MockRegistry::instance().evaluateNode(_node.mockNode());
+    if (o_status) *o_status = MS::kSuccess;
+  }
+  void evaluate() const
+  {
+    for (const auto& node : m_mockNodes) evaluateNode(node);
+  }
+
+  // Mock state, the nodes claimed into this cluster
+  std::vector<MEvaluationNode> m_mockNodes;
+};
+
+class MPxCustomEvaluator
+{
+public:
+  enum ConsolidationType { kConsolidateNone, kConsolidateR };
+  virtual ~MPxCustomEvaluator() = default;
+  virtual bool markIfSupported(const MEvaluationNode*) { return false; }
+  virtual MCustomEvaluatorClusterNode::SchedulingType schedulingType(const MCustomEvaluatorClusterNode*)
+  {
+    return MCustomEvaluatorClusterNode::kSerial;
+  }
+  virtual void preEvaluate(const MEvaluationGraph*) {}
+  virtual void postEvaluate(const MEvaluationGraph*) {}
+  virtual bool clusterInitialize(const MCustomEvaluatorClusterNode*) { return true; }
+  virtual void clusterTerminate(const MCustomEvaluatorClusterNode*) {}
+  virtual void clusterEvaluate(const MCustomEvaluatorClusterNode*) {}
+  void setConsolidation(ConsolidationType _type) { m_consolidation = _type; }
+  ConsolidationType consolidation() const { return m_consolidation; }
+private:
+  ConsolidationType m_consolidation = kConsolidateNone;
+};
+
+// Profiler
+class MProfiler
+{
+public:
+  enum ProfilingColor
+  {
+    kColorA_L1, kColorA_L2, kColorA_L3, kColorB_L1, kColorB_L2, kColorB_L3, kColorC_L1, kColorC_L2, kColorC_L3,
+    kColorD_L1, kColorD_L2, kColorD_L3, kColorE_L1, kColorE_L2, kColorE_L3
+  };
+  static int addCategory(const char* _name, const char* = nullptr)
+  {
+    auto& categories = MockRegistry::instance().profilerCategories;
+    const auto found = std::find(categories.begin(), categories.end(), _name);
+    if (found != categories.end()) return int(found - categories.begin());
+    categories.push_back(_name);
+    return int(categories.size()) - 1;
+  }
+  static MStatus removeCategory(const char* _name)
+  {
+    auto& categories = MockRegistry::instance().profilerCategories;
+    const auto found = std::find(categories.begin(), categories.end(), _name);
+    if (found == categories.end()) return MS::kFailure;
+    // Ids stay stable, as in maya
+    found->clear();
+    return MS::kSuccess;
+  }
+};
+
+class MProfilingScope
+{
+public:
+  MProfilingScope(int _categoryId, MProfiler::ProfilingColor, const char* _eventName, const char* = nullptr)
+  {
+    auto& registry = MockRegistry::instance();
+    if (registry.profiling) registry.profilerEvents.emplace_back(_categoryId, _eventName);
+  }
+  MProfilingScope(const MProfilingScope&) = delete;
+  MProfilingScope& operator=(const MProfilingScope&) = delete;
+};
+
+// Commands
+class MGlobal
+{
+public:
+  static void displayError(const MString& _message) { std::fprintf(stderr, "// Error: %s\n", _message.asChar()); }
+  static void displayInfo(const MString& _message) { std::fprintf(stderr, "// %s\n", _message.asChar()); }
+};
+
+// Maya evaluates on as many threads as the hardware has unless limited, the stand-in is never limited
+class MThreadUtils
+{
+public:
+  static int getNumThreads() { return int(std::max(1u, std::thread::hardware_concurrency())); }
+};
+
+class MArgList
+{
+public:
+  MArgList() = default;
+  explicit MArgList(const std::vector<std::string>& _args) : m_args(_args) {}
+  unsigned length() const { return unsigned(m_args.size()); }
+  MString asString(unsigned _index, MStatus* o_status = nullptr) const
+  {
+    if (o_status) *o_status = _index < m_args.size() ? MS::kSuccess : MS::kFailure;
+    return _index < m_args.size() ? MString(m_args[_index]) : MString();
+  }
+private:
+  std::vector<std::string> m_args;
+};
+
+class MIntArray
+{
+public:
+  unsigned length() const { return unsigned(m_values.size()); }
+  MStatus append(int _value) { m_values.push_back(_value); return MS::kSuccess; }
+  int operator[](unsigned _i) const { return m_values[_i]; }
+  const std::vector<int>& mockValues() const { return m_values; }
+private:
+  std::vector<int> m_values;
+};
+
+class MPxCommand
+{
+public:
+  virtual ~MPxCommand() = default;
+  virtual MStatus doIt(const MArgList&) { return MS::kSuccess; }
+  virtual bool isUndoable() const { return false; }
+  static void clearResult()
+  {
+    MockRegistry::instance().commandStringResult.clear();
+    MockRegistry::instance().commandIntResult.clear();
+  }
+  static void setResult(const MString& _result)
+  {
+    clearResult();
+    MockRegistry::instance().commandStringResult = _result.asChar();
+  }
+  static void setResult(const MIntArray& _result)
+  {
+    clearResult();
+    MockRegistry::instance().commandIntResult = _result.mockValues();
+  }
+};
+
+inline MStatus MockRegistry::executeCommand(const std::string& _name, const std::vector<std::string>& _args)
+{
+  for (const auto& command : commands)
+  {
+    if (command.name != _name) continue;
+    std::unique_ptr<MPxCommand> instance(static_cast<MPxCommand*>(command.creator()));
+    MPxCommand::clearResult();
+    return instance->doIt(MArgList(_args));
+  }
+  return MS::kInvalidParameter;
+}
+
+class MFnPlugin
+{
+public:
+  typedef void* (*CreatorFunction)();
+  typedef MStatus (*InitializeFunction)();
+  MFnPlugin() = default;
+  MFnPlugin(const MObject&, const char* = "", const char* = "", const char* = "", MStatus* o_status = nullptr)
+  {
+    if (o_status) *o_status = MS::kSuccess;
+  }
+  MStatus registerNode(const MString& _name, const MTypeId& _id, CreatorFunction _creator, InitializeFunction _initialize)
+  {
+    MockRegistry::NodeType type;
+    type.name = _name.asChar();
+    type.typeId = _id;
+    type.creator = _creator;
+    MockRegistry::instance().nodeTypes.push_back(type);
+    return _initialize();
+  }
+  MStatus deregisterNode(const MTypeId&) { return MS::kSuccess; }
+  MStatus registerEvaluator(const char* _name, unsigned _priority, CreatorFunction _creator)
+  {
+    MockRegistry::Evaluator evaluator;
+    evaluator.name = _name;
+    evaluator.priority = _priority;
+    evaluator.creator = _creator;
+    MockRegistry::instance().evaluators.push_back(evaluator);
+    return MS::kSuccess;
+  }
+  MStatus deregisterEvaluator(const char* _name)
+  {
+    auto& evaluators = MockRegistry::instance().evaluators;
+    evaluators.erase(
+        std::remove_if(evaluators.begin(), evaluators.end(), [&](const MockRegistry::Evaluator& _e) { return _e.name == _name; }),
+        evaluators.end());
+    return MS::kSuccess;
+  }
+  MStatus registerCommand(const MString& _name, CreatorFunction _creator, void* = nullptr)
+  {
+    MockRegistry::Command command;
+    command.name = _name.asChar();
+    command.creator = _creator;
+    MockRegistry::instance().commands.push_back(command);
+    return MS::kSuccess;
+  }
+  MStatus deregisterCommand(const MString& _name)
+  {
+    auto& commands = MockRegistry::instance().commands;
+    commands.erase(
+        std::remove_if(commands.begin(), commands.end(), [&](const MockRegistry::Command& _c) { return _c.name == _name.asChar(); }),
+        commands.end());
+    return MS::kSuccess;
+  }
+};
+
+#endif //SIMPLEIKMOCKMAYA_INCLUDE_H
@@ -0,0 +1,2 @@
+// Stand-in for <maya/MFnEnumAttribute.h>, see MockMaya.h
+#include "../MockMaya.h"
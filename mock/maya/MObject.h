@@ -0,0 +1,2 @@
+// Stand-in for <maya/MObject.h>, see MockMaya.h
+#include "../MockMaya.h"
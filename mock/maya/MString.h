@@ -0,0 +1,2 @@
+// Stand-in for <maya/MString.h>, see MockMaya.h
+#include "../MockMaya.h"
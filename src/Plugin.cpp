@@ -2,6 +2,12 @@
 
 #include "../include/TwoBoneIK.h"
 #include "../include/InclineAngle.h"
+#include "../include/TwoBoneIKArray.h"
+#include "../include/ChainIK.h"
+#include "../include/SplineIK.h"
+#include "../include/SimpleIKEvaluator.h"
+#include "../include/ComputeRecordCommand.h"
+#include "../include/ComputeStatsCommand.h"
 
 MStatus initializePlugin(MObject _pluginObj)
 {
@@ -10,6 +16,14 @@ MStatus initializePlugin(MObject _pluginObj)
   // only add the node if the plugin init was successful
   if (!plugStat.error()) 
   {
+    // The computes emit their phases under this category in the maya profiler
+    SimpleIKProfiler::registerCategory();
+
+    // Picks the batch kernels for this cpu, SIMPLEIK_SIMD forces a level for testing
+    std::string error;
+    if (!BatchDispatch::selectFromEnvironment(error)) MGlobal::displayError(MString(error.c_str()));
+    MGlobal::displayInfo(MString("SimpleIK batch kernels: ") + BatchDispatch::kernels().name);
+
     int id = 0x416D;
     MStatus stat;
     #define REGISTER_MNODE(NAME)\
@@ -19,8 +33,30 @@ MStatus initializePlugin(MObject _pluginObj)
 
     REGISTER_MNODE(twoBoneIK);
     REGISTER_MNODE(inclineAngle);
+    REGISTER_MNODE(twoBoneIKArray);
+    REGISTER_MNODE(chainIK);
+    REGISTER_MNODE(splineIK);
 
     #undef REGISTER_MNODE
+
+    // Batches the nodes above when enabled through the evaluator command
+    stat = SimpleIKEvaluator::registerEvaluator(pluginFn, 40000u);
+    CHECK_MSTATUS(stat);
+    if (!stat) plugStat = stat;
+    stat = SimpleIKEvaluatorStatsCommand::registerCommand(pluginFn);
+    CHECK_MSTATUS(stat);
+    if (!stat) plugStat = stat;
+
+    // Records the node computes from load to unload when SIMPLEIK_RECORD is set
+    stat = ComputeRecordCommand::registerCommand(pluginFn);
+    CHECK_MSTATUS(stat);
+    if (!stat) plugStat = stat;
+    // Reports the compute counts and latencies the nodes keep
+    stat = ComputeStatsCommand::registerCommand(pluginFn);
+    CHECK_MSTATUS(stat);
+    if (!stat) plugStat = stat;
+    error.clear();
+    if (!ComputeRecorder::instance().startFromEnvironment(error)) MGlobal::displayError(MString(error.c_str()));
   }
   return plugStat;
 }
@@ -30,6 +66,22 @@ MStatus uninitializePlugin(MObject _pluginObj)
   MFnPlugin pluginFn(_pluginObj);
   MStatus plugStat, stat;
 
+  // Writes out the rest of any recording before the node code is unloaded
+  std::string error;
+  if (!ComputeRecorder::instance().stop(error)) MGlobal::displayError(MString(error.c_str()));
+  stat = ComputeRecordCommand::deregisterCommand(pluginFn);
+  CHECK_MSTATUS(stat);
+  if (!stat) plugStat = stat;
+  stat = ComputeStatsCommand::deregisterCommand(pluginFn);
+  CHECK_MSTATUS(stat);
+  if (!stat) plugStat = stat;
+  stat = SimpleIKEvaluatorStatsCommand::deregisterCommand(pluginFn);
+  CHECK_MSTATUS(stat);
+  if (!stat) plugStat = stat;
+  stat = SimpleIKEvaluator::deregisterEvaluator(pluginFn);
+  CHECK_MSTATUS(stat);
+  if (!stat) plugStat = stat;
+
   #define DEREGISTER_MNODE(NAME)\
   stat = NAME::deregisterNode(pluginFn);\
   CHECK_MSTATUS(stat);\
@@ -37,8 +89,13 @@ MStatus uninitializePlugin(MObject _pluginObj)
 
   DEREGISTER_MNODE(twoBoneIK);
   DEREGISTER_MNODE(inclineAngle);
+  DEREGISTER_MNODE(twoBoneIKArray);
+  DEREGISTER_MNODE(chainIK);
+  DEREGISTER_MNODE(splineIK);
 
   #undef DEREGISTER_MNODE
+
+  SimpleIKProfiler::deregisterCategory();
   return plugStat;
 }
 
@@ -0,0 +1,54 @@
+// The headless solver core, built without any maya headers into libsimpleikcore.a.
+// Explicit instantiations keep the solvers generic over the scalar type and free of maya,
+// and give tools a prebuilt copy of the double precision entry points.
+#include "SolverTypes.h"
+#include "SolverMath.h"
+#include "TwoBoneIKSolver.h"
+#include "InclineAngleSolver.h"
+#include "TwoBoneIKBatch.h"
+#include "TwoBoneIKParallel.h"
+#include "ChainIKSolver.h"
+#include "SplineIKSolver.h"
+
+template struct Vector3<float>;
+template struct Vector3<double>;
+template struct Matrix3<float>;
+template struct Matrix3<double>;
+template struct EulerRotation<float>;
+template struct EulerRotation<double>;
+template struct Quaternion<float>;
+template struct Quaternion<double>;
+
+template TwoBoneIKSolution<float> solveTwoBoneIK(const Vector3<float>&, const Vector3<float>&, float, float, float, float, float, TwoBoneIKOrientationMethod);
+template TwoBoneIKSolution<double> solveTwoBoneIK(const Vector3<double>&, const Vector3<double>&, double, double, double, double, double, TwoBoneIKOrientationMethod);
+
+// The approximate tiers are prebuilt in double precision only
+template TwoBoneIKSolution<double> solveTwoBoneIK<double, HighMath>(const Vector3<double>&, const Vector3<double>&, double, double, double, double, double, TwoBoneIKOrientationMethod);
+template TwoBoneIKSolution<double> solveTwoBoneIK<double, FastMath>(const Vector3<double>&, const Vector3<double>&, double, double, double, double, double, TwoBoneIKOrientationMethod);
+
+template TwoBoneIKEdges<float> solveTwoBoneIKEdges(const Vector3<float>&, float, float, float);
+template TwoBoneIKEdges<double> solveTwoBoneIKEdges(const Vector3<double>&, double, double, double);
+template EulerRotation<float> solveRootOrientation(const Vector3<float>&, const Vector3<float>&, float, float, float, float);
+template EulerRotation<double> solveRootOrientation(const Vector3<double>&, const Vector3<double>&, double, double, double, double);
+template Matrix3<float> solveRootMatrix(const Vector3<float>&, const Vector3<float>&, float, float, float, float);
+template Matrix3<double> solveRootMatrix(const Vector3<double>&, const Vector3<double>&, double, double, double, double);
+template Matrix3<float> solveRootFrame(const Vector3<float>&, const Vector3<float>&, float, float, float, float);
+template Matrix3<double> solveRootFrame(const Vector3<double>&, const Vector3<double>&, double, double, double, double);
+
+template float solveInclineAngle(const Vector3<float>&, float, float, float);
+template double solveInclineAngle(const Vector3<double>&, double, double, double);
+template double solveInclineAngle<double, HighMath>(const Vector3<double>&, double, double, double);
+template double solveInclineAngle<double, FastMath>(const Vector3<double>&, double, double, double);
+
+template void solveTwoBoneIKBatch<kTwoBoneIKBatchWidth>(const TwoBoneIKBatch&, std::size_t);
+template void solveInclineAngleBatch<kTwoBoneIKBatchWidth>(const InclineAngleBatch&, std::size_t);
+template void solveTwoBoneIKBatchParallel<kTwoBoneIKBatchWidth>(const TwoBoneIKBatch&, std::size_t, ThreadPool&, std::size_t);
+template void solveInclineAngleBatchParallel<kTwoBoneIKBatchWidth>(const InclineAngleBatch&, std::size_t, ThreadPool&, std::size_t);
+
+template ChainIKResult<float> solveChainIK(const Vector3<float>&, const Vector3<float>&, const float*, std::size_t, float, float, unsigned, float, ChainIKMethod, ChainIKPose<float>&, EulerRotation<float>*, bool);
+template ChainIKResult<double> solveChainIK(const Vector3<double>&, const Vector3<double>&, const double*, std::size_t, double, double, unsigned, double, ChainIKMethod, ChainIKPose<double>&, EulerRotation<double>*, bool);
+
+template struct SplineIKArcLengthTable<float>;
+template struct SplineIKArcLengthTable<double>;
+template void solveSplineIK(const Vector3<float>*, std::size_t, const SplineIKArcLengthTable<float>&, const float*, std::size_t, const Vector3<float>&, float, float, float, float, ChainIKPose<float>&, float*, EulerRotation<float>*);
+template void solveSplineIK(const Vector3<double>*, std::size_t, const SplineIKArcLengthTable<double>&, const double*, std::size_t, const Vector3<double>&, double, double, double, double, ChainIKPose<double>&, double*, EulerRotation<double>*);
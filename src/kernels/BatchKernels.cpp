@@ -0,0 +1,28 @@
+// The batch solve kernels of one instruction set level, built once per level with the flags the makefile gives it.
+// Only internal linkage code is built here, see solveTwoBoneIKPacks, so the builds never stand in for each other
+// at link time. The tables are constant initialized so loading a build the cpu can not run executes none of it.
+#include "BatchDispatch.h"
+
+#if !defined(SIMPLEIK_SIMD_LEVEL)
+#error "build with -DSIMPLEIK_SIMD_LEVEL set to a SimdLevel"
+#endif
+
+#if SIMPLEIK_SIMD_LEVEL == 2
+#define SIMPLEIK_KERNELS kBatchKernelsAVX512
+#define SIMPLEIK_KERNELS_NAME "avx512"
+#define SIMPLEIK_KERNELS_WIDTH 8u
+#elif SIMPLEIK_SIMD_LEVEL == 1
+#define SIMPLEIK_KERNELS kBatchKernelsAVX2
+#define SIMPLEIK_KERNELS_NAME "avx2"
+#define SIMPLEIK_KERNELS_WIDTH 4u
+#else
+#define SIMPLEIK_KERNELS kBatchKernelsSSE
+#define SIMPLEIK_KERNELS_NAME "sse"
+#define SIMPLEIK_KERNELS_WIDTH kTwoBoneIKBatchWidth
+#endif
+
+extern const BatchKernels SIMPLEIK_KERNELS = {
+  SIMPLEIK_KERNELS_NAME, SIMPLEIK_KERNELS_WIDTH,
+  &solveTwoBoneIKPacks<SimdPack<SIMPLEIK_KERNELS_WIDTH>::Real>,
+  &solveInclineAnglePacks<SimdPack<SIMPLEIK_KERNELS_WIDTH>::Real>
+};
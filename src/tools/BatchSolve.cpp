@@ -0,0 +1,219 @@
+// Solves a recorded limb stream offline, with no maya, giving the outputs of the two bone ik and incline angle nodes
+// for every limb of every frame. See LimbStream.h for the file formats.
+//
+//   BatchSolve <input> <output> [--threads N] [--precision exact|high|fast] [--orientation angles|frame] [--packed] [--pipeline]
+//              [--trace <trace.json>]
+//
+// Files ending in .csv are read and written as CSV, files ending in .sikc are mapped columnar files solved in place
+// (see LimbColumns.h), anything else is the binary row format.
+// With --pipeline CSV and binary streams are read, solved and written a chunk at a time on overlapping stages
+// (see LimbPipeline.h), in constant memory, so the input can be a named pipe fed by a live capture.
+// With --trace the read, solve and write phases are written as Chrome trace event JSON, see TraceEvents.h.
+// --packed solves with the batch kernels of the best instruction set the cpu has, SIMPLEIK_SIMD forces one (see BatchDispatch.h).
+// A summary is printed to stdout as one JSON object
+
+#include "LimbColumns.h"
+#include "LimbPipeline.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace
+{
+
+int usage(const char* _program)
+{
+  std::fprintf(stderr,
+      "usage: %s <input> <output> [--threads N] [--precision exact|high|fast] [--orientation angles|frame] [--packed] [--pipeline]"
+      " [--trace <trace.json>]\n",
+      _program);
+  return 2;
+}
+
+double secondsSince(const std::chrono::steady_clock::time_point& _start)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+}
+
+// Recordings are grouped by frame, so frames are counted as runs of rows with the same frame
+std::size_t countFrames(const std::int64_t* _frames, std::size_t _rows)
+{
+  std::size_t frames = _rows ? 1u : 0u;
+  for (std::size_t i = 1u; i < _rows; ++i) frames += _frames[i] != _frames[i - 1u];
+  return frames;
+}
+
+// Rates are over the solve, or over the whole run for a pipeline where the stages overlap
+void printSummary(
+    std::size_t _frames, std::size_t _rows, unsigned _threads, double _read, double _solve, double _write, double _rateSeconds,
+    const std::string& _extra = std::string())
+{
+  const double rate = _rateSeconds > 0.0 ? 1.0 / _rateSeconds : 0.0;
+  std::printf(
+      "{\"frames\": %zu, \"limbs\": %zu, \"threads\": %u, \"simd\": \"%s\", \"read_s\": %.6f, \"solve_s\": %.6f, \"write_s\": %.6f, "
+      "\"frames_per_s\": %.1f, \"limbs_per_s\": %.1f%s%s}\n",
+      _frames, _rows, _threads, BatchDispatch::kernels().name, _read, _solve, _write, double(_frames) * rate, double(_rows) * rate, _extra.empty() ? "" : ", ", _extra.c_str());
+}
+
+// Columnar files are mapped and solved in place, so there is no separate read or write
+int solveColumns(
+    const std::string& _inputPath, const std::string& _outputPath, ThreadPool& io_pool, SolvePrecision _precision,
+    TwoBoneIKOrientationMethod _method, bool _packed, TraceEventWriter* io_trace)
+{
+  std::string error;
+  LimbColumnsFile input;
+  LimbColumnsFile output;
+  if (!input.open(_inputPath, error) || !output.create(_outputPath, input.rows(), limbColumnsOutputs(), error))
+  {
+    std::fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+  const auto start = std::chrono::steady_clock::now();
+  if (!solveLimbColumns(input, output, io_pool, _precision, _method, _packed, error, io_trace))
+  {
+    std::fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+  const double solveSeconds = secondsSince(start);
+  const std::size_t rows = std::size_t(input.rows());
+  printSummary(countFrames(output.frame(), rows), rows, io_pool.threadCount(), 0.0, solveSeconds, 0.0, solveSeconds);
+  return 0;
+}
+
+int solvePipeline(
+    const std::string& _inputPath, const std::string& _outputPath, ThreadPool& io_pool, SolvePrecision _precision,
+    TwoBoneIKOrientationMethod _method, bool _packed, TraceEventWriter* io_trace)
+{
+  std::string error;
+  LimbStreamReader reader;
+  LimbStreamWriter writer;
+  LimbPipelineStats stats;
+  if (!reader.open(_inputPath, error) || !writer.open(_outputPath, error) ||
+      !runLimbPipeline(reader, writer, io_pool, _precision, _method, _packed, stats, error, kLimbPipelineChunkRows, kLimbPipelineChunks, io_trace) ||
+      !writer.close(error))
+  {
+    std::fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+  const auto& stages = stats.stages;
+  printSummary(
+      stats.frames, stages[LimbPipelineStats::kSolve].rows, io_pool.threadCount(), stages[LimbPipelineStats::kRead].busySeconds,
+      stages[LimbPipelineStats::kSolve].busySeconds, stages[LimbPipelineStats::kWrite].busySeconds, stats.seconds, stats.json());
+  return 0;
+}
+
+// The whole take is read, solved and written in turn
+int solveTake(
+    const std::string& _inputPath, const std::string& _outputPath, ThreadPool& io_pool, SolvePrecision _precision,
+    TwoBoneIKOrientationMethod _method, bool _packed, TraceEventWriter* io_trace)
+{
+  LimbStream stream;
+  std::string error;
+  auto start = std::chrono::steady_clock::now();
+  if (!readLimbStreamInputs(_inputPath, stream, error))
+  {
+    std::fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+  const double readSeconds = secondsSince(start);
+  if (io_trace) io_trace->add("read", start, std::chrono::steady_clock::now(), stream.size());
+
+  start = std::chrono::steady_clock::now();
+  solveLimbStream(stream, io_pool, _precision, _method, _packed, io_trace);
+  const double solveSeconds = secondsSince(start);
+
+  start = std::chrono::steady_clock::now();
+  if (!writeLimbStreamOutputs(_outputPath, stream, error))
+  {
+    std::fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+  const double writeSeconds = secondsSince(start);
+  if (io_trace) io_trace->add("write", start, std::chrono::steady_clock::now(), stream.size());
+
+  printSummary(
+      countFrames(stream.frame.data(), stream.size()), stream.size(), io_pool.threadCount(), readSeconds, solveSeconds, writeSeconds, solveSeconds);
+  return 0;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  std::string inputPath;
+  std::string outputPath;
+  unsigned threads = ThreadPool::defaultThreadCount();
+  SolvePrecision precision = kPrecisionExact;
+  TwoBoneIKOrientationMethod method = kOrientationAngles;
+  bool packed = false;
+  bool pipeline = false;
+  std::string tracePath;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (!std::strcmp(argv[i], "--threads") && i + 1 < argc) threads = unsigned(std::max(std::atoi(argv[++i]), 1));
+    else if (!std::strcmp(argv[i], "--precision") && i + 1 < argc)
+    {
+      const std::string value = argv[++i];
+      if (value == "exact") precision = kPrecisionExact;
+      else if (value == "high") precision = kPrecisionHigh;
+      else if (value == "fast") precision = kPrecisionFast;
+      else return usage(argv[0]);
+    }
+    else if (!std::strcmp(argv[i], "--orientation") && i + 1 < argc)
+    {
+      const std::string value = argv[++i];
+      if (value == "angles") method = kOrientationAngles;
+      else if (value == "frame") method = kOrientationFrame;
+      else return usage(argv[0]);
+    }
+    else if (!std::strcmp(argv[i], "--packed")) packed = true;
+    else if (!std::strcmp(argv[i], "--pipeline")) pipeline = true;
+    else if (!std::strcmp(argv[i], "--trace") && i + 1 < argc) tracePath = argv[++i];
+    else if (argv[i][0] != '-' && inputPath.empty()) inputPath = argv[i];
+    else if (argv[i][0] != '-' && outputPath.empty()) outputPath = argv[i];
+    else return usage(argv[0]);
+  }
+  if (inputPath.empty() || outputPath.empty()) return usage(argv[0]);
+  if (packed && (precision != kPrecisionExact || method != kOrientationAngles))
+  {
+    std::fprintf(stderr, "--packed only solves the exact precision angles method\n");
+    return 2;
+  }
+
+  std::string error;
+  if (!BatchDispatch::selectFromEnvironment(error)) std::fprintf(stderr, "%s\n", error.c_str());
+  error.clear();
+
+  ThreadPool pool(threads);
+  TraceEventWriter trace;
+  TraceEventWriter* tracing = tracePath.empty() ? nullptr : &trace;
+  int status;
+  if (isLimbColumns(inputPath) || isLimbColumns(outputPath))
+  {
+    if (isLimbColumns(inputPath) != isLimbColumns(outputPath))
+    {
+      std::fprintf(stderr, "columnar inputs are solved into columnar outputs, convert other formats with LimbConvert\n");
+      return 2;
+    }
+    if (pipeline)
+    {
+      std::fprintf(stderr, "columnar files are mapped whole, --pipeline streams CSV and binary row files\n");
+      return 2;
+    }
+    status = solveColumns(inputPath, outputPath, pool, precision, method, packed, tracing);
+  }
+  else if (pipeline) status = solvePipeline(inputPath, outputPath, pool, precision, method, packed, tracing);
+  else status = solveTake(inputPath, outputPath, pool, precision, method, packed, tracing);
+
+  if (!status && tracing && !trace.write(tracePath, error))
+  {
+    std::fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+  return status;
+}
+
+
@@ -0,0 +1,121 @@
+// Converts recorded limb streams between the formats of LimbStream.h and LimbColumns.h
+//
+//   LimbConvert <input> <output>
+//
+// CSV and binary row inputs convert to columnar files (.sikc), CSV is parsed straight into the mapped columns so takes
+// larger than memory convert a window at a time. Columnar files convert to CSV with every column they hold, which
+// is how solved columnar outputs are inspected.
+// A summary is printed to stdout as one JSON object
+
+#include "LimbColumns.h"
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+namespace
+{
+
+// CSV input parsed into a new columnar file
+bool csvToColumns(const std::string& _inputPath, const std::string& _outputPath, std::size_t& o_rows, std::string& o_error)
+{
+  MappedFile input;
+  if (!input.open(_inputPath, o_error)) return false;
+  o_rows = LimbStreamIO::countCSVRows(input.data(), input.size());
+  LimbColumnsFile output;
+  if (!output.create(_outputPath, o_rows, limbColumnsInputs(), o_error)) return false;
+  std::int64_t* frame = output.frame();
+  std::int64_t* limb = output.limb();
+  double* channels[kLimbStreamInputChannels];
+  for (std::size_t c = 0u; c < kLimbStreamInputChannels; ++c) channels[c] = output.channel(c);
+  std::size_t row = 0u;
+  return LimbStreamIO::parseCSV(_inputPath, input.data(), input.size(), [&](std::int64_t _frame, std::int64_t _limb, const double* _channels)
+  {
+    frame[row] = _frame;
+    limb[row] = _limb;
+    for (std::size_t c = 0u; c < kLimbStreamInputChannels; ++c) channels[c][row] = _channels[c];
+    if (++row % kLimbColumnsWindowRows == 0u) output.release(row - kLimbColumnsWindowRows, row);
+  }, o_error);
+}
+
+// A columnar file written out as CSV, with every column it holds
+bool columnsToCSV(const std::string& _inputPath, const std::string& _outputPath, std::size_t& o_rows, std::string& o_error)
+{
+  LimbColumnsFile input;
+  if (!input.open(_inputPath, o_error)) return false;
+  std::vector<std::uint32_t> columns;
+  for (std::uint32_t c = 0u; c < kLimbColumnCount; ++c)
+  {
+    if (input.has(c)) columns.push_back(c);
+  }
+  LimbStreamIO::File out(_outputPath, "wb");
+  if (!out.file) return LimbStreamIO::fail(o_error, "cannot open " + _outputPath + ": " + std::strerror(errno));
+  std::string buffer;
+  for (std::size_t i = 0u; i < columns.size(); ++i)
+  {
+    if (i) buffer += ',';
+    buffer += columns[i] == kLimbColumnFrame ? "frame" : columns[i] == kLimbColumnLimb ? "limb" : LimbStream::channelName(columns[i] - kLimbColumnChannels);
+  }
+  buffer += '\n';
+  o_rows = std::size_t(input.rows());
+  char value[32];
+  for (std::size_t row = 0u; row < o_rows; ++row)
+  {
+    for (std::size_t i = 0u; i < columns.size(); ++i)
+    {
+      if (i) buffer += ',';
+      if (columns[i] < kLimbColumnChannels) buffer += std::to_string((columns[i] == kLimbColumnFrame ? input.frame() : input.limb())[row]);
+      else buffer.append(value, std::size_t(std::snprintf(value, sizeof(value), "%.17g", input.channel(columns[i] - kLimbColumnChannels)[row])));
+    }
+    buffer += '\n';
+    if (buffer.size() > (1u << 20) || row + 1u == o_rows)
+    {
+      if (std::fwrite(buffer.data(), 1u, buffer.size(), out.file) != buffer.size()) return LimbStreamIO::fail(o_error, "cannot write " + _outputPath);
+      buffer.clear();
+    }
+    if ((row + 1u) % kLimbColumnsWindowRows == 0u) input.release(row + 1u - kLimbColumnsWindowRows, row + 1u);
+  }
+  if (!buffer.empty() && std::fwrite(buffer.data(), 1u, buffer.size(), out.file) != buffer.size()) return LimbStreamIO::fail(o_error, "cannot write " + _outputPath);
+  return true;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  if (argc != 3)
+  {
+    std::fprintf(stderr, "usage: %s <input> <output>\n", argv[0]);
+    return 2;
+  }
+  const std::string inputPath = argv[1];
+  const std::string outputPath = argv[2];
+  std::string error;
+  std::size_t rows = 0u;
+  const auto start = std::chrono::steady_clock::now();
+  bool ok = false;
+  if (isLimbColumns(inputPath) && isLimbStreamCSV(outputPath)) ok = columnsToCSV(inputPath, outputPath, rows, error);
+  else if (!isLimbColumns(inputPath) && isLimbColumns(outputPath))
+  {
+    if (isLimbStreamCSV(inputPath)) ok = csvToColumns(inputPath, outputPath, rows, error);
+    else
+    {
+      // Binary row files are small enough to read whole, they have no parsing to stream
+      LimbStream stream;
+      ok = readLimbStreamInputs(inputPath, stream, error) && writeLimbColumnsInputs(outputPath, stream, error);
+      rows = stream.size();
+    }
+  }
+  else
+  {
+    std::fprintf(stderr, "LimbConvert converts CSV and binary row files to .sikc, and .sikc files to CSV\n");
+    return 2;
+  }
+  if (!ok)
+  {
+    std::fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::printf("{\"rows\": %zu, \"seconds\": %.6f, \"rows_per_s\": %.1f}\n", rows, seconds, seconds > 0.0 ? double(rows) / seconds : 0.0);
+  return 0;
+}
@@ -0,0 +1,69 @@
+// Replays a log of recorded node computes through the headless solver, see ComputeRecorder.h, and reports any output
+// that no longer matches what the node gave in scene, so recorded production rigs double as numeric regression tests.
+//
+//   ReplayComputes <log> [--threads N] [--tolerance X] [--limbs <stream>]
+//
+// With --limbs the recorded inputs are also written as a limb stream, for timing with BatchSolve.
+// A summary is printed to stdout as one JSON object, and the exit status is 1 when an output is off by more than the
+// tolerance, 1e-9 by default
+
+#include "ComputeRecorder.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace
+{
+
+int usage(const char* _program)
+{
+  std::fprintf(stderr, "usage: %s <log> [--threads N] [--tolerance X] [--limbs <stream>]\n", _program);
+  return 2;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  std::string logPath;
+  std::string limbsPath;
+  unsigned threads = ThreadPool::defaultThreadCount();
+  double tolerance = 1e-9;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (!std::strcmp(argv[i], "--threads") && i + 1 < argc) threads = unsigned(std::max(std::atoi(argv[++i]), 1));
+    else if (!std::strcmp(argv[i], "--tolerance") && i + 1 < argc) tolerance = std::atof(argv[++i]);
+    else if (!std::strcmp(argv[i], "--limbs") && i + 1 < argc) limbsPath = argv[++i];
+    else if (argv[i][0] != '-' && logPath.empty()) logPath = argv[i];
+    else return usage(argv[0]);
+  }
+  if (logPath.empty()) return usage(argv[0]);
+
+  std::vector<ComputeRecord> records;
+  std::string error;
+  if (!readComputeRecords(logPath, records, error))
+  {
+    std::fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+  ThreadPool pool(threads);
+  const auto start = std::chrono::steady_clock::now();
+  const auto stats = replayComputeRecords(records, pool, tolerance);
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  if (!limbsPath.empty())
+  {
+    LimbStream stream;
+    computeRecordsToLimbStream(records, stream);
+    if (!writeLimbStreamInputs(limbsPath, stream, error))
+    {
+      std::fprintf(stderr, "%s\n", error.c_str());
+      return 1;
+    }
+  }
+  std::printf("{%s, \"threads\": %u, \"replay_s\": %.6f, \"records_per_s\": %.1f}\n",
+      stats.json().c_str(), pool.threadCount(), seconds, seconds > 0.0 ? double(records.size()) / seconds : 0.0);
+  return stats.mismatches ? 1 : 0;
+}
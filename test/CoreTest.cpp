@@ -0,0 +1,171 @@
+// Checks the headless solver core against values worked out by hand from the limb geometry, so a change to the
+// solves, or to the euler conventions they share with maya, fails here before any scene is opened.
+// Prints one json line per check and exits non-zero when any check fails.
+#include "SolverTypes.h"
+#include "TwoBoneIKSolver.h"
+#include "InclineAngleSolver.h"
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+namespace
+{
+constexpr double kTolerance = 1e-12;
+constexpr double kPi = 3.14159265358979323846;
+
+int g_failures = 0;
+
+void report(const char* _check, double _error, double _tolerance)
+{
+  const bool ok = _error <= _tolerance;
+  g_failures += !ok;
+  std::printf("{\"check\":\"%s\",\"error\":%.3g,\"ok\":%s}\n", _check, _error, ok ? "true" : "false");
+}
+
+// Rotation by _angle about world _axis, for row vectors, written out rather than taken from Vector3::rotateBy
+Matrix3<double> axisRotation(int _axis, double _angle)
+{
+  const double c = std::cos(_angle);
+  const double s = std::sin(_angle);
+  Matrix3<double> m;
+  const int i = (_axis + 1) % 3;
+  const int j = (_axis + 2) % 3;
+  m[i][i] = c;
+  m[i][j] = s;
+  m[j][i] = -s;
+  m[j][j] = c;
+  return m;
+}
+
+// The maya rotation orders as the axes in the order they apply
+const int kOrderAxes[6][3] = {{0, 1, 2}, {1, 2, 0}, {2, 0, 1}, {0, 2, 1}, {1, 0, 2}, {2, 1, 0}};
+
+Matrix3<double> referenceMatrix(double _x, double _y, double _z, int _order)
+{
+  const double angles[3] = {_x, _y, _z};
+  Matrix3<double> m;
+  for (int axis : kOrderAxes[_order]) m = m * axisRotation(axis, angles[axis]);
+  return m;
+}
+
+double matrixError(const Matrix3<double>& _a, const Matrix3<double>& _b)
+{
+  double error = 0.0;
+  for (int i = 0; i < 3; ++i)
+    for (int j = 0; j < 3; ++j)
+      error = std::max(error, std::abs(_a[i][j] - _b[i][j]));
+  return error;
+}
+
+Vector3<double> rowTimes(const Vector3<double>& _v, const Matrix3<double>& _m)
+{
+  return Vector3<double>(
+      _v.x * _m[0][0] + _v.y * _m[1][0] + _v.z * _m[2][0],
+      _v.x * _m[0][1] + _v.y * _m[1][1] + _v.z * _m[2][1],
+      _v.x * _m[0][2] + _v.y * _m[1][2] + _v.z * _m[2][2]);
+}
+
+void checkEulerRotation()
+{
+  using Euler = EulerRotation<double>;
+  // A quarter turn about each axis, as maya reports it: x onto y about z, y onto z about x, z onto x about y
+  double error = 0.0;
+  error = std::max(error, (rowTimes(Vector3<double>(1.0, 0.0, 0.0), Euler(0.0, 0.0, kPi / 2.0).asMatrix()) - Vector3<double>(0.0, 1.0, 0.0)).length());
+  error = std::max(error, (rowTimes(Vector3<double>(0.0, 1.0, 0.0), Euler(kPi / 2.0, 0.0, 0.0).asMatrix()) - Vector3<double>(0.0, 0.0, 1.0)).length());
+  error = std::max(error, (rowTimes(Vector3<double>(0.0, 0.0, 1.0), Euler(0.0, kPi / 2.0, 0.0).asMatrix()) - Vector3<double>(1.0, 0.0, 0.0)).length());
+  // xyz applies x first: a quarter turn about x then about y takes y to z, then z to x
+  error = std::max(error, (rowTimes(Vector3<double>(0.0, 1.0, 0.0), Euler(kPi / 2.0, kPi / 2.0, 0.0).asMatrix()) - Vector3<double>(1.0, 0.0, 0.0)).length());
+  // zyx applies y before x, so y stays on y then turns onto z
+  error = std::max(error, (rowTimes(Vector3<double>(0.0, 1.0, 0.0), Euler(kPi / 2.0, kPi / 2.0, 0.0, Euler::kZYX).asMatrix()) - Vector3<double>(0.0, 0.0, 1.0)).length());
+  report("eulerRotation.axes", error, kTolerance);
+
+  // Each order against the axis rotations multiplied out, then decomposed back into its angles, with the middle
+  // angle inside a quarter turn so the angles are unique
+  std::mt19937 random(7u);
+  std::uniform_real_distribution<double> outer(-kPi * 0.99, kPi * 0.99);
+  std::uniform_real_distribution<double> middle(-kPi * 0.49, kPi * 0.49);
+  double matrix = 0.0;
+  double angles = 0.0;
+  for (int order = 0; order < 6; ++order)
+  {
+    for (int i = 0; i < 200; ++i)
+    {
+      double xyz[3] = {outer(random), outer(random), outer(random)};
+      xyz[kOrderAxes[order][1]] = middle(random);
+      const auto reference = referenceMatrix(xyz[0], xyz[1], xyz[2], order);
+      const Euler rotation(xyz[0], xyz[1], xyz[2], Euler::RotationOrder(order));
+      matrix = std::max(matrix, matrixError(rotation.asMatrix(), reference));
+      const auto decomposed = Euler::decompose(reference, Euler::RotationOrder(order));
+      angles = std::max({angles, std::abs(decomposed.x - xyz[0]), std::abs(decomposed.y - xyz[1]), std::abs(decomposed.z - xyz[2])});
+    }
+  }
+  report("eulerRotation.asMatrix", matrix, kTolerance);
+  report("eulerRotation.decompose", angles, 1e-9);
+
+  // A reorder keeps the rotation, and the angles in the new order rebuild it
+  double reorder = 0.0;
+  for (int from = 0; from < 6; ++from)
+  {
+    for (int to = 0; to < 6; ++to)
+    {
+      const double x = outer(random), y = middle(random), z = outer(random);
+      Euler rotation(x, y, z, Euler::RotationOrder(from));
+      rotation.reorderIt(Euler::RotationOrder(to));
+      reorder = std::max({reorder, double(rotation.order != to),
+          matrixError(referenceMatrix(rotation.x, rotation.y, rotation.z, to), referenceMatrix(x, y, z, from))});
+    }
+  }
+  // A quarter turn about z then x, in xyz order, is x then y in zxy order, as maya's reorderIt gives
+  Euler known(kPi / 2.0, 0.0, kPi / 2.0, Euler::kXYZ);
+  known.reorderIt(Euler::kZXY);
+  reorder = std::max({reorder, std::abs(known.x), std::abs(known.y - kPi / 2.0), std::abs(known.z - kPi / 2.0)});
+  report("eulerRotation.reorder", reorder, 1e-9);
+}
+
+void checkTwoBoneIK()
+{
+  // Unit bones reaching a target root two away meet at a right angle, the root bone 45 degrees off the target,
+  // and the pole side of the limb is where the middle joint goes
+  const Vector3<double> target(1.0, 1.0, 0.0);
+  const Vector3<double> pole(0.0, 0.0, 1.0);
+  for (const auto method : {kOrientationAngles, kOrientationFrame})
+  {
+    const auto solution = solveTwoBoneIK<double>(target, pole, 1.0, 1.0, 0.0, 0.0, 0.0, method);
+    const auto middle = rowTimes(Vector3<double>(1.0, 0.0, 0.0), solution.orientation.asMatrix());
+    const double reach = std::max({std::abs((target - middle).length() - 1.0), std::abs(middle * target - 1.0),
+        std::abs((middle * pole) - std::sqrt(0.5))});
+    const bool frame = method == kOrientationFrame;
+    report(frame ? "twoBoneIK.frame.bendAngle" : "twoBoneIK.angles.bendAngle", std::abs(solution.bendAngle - 1.5 * kPi), kTolerance);
+    report(frame ? "twoBoneIK.frame.middleJoint" : "twoBoneIK.angles.middleJoint", reach, 1e-9);
+  }
+
+  // Out of reach the limb straightens, a full turn with the obtuse complement, and full stretch grows both bones in proportion to meet the target
+  const auto straight = solveTwoBoneIK<double>(Vector3<double>(0.0, 4.0, 3.0), pole, 1.0, 3.0, 0.0, 0.0, 1.0);
+  const auto aim = rowTimes(Vector3<double>(1.0, 0.0, 0.0), straight.orientation.asMatrix());
+  report("twoBoneIK.straight", std::max({std::abs(straight.bendAngle - 2.0 * kPi), (aim - Vector3<double>(0.0, 0.8, 0.6)).length(),
+      std::abs(straight.stretchedEdgeA - 1.25), std::abs(straight.stretchedEdgeB - 3.75)}), 1e-9);
+
+  // A soften distance of one on a chain of two reaches a target two away at two less one over e
+  const auto soft = solveTwoBoneIK<double>(Vector3<double>(2.0, 0.0, 0.0), pole, 1.0, 1.0, 0.0, 1.0, 0.0);
+  const double softEdge = 2.0 - std::exp(-1.0);
+  report("twoBoneIK.soften", std::abs(soft.bendAngle - (kPi + std::acos(1.0 - 0.5 * softEdge * softEdge))), kTolerance);
+}
+
+void checkInclineAngle()
+{
+  // The unit limb above, with the target 45 degrees up, inclines a quarter turn
+  double error = std::abs(solveInclineAngle<double>(Vector3<double>(1.0, 1.0, 0.0), 1.0, 1.0, 0.0) - kPi / 2.0);
+  // A straight limb along x does not incline at all, and the target's height adds its own incline
+  error = std::max(error, std::abs(solveInclineAngle<double>(Vector3<double>(2.0, 0.0, 0.0), 1.0, 1.0, 0.0)));
+  error = std::max(error, std::abs(solveInclineAngle<double>(Vector3<double>(3.0, std::sqrt(3.0), 0.0), 2.0, 2.0, 0.0) - kPi / 3.0));
+  report("inclineAngle.known", error, 1e-7);
+}
+}
+
+int main()
+{
+  checkEulerRotation();
+  checkTwoBoneIK();
+  checkInclineAngle();
+  return g_failures ? 1 : 0;
+}